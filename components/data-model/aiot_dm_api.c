@@ -221,8 +221,7 @@ static int32_t _dm_prepare_send_topic(dm_handle_t *dm_handle, const aiot_dm_msg_
                     }
                 }
                 tmp_fmt[k] = '\0';
-                strncpy(topic_fmt, tmp_fmt, sizeof(topic_fmt) - 1);
-                topic_fmt[sizeof(topic_fmt) - 1] = '\0';
+                memcpy(topic_fmt, tmp_fmt, k + 1);
             }
             src[0] = pk;
             src[1] = dn;
@@ -10,6 +10,7 @@
 #include "core_string.h"
 #include "core_log.h"
 #include "core_auth.h"
+#include "core_timer.h"
 #include <stdio.h>
 
 
@@ -526,12 +527,9 @@ int32_t aiot_dynregmq_recv(void *handle)
     _dynregmq_exec_inc(dynregmq_handle);
 
     dynregmq_handle->sysdep->core_sysdep_mutex_lock(dynregmq_handle->data_mutex);
-    timenow_ms = dynregmq_handle->sysdep->core_sysdep_time();
+    timenow_ms = core_time_ms(dynregmq_handle->sysdep);
     while (1) {
-        if (timenow_ms >= dynregmq_handle->sysdep->core_sysdep_time()) {
-            timenow_ms = dynregmq_handle->sysdep->core_sysdep_time();
-        }
-        if (dynregmq_handle->sysdep->core_sysdep_time() - timenow_ms >= dynregmq_handle->timeout_ms) {
+        if (core_time_ms(dynregmq_handle->sysdep) - timenow_ms >= dynregmq_handle->timeout_ms) {
             res = STATE_DYNREGMQ_AUTH_TIMEOUT;
             break;
         }
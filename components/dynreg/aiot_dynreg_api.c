@@ -10,6 +10,7 @@
 #include "core_string.h"
 #include "core_log.h"
 #include "core_auth.h"
+#include "core_timer.h"
 
 static void _dynreg_exec_inc(dynreg_handle_t *dynreg_handle)
 {
@@ -345,15 +346,14 @@ int32_t aiot_dynreg_send_request(void *handle)
     }
     memset(&dynreg_handle->response, 0, sizeof(core_http_response_t));
 
-    if (dynreg_handle->http_handle != NULL) {
-        core_http_deinit(&dynreg_handle->http_handle);
-    }
-
-    dynreg_handle->http_handle = core_http_init();
+    /* 保留上一次请求的HTTP实例, 重新连接时可以复用尚未断开的连接 */
     if (dynreg_handle->http_handle == NULL) {
-        dynreg_handle->sysdep->core_sysdep_mutex_unlock(dynreg_handle->data_mutex);
-        _dynreg_exec_dec(dynreg_handle);
-        return STATE_SYS_DEPEND_MALLOC_FAILED;
+        dynreg_handle->http_handle = core_http_init();
+        if (dynreg_handle->http_handle == NULL) {
+            dynreg_handle->sysdep->core_sysdep_mutex_unlock(dynreg_handle->data_mutex);
+            _dynreg_exec_dec(dynreg_handle);
+            return STATE_SYS_DEPEND_MALLOC_FAILED;
+        }
     }
 
     if (((res = core_http_setopt(dynreg_handle->http_handle, CORE_HTTPOPT_HOST,
@@ -460,12 +460,9 @@ int32_t aiot_dynreg_recv(void *handle)
     _dynreg_exec_inc(dynreg_handle);
 
     dynreg_handle->sysdep->core_sysdep_mutex_lock(dynreg_handle->data_mutex);
-    timenow_ms = dynreg_handle->sysdep->core_sysdep_time();
+    timenow_ms = core_time_ms(dynreg_handle->sysdep);
     while (1) {
-        if (timenow_ms >= dynreg_handle->sysdep->core_sysdep_time()) {
-            timenow_ms = dynreg_handle->sysdep->core_sysdep_time();
-        }
-        if (dynreg_handle->sysdep->core_sysdep_time() - timenow_ms >= dynreg_handle->timeout_ms) {
+        if (core_time_ms(dynreg_handle->sysdep) - timenow_ms >= dynreg_handle->timeout_ms) {
             break;
         }
 
@@ -313,6 +313,19 @@ int32_t aiot_download_setopt(void *handle, aiot_download_option_t option, void *
         res = core_http_setopt(download_handle->http_handle, CORE_HTTPOPT_BODY_BUFFER_MAX_LEN, data);
     }
     break;
+    case AIOT_DLOPT_NETWORK_SOCKOPT: {
+        res = core_http_setopt(download_handle->http_handle, CORE_HTTPOPT_NETWORK_SOCKOPT, data);
+    }
+    break;
+    case AIOT_DLOPT_BODY_BUFFER: {
+        aiot_download_body_buffer_t *body_buffer = (aiot_download_body_buffer_t *)data;
+        core_http_body_buffer_t http_body_buffer;
+
+        http_body_buffer.buffer = body_buffer->buffer;
+        http_body_buffer.len = body_buffer->len;
+        res = core_http_setopt(download_handle->http_handle, CORE_HTTPOPT_BODY_BUFFER, &http_body_buffer);
+    }
+    break;
     default: {
         res = STATE_USER_INPUT_OUT_RANGE;
     }
@@ -245,7 +245,8 @@ typedef struct {
     struct {
 
         /**
-        * @brief 下载固件过程中, SDK分配出来的存储云端下行的固件内容的buffer地址.在回调函数结束后SDK就会主动释放.用户需要自行将报文拷贝保存.
+        * @brief 下载固件过程中, 存储云端下行的固件内容的buffer地址. 通过@ref AIOT_DLOPT_BODY_BUFFER 设置了用户缓冲区时指向该缓冲区,
+        * 否则为SDK内部的缓冲区, 回调函数结束后会被复用, 用户需要自行将报文拷贝保存.
         *
         */
         uint8_t *buffer;
@@ -265,6 +266,24 @@ typedef struct {
 } aiot_download_recv_t;
 
 
+/**
+ * @brief 用户提供给SDK的固件接收缓冲区, 见@ref AIOT_DLOPT_BODY_BUFFER
+ *
+ */
+typedef struct {
+    /**
+    * @brief 缓冲区地址, 为NULL时恢复使用SDK内部的缓冲区
+    *
+    */
+    uint8_t *buffer;
+
+    /**
+    * @brief 缓冲区长度, 也是每次从@ref aiot_download_recv_handler_t 回调函数中给出的body最大长度
+    *
+    */
+    uint32_t len;
+} aiot_download_body_buffer_t;
+
 /**
  * @brief 升级开始后, 设备收到分成一段段的固件内容时的收包回调函数.当前默认是通过https报文下推分段后的固件内容.
 
@@ -473,11 +492,33 @@ typedef enum {
     * @brief 当设备从固件下载服务器接收返回的http报文时, 每次从 @ref aiot_download_recv_handler_t 回调函数中给出的body最大长度
     *
     * @details
-    * 如果收到的数据没能达到这个长度, 则以aiot_download_recv_handler_t回调函数给出的长度是设备实际接收到的长度
+    * 如果收到的数据没能达到这个长度, 则以aiot_download_recv_handler_t回调函数给出的长度是设备实际接收到的长度.
+    * 默认值为一个TLS记录的长度, 内存紧张的设备可以调小, 代价是回调次数增多, 下载变慢
     *
-    * 数据类型: (uint32_t *) 默认值: (2 *1024) Bytes
+    * 数据类型: (uint32_t *) 默认值: (16 *1024) Bytes
     */
     AIOT_DLOPT_BODY_BUFFER_MAX_LEN,
+
+    /**
+    * @brief 下载固件时使用的socket调优参数
+    *
+    * @details
+    * 如为大文件下载加大接收缓冲区, 各字段含义见@ref aiot_sysdep_network_sockopt_t , 在下一次建立下载连接时生效
+    *
+    * 数据类型: (aiot_sysdep_network_sockopt_t *) 默认值: 全部使用系统默认值
+    */
+    AIOT_DLOPT_NETWORK_SOCKOPT,
+
+    /**
+    * @brief 由用户提供接收固件内容的缓冲区, SDK将固件内容直接读入其中, 再从@ref aiot_download_recv_handler_t 回调函数中原地给出
+    *
+    * @details
+    * 适合将固件内容直接写入flash等场景, 省去SDK内部缓冲区和一次拷贝. 缓冲区由用户管理, 在download实例销毁或以buffer为NULL
+    * 重新设置本选项之前必须保持有效. 设置后@ref AIOT_DLOPT_BODY_BUFFER_MAX_LEN 不再生效, 每次给出的body最大长度为缓冲区长度
+    *
+    * 数据类型: (aiot_download_body_buffer_t *) 默认值: 使用SDK内部的缓冲区
+    */
+    AIOT_DLOPT_BODY_BUFFER,
     AIOT_DLOPT_MAX
 } aiot_download_option_t;
 
@@ -647,6 +688,7 @@ int32_t aiot_download_recv(void *handle); /* 返回条件: 网络出错 | 校验
  * + `AIOT_DLOPT_RECV_HANDLER`: 用户告诉SDK, 当SDK收到固件内容的时候, 调用哪个用户函数来传出固件内容缓冲区
  * + `AIOT_DLOPT_NETWORK_CRED`: 可以配置是走HTTP还是走HTTPS下载固件内容
  * + `AIOT_DLOPT_BODY_BUFFER_MAX_LEN`: 这是个缓冲区的长度, SDK下载中, 每当填满这个长度就调用一次用户回调, 所以这里设置的越大, 下载越快, 内存开销也越大
+ * + `AIOT_DLOPT_BODY_BUFFER`: 由用户提供上述缓冲区, SDK将固件内容直接读入其中
  *
  * @param[in] handle download句柄
  * @param[in] option 配置选项, 更多信息请参考@ref aiot_download_option_t
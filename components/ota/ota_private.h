@@ -16,7 +16,7 @@ extern "C" {
 #define OTA_MODULE_NAME                      "OTA"
 #define DOWNLOAD_MODULE_NAME                 "DOWNLOAD"
 
-#define OTA_DEFAULT_DOWNLOAD_BUFLEN          (2 * 1024)
+#define OTA_DEFAULT_DOWNLOAD_BUFLEN          (16 * 1024)
 #define OTA_DEFAULT_DOWNLOAD_TIMEOUT_MS      (5 * 1000)
 
 #define OTA_FOTA_TOPIC                       "/ota/device/upgrade/+/+"
@@ -0,0 +1,686 @@
+/**
+ * @file aiot_http_api.c
+ * @brief HTTP模块实现, 其中包含了向物联网平台认证和上报数据的API接口
+ * @date 2019-12-27
+ *
+ * @copyright Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ *
+ */
+
+#include "core_http.h"
+#include "core_timer.h"
+
+static void _http_exec_inc(core_http_handle_t *http_handle)
+{
+    http_handle->sysdep->core_sysdep_mutex_lock(http_handle->data_mutex);
+    http_handle->exec_count++;
+    http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->data_mutex);
+}
+
+static void _http_exec_dec(core_http_handle_t *http_handle)
+{
+    http_handle->sysdep->core_sysdep_mutex_lock(http_handle->data_mutex);
+    http_handle->exec_count--;
+    http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->data_mutex);
+}
+
+/*
+ *  一次上报或认证从发出请求到读完应答都在report_mutex内完成, 应答只能按发送顺序逐个读取,
+ *  因此流水线计数, 合并缓冲区和token同一时刻只有一个线程在修改
+ */
+static void _http_report_lock(core_http_handle_t *http_handle)
+{
+    _http_exec_inc(http_handle);
+    http_handle->sysdep->core_sysdep_mutex_lock(http_handle->report_mutex);
+}
+
+static void _http_report_unlock(core_http_handle_t *http_handle)
+{
+    http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->report_mutex);
+    _http_exec_dec(http_handle);
+}
+
+/* 通知用户有count个上报请求丢失, error_code为丢失的原因 */
+static void _http_report_lost(core_http_handle_t *http_handle, uint32_t count, int32_t error_code)
+{
+    aiot_http_event_t event;
+
+    core_log1(http_handle->sysdep, STATE_HTTP_LOG_DISCONNECT, "%d report request(s) lost\r\n", &count);
+    if (http_handle->event_handler == NULL) {
+        return;
+    }
+    memset(&event, 0, sizeof(aiot_http_event_t));
+    event.type = AIOT_HTTPEVT_REPORT_LOST;
+    event.data.report_lost.count = count;
+    event.data.report_lost.error_code = error_code;
+    http_handle->event_handler(http_handle, &event, http_handle->userdata);
+}
+
+/* 断开当前连接, 下一次发送时重新建连. 流水线中尚未收到应答的请求随之作废, 以error_code通知用户 */
+static void _http_disconnect(core_http_handle_t *http_handle, int32_t error_code)
+{
+    uint32_t lost_count = http_handle->pipeline_count;
+
+    if (http_handle->network_handle != NULL) {
+        http_handle->sysdep->core_sysdep_network_deinit(&http_handle->network_handle);
+    }
+    if (lost_count > 0) {
+        http_handle->pipeline_count = 0;
+        _http_report_lost(http_handle, lost_count, error_code);
+    }
+}
+
+/* 保存应答body的开头部分, 用于解析业务码和token */
+static void _http_response_save(core_http_handle_t *http_handle, const aiot_http_recv_t *packet)
+{
+    core_http_response_t *response = &http_handle->response;
+    uint32_t save_len = 0;
+
+    switch (packet->type) {
+        case AIOT_HTTPRECV_STATUS_CODE: {
+            response->code = packet->data.status_code.code;
+        }
+        break;
+        case AIOT_HTTPRECV_BODY: {
+            response->content_total_len = http_handle->session.body_total_len;
+            if (response->content == NULL) {
+                response->content = http_handle->sysdep->core_sysdep_malloc(CORE_HTTP_RESPONSE_MAX_LEN + 1,
+                                    CORE_HTTP_MODULE_NAME);
+                if (response->content == NULL) {
+                    return;
+                }
+            }
+            save_len = CORE_HTTP_RESPONSE_MAX_LEN - response->content_len;
+            if (save_len > packet->data.body.len) {
+                save_len = packet->data.body.len;
+            }
+            memcpy(response->content + response->content_len, packet->data.body.buffer, save_len);
+            response->content_len += save_len;
+            response->content[response->content_len] = '\0';
+        }
+        break;
+        default: {
+        }
+        break;
+    }
+}
+
+static void _http_auth_recv_handler(void *handle, const aiot_http_recv_t *packet, void *userdata)
+{
+    _http_response_save((core_http_handle_t *)handle, packet);
+}
+
+static void _http_recv_handler(void *handle, const aiot_http_recv_t *packet, void *userdata)
+{
+    core_http_handle_t *http_handle = (core_http_handle_t *)handle;
+
+    _http_response_save(http_handle, packet);
+    if (http_handle->recv_handler != NULL) {
+        http_handle->recv_handler(http_handle, packet, http_handle->userdata);
+    }
+}
+
+/*
+ *  接收流水线中最早的一个请求的完整应答, 返回body长度. 出错时应答已无法与请求对应, 断开连接;
+ *  服务端要求关闭连接或未使用长连接时, 读完应答后同样断开
+ */
+static int32_t _http_recv_response(core_http_handle_t *http_handle, uint32_t timeout_ms)
+{
+    int32_t res = STATE_SUCCESS;
+    uint32_t body_len = 0;
+    uint64_t timenow_ms = core_time_ms(http_handle->sysdep);
+
+    http_handle->response.code = 0;
+    http_handle->response.content_len = 0;
+    http_handle->response.content_total_len = 0;
+
+    while (1) {
+        if (core_time_ms(http_handle->sysdep) - timenow_ms >= timeout_ms) {
+            res = STATE_HTTP_RECV_NOT_FINISHED;
+            break;
+        }
+        res = core_http_recv(http_handle);
+        if (res == STATE_HTTP_READ_BODY_FINISHED || res == STATE_HTTP_READ_BODY_EMPTY) {
+            res = STATE_SUCCESS;
+            break;
+        } else if (res < STATE_SUCCESS) {
+            break;
+        }
+        body_len += res;
+    }
+
+    if (res < STATE_SUCCESS) {
+        _http_disconnect(http_handle, res);
+        return res;
+    }
+
+    if (http_handle->pipeline_count > 0) {
+        http_handle->pipeline_count--;
+    }
+    if (http_handle->keep_alive == 0 || http_handle->long_connection == 0) {
+        _http_disconnect(http_handle, STATE_HTTP_REPORT_LOST);
+    }
+
+    return (int32_t)body_len;
+}
+
+/* 上报请求的应答: token失效时丢弃缓存的token并通知用户, 之后的上报需要重新认证 */
+static int32_t _http_recv_report_response(core_http_handle_t *http_handle)
+{
+    int32_t res = STATE_SUCCESS;
+    char *code_str = NULL;
+    uint32_t code_len = 0, code = 0;
+
+    res = _http_recv_response(http_handle, http_handle->recv_timeout_ms);
+    if (res < STATE_SUCCESS || http_handle->response.content == NULL) {
+        return res;
+    }
+
+    if (core_json_value((char *)http_handle->response.content, http_handle->response.content_len, "code",
+                        (uint32_t)strlen("code"), &code_str, &code_len) < STATE_SUCCESS ||
+        core_str2uint(code_str, (uint8_t)code_len, &code) < STATE_SUCCESS) {
+        return res;
+    }
+
+    if (code == AIOT_HTTP_RSPCODE_TOKEN_EXPIRED || code == AIOT_HTTP_RSPCODE_TOKEN_NULL ||
+        code == AIOT_HTTP_RSPCODE_TOKEN_CHECK_ERROR) {
+        if (http_handle->token != NULL) {
+            http_handle->sysdep->core_sysdep_free(http_handle->token);
+            http_handle->token = NULL;
+        }
+        if (http_handle->event_handler != NULL) {
+            aiot_http_event_t event;
+
+            memset(&event, 0, sizeof(aiot_http_event_t));
+            event.type = AIOT_HTTPEVT_TOKEN_INVALID;
+            http_handle->event_handler(http_handle, &event, http_handle->userdata);
+        }
+    }
+
+    return res;
+}
+
+/* 流水线已满时先接收最早的应答, 然后在当前连接(必要时重新建连)上发出一个上报请求 */
+static int32_t _http_send_report(core_http_handle_t *http_handle, char *topic, uint8_t *payload, uint32_t payload_len)
+{
+    int32_t res = STATE_SUCCESS;
+    char *path = NULL, *header = NULL;
+    char *path_src[] = { topic };
+    char *header_src[] = { NULL };
+    core_http_request_t request;
+
+    while (http_handle->pipeline_count > 0 && (http_handle->pipeline_count >= http_handle->pipeline_max_count ||
+            http_handle->long_connection == 0)) {
+        res = _http_recv_report_response(http_handle);
+        if (res < STATE_SUCCESS) {
+            return res;
+        }
+    }
+
+    if (http_handle->token == NULL) {
+        return STATE_HTTP_NEED_AUTH;
+    }
+
+    if (http_handle->network_handle == NULL) {
+        res = core_http_connect(http_handle);
+        if (res < STATE_SUCCESS) {
+            return res;
+        }
+    }
+
+    header_src[0] = http_handle->token;
+    res = core_sprintf(http_handle->sysdep, &path, "/topic%s", path_src, sizeof(path_src) / sizeof(char *),
+                       CORE_HTTP_MODULE_NAME);
+    if (res < STATE_SUCCESS) {
+        return res;
+    }
+    res = core_sprintf(http_handle->sysdep, &header, "Content-Type: application/octet-stream\r\nPassword: %s\r\n",
+                       header_src, sizeof(header_src) / sizeof(char *), CORE_HTTP_MODULE_NAME);
+    if (res < STATE_SUCCESS) {
+        http_handle->sysdep->core_sysdep_free(path);
+        return res;
+    }
+
+    memset(&request, 0, sizeof(core_http_request_t));
+    request.method = "POST";
+    request.path = path;
+    request.header = header;
+    request.content = payload;
+    request.content_len = payload_len;
+
+    res = core_http_send(http_handle, &request);
+    http_handle->sysdep->core_sysdep_free(path);
+    http_handle->sysdep->core_sysdep_free(header);
+    if (res < STATE_SUCCESS) {
+        _http_disconnect(http_handle, res);
+        return res;
+    }
+    http_handle->pipeline_count++;
+
+    return STATE_SUCCESS;
+}
+
+/* 发出已合并的上报内容, 失败时保留, 以便认证或重连后再次发送 */
+static int32_t _http_batch_flush(core_http_handle_t *http_handle)
+{
+    int32_t res = STATE_SUCCESS;
+
+    if (http_handle->batch_len == 0) {
+        return STATE_SUCCESS;
+    }
+
+    res = _http_send_report(http_handle, http_handle->batch_topic, http_handle->batch_buffer, http_handle->batch_len);
+    if (res >= STATE_SUCCESS) {
+        http_handle->batch_len = 0;
+    }
+
+    return res;
+}
+
+/* 把消息拼接到待发送的内容中, topic不同或放不下时先发出已合并的内容 */
+static int32_t _http_batch_append(core_http_handle_t *http_handle, char *topic, uint8_t *payload, uint32_t payload_len)
+{
+    int32_t res = STATE_SUCCESS;
+
+    if (http_handle->batch_len > 0 && (strcmp(http_handle->batch_topic, topic) != 0 ||
+                                       http_handle->batch_len + 1 + payload_len > http_handle->batch_buffer_len)) {
+        res = _http_batch_flush(http_handle);
+        if (res < STATE_SUCCESS) {
+            return res;
+        }
+    }
+
+    if (http_handle->batch_len == 0) {
+        if (http_handle->batch_buffer_len != http_handle->batch_max_len) {
+            if (http_handle->batch_buffer != NULL) {
+                http_handle->sysdep->core_sysdep_free(http_handle->batch_buffer);
+                http_handle->batch_buffer_len = 0;
+            }
+            http_handle->batch_buffer = http_handle->sysdep->core_sysdep_malloc(http_handle->batch_max_len,
+                                        CORE_HTTP_MODULE_NAME);
+            if (http_handle->batch_buffer == NULL) {
+                return STATE_SYS_DEPEND_MALLOC_FAILED;
+            }
+            http_handle->batch_buffer_len = http_handle->batch_max_len;
+        }
+        if (http_handle->batch_topic == NULL || strcmp(http_handle->batch_topic, topic) != 0) {
+            res = core_strdup(http_handle->sysdep, &http_handle->batch_topic, topic, CORE_HTTP_MODULE_NAME);
+            if (res < STATE_SUCCESS) {
+                return res;
+            }
+        }
+    } else {
+        http_handle->batch_buffer[http_handle->batch_len++] = '\n';
+    }
+
+    memcpy(http_handle->batch_buffer + http_handle->batch_len, payload, payload_len);
+    http_handle->batch_len += payload_len;
+
+    return STATE_SUCCESS;
+}
+
+void *aiot_http_init(void)
+{
+    core_http_handle_t *http_handle = NULL;
+
+    http_handle = core_http_init();
+    if (http_handle == NULL) {
+        return NULL;
+    }
+
+    http_handle->port = CORE_HTTP_DEFAULT_PORT;
+    http_handle->auth_timeout_ms = CORE_HTTP_DEFAULT_AUTH_TIMEOUT_MS;
+    http_handle->long_connection = 1;
+    http_handle->pipeline_max_count = CORE_HTTP_DEFAULT_PIPELINE_MAX_COUNT;
+    http_handle->core_recv_handler = _http_recv_handler;
+
+    http_handle->report_mutex = http_handle->sysdep->core_sysdep_mutex_init();
+    if (http_handle->report_mutex == NULL) {
+        core_http_deinit((void **)&http_handle);
+        return NULL;
+    }
+
+    if (core_strdup(http_handle->sysdep, &http_handle->host, CORE_HTTP_DEFAULT_HOST, CORE_HTTP_MODULE_NAME) < STATE_SUCCESS) {
+        http_handle->sysdep->core_sysdep_mutex_deinit(&http_handle->report_mutex);
+        core_http_deinit((void **)&http_handle);
+        return NULL;
+    }
+
+    http_handle->exec_enabled = 1;
+
+    return http_handle;
+}
+
+int32_t aiot_http_setopt(void *handle, aiot_http_option_t option, void *data)
+{
+    int32_t res = STATE_SUCCESS;
+    core_http_handle_t *http_handle = (core_http_handle_t *)handle;
+
+    if (http_handle == NULL || data == NULL) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+
+    if (option >= AIOT_HTTPOPT_MAX) {
+        return STATE_USER_INPUT_OUT_RANGE;
+    }
+
+    if (http_handle->exec_enabled == 0) {
+        return STATE_USER_INPUT_EXEC_DISABLED;
+    }
+
+    /* 这部分选项与CORE_HTTPOPT_XXX共用 */
+    if (option <= AIOT_HTTPOPT_EVENT_HANDLER) {
+        return core_http_setopt(handle, (core_http_option_t)option, data);
+    }
+
+    _http_exec_inc(http_handle);
+
+    http_handle->sysdep->core_sysdep_mutex_lock(http_handle->data_mutex);
+    switch (option) {
+        case AIOT_HTTPOPT_USERDATA: {
+            http_handle->userdata = data;
+        }
+        break;
+        case AIOT_HTTPOPT_RECV_HANDLER: {
+            http_handle->recv_handler = (aiot_http_recv_handler_t)data;
+        }
+        break;
+        case AIOT_HTTPOPT_PRODUCT_KEY: {
+            res = core_strdup(http_handle->sysdep, &http_handle->product_key, (char *)data, CORE_HTTP_MODULE_NAME);
+        }
+        break;
+        case AIOT_HTTPOPT_DEVICE_NAME: {
+            res = core_strdup(http_handle->sysdep, &http_handle->device_name, (char *)data, CORE_HTTP_MODULE_NAME);
+        }
+        break;
+        case AIOT_HTTPOPT_DEVICE_SECRET: {
+            res = core_strdup(http_handle->sysdep, &http_handle->device_secret, (char *)data, CORE_HTTP_MODULE_NAME);
+        }
+        break;
+        case AIOT_HTTPOPT_EXTEND_DEVINFO: {
+            res = core_strdup(http_handle->sysdep, &http_handle->extend_devinfo, (char *)data, CORE_HTTP_MODULE_NAME);
+        }
+        break;
+        case AIOT_HTTPOPT_AUTH_TIMEOUT_MS: {
+            http_handle->auth_timeout_ms = *(uint32_t *)data;
+        }
+        break;
+        case AIOT_HTTPOPT_LONG_CONNECTION: {
+            http_handle->long_connection = *(uint8_t *)data;
+        }
+        break;
+        case AIOT_HTTPOPT_PIPELINE_MAX_COUNT: {
+            if (*(uint32_t *)data == 0) {
+                res = STATE_USER_INPUT_OUT_RANGE;
+                break;
+            }
+            http_handle->pipeline_max_count = *(uint32_t *)data;
+        }
+        break;
+        case AIOT_HTTPOPT_BATCH_MAX_LEN: {
+            http_handle->batch_max_len = *(uint32_t *)data;
+        }
+        break;
+        default: {
+            res = STATE_USER_INPUT_UNKNOWN_OPTION;
+        }
+        break;
+    }
+    http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->data_mutex);
+
+    _http_exec_dec(http_handle);
+
+    return res;
+}
+
+int32_t aiot_http_auth(void *handle)
+{
+    int32_t res = STATE_SUCCESS;
+    char *content = NULL, *value = NULL;
+    uint32_t value_len = 0, code = 0;
+    core_http_request_t request;
+    core_http_handle_t *http_handle = (core_http_handle_t *)handle;
+
+    if (http_handle == NULL) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+    if (http_handle->product_key == NULL) {
+        return STATE_USER_INPUT_MISSING_PRODUCT_KEY;
+    }
+    if (http_handle->device_name == NULL) {
+        return STATE_USER_INPUT_MISSING_DEVICE_NAME;
+    }
+    if (http_handle->device_secret == NULL) {
+        return STATE_USER_INPUT_MISSING_DEVICE_SECRET;
+    }
+    if (http_handle->exec_enabled == 0) {
+        return STATE_USER_INPUT_EXEC_DISABLED;
+    }
+
+    _http_report_lock(http_handle);
+
+    /* 流水线中尚未接收的应答先交给用户, 之后读到的才是认证请求的应答 */
+    while (http_handle->pipeline_count > 0) {
+        if (_http_recv_report_response(http_handle) < STATE_SUCCESS) {
+            break;
+        }
+    }
+
+    if (http_handle->network_handle == NULL) {
+        res = core_http_connect(http_handle);
+        if (res < STATE_SUCCESS) {
+            _http_report_unlock(http_handle);
+            return res;
+        }
+    }
+
+    res = core_auth_http_body(http_handle->sysdep, &content, http_handle->product_key, http_handle->device_name,
+                              http_handle->device_secret, CORE_HTTP_MODULE_NAME);
+    if (res < STATE_SUCCESS) {
+        _http_report_unlock(http_handle);
+        return res;
+    }
+
+    memset(&request, 0, sizeof(core_http_request_t));
+    request.method = "POST";
+    request.path = "/auth";
+    request.header = "Content-Type: application/json\r\n";
+    request.content = (uint8_t *)content;
+    request.content_len = (uint32_t)strlen(content);
+
+    http_handle->core_recv_handler = _http_auth_recv_handler;
+    res = core_http_send(http_handle, &request);
+    http_handle->sysdep->core_sysdep_free(content);
+    if (res < STATE_SUCCESS) {
+        http_handle->core_recv_handler = _http_recv_handler;
+        _http_disconnect(http_handle, res);
+        _http_report_unlock(http_handle);
+        return res;
+    }
+    /* 认证请求不计入流水线, 它的应答丢失时直接以返回值通知用户 */
+    res = _http_recv_response(http_handle, http_handle->auth_timeout_ms);
+    http_handle->core_recv_handler = _http_recv_handler;
+    if (res < STATE_SUCCESS) {
+        _http_report_unlock(http_handle);
+        return STATE_HTTP_AUTH_NOT_FINISHED;
+    }
+
+    if (http_handle->response.code != 200) {
+        _http_report_unlock(http_handle);
+        return STATE_HTTP_AUTH_CODE_FAILED;
+    }
+
+    if (http_handle->response.content == NULL ||
+        core_json_value((char *)http_handle->response.content, http_handle->response.content_len, "code",
+                        (uint32_t)strlen("code"), &value, &value_len) < STATE_SUCCESS ||
+        core_str2uint(value, (uint8_t)value_len, &code) < STATE_SUCCESS || code != AIOT_HTTP_RSPCODE_SUCCESS) {
+        _http_report_unlock(http_handle);
+        return STATE_HTTP_AUTH_NOT_EXPECTED;
+    }
+
+    if (core_json_value((char *)http_handle->response.content, http_handle->response.content_len, "token",
+                        (uint32_t)strlen("token"), &value, &value_len) < STATE_SUCCESS || value_len == 0) {
+        _http_report_unlock(http_handle);
+        return STATE_HTTP_AUTH_TOKEN_FAILED;
+    }
+
+    /* token在之后的上报中一直复用, 直到服务端应答token失效 */
+    http_handle->sysdep->core_sysdep_mutex_lock(http_handle->data_mutex);
+    if (http_handle->token != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->token);
+    }
+    http_handle->token = http_handle->sysdep->core_sysdep_malloc(value_len + 1, CORE_HTTP_MODULE_NAME);
+    if (http_handle->token == NULL) {
+        res = STATE_SYS_DEPEND_MALLOC_FAILED;
+    } else {
+        memcpy(http_handle->token, value, value_len);
+        http_handle->token[value_len] = '\0';
+        res = STATE_SUCCESS;
+    }
+    http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->data_mutex);
+
+    if (res == STATE_SUCCESS) {
+        core_log(http_handle->sysdep, STATE_HTTP_LOG_AUTH, "auth success\r\n");
+    }
+
+    _http_report_unlock(http_handle);
+
+    return res;
+}
+
+int32_t aiot_http_send(void *handle, char *topic, uint8_t *payload, uint32_t payload_len)
+{
+    int32_t res = STATE_SUCCESS;
+    core_http_handle_t *http_handle = (core_http_handle_t *)handle;
+
+    if (http_handle == NULL || topic == NULL || (payload == NULL && payload_len > 0)) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+    if (http_handle->exec_enabled == 0) {
+        return STATE_USER_INPUT_EXEC_DISABLED;
+    }
+    _http_report_lock(http_handle);
+
+    if (http_handle->token == NULL) {
+        _http_report_unlock(http_handle);
+        return STATE_HTTP_NEED_AUTH;
+    }
+
+    if (http_handle->batch_max_len > 0 && payload_len < http_handle->batch_max_len) {
+        res = _http_batch_append(http_handle, topic, payload, payload_len);
+    } else {
+        /* 先发出之前合并的内容, 保持上报顺序 */
+        res = _http_batch_flush(http_handle);
+        if (res >= STATE_SUCCESS) {
+            res = _http_send_report(http_handle, topic, payload, payload_len);
+        }
+    }
+
+    _http_report_unlock(http_handle);
+
+    return res;
+}
+
+int32_t aiot_http_flush(void *handle)
+{
+    int32_t res = STATE_SUCCESS;
+    core_http_handle_t *http_handle = (core_http_handle_t *)handle;
+
+    if (http_handle == NULL) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+    if (http_handle->exec_enabled == 0) {
+        return STATE_USER_INPUT_EXEC_DISABLED;
+    }
+
+    _http_report_lock(http_handle);
+    res = _http_batch_flush(http_handle);
+    _http_report_unlock(http_handle);
+
+    return res;
+}
+
+int32_t aiot_http_recv(void *handle)
+{
+    int32_t res = STATE_SUCCESS;
+    core_http_handle_t *http_handle = (core_http_handle_t *)handle;
+
+    if (http_handle == NULL) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+    if (http_handle->exec_enabled == 0) {
+        return STATE_USER_INPUT_EXEC_DISABLED;
+    }
+
+    _http_report_lock(http_handle);
+
+    res = _http_batch_flush(http_handle);
+    if (res >= STATE_SUCCESS && http_handle->pipeline_count > 0) {
+        res = _http_recv_report_response(http_handle);
+    }
+
+    _http_report_unlock(http_handle);
+
+    return res;
+}
+
+int32_t aiot_http_deinit(void **p_handle)
+{
+    int32_t res = STATE_SUCCESS;
+    uint64_t deinit_timestart = 0;
+    core_http_handle_t *http_handle = NULL;
+
+    if (p_handle == NULL || *p_handle == NULL) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+
+    http_handle = *(core_http_handle_t **)p_handle;
+
+    http_handle->exec_enabled = 0;
+    deinit_timestart = core_time_ms(http_handle->sysdep);
+    while (http_handle->exec_count != 0) {
+        if (core_time_ms(http_handle->sysdep) - deinit_timestart > http_handle->deinit_timeout_ms) {
+            return STATE_HTTP_DEINIT_TIMEOUT;
+        }
+        http_handle->sysdep->core_sysdep_sleep(CORE_HTTP_DEINIT_INTERVAL_MS);
+    }
+
+    /* 发出合并待发的内容并接收流水线中的应答, 未能发出或收不到应答的上报通过事件通知用户 */
+    res = _http_batch_flush(http_handle);
+    if (res < STATE_SUCCESS) {
+        _http_report_lost(http_handle, 1, res);
+    }
+    while (http_handle->pipeline_count > 0) {
+        if (_http_recv_report_response(http_handle) < STATE_SUCCESS) {
+            break;
+        }
+    }
+
+    if (http_handle->product_key != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->product_key);
+    }
+    if (http_handle->device_name != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->device_name);
+    }
+    if (http_handle->device_secret != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->device_secret);
+    }
+    if (http_handle->extend_devinfo != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->extend_devinfo);
+    }
+    if (http_handle->token != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->token);
+    }
+    if (http_handle->response.content != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->response.content);
+    }
+    if (http_handle->batch_buffer != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->batch_buffer);
+    }
+    if (http_handle->batch_topic != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->batch_topic);
+    }
+    http_handle->sysdep->core_sysdep_mutex_deinit(&http_handle->report_mutex);
+
+    return core_http_deinit(p_handle);
+}
@@ -161,7 +161,9 @@ typedef enum {
      *
      * @details
      *
-     * 数据类型: (uint32_t *) 默认值: 128
+     * 默认值足以在一次回调中给出物联网平台认证和上报的完整应答, 内存紧张的设备可以调小
+     *
+     * 数据类型: (uint32_t *) 默认值: 1024
      */
     AIOT_HTTPOPT_BODY_BUFFER_LEN,
     /**
@@ -251,6 +253,42 @@ typedef enum {
      * 数据类型: (uint8_t *) 默认值: (5 * 1000) ms
      */
     AIOT_HTTPOPT_LONG_CONNECTION,
+    /**
+     * @brief 同一连接上最多可以有多少个已发出但尚未接收应答的上报请求
+     *
+     * @details
+     *
+     * 默认不使用流水线, 需要用户显式设置大于1的值启用(pipelining): 连续调用 @ref aiot_http_send 不必等待上一个请求的应答.
+     * 未接收应答的请求数达到该值时, @ref aiot_http_send 会先接收最早的一个应答, 从 @ref aiot_http_recv_handler_t 输出后再发送新的请求.
+     * 应答按请求的发送顺序返回, 用户也可以随时调用 @ref aiot_http_recv 逐个接收
+     *
+     * 上报使用的POST不是幂等请求, RFC 7230 6.3.2节要求客户端不要流水线发送非幂等请求: 连接在流水线中途断开时(如应答中带有
+     * Connection: close), 无法知道之后已发出的请求是否已被服务端处理. 此时SDK不会自动重发, 而是通过 @ref AIOT_HTTPEVT_REPORT_LOST
+     * 事件通知丢失的请求数, 由用户决定是否重新上报. 只有业务能够容忍重复或丢失的消息时才应启用.
+     * @ref AIOT_HTTPOPT_LONG_CONNECTION 为0时不使用流水线
+     *
+     * 数据类型: (uint32_t *) 默认值: 1, 即收到应答后才发送下一个请求, 不使用流水线
+     */
+    AIOT_HTTPOPT_PIPELINE_MAX_COUNT,
+    /**
+     * @brief 合并上报时单个请求body的最大长度
+     *
+     * @details
+     *
+     * 大于0时, 连续上报到同一topic的消息以换行符分隔, 拼接后作为一个请求的body发出. 以下情况会发出已拼接的内容:
+     *
+     * 1. 再拼接本条消息会超过该长度
+     *
+     * 2. 本条消息的topic与已拼接消息的topic不同
+     *
+     * 3. 调用 @ref aiot_http_flush 或 @ref aiot_http_recv
+     *
+     * 服务端会将拼接后的内容作为一条消息处理, 因此只适用于按行解析的消息格式. 不短于该长度的消息不参与拼接, 直接上报.
+     * 每个合并后的请求只有一个应答. 销毁实例时会发出尚未发送的内容并接收其应答, 未能发出时通过 @ref AIOT_HTTPEVT_REPORT_LOST 事件通知
+     *
+     * 数据类型: (uint32_t *) 默认值: 0, 不合并
+     */
+    AIOT_HTTPOPT_BATCH_MAX_LEN,
 
     AIOT_HTTPOPT_MAX
 } aiot_http_option_t;
@@ -342,7 +380,12 @@ typedef enum {
     /**
      * @brief token无效事件, 此时用户应该调用 @ref aiot_http_auth 获取新的token
      */
-    AIOT_HTTPEVT_TOKEN_INVALID
+    AIOT_HTTPEVT_TOKEN_INVALID,
+    /**
+     * @brief 上报丢失事件, 流水线中已发出的请求因连接断开收不到应答, 或销毁实例时合并待发的内容未能发出.
+     * 服务端是否已处理这些请求无法确定, 用户需要按业务决定是否重新上报
+     */
+    AIOT_HTTPEVT_REPORT_LOST
 } aiot_http_event_type_t;
 
 /**
@@ -350,6 +393,24 @@ typedef enum {
  */
 typedef struct {
     aiot_http_event_type_t type;
+    /**
+     * @brief HTTP事件数据联合体
+     */
+    union {
+        /**
+         * @brief AIOT_HTTPEVT_REPORT_LOST
+         */
+        struct {
+            /**
+             * @brief 丢失的上报请求数, 合并发送时一个请求包含多条消息
+             */
+            uint32_t count;
+            /**
+             * @brief 导致丢失的原因, 为断开连接时的错误码, 服务端关闭连接时为STATE_HTTP_REPORT_LOST
+             */
+            int32_t error_code;
+        } report_lost;
+    } data;
 } aiot_http_event_t;
 
 /**
@@ -418,9 +479,28 @@ int32_t aiot_http_auth(void *handle);
  * @retval STATE_HTTP_HANDLE_IS_NULL, HTTP句柄为NULL
  * @retval STATE_USER_INPUT_OUT_RANGE, 用户输入参数无效
  * @retval STATE_HTTP_NOT_AUTH, 设备未认证
+ *
+ * @note
+ *
+ * 可以在多个线程中调用此函数, 同一实例上的上报, 认证和应答接收由内部加锁依次进行.
+ *
+ * 流水线已满时此函数会先接收应答, 因此不要在 @ref aiot_http_recv_handler_t 和 @ref aiot_http_event_handler_t 回调中调用本实例的收发接口
  */
 int32_t aiot_http_send(void *handle, char *topic, uint8_t *payload, uint32_t payload_len);
 
+/**
+ * @brief 发出通过 @ref AIOT_HTTPOPT_BATCH_MAX_LEN 合并后尚未发送的上报内容
+ *
+ * @param[in] handle HTTP句柄
+ *
+ * @return int32_t
+ *
+ * @retval STATE_SUCCESS, 发送成功或没有待发送的内容
+ * @retval STATE_USER_INPUT_NULL_POINTER, HTTP句柄为NULL
+ * @retval STATE_HTTP_NEED_AUTH, 设备未认证, 待发送的内容会保留到下一次发送
+ */
+int32_t aiot_http_flush(void *handle);
+
 /**
  * 服务器响应数据格式为
  * {
@@ -439,7 +519,7 @@ int32_t aiot_http_send(void *handle, char *topic, uint8_t *payload, uint32_t pay
  *
  * @return int32_t
  *
- * @retval >= 0, 接受到的HTTP body数据长度
+ * @retval >= 0, 接受到的HTTP body数据长度, 没有待接收的应答时为0
  * @retval STATE_HTTP_HANDLE_IS_NULL, HTTP句柄为NULL
  * @retval STATE_USER_INPUT_NULL_POINTER, 用户输入参数为NULL
  * @retval STATE_USER_INPUT_OUT_RANGE, buffer_len为0
@@ -449,6 +529,10 @@ int32_t aiot_http_send(void *handle, char *topic, uint8_t *payload, uint32_t pay
  * @retval STATE_HTTP_RECV_LINE_TOO_LONG, HTTP单行数据过长, 内部无法解析
  * @retval STATE_HTTP_PARSE_STATUS_LINE_FAILED, 无法解析状态码
  * @retval STATE_HTTP_GET_CONTENT_LEN_FAILED, 获取Content-Length失败
+ *
+ * @note
+ *
+ * 与 @ref aiot_http_send 相同, 回调函数在接收应答的过程中被调用, 其中不能再调用本实例的收发接口
  */
 int32_t aiot_http_recv(void *handle);
 
@@ -81,16 +81,18 @@ static void _core_mqtt_disconnect_event_notify(core_mqtt_handle_t *mqtt_handle,
 
 static void _core_mqtt_exec_inc(core_mqtt_handle_t *mqtt_handle)
 {
-    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->data_mutex);
-    mqtt_handle->exec_count++;
-    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
+    core_atomic_add(mqtt_handle->sysdep, mqtt_handle->data_mutex, &mqtt_handle->exec_count, 1);
 }
 
 static void _core_mqtt_exec_dec(core_mqtt_handle_t *mqtt_handle)
 {
-    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->data_mutex);
-    mqtt_handle->exec_count--;
-    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
+    if (core_atomic_add(mqtt_handle->sysdep, mqtt_handle->data_mutex, &mqtt_handle->exec_count, -1) == 0 &&
+        mqtt_handle->exec_enabled == 0) {
+        /* 持有data_mutex时唤醒, 避免aiot_mqtt_deinit检查计数后、开始等待前错过唤醒 */
+        mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->data_mutex);
+        core_cond_broadcast(mqtt_handle->sysdep, mqtt_handle->exec_cond);
+        mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
+    }
 }
 
 static void _core_mqtt_sign_clean(core_mqtt_handle_t *mqtt_handle)
@@ -289,9 +291,9 @@ static int32_t _core_mqtt_append_topic_map(core_mqtt_handle_t *mqtt_handle, aiot
     topic_buff.buffer = (uint8_t *)map->topic;
     topic_buff.len = strlen(map->topic);
 
-    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->sub_mutex);
+    core_rwlock_wrlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
     res = _core_mqtt_sublist_insert(mqtt_handle, &topic_buff, map->handler, map->userdata);
-    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->sub_mutex);
+    core_rwlock_unlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
 
     return res;
 }
@@ -315,9 +317,9 @@ static int32_t _core_mqtt_remove_topic_map(core_mqtt_handle_t *mqtt_handle, aiot
     topic_buff.buffer = (uint8_t *)map->topic;
     topic_buff.len = strlen(map->topic);
 
-    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->sub_mutex);
+    core_rwlock_wrlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
     _core_mqtt_sublist_remove_handler(mqtt_handle, &topic_buff, map->handler);
-    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->sub_mutex);
+    core_rwlock_unlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
 
     return STATE_SUCCESS;
 }
@@ -444,12 +446,13 @@ static int32_t _core_mqtt_connack_handle(core_mqtt_handle_t *mqtt_handle, uint8_
     return res;
 }
 
-static int32_t _core_mqtt_read(core_mqtt_handle_t *mqtt_handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms)
+static int32_t _core_mqtt_nwk_read(core_mqtt_handle_t *mqtt_handle, void *network_handle, uint8_t *buffer,
+                                   uint32_t len, uint32_t timeout_ms)
 {
     int32_t res = STATE_SUCCESS;
 
-    if (mqtt_handle->network_handle != NULL) {
-        res = mqtt_handle->sysdep->core_sysdep_network_recv(mqtt_handle->network_handle, buffer, len, timeout_ms, NULL);
+    if (network_handle != NULL) {
+        res = mqtt_handle->sysdep->core_sysdep_network_recv(network_handle, buffer, len, timeout_ms, NULL);
         if (res < STATE_SUCCESS) {
             res = _core_mqtt_sysdep_return(res, STATE_SYS_DEPEND_NWK_RECV_ERR);
         } else if (res != len) {
@@ -462,12 +465,13 @@ static int32_t _core_mqtt_read(core_mqtt_handle_t *mqtt_handle, uint8_t *buffer,
     return res;
 }
 
-static int32_t _core_mqtt_write(core_mqtt_handle_t *mqtt_handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms)
+static int32_t _core_mqtt_nwk_write(core_mqtt_handle_t *mqtt_handle, void *network_handle, uint8_t *buffer,
+                                    uint32_t len, uint32_t timeout_ms)
 {
     int32_t res = STATE_SUCCESS;
 
-    if (mqtt_handle->network_handle != NULL) {
-        res = mqtt_handle->sysdep->core_sysdep_network_send(mqtt_handle->network_handle, buffer, len, timeout_ms, NULL);
+    if (network_handle != NULL) {
+        res = mqtt_handle->sysdep->core_sysdep_network_send(network_handle, buffer, len, timeout_ms, NULL);
         if (res < STATE_SUCCESS) {
             res = _core_mqtt_sysdep_return(res, STATE_SYS_DEPEND_NWK_SEND_ERR);
         } else if (res != len) {
@@ -480,6 +484,41 @@ static int32_t _core_mqtt_write(core_mqtt_handle_t *mqtt_handle, uint8_t *buffer
     return res;
 }
 
+static int32_t _core_mqtt_nwk_read_remainlen(core_mqtt_handle_t *mqtt_handle, void *network_handle,
+        uint32_t *remainlen)
+{
+    int32_t res = 0;
+    uint8_t ch = 0;
+    uint32_t multiplier = 1;
+    uint32_t mqtt_remainlen = 0;
+
+    do {
+        res = _core_mqtt_nwk_read(mqtt_handle, network_handle, &ch, 1, mqtt_handle->recv_timeout_ms);
+        if (res < STATE_SUCCESS) {
+            return res;
+        }
+        mqtt_remainlen += (ch & 127) * multiplier;
+        if (multiplier > 128 * 128 * 128) {
+            return STATE_MQTT_MALFORMED_REMAINING_LEN;
+        }
+        multiplier *= 128;
+    } while ((ch & 128) != 0);
+
+    *remainlen = mqtt_remainlen;
+
+    return STATE_SUCCESS;
+}
+
+static int32_t _core_mqtt_read(core_mqtt_handle_t *mqtt_handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms)
+{
+    return _core_mqtt_nwk_read(mqtt_handle, mqtt_handle->network_handle, buffer, len, timeout_ms);
+}
+
+static int32_t _core_mqtt_write(core_mqtt_handle_t *mqtt_handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms)
+{
+    return _core_mqtt_nwk_write(mqtt_handle, mqtt_handle->network_handle, buffer, len, timeout_ms);
+}
+
 
 static void _core_mqtt_connect_diag(core_mqtt_handle_t *mqtt_handle, uint8_t flag)
 {
@@ -507,8 +546,6 @@ static void _core_mqtt_heartbeat_diag(core_mqtt_handle_t *mqtt_handle, uint8_t f
     core_diag(mqtt_handle->sysdep, STATE_MQTT_BASE, buf, sizeof(buf));
 }
 
-static int32_t _core_mqtt_read_remainlen(core_mqtt_handle_t *mqtt_handle, uint32_t *remainlen);
-
 static int32_t _core_mqtt_add_extend_clientid(core_mqtt_handle_t *channel_handle, char **dst_clientid, char *extend)
 {
     int32_t res = STATE_SUCCESS;
@@ -559,32 +596,24 @@ static int32_t _core_mqtt_add_netstats_extend(core_mqtt_handle_t *mqtt_handle, c
     return res;
 }
 
-static int32_t _core_mqtt_connect(core_mqtt_handle_t *mqtt_handle)
+static void _core_mqtt_connect_stage(core_mqtt_handle_t *mqtt_handle, core_mqtt_conn_stage_t stage)
+{
+    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->data_mutex);
+    mqtt_handle->conn_stage = stage;
+    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
+}
+
+/* PREPARE阶段: 持有data_mutex, 生成认证信息, 创建并配置新的network handle, 不做任何网络IO */
+static int32_t _core_mqtt_connect_prepare(core_mqtt_handle_t *mqtt_handle, void **network_handle)
 {
     int32_t res = 0;
     core_sysdep_socket_type_t socket_type = CORE_SYSDEP_SOCKET_TCP_CLIENT;
     char backup_ip[16] = {0};
-    uint8_t *conn_pkt = NULL;
-    uint8_t connack_fixed_header = 0;
-    uint8_t *connack_ptr = NULL;
-    uint32_t conn_pkt_len = 0;
-    char *secure_mode = (mqtt_handle->cred == NULL) ? ("3") : ("2");
-    uint32_t remain_len = 0;
 
     if (mqtt_handle->host == NULL) {
         return STATE_USER_INPUT_MISSING_HOST;
     }
 
-    if (mqtt_handle->security_mode != NULL) {
-        secure_mode = mqtt_handle->security_mode;
-    }
-
-    if (mqtt_handle->cred && \
-        mqtt_handle->cred->option == AIOT_SYSDEP_NETWORK_CRED_NONE && \
-        mqtt_handle->security_mode == NULL) {
-        secure_mode = "3";
-    }
-
     if (mqtt_handle->username == NULL || mqtt_handle->password == NULL ||
         mqtt_handle->clientid == NULL) {
         /* no valid username, password or clientid, check pk/dn/ds */
@@ -610,14 +639,8 @@ static int32_t _core_mqtt_connect(core_mqtt_handle_t *mqtt_handle)
         core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_USERNAME, "user name: %s\r\n", (void *)mqtt_handle->username);
     }
 
-    if (mqtt_handle->network_handle != NULL) {
-        mqtt_handle->sysdep->core_sysdep_network_deinit(&mqtt_handle->network_handle);
-    }
-
-    _core_mqtt_connect_diag(mqtt_handle, 0x00);
-
-    mqtt_handle->network_handle = mqtt_handle->sysdep->core_sysdep_network_init();
-    if (mqtt_handle->network_handle == NULL) {
+    *network_handle = mqtt_handle->sysdep->core_sysdep_network_init();
+    if (*network_handle == NULL) {
         return STATE_SYS_DEPEND_MALLOC_FAILED;
     }
 
@@ -625,25 +648,30 @@ static int32_t _core_mqtt_connect(core_mqtt_handle_t *mqtt_handle)
     if (strlen(backup_ip) > 0) {
         core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_BACKUP_IP, "%s\r\n", (void *)backup_ip);
     }
-    if ((res = mqtt_handle->sysdep->core_sysdep_network_setopt(mqtt_handle->network_handle, CORE_SYSDEP_NETWORK_SOCKET_TYPE,
+    if ((res = mqtt_handle->sysdep->core_sysdep_network_setopt(*network_handle, CORE_SYSDEP_NETWORK_SOCKET_TYPE,
                &socket_type)) < STATE_SUCCESS ||
-        (res = mqtt_handle->sysdep->core_sysdep_network_setopt(mqtt_handle->network_handle, CORE_SYSDEP_NETWORK_HOST,
+        (res = mqtt_handle->sysdep->core_sysdep_network_setopt(*network_handle, CORE_SYSDEP_NETWORK_HOST,
                 mqtt_handle->host)) < STATE_SUCCESS ||
-        (res = mqtt_handle->sysdep->core_sysdep_network_setopt(mqtt_handle->network_handle, CORE_SYSDEP_NETWORK_BACKUP_IP,
+        (res = mqtt_handle->sysdep->core_sysdep_network_setopt(*network_handle, CORE_SYSDEP_NETWORK_BACKUP_IP,
                 backup_ip)) < STATE_SUCCESS ||
-        (res = mqtt_handle->sysdep->core_sysdep_network_setopt(mqtt_handle->network_handle, CORE_SYSDEP_NETWORK_PORT,
+        (res = mqtt_handle->sysdep->core_sysdep_network_setopt(*network_handle, CORE_SYSDEP_NETWORK_PORT,
                 &mqtt_handle->port)) < STATE_SUCCESS ||
-        (res = mqtt_handle->sysdep->core_sysdep_network_setopt(mqtt_handle->network_handle,
+        (res = mqtt_handle->sysdep->core_sysdep_network_setopt(*network_handle,
                 CORE_SYSDEP_NETWORK_CONNECT_TIMEOUT_MS,
                 &mqtt_handle->connect_timeout_ms)) < STATE_SUCCESS) {
-        mqtt_handle->sysdep->core_sysdep_network_deinit(&mqtt_handle->network_handle);
         return _core_mqtt_sysdep_return(res, STATE_SYS_DEPEND_NWK_INVALID_OPTION);
     }
 
+    if (mqtt_handle->sockopt != NULL) {
+        if ((res = mqtt_handle->sysdep->core_sysdep_network_setopt(*network_handle, CORE_SYSDEP_NETWORK_SOCKOPT,
+                   mqtt_handle->sockopt)) < STATE_SUCCESS) {
+            return _core_mqtt_sysdep_return(res, STATE_SYS_DEPEND_NWK_INVALID_OPTION);
+        }
+    }
+
     if (mqtt_handle->cred != NULL) {
-        if ((res = mqtt_handle->sysdep->core_sysdep_network_setopt(mqtt_handle->network_handle, CORE_SYSDEP_NETWORK_CRED,
+        if ((res = mqtt_handle->sysdep->core_sysdep_network_setopt(*network_handle, CORE_SYSDEP_NETWORK_CRED,
                    mqtt_handle->cred)) < STATE_SUCCESS) {
-            mqtt_handle->sysdep->core_sysdep_network_deinit(&mqtt_handle->network_handle);
             return _core_mqtt_sysdep_return(res, STATE_SYS_DEPEND_NWK_INVALID_OPTION);
         }
         if (mqtt_handle->cred->option == AIOT_SYSDEP_NETWORK_CRED_SVRCERT_PSK) {
@@ -661,7 +689,7 @@ static int32_t _core_mqtt_connect(core_mqtt_handle_t *mqtt_handle)
             sysdep_psk.psk = psk;
             core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_TLS_PSK, "%s\r\n", sysdep_psk.psk_id);
             core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_TLS_PSK, "%s\r\n", sysdep_psk.psk);
-            res = mqtt_handle->sysdep->core_sysdep_network_setopt(mqtt_handle->network_handle, CORE_SYSDEP_NETWORK_PSK,
+            res = mqtt_handle->sysdep->core_sysdep_network_setopt(*network_handle, CORE_SYSDEP_NETWORK_PSK,
                     (void *)&sysdep_psk);
             mqtt_handle->sysdep->core_sysdep_free(psk_id);
             if (res < STATE_SUCCESS) {
@@ -671,66 +699,93 @@ static int32_t _core_mqtt_connect(core_mqtt_handle_t *mqtt_handle)
         mqtt_handle->nwkstats_info.network_type = (uint8_t)mqtt_handle->cred->option;
     }
 
+    return STATE_SUCCESS;
+}
+
+/* ESTABLISH阶段: 不持有任何锁, 完成DNS解析、TCP建连和TLS握手 */
+static int32_t _core_mqtt_connect_establish(core_mqtt_handle_t *mqtt_handle, void *network_handle)
+{
+    int32_t res = 0;
+    uint64_t time_start = core_time_ms(mqtt_handle->sysdep);
+
     /* network stats */
     mqtt_handle->nwkstats_info.connect_timestamp = mqtt_handle->sysdep->core_sysdep_time();
 
-    if ((res = mqtt_handle->sysdep->core_sysdep_network_establish(mqtt_handle->network_handle)) < STATE_SUCCESS) {
-        mqtt_handle->sysdep->core_sysdep_network_deinit(&mqtt_handle->network_handle);
+    if ((res = mqtt_handle->sysdep->core_sysdep_network_establish(network_handle)) < STATE_SUCCESS) {
         mqtt_handle->nwkstats_info.failed_timestamp = mqtt_handle->nwkstats_info.connect_timestamp;
         mqtt_handle->nwkstats_info.failed_error_code = res;
         last_failed_error_code = res;
         return _core_mqtt_sysdep_return(res, STATE_SYS_DEPEND_NWK_EST_FAILED);
     }
 
-    mqtt_handle->nwkstats_info.connect_time_used = mqtt_handle->sysdep->core_sysdep_time() \
-            - mqtt_handle->nwkstats_info.connect_timestamp;
+    mqtt_handle->nwkstats_info.connect_time_used = core_time_ms(mqtt_handle->sysdep) - time_start;
+
+    return STATE_SUCCESS;
+}
+
+/* PACKET阶段: 持有data_mutex, 生成clientid和CONNECT报文 */
+static int32_t _core_mqtt_connect_packet(core_mqtt_handle_t *mqtt_handle, uint8_t **conn_pkt, uint32_t *conn_pkt_len)
+{
+    int32_t res = 0;
+    char *secure_mode = (mqtt_handle->cred == NULL) ? ("3") : ("2");
+
+    if (mqtt_handle->security_mode != NULL) {
+        secure_mode = mqtt_handle->security_mode;
+    }
+
+    if (mqtt_handle->cred && \
+        mqtt_handle->cred->option == AIOT_SYSDEP_NETWORK_CRED_NONE && \
+        mqtt_handle->security_mode == NULL) {
+        secure_mode = "3";
+    }
 
     if (mqtt_handle->clientid == NULL) {
         char *extend_clientid = NULL;
         _core_mqtt_add_extend_clientid(mqtt_handle, &extend_clientid, mqtt_handle->extend_clientid);
         _core_mqtt_add_netstats_extend(mqtt_handle, &extend_clientid);
-        if (core_auth_mqtt_clientid(mqtt_handle->sysdep, &mqtt_handle->clientid, mqtt_handle->product_key,
-                                    mqtt_handle->device_name, secure_mode, extend_clientid,
-                                    CORE_MQTT_MODULE_NAME) < STATE_SUCCESS) {
-            _core_mqtt_sign_clean(mqtt_handle);
-            return res;
-        }
+        res = core_auth_mqtt_clientid(mqtt_handle->sysdep, &mqtt_handle->clientid, mqtt_handle->product_key,
+                                      mqtt_handle->device_name, secure_mode, extend_clientid,
+                                      CORE_MQTT_MODULE_NAME);
         if (extend_clientid != NULL) {
             mqtt_handle->sysdep->core_sysdep_free(extend_clientid);
         }
+        if (res < STATE_SUCCESS) {
+            _core_mqtt_sign_clean(mqtt_handle);
+            return res;
+        }
         core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_CLIENTID, "生成的Client ID: %s\r\n", (void *)mqtt_handle->clientid);
     }
+
     /* Get MQTT Connect Packet */
-    res = _core_mqtt_conn_pkt(mqtt_handle, &conn_pkt, &conn_pkt_len);
-    if (res < STATE_SUCCESS) {
-        return res;
-    }
+    return _core_mqtt_conn_pkt(mqtt_handle, conn_pkt, conn_pkt_len);
+}
+
+/* CONNACK阶段: 不持有任何锁, 在新的network handle上发送CONNECT报文并等待CONNACK */
+static int32_t _core_mqtt_connect_connack(core_mqtt_handle_t *mqtt_handle, void *network_handle, uint8_t *conn_pkt,
+        uint32_t conn_pkt_len)
+{
+    int32_t res = 0;
+    uint8_t connack_fixed_header = 0;
+    uint8_t connack[2] = {0};
+    uint32_t remain_len = 0;
 
     /* Send MQTT Connect Packet */
-    res = _core_mqtt_write(mqtt_handle, conn_pkt, conn_pkt_len, mqtt_handle->send_timeout_ms);
-    mqtt_handle->sysdep->core_sysdep_free(conn_pkt);
+    res = _core_mqtt_nwk_write(mqtt_handle, network_handle, conn_pkt, conn_pkt_len, mqtt_handle->send_timeout_ms);
     if (res < STATE_SUCCESS) {
         if (res == STATE_SYS_DEPEND_NWK_WRITE_LESSDATA) {
             core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_CONNECT_TIMEOUT, "MQTT connect packet send timeout: %d\r\n",
                       &mqtt_handle->send_timeout_ms);
-        } else {
-            if (mqtt_handle->network_handle != NULL) {
-                mqtt_handle->sysdep->core_sysdep_network_deinit(&mqtt_handle->network_handle);
-            }
         }
         return res;
     }
 
     /* Receive MQTT Connect ACK Fixed Header Byte */
-    res = _core_mqtt_read(mqtt_handle, &connack_fixed_header, CORE_MQTT_FIXED_HEADER_LEN, mqtt_handle->recv_timeout_ms);
+    res = _core_mqtt_nwk_read(mqtt_handle, network_handle, &connack_fixed_header, CORE_MQTT_FIXED_HEADER_LEN,
+                              mqtt_handle->recv_timeout_ms);
     if (res < STATE_SUCCESS) {
         if (res == STATE_SYS_DEPEND_NWK_READ_LESSDATA) {
             core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_CONNECT_TIMEOUT, "MQTT connack packet recv fixed header timeout: %d\r\n",
                       &mqtt_handle->recv_timeout_ms);
-        } else {
-            if (mqtt_handle->network_handle != NULL) {
-                mqtt_handle->sysdep->core_sysdep_network_deinit(&mqtt_handle->network_handle);
-            }
         }
         return res;
     }
@@ -740,7 +795,7 @@ static int32_t _core_mqtt_connect(core_mqtt_handle_t *mqtt_handle)
     }
 
     /* Receive MQTT Connect ACK remain len */
-    res = _core_mqtt_read_remainlen(mqtt_handle, &remain_len);
+    res = _core_mqtt_nwk_read_remainlen(mqtt_handle, network_handle, &remain_len);
     if (res < STATE_SUCCESS) {
         if (res == STATE_SYS_DEPEND_NWK_READ_LESSDATA) {
             core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_CONNECT_TIMEOUT, "MQTT connack packet recv remain len timeout: %d\r\n",
@@ -750,39 +805,104 @@ static int32_t _core_mqtt_connect(core_mqtt_handle_t *mqtt_handle)
     }
 
     /* Connack Format Error for Mqtt 3.1 */
-    if (remain_len != 0x2) {
+    if (remain_len != sizeof(connack)) {
         return STATE_MQTT_CONNACK_FMT_ERROR;
     }
 
-    connack_ptr = mqtt_handle->sysdep->core_sysdep_malloc(remain_len, CORE_MQTT_MODULE_NAME);
-    if (NULL == connack_ptr) {
-        return STATE_SYS_DEPEND_MALLOC_FAILED;
-    }
-    memset(connack_ptr, 0, remain_len);
-
     /* Receive MQTT Connect ACK Variable Header */
-    res = _core_mqtt_read(mqtt_handle, connack_ptr, remain_len, mqtt_handle->recv_timeout_ms);
-
+    res = _core_mqtt_nwk_read(mqtt_handle, network_handle, connack, remain_len, mqtt_handle->recv_timeout_ms);
     if (res < STATE_SUCCESS) {
         if (res == STATE_SYS_DEPEND_NWK_READ_LESSDATA) {
             core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_CONNECT_TIMEOUT,
                       "MQTT connack packet variable header recv timeout: %d\r\n",
                       &mqtt_handle->recv_timeout_ms);
         }
-        mqtt_handle->sysdep->core_sysdep_free(connack_ptr);
         return res;
     }
 
-    res = _core_mqtt_connack_handle(mqtt_handle, connack_ptr, remain_len);
-    mqtt_handle->sysdep->core_sysdep_free(connack_ptr);
+    return _core_mqtt_connack_handle(mqtt_handle, connack, remain_len);
+}
+
+/*
+ * 建连入口, 调用者不能持有data_mutex、send_mutex或recv_mutex
+ *
+ * 新连接在独立的network handle上完成建连, 期间mqtt_handle->network_handle保持不变(重连时为NULL),
+ * 因此aiot_mqtt_pub/aiot_mqtt_sub等接口不会被阻塞, 而是快速返回STATE_SYS_DEPEND_NWK_CLOSED
+ */
+static int32_t _core_mqtt_connect(core_mqtt_handle_t *mqtt_handle)
+{
+    int32_t res = 0;
+    void *network_handle = NULL;
+    uint8_t *conn_pkt = NULL;
+    uint32_t conn_pkt_len = 0;
+
+    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->data_mutex);
+    if (mqtt_handle->conn_stage != CORE_MQTT_CONN_STAGE_IDLE) {
+        mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
+        return STATE_MQTT_CONNECT_IN_PROGRESS;
+    }
+    mqtt_handle->conn_stage = CORE_MQTT_CONN_STAGE_PREPARE;
+    res = _core_mqtt_connect_prepare(mqtt_handle, &network_handle);
+    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
+    if (res < STATE_SUCCESS) {
+        goto exit;
+    }
+
+    _core_mqtt_connect_diag(mqtt_handle, 0x00);
+
+    _core_mqtt_connect_stage(mqtt_handle, CORE_MQTT_CONN_STAGE_ESTABLISH);
+    res = _core_mqtt_connect_establish(mqtt_handle, network_handle);
+    if (res < STATE_SUCCESS) {
+        goto exit;
+    }
+
+    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->data_mutex);
+    mqtt_handle->conn_stage = CORE_MQTT_CONN_STAGE_PACKET;
+    res = _core_mqtt_connect_packet(mqtt_handle, &conn_pkt, &conn_pkt_len);
+    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
+    if (res < STATE_SUCCESS) {
+        goto exit;
+    }
+
+    _core_mqtt_connect_stage(mqtt_handle, CORE_MQTT_CONN_STAGE_CONNACK);
+    res = _core_mqtt_connect_connack(mqtt_handle, network_handle, conn_pkt, conn_pkt_len);
+    mqtt_handle->sysdep->core_sysdep_free(conn_pkt);
     if (res < STATE_SUCCESS) {
+        goto exit;
+    }
+
+    /*
+     * SWAP阶段: CONNACK成功后才短暂持有send_mutex和recv_mutex, 替换network handle.
+     * 建连期间用户可能已调用aiot_mqtt_disconnect, 它关闭的是当时为NULL的旧handle, 此时需放弃新连接;
+     * aiot_mqtt_disconnect在置位标志后才获取这两把锁, 因此在锁内检查标志不会遗漏
+     */
+    _core_mqtt_connect_stage(mqtt_handle, CORE_MQTT_CONN_STAGE_SWAP);
+    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->send_mutex);
+    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->recv_mutex);
+    if (mqtt_handle->disconnect_api_called == 1) {
+        mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->recv_mutex);
+        mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->send_mutex);
+        res = STATE_MQTT_DISCONNECT_API_CALLED;
+        goto exit;
+    }
+    if (mqtt_handle->network_handle != NULL) {
         mqtt_handle->sysdep->core_sysdep_network_deinit(&mqtt_handle->network_handle);
-        return res;
     }
+    mqtt_handle->network_handle = network_handle;
+    network_handle = NULL;
+    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->recv_mutex);
+    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->send_mutex);
 
     _core_mqtt_connect_diag(mqtt_handle, 0x01);
+    res = STATE_MQTT_CONNECT_SUCCESS;
 
-    return STATE_MQTT_CONNECT_SUCCESS;
+exit:
+    if (network_handle != NULL) {
+        mqtt_handle->sysdep->core_sysdep_network_deinit(&network_handle);
+    }
+    _core_mqtt_connect_stage(mqtt_handle, CORE_MQTT_CONN_STAGE_IDLE);
+
+    return res;
 }
 
 static int32_t _core_mqtt_disconnect(core_mqtt_handle_t *mqtt_handle)
@@ -854,9 +974,13 @@ static int32_t _core_mqtt_publist_insert(core_mqtt_handle_t *mqtt_handle, uint8_
     memset(node->packet, 0, len);
     memcpy(node->packet, packet, len);
     node->len = len;
-    node->last_send_time = mqtt_handle->sysdep->core_sysdep_time();
+    node->last_send_time = core_time_ms(mqtt_handle->sysdep);
 
     core_list_add_tail(&node->linked_node, &mqtt_handle->pub_list);
+    if (!core_timer_active(&mqtt_handle->timer_service, &mqtt_handle->repub_timer)) {
+        core_timer_start_at(&mqtt_handle->timer_service, &mqtt_handle->repub_timer,
+                            node->last_send_time + mqtt_handle->repub_timeout_ms);
+    }
 
     return STATE_SUCCESS;
 }
@@ -980,18 +1104,13 @@ static int32_t _core_mqtt_heartbeat(core_mqtt_handle_t *mqtt_handle)
     return STATE_SUCCESS;
 }
 
-static int32_t _core_mqtt_repub(core_mqtt_handle_t *mqtt_handle)
+static int32_t _core_mqtt_repub(core_mqtt_handle_t *mqtt_handle, uint64_t time_now)
 {
     int32_t res = 0;
-    uint64_t time_now = 0;
     core_mqtt_pub_node_t *node = NULL;
 
     mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->pub_mutex);
     core_list_for_each_entry(node, &mqtt_handle->pub_list, linked_node, core_mqtt_pub_node_t) {
-        time_now = mqtt_handle->sysdep->core_sysdep_time();
-        if (time_now < node->last_send_time) {
-            node->last_send_time = time_now;
-        }
         if ((time_now - node->last_send_time) >= mqtt_handle->repub_timeout_ms) {
             mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->send_mutex);
             res = _core_mqtt_write(mqtt_handle, node->packet, node->len, mqtt_handle->send_timeout_ms);
@@ -1017,6 +1136,38 @@ static int32_t _core_mqtt_repub(core_mqtt_handle_t *mqtt_handle)
     return STATE_SUCCESS;
 }
 
+static void _core_mqtt_repub_timer_handler(core_timer_t *timer, uint64_t time_now_ms, void *userdata)
+{
+    core_mqtt_handle_t *mqtt_handle = (core_mqtt_handle_t *)userdata;
+    core_mqtt_pub_node_t *node = NULL;
+    uint64_t deadline = 0;
+
+    _core_mqtt_repub(mqtt_handle, time_now_ms);
+
+    /* 按最早需要重发的报文重新设置定时器, 列表为空时等待下一次插入 */
+    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->pub_mutex);
+    core_list_for_each_entry(node, &mqtt_handle->pub_list, linked_node, core_mqtt_pub_node_t) {
+        if (deadline == 0 || node->last_send_time + mqtt_handle->repub_timeout_ms < deadline) {
+            deadline = node->last_send_time + mqtt_handle->repub_timeout_ms;
+        }
+    }
+    if (deadline != 0) {
+        core_timer_start_at(&mqtt_handle->timer_service, timer, deadline);
+    }
+    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->pub_mutex);
+}
+
+static void _core_mqtt_heartbeat_timer_handler(core_timer_t *timer, uint64_t time_now_ms, void *userdata)
+{
+    core_mqtt_handle_t *mqtt_handle = (core_mqtt_handle_t *)userdata;
+
+    mqtt_handle->heartbeat_params.last_send_time = time_now_ms;
+    mqtt_handle->heartbeat_params.send_res = _core_mqtt_heartbeat(mqtt_handle);
+    mqtt_handle->heartbeat_params.lost_times++;
+
+    core_timer_start_at(&mqtt_handle->timer_service, timer, time_now_ms + mqtt_handle->heartbeat_params.interval_ms);
+}
+
 static int32_t _core_mqtt_process_datalist_insert(core_mqtt_handle_t *mqtt_handle,
         core_mqtt_process_data_t *process_data)
 {
@@ -1127,6 +1278,8 @@ static int32_t _core_mqtt_reconnect(core_mqtt_handle_t *mqtt_handle)
 {
     int32_t res = STATE_SYS_DEPEND_NWK_CLOSED;
     uint64_t time_now = 0;
+    uint8_t retry = 0;
+    uint32_t rand_value = 0;
     uint32_t interval_ms = mqtt_handle->reconnect_params.interval_ms;
     if (mqtt_handle->reconnect_params.backoff_enabled) {
         interval_ms = mqtt_handle->reconnect_params.interval_ms * (mqtt_handle->reconnect_params.reconnect_counter + 1) +
@@ -1138,26 +1291,38 @@ static int32_t _core_mqtt_reconnect(core_mqtt_handle_t *mqtt_handle)
     }
 
     mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->data_mutex);
-    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->send_mutex);
-    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->recv_mutex);
-    time_now = mqtt_handle->sysdep->core_sysdep_time();
-    if (time_now < mqtt_handle->reconnect_params.last_retry_time) {
-        mqtt_handle->reconnect_params.last_retry_time = time_now;
-    }
+    time_now = core_time_ms(mqtt_handle->sysdep);
     if (time_now >= (mqtt_handle->reconnect_params.last_retry_time + interval_ms)) {
-        core_log(mqtt_handle->sysdep, STATE_MQTT_LOG_RECONNECTING, "MQTT network disconnect, try to reconnecting...\r\n");
-        res = _core_mqtt_connect(mqtt_handle);
-        mqtt_handle->reconnect_params.last_retry_time = mqtt_handle->sysdep->core_sysdep_time();
-        if (mqtt_handle->reconnect_params.backoff_enabled) {
-            if (STATE_MQTT_CONNECT_SUCCESS == res) {
-                mqtt_handle->reconnect_params.reconnect_counter = 0;
-            } else if (mqtt_handle->reconnect_params.reconnect_counter < CORE_MQTT_DEFAULT_RECONN_MAX_COUNTERS) {
+        retry = 1;
+    }
+    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
+
+    if (retry == 0) {
+        return res;
+    }
+
+    /* 建连过程不持有data_mutex/send_mutex/recv_mutex, 其它线程的pub/sub会快速失败而不是被阻塞 */
+    core_log(mqtt_handle->sysdep, STATE_MQTT_LOG_RECONNECTING, "MQTT network disconnect, try to reconnecting...\r\n");
+    res = _core_mqtt_connect(mqtt_handle);
+    if (res == STATE_MQTT_CONNECT_IN_PROGRESS || res == STATE_MQTT_DISCONNECT_API_CALLED) {
+        return res;
+    }
+
+    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->data_mutex);
+    mqtt_handle->reconnect_params.last_retry_time = core_time_ms(mqtt_handle->sysdep);
+    if (mqtt_handle->reconnect_params.backoff_enabled) {
+        if (STATE_MQTT_CONNECT_SUCCESS == res) {
+            mqtt_handle->reconnect_params.reconnect_counter = 0;
+        } else {
+            if (mqtt_handle->reconnect_params.reconnect_counter < CORE_MQTT_DEFAULT_RECONN_MAX_COUNTERS) {
                 mqtt_handle->reconnect_params.reconnect_counter++;
             }
+            /* 每次失败后重新抽取随机偏移, 同时断线的设备不会在之后每一轮都对齐重连 */
+            mqtt_handle->sysdep->core_sysdep_rand((uint8_t *)&rand_value, sizeof(rand_value));
+            mqtt_handle->reconnect_params.rand_ms = rand_value % CORE_MQTT_DEFAULT_RECONN_RANDLIMIT_MS -
+                                                    CORE_MQTT_DEFAULT_RECONN_RANDLIMIT_MS / 2;
         }
     }
-    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->recv_mutex);
-    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->send_mutex);
     mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
 
     return res;
@@ -1165,26 +1330,7 @@ static int32_t _core_mqtt_reconnect(core_mqtt_handle_t *mqtt_handle)
 
 static int32_t _core_mqtt_read_remainlen(core_mqtt_handle_t *mqtt_handle, uint32_t *remainlen)
 {
-    int32_t res = 0;
-    uint8_t ch = 0;
-    uint32_t multiplier = 1;
-    uint32_t mqtt_remainlen = 0;
-
-    do {
-        res = _core_mqtt_read(mqtt_handle, &ch, 1, mqtt_handle->recv_timeout_ms);
-        if (res < STATE_SUCCESS) {
-            return res;
-        }
-        mqtt_remainlen += (ch & 127) * multiplier;
-        if (multiplier > 128 * 128 * 128) {
-            return STATE_MQTT_MALFORMED_REMAINING_LEN;
-        }
-        multiplier *= 128;
-    } while ((ch & 128) != 0);
-
-    *remainlen = mqtt_remainlen;
-
-    return STATE_SUCCESS;
+    return _core_mqtt_nwk_read_remainlen(mqtt_handle, mqtt_handle->network_handle, remainlen);
 }
 
 static int32_t _core_mqtt_read_remainbytes(core_mqtt_handle_t *mqtt_handle, uint32_t remainlen, uint8_t **output)
@@ -1217,8 +1363,7 @@ static int32_t _core_mqtt_read_remainbytes(core_mqtt_handle_t *mqtt_handle, uint
 static int32_t _core_mqtt_pingresp_handler(core_mqtt_handle_t *mqtt_handle, uint8_t *input, uint32_t len)
 {
     aiot_mqtt_recv_t packet;
-    uint64_t rtt = mqtt_handle->sysdep->core_sysdep_time()  \
-                   - mqtt_handle->heartbeat_params.last_send_time;
+    uint64_t rtt = core_time_ms(mqtt_handle->sysdep) - mqtt_handle->heartbeat_params.last_send_time;
 
     if (len != 0) {
         return STATE_MQTT_RECV_INVALID_PINRESP_PACKET;
@@ -1379,14 +1524,14 @@ static void _core_mqtt_call_user_handler(core_mqtt_handle_t *mqtt_handle, core_m
 
     /* Search Packet Handler In sublist */
     CORE_INIT_LIST_HEAD(&handler_list_copy);
-    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->sub_mutex);
+    core_rwlock_rdlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
     core_list_for_each_entry(sub_node, &mqtt_handle->sub_list, linked_node, core_mqtt_sub_node_t) {
         if (_core_mqtt_topic_compare(sub_node->topic, (uint32_t)(strlen(sub_node->topic)), packet.data.pub.topic,
                                      packet.data.pub.topic_len) == STATE_SUCCESS) {
             _core_mqtt_handlerlist_append(mqtt_handle, &handler_list_copy, &sub_node->handle_list, &sub_found);
         }
     }
-    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->sub_mutex);
+    core_rwlock_unlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
 
     core_list_for_each_entry(handler_node, &handler_list_copy,
                              linked_node, core_mqtt_sub_handler_node_t) {
@@ -1622,6 +1767,13 @@ void *aiot_mqtt_init(void)
     sysdep->core_sysdep_rand((uint8_t *)&rand_value, sizeof(rand_value));
     memset(mqtt_handle, 0, sizeof(core_mqtt_handle_t));
 
+    res = core_timer_service_init(&mqtt_handle->timer_service, sysdep);
+    if (res < STATE_SUCCESS) {
+        sysdep->core_sysdep_free(mqtt_handle);
+        core_global_deinit(sysdep);
+        return NULL;
+    }
+
     mqtt_handle->sysdep = sysdep;
     mqtt_handle->keep_alive_s = CORE_MQTT_DEFAULT_KEEPALIVE_S;
     mqtt_handle->clean_session = CORE_MQTT_DEFAULT_CLEAN_SESSION;
@@ -1643,7 +1795,8 @@ void *aiot_mqtt_init(void)
     mqtt_handle->data_mutex = sysdep->core_sysdep_mutex_init();
     mqtt_handle->send_mutex = sysdep->core_sysdep_mutex_init();
     mqtt_handle->recv_mutex = sysdep->core_sysdep_mutex_init();
-    mqtt_handle->sub_mutex = sysdep->core_sysdep_mutex_init();
+    mqtt_handle->sub_rwlock = core_rwlock_init(sysdep);
+    mqtt_handle->exec_cond = core_cond_init(sysdep);
     mqtt_handle->pub_mutex = sysdep->core_sysdep_mutex_init();
     mqtt_handle->process_handler_mutex = sysdep->core_sysdep_mutex_init();
 
@@ -1651,6 +1804,11 @@ void *aiot_mqtt_init(void)
     CORE_INIT_LIST_HEAD(&mqtt_handle->pub_list);
     CORE_INIT_LIST_HEAD(&mqtt_handle->process_data_list);
 
+    core_timer_init(&mqtt_handle->heartbeat_timer, _core_mqtt_heartbeat_timer_handler, mqtt_handle);
+    core_timer_init(&mqtt_handle->repub_timer, _core_mqtt_repub_timer_handler, mqtt_handle);
+    /* 与原先last_send_time为0时的行为一致, 首次process即发送心跳 */
+    core_timer_start_at(&mqtt_handle->timer_service, &mqtt_handle->heartbeat_timer, 0);
+
     mqtt_handle->exec_enabled = 1;
     mqtt_handle->topic_header_check = 1;
 
@@ -1748,8 +1906,26 @@ int32_t aiot_mqtt_setopt(void *handle, aiot_mqtt_option_t option, void *data)
             mqtt_handle->connect_timeout_ms = *(uint32_t *)data;
         }
         break;
+        case AIOT_MQTTOPT_NETWORK_SOCKOPT: {
+            if (mqtt_handle->sockopt != NULL) {
+                mqtt_handle->sysdep->core_sysdep_free(mqtt_handle->sockopt);
+                mqtt_handle->sockopt = NULL;
+            }
+            mqtt_handle->sockopt = mqtt_handle->sysdep->core_sysdep_malloc(sizeof(aiot_sysdep_network_sockopt_t),
+                                   CORE_MQTT_MODULE_NAME);
+            if (mqtt_handle->sockopt != NULL) {
+                memcpy(mqtt_handle->sockopt, data, sizeof(aiot_sysdep_network_sockopt_t));
+            } else {
+                res = STATE_SYS_DEPEND_MALLOC_FAILED;
+            }
+        }
+        break;
         case AIOT_MQTTOPT_HEARTBEAT_INTERVAL_MS: {
             mqtt_handle->heartbeat_params.interval_ms = *(uint32_t *)data;
+            if (mqtt_handle->heartbeat_params.last_send_time != 0) {
+                core_timer_start_at(&mqtt_handle->timer_service, &mqtt_handle->heartbeat_timer,
+                                    mqtt_handle->heartbeat_params.last_send_time + mqtt_handle->heartbeat_params.interval_ms);
+            }
         }
         break;
         case AIOT_MQTTOPT_HEARTBEAT_MAX_LOST: {
@@ -1778,6 +1954,10 @@ int32_t aiot_mqtt_setopt(void *handle, aiot_mqtt_option_t option, void *data)
         break;
         case AIOT_MQTTOPT_REPUB_TIMEOUT_MS: {
             mqtt_handle->repub_timeout_ms = *(uint32_t *)data;
+            /* 立即按新的超时时间重新计算下一次重发时间 */
+            if (core_timer_active(&mqtt_handle->timer_service, &mqtt_handle->repub_timer)) {
+                core_timer_start_at(&mqtt_handle->timer_service, &mqtt_handle->repub_timer, 0);
+            }
         }
         break;
         case AIOT_MQTTOPT_DEINIT_TIMEOUT_MS: {
@@ -1838,7 +2018,7 @@ int32_t aiot_mqtt_setopt(void *handle, aiot_mqtt_option_t option, void *data)
 
 int32_t aiot_mqtt_deinit(void **handle)
 {
-    uint64_t deinit_timestart = 0;
+    uint64_t deinit_timestart = 0, time_now = 0;
     core_mqtt_handle_t *mqtt_handle = NULL;
     core_mqtt_event_t core_event;
 
@@ -1853,13 +2033,18 @@ int32_t aiot_mqtt_deinit(void **handle)
     }
 
     mqtt_handle->exec_enabled = 0;
-    deinit_timestart = mqtt_handle->sysdep->core_sysdep_time();
-    do {
-        if (mqtt_handle->exec_count == 0) {
+    deinit_timestart = core_time_ms(mqtt_handle->sysdep);
+    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->data_mutex);
+    /* core_atomic_add退化实现也持有data_mutex, 此处直接读取计数 */
+    while (mqtt_handle->exec_count != 0) {
+        time_now = core_time_ms(mqtt_handle->sysdep);
+        if (time_now - deinit_timestart >= mqtt_handle->deinit_timeout_ms) {
             break;
         }
-        mqtt_handle->sysdep->core_sysdep_sleep(CORE_MQTT_DEINIT_INTERVAL_MS);
-    } while ((mqtt_handle->sysdep->core_sysdep_time() - deinit_timestart) < mqtt_handle->deinit_timeout_ms);
+        core_cond_wait(mqtt_handle->sysdep, mqtt_handle->exec_cond, mqtt_handle->data_mutex,
+                       (uint32_t)(mqtt_handle->deinit_timeout_ms - (time_now - deinit_timestart)));
+    }
+    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->data_mutex);
 
     if (mqtt_handle->exec_count != 0) {
         return STATE_MQTT_DEINIT_TIMEOUT;
@@ -1904,14 +2089,19 @@ int32_t aiot_mqtt_deinit(void **handle)
     if (mqtt_handle->cred != NULL) {
         mqtt_handle->sysdep->core_sysdep_free(mqtt_handle->cred);
     }
+    if (mqtt_handle->sockopt != NULL) {
+        mqtt_handle->sysdep->core_sysdep_free(mqtt_handle->sockopt);
+    }
 
     mqtt_handle->sysdep->core_sysdep_mutex_deinit(&mqtt_handle->data_mutex);
     mqtt_handle->sysdep->core_sysdep_mutex_deinit(&mqtt_handle->send_mutex);
     mqtt_handle->sysdep->core_sysdep_mutex_deinit(&mqtt_handle->recv_mutex);
-    mqtt_handle->sysdep->core_sysdep_mutex_deinit(&mqtt_handle->sub_mutex);
+    core_rwlock_deinit(mqtt_handle->sysdep, &mqtt_handle->sub_rwlock);
+    core_cond_deinit(mqtt_handle->sysdep, &mqtt_handle->exec_cond);
     mqtt_handle->sysdep->core_sysdep_mutex_deinit(&mqtt_handle->pub_mutex);
     mqtt_handle->sysdep->core_sysdep_mutex_deinit(&mqtt_handle->process_handler_mutex);
 
+    core_timer_service_deinit(&mqtt_handle->timer_service);
     _core_mqtt_sublist_destroy(mqtt_handle);
     _core_mqtt_publist_destroy(mqtt_handle);
     _core_mqtt_process_datalist_destroy(mqtt_handle);
@@ -1933,7 +2123,7 @@ int32_t aiot_mqtt_connect(void *handle)
         return STATE_USER_INPUT_NULL_POINTER;
     }
 
-    time_ent_ms = mqtt_handle->sysdep->core_sysdep_time();
+    time_ent_ms = core_time_ms(mqtt_handle->sysdep);
 
     if (mqtt_handle->exec_enabled == 0) {
         return STATE_USER_INPUT_EXEC_DISABLED;
@@ -1947,20 +2137,23 @@ int32_t aiot_mqtt_connect(void *handle)
     core_log(mqtt_handle->sysdep, STATE_MQTT_LOG_CONNECT, "MQTT user calls aiot_mqtt_connect api, connect\r\n");
     mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->send_mutex);
     mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->recv_mutex);
-
-    res = _core_mqtt_connect(mqtt_handle);
-
+    if (mqtt_handle->network_handle != NULL) {
+        mqtt_handle->sysdep->core_sysdep_network_deinit(&mqtt_handle->network_handle);
+    }
     mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->recv_mutex);
     mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->send_mutex);
 
+    res = _core_mqtt_connect(mqtt_handle);
+
     if (res == STATE_MQTT_CONNECT_SUCCESS) {
-        uint64_t time_ms = mqtt_handle->sysdep->core_sysdep_time();
+        uint64_t time_ms = core_time_ms(mqtt_handle->sysdep);
         uint32_t time_delta = (uint32_t)(time_ms - time_ent_ms);
 
         core_log1(mqtt_handle->sysdep, STATE_MQTT_LOG_CONNECT, "MQTT connect success in %d ms\r\n", (void *)&time_delta);
         _core_mqtt_connect_event_notify(mqtt_handle);
         res = STATE_SUCCESS;
-    } else {
+    } else if (res != STATE_MQTT_CONNECT_IN_PROGRESS && res != STATE_MQTT_DISCONNECT_API_CALLED) {
+        /* 另一个建连流程仍在进行, 或aiot_mqtt_disconnect已经通知过断连, 这两种情况不再通知 */
         last_failed_error_code = res;
         _core_mqtt_disconnect_event_notify(mqtt_handle, AIOT_MQTTDISCONNEVT_NETWORK_DISCONNECT);
     }
@@ -2020,7 +2213,6 @@ int32_t aiot_mqtt_heartbeat(void *handle)
 int32_t aiot_mqtt_process(void *handle)
 {
     int32_t res = STATE_SUCCESS;
-    uint64_t time_now = 0;
     core_mqtt_handle_t *mqtt_handle = (core_mqtt_handle_t *)handle;
 
     if (mqtt_handle == NULL) {
@@ -2032,19 +2224,10 @@ int32_t aiot_mqtt_process(void *handle)
 
     _core_mqtt_exec_inc(mqtt_handle);
 
-    /* mqtt PINREQ packet */
-    time_now = mqtt_handle->sysdep->core_sysdep_time();
-    if (time_now < mqtt_handle->heartbeat_params.last_send_time) {
-        mqtt_handle->heartbeat_params.last_send_time = time_now;
-    }
-    if ((time_now - mqtt_handle->heartbeat_params.last_send_time) >= mqtt_handle->heartbeat_params.interval_ms) {
-        res = _core_mqtt_heartbeat(mqtt_handle);
-        mqtt_handle->heartbeat_params.last_send_time = time_now;
-        mqtt_handle->heartbeat_params.lost_times++;
-    }
-
-    /* mqtt QoS1 packet republish */
-    _core_mqtt_repub(mqtt_handle);
+    /* mqtt PINREQ packet and QoS1 packet republish, driven by timer service */
+    mqtt_handle->heartbeat_params.send_res = STATE_SUCCESS;
+    core_timer_process(&mqtt_handle->timer_service);
+    res = mqtt_handle->heartbeat_params.send_res;
 
     /* mqtt process handler process */
     _core_mqtt_process_data_process(mqtt_handle, NULL);
@@ -2299,11 +2482,12 @@ static int32_t _core_mqtt_sub(void *handle, core_mqtt_buff_t *topic, aiot_mqtt_r
 
     core_log2(mqtt_handle->sysdep, STATE_MQTT_LOG_TOPIC, "sub: %.*s\r\n", &topic->len, topic->buffer);
 
-    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->sub_mutex);
+    core_rwlock_wrlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
     res = _core_mqtt_sublist_insert(mqtt_handle, topic, handler, userdata);
-    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->sub_mutex);
+    core_rwlock_unlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
 
     if (res < STATE_SUCCESS) {
+        _core_mqtt_exec_dec(mqtt_handle);
         return res;
     }
 
@@ -2357,9 +2541,9 @@ static int32_t _core_mqtt_unsub(void *handle, core_mqtt_buff_t *topic)
 
     core_log2(mqtt_handle->sysdep, STATE_MQTT_LOG_TOPIC, "unsub: %.*s\r\n", &topic->len, topic->buffer);
 
-    mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->sub_mutex);
+    core_rwlock_wrlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
     _core_mqtt_sublist_remove(mqtt_handle, topic);
-    mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->sub_mutex);
+    core_rwlock_unlock(mqtt_handle->sysdep, mqtt_handle->sub_rwlock);
 
     res = _core_mqtt_subunsub(mqtt_handle, (char *)topic->buffer, topic->len, 0, CORE_MQTT_UNSUB_PKT_TYPE);
 
@@ -2433,9 +2617,12 @@ int32_t aiot_mqtt_recv(void *handle)
                       &mqtt_handle->heartbeat_params.lost_times);
             mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->send_mutex);
             mqtt_handle->sysdep->core_sysdep_mutex_lock(mqtt_handle->recv_mutex);
-            res = _core_mqtt_connect(mqtt_handle);
+            if (mqtt_handle->network_handle != NULL) {
+                mqtt_handle->sysdep->core_sysdep_network_deinit(&mqtt_handle->network_handle);
+            }
             mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->recv_mutex);
             mqtt_handle->sysdep->core_sysdep_mutex_unlock(mqtt_handle->send_mutex);
+            res = _core_mqtt_connect(mqtt_handle);
             if (res < STATE_SUCCESS) {
                 if (res == STATE_MQTT_CONNECT_SUCCESS) {
                     mqtt_handle->heartbeat_params.lost_times = 0;
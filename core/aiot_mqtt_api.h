@@ -568,6 +568,18 @@ typedef enum {
     */
     AIOT_MQTTOPT_TOPIC_HEADER_CHECK,
 
+    /**
+    * @brief MQTT建联时使用的socket调优参数
+    *
+    * @details
+    *
+    * 如关闭Nagle算法使PUBACK/PINGREQ等小报文立即发出, 设置TCP_USER_TIMEOUT以便比心跳更快地发现断链,
+    * 设置DSCP等, 各字段含义见@ref aiot_sysdep_network_sockopt_t . 在下一次建联(包括断线重连)时生效
+    *
+    * 数据类型: (aiot_sysdep_network_sockopt_t *) 默认值: 全部使用系统默认值
+    */
+    AIOT_MQTTOPT_NETWORK_SOCKOPT,
+
     AIOT_MQTTOPT_MAX
 } aiot_mqtt_option_t;
 
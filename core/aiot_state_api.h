@@ -168,6 +168,12 @@ int32_t aiot_state_set_logcb(aiot_state_logcb_t handler);
  */
 #define STATE_SYS_DEPEND_NWK_RECV_ERR                               (-0x020A)
 
+/**
+ * @brief portfile未实现SDK所需的可选接口
+ *
+ */
+#define STATE_SYS_DEPEND_NOT_SUPPORTED                              (-0x020B)
+
 /**
  * @brief -0x0300~-0x03FF表达SDK在MQTT模块内的状态码
  *
@@ -366,6 +372,18 @@ int32_t aiot_state_set_logcb(aiot_state_logcb_t handler);
  */
 #define STATE_MQTT_RECV_INVALID_PUBACK_PACKET                       (-0x0320)
 
+/**
+ * @brief 已有建连/重连流程正在执行, 本次建连请求被忽略
+ *
+ */
+#define STATE_MQTT_CONNECT_IN_PROGRESS                              (-0x0321)
+
+/**
+ * @brief 建连/重连过程中用户调用了@ref aiot_mqtt_disconnect, 新建立的连接被关闭而不再启用
+ *
+ */
+#define STATE_MQTT_DISCONNECT_API_CALLED                            (-0x0322)
+
 /**
  * @brief MQTT连接服务器时, 使用的host的日志状态码
  *
@@ -486,6 +504,12 @@ int32_t aiot_state_set_logcb(aiot_state_logcb_t handler);
  */
 #define STATE_HTTP_READ_BODY_EMPTY                                  (-0x0412)
 
+/**
+ * @brief 已发出的上报请求因连接断开收不到应答, 或合并待发的上报内容在销毁实例时未能发出, 这些上报需要用户重新发送
+ *
+ */
+#define STATE_HTTP_REPORT_LOST                                      (-0x0413)
+
 /**
  * @brief -0x0F00~-0x0FFF表达SDK在系统底层依赖模块内的状态码
  *
@@ -732,6 +756,18 @@ int32_t aiot_state_set_logcb(aiot_state_logcb_t handler);
  */
 #define STATE_QOS_CACHE_EXCEEDS_LIMIT                               (-0x0F28)
 
+/**
+ * @brief 分步建立TLS连接时握手尚未完成, 需等待socket可读后再次调用
+ *
+ */
+#define STATE_PORT_TLS_HANDSHAKE_WANT_READ                          (-0x0F29)
+
+/**
+ * @brief 分步建立TLS连接时握手尚未完成, 需等待socket可写后再次调用
+ *
+ */
+#define STATE_PORT_TLS_HANDSHAKE_WANT_WRITE                         (-0x0F2A)
+
 /**
  * @brief core_adapter适配模块
  *
@@ -36,6 +36,25 @@ typedef struct {
     char         *tls_extend_info;
 } aiot_sysdep_network_cred_t;
 
+/**
+ * @brief socket调优参数, 各字段为0时保持系统默认值
+ *
+ * @details
+ *
+ * 在建立连接前设置到socket上, 当前平台不支持的项会被忽略. TLS连接在握手期间总是关闭Nagle算法, 握手结束后按tcp_nodelay设置
+ */
+typedef struct {
+    uint8_t       tcp_nodelay;          /* 为1时关闭Nagle算法(TCP_NODELAY), 小报文(PUBACK/PINGREQ等)立即发出 */
+    uint32_t      send_buffer_size;     /* 发送缓冲区大小(SO_SNDBUF), 单位字节 */
+    uint32_t      recv_buffer_size;     /* 接收缓冲区大小(SO_RCVBUF), 单位字节 */
+    uint8_t       keepalive_enabled;    /* 为1时开启TCP keepalive(SO_KEEPALIVE) */
+    uint32_t      keepalive_idle_s;     /* 连接空闲多久后开始探测(TCP_KEEPIDLE), 单位秒 */
+    uint32_t      keepalive_interval_s; /* 探测间隔(TCP_KEEPINTVL), 单位秒 */
+    uint32_t      keepalive_count;      /* 探测失败多少次后断开(TCP_KEEPCNT) */
+    uint32_t      tcp_user_timeout_ms;  /* 已发送数据多久未被确认即断开(TCP_USER_TIMEOUT), 单位毫秒 */
+    uint8_t       ip_tos;               /* IP_TOS/IPV6_TCLASS字节, DSCP值需左移2位, 如EF(46)为0xB8 */
+} aiot_sysdep_network_sockopt_t;
+
 typedef enum {
     CORE_SYSDEP_SOCKET_TCP_CLIENT,
     CORE_SYSDEP_SOCKET_TCP_SERVER,
@@ -56,6 +75,7 @@ typedef enum {
     CORE_SYSDEP_NETWORK_CONNECT_TIMEOUT_MS,      /* 建立网络连接的超时时间  数据类型: (uint32_t *) */
     CORE_SYSDEP_NETWORK_CRED,                    /* 用于设置网络层安全参数  数据类型: (aiot_sysdep_network_cred_t *) */
     CORE_SYSDEP_NETWORK_PSK,                     /* 用于配合PSK模式下的psk-id和psk  数据类型: (core_sysdep_psk_t *) */
+    CORE_SYSDEP_NETWORK_SOCKOPT,                 /* socket调优参数, 建立连接时生效  数据类型: (aiot_sysdep_network_sockopt_t *) */
     CORE_SYSDEP_NETWORK_MAX
 } core_sysdep_network_option_t;
 
@@ -64,6 +84,51 @@ typedef struct {
     uint16_t port; /* 端口号 */
 } core_sysdep_addr_t;
 
+/* 模块名的最大长度(含结束符), 超出部分会被截断 */
+#define AIOT_SYSDEP_MEM_MODULE_NAME_MAXLEN  (16)
+
+/**
+ * @brief 单个模块的内存使用统计, 模块即调用@ref aiot_sysdep_portfile_t::core_sysdep_malloc 时传入的name
+ */
+typedef struct {
+    char module[AIOT_SYSDEP_MEM_MODULE_NAME_MAXLEN];
+    uint64_t live_bytes;    /* 当前持有的内存字节数, 按申请大小计算 */
+    uint64_t peak_bytes;    /* live_bytes的历史峰值 */
+    uint64_t live_count;    /* 当前未释放的内存块个数 */
+    uint64_t total_count;   /* 累计申请次数 */
+    uint64_t failed_count;  /* 累计申请失败次数 */
+} aiot_sysdep_mem_stats_t;
+
+/**
+ * @brief TLS握手统计, 会话复用率为resumed_handshake_count / (resumed_handshake_count + full_handshake_count)
+ */
+typedef struct {
+    uint64_t full_handshake_count;      /* 完整握手成功的次数, 含提供了缓存会话但服务端未接受的情况 */
+    uint64_t resumed_handshake_count;   /* 复用缓存会话, 以简化握手成功的次数 */
+    uint64_t resume_rejected_count;     /* 提供了缓存会话但服务端要求完整握手的次数 */
+    uint64_t failed_handshake_count;    /* 握手失败的次数 */
+    uint64_t full_handshake_time_us;    /* 完整握手的累计耗时 */
+    uint64_t resumed_handshake_time_us; /* 简化握手的累计耗时 */
+    uint32_t cached_session_count;      /* 当前缓存的会话个数 */
+} aiot_sysdep_tls_stats_t;
+
+/* 连接统计中主机名的最大长度(含结束符), 超出部分会被截断 */
+#define AIOT_SYSDEP_TLS_CONN_HOST_MAXLEN    (64)
+
+/**
+ * @brief 单个已建立的TLS连接的记录缓冲区占用, 缓冲区随收发的记录大小增长, 空闲后缩回
+ */
+typedef struct {
+    char host[AIOT_SYSDEP_TLS_CONN_HOST_MAXLEN];
+    uint16_t port;
+    uint32_t in_buf_len;    /* 当前接收缓冲区字节数 */
+    uint32_t out_buf_len;   /* 当前发送缓冲区字节数 */
+    uint32_t peak_buf_len;  /* 建连以来in_buf_len + out_buf_len的峰值, 不含握手期间 */
+    uint32_t handshake_peak_bytes;  /* 握手期间mbedtls净申请内存的峰值 */
+    uint32_t handshake_alloc_count; /* 握手期间mbedtls申请内存的次数 */
+    uint32_t handshake_reuse_count; /* 其中由连接自己的握手内存池满足, 未经过core_sysdep_malloc的次数 */
+} aiot_sysdep_tls_conn_stats_t;
+
 /* 这不是一个面向用户的编译配置开关, 多数情况下, 不必用户关心 */
 
 /**
@@ -101,11 +166,17 @@ typedef struct {
     int32_t (*core_sysdep_network_establish)(void *handle);
     /**
      * @brief 从指定的网络会话上读取
+     * @details
+     *
+     * timeout_ms为0时只读取已到达的数据, 不等待
      */
     int32_t (*core_sysdep_network_recv)(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
                                         core_sysdep_addr_t *addr);
     /**
      * @brief 在指定的网络会话上发送
+     * @details
+     *
+     * timeout_ms为0时只写入socket当前能接受的数据, 不等待
      */
     int32_t (*core_sysdep_network_send)(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
                                         core_sysdep_addr_t *addr);
@@ -133,11 +204,148 @@ typedef struct {
      * @brief 销毁互斥锁
      */
     void (*core_sysdep_mutex_deinit)(void **mutex);
+    /**
+     * @brief 可选, 获取单调递增的纳秒时间戳, 不受系统时间调整影响, SDK用于超时与耗时计算
+     *
+     * @details
+     *
+     * 为NULL时SDK使用core_sysdep_time计算超时
+     */
+    uint64_t (*core_sysdep_time_ns)(void);
+    /**
+     * @brief 可选, 按模块获取内存使用统计
+     *
+     * @details
+     *
+     * 最多填充max_count个模块的统计到stats, 返回实际的模块个数; 为NULL时表示portfile不统计内存
+     */
+    int32_t (*core_sysdep_mem_stats)(aiot_sysdep_mem_stats_t *stats, uint32_t max_count);
+    /**
+     * @brief 可选, 创建读写锁
+     *
+     * @details
+     *
+     * 读写锁的5个接口需同时实现, 任意一个为NULL时SDK使用互斥锁代替, 读多写少的数据(如订阅列表)无法并发读取
+     */
+    void    *(*core_sysdep_rwlock_init)(void);
+    /**
+     * @brief 可选, 申请读锁
+     */
+    void (*core_sysdep_rwlock_rdlock)(void *rwlock);
+    /**
+     * @brief 可选, 申请写锁
+     */
+    void (*core_sysdep_rwlock_wrlock)(void *rwlock);
+    /**
+     * @brief 可选, 释放读锁或写锁
+     */
+    void (*core_sysdep_rwlock_unlock)(void *rwlock);
+    /**
+     * @brief 可选, 销毁读写锁
+     */
+    void (*core_sysdep_rwlock_deinit)(void **rwlock);
+    /**
+     * @brief 可选, 创建条件变量
+     *
+     * @details
+     *
+     * 条件变量的4个接口需同时实现, 任意一个为NULL时SDK以睡眠轮询代替等待
+     */
+    void    *(*core_sysdep_cond_init)(void);
+    /**
+     * @brief 可选, 释放mutex并等待条件变量被唤醒或超时, 返回前重新持有mutex. mutex由core_sysdep_mutex_init创建
+     */
+    void (*core_sysdep_cond_wait)(void *cond, void *mutex, uint32_t timeout_ms);
+    /**
+     * @brief 可选, 唤醒所有等待条件变量的线程
+     */
+    void (*core_sysdep_cond_broadcast)(void *cond);
+    /**
+     * @brief 可选, 销毁条件变量
+     */
+    void (*core_sysdep_cond_deinit)(void **cond);
+    /**
+     * @brief 可选, 原子地把delta加到*value上, 返回相加后的值
+     *
+     * @details
+     *
+     * 为NULL时SDK在互斥锁保护下计算
+     */
+    int32_t (*core_sysdep_atomic_add)(int32_t *value, int32_t delta);
+    /**
+     * @brief 可选, 获取网络会话底层的socket描述符
+     *
+     * @details
+     *
+     * 分步建立TLS连接时, 调用者据此等待socket可读/可写; 为NULL时分步建连仍可使用, 但不返回描述符
+     */
+    int32_t (*core_sysdep_network_get_fd)(void *handle);
+    /**
+     * @brief 可选, 在指定的网络会话上接收, 收到数据即返回, 不必读满len字节
+     *
+     * @details
+     *
+     * 参数与返回值同core_sysdep_network_recv, 超时前没有收到数据时返回0. 为NULL时SDK以core_sysdep_network_recv读取,
+     * 长度未知的数据(如HTTP应答头)只能以很短的超时试探读取
+     */
+    int32_t (*core_sysdep_network_recv_some)(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
+            core_sysdep_addr_t *addr);
+    /**
+     * @brief 可选, 原子地比较并交换: *value等于expected时改为desired并返回1, 否则返回0
+     *
+     * @details
+     *
+     * 也用于串行化模块的全局初始化/销毁. 为NULL时SDK在互斥锁保护下更新峰值等统计, 且不能在多个线程中同时初始化/销毁SDK的模块
+     */
+    uint8_t (*core_sysdep_atomic_cas)(int32_t *value, int32_t expected, int32_t desired);
 } aiot_sysdep_portfile_t;
 
 void aiot_sysdep_set_portfile(aiot_sysdep_portfile_t *portfile);
 aiot_sysdep_portfile_t *aiot_sysdep_get_portfile(void);
 
+/**
+ * @brief 获取各模块的内存使用统计
+ *
+ * @param[out] stats 统计结果数组
+ * @param[in] max_count stats数组的元素个数
+ *
+ * @return int32_t
+ * @retval >=0 模块个数, 大于max_count时只填充了前max_count个
+ * @retval STATE_USER_INPUT_NULL_POINTER stats为NULL且max_count不为0
+ * @retval STATE_SYS_DEPEND_NOT_SUPPORTED 未设置portfile, 或portfile未实现core_sysdep_mem_stats
+ */
+int32_t aiot_sysdep_get_mem_stats(aiot_sysdep_mem_stats_t *stats, uint32_t max_count);
+
+/**
+ * @brief 获取TLS握手及会话复用的统计
+ *
+ * @details
+ *
+ * SDK按(host, port, 证书/PSK配置)缓存每次握手成功后协商出的TLS会话, 下次连接同一服务器时(如MQTT重连,
+ * OTA下载断点续传)优先尝试复用, 服务端不接受时自动退化为完整握手
+ *
+ * @param[out] stats 统计结果
+ *
+ * @return int32_t
+ * @retval STATE_SUCCESS 获取成功
+ * @retval STATE_USER_INPUT_NULL_POINTER stats为NULL
+ * @retval STATE_SYS_DEPEND_NOT_SUPPORTED 对接层未启用TLS
+ */
+int32_t aiot_sysdep_get_tls_stats(aiot_sysdep_tls_stats_t *stats);
+
+/**
+ * @brief 获取每个已建立的TLS连接的记录缓冲区占用
+ *
+ * @param[out] stats 统计结果数组
+ * @param[in] max_count stats数组的元素个数
+ *
+ * @return int32_t
+ * @retval >=0 连接个数, 大于max_count时只填充了前max_count个
+ * @retval STATE_USER_INPUT_NULL_POINTER stats为NULL且max_count不为0
+ * @retval STATE_SYS_DEPEND_NOT_SUPPORTED 对接层未启用TLS
+ */
+int32_t aiot_sysdep_get_tls_conn_stats(aiot_sysdep_tls_conn_stats_t *stats, uint32_t max_count);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -1,6 +1,9 @@
 #include "core_adapter.h"
 #include "aiot_state_api.h"
 #include "core_log.h"
+#include "core_timer.h"
+#include "core_list.h"
+#include "core_sync.h"
 
 static aiot_sysdep_portfile_t *g_origin_portfile = NULL;
 static aiot_sysdep_portfile_t g_aiot_portfile;
@@ -39,20 +42,91 @@ typedef struct {
 #include "mbedtls/debug.h"
 #include "mbedtls/platform.h"
 #include "mbedtls/timing.h"
+#include "mbedtls/platform_util.h"
 
 #ifndef CORE_ADAPTER_DTLS_ENABLED
     #undef MBEDTLS_SSL_PROTO_DTLS
 #endif
 
+/*
+ *  握手期间的内存池: 握手由建连线程独占驱动, 其间释放的小块内存(大数运算的临时变量, 摘要上下文, 证书解析的中间结构等)
+ *  不还给系统, 留在连接自己按大小分级的空闲链表中供同一次握手后续的申请复用, 无需加锁; 握手结束后一次性归还.
+ *  握手后仍存活的对象(会话, 密钥上下文, 服务端证书等)是普通的堆内存块, 不会把内存池钉住
+ *
+ *  申请内存的mbedtls回调不带上下文, 通过线程局部变量找到当前握手的连接, 编译器不支持__thread时定义为0关闭
+ */
+#ifndef CORE_ADAPTER_TLS_HANDSHAKE_POOL
+    #if defined(__GNUC__) && defined(__linux__)
+        #define CORE_ADAPTER_TLS_HANDSHAKE_POOL     (1)
+    #else
+        #define CORE_ADAPTER_TLS_HANDSHAKE_POOL     (0)
+    #endif
+#endif
+#define CORE_ADAPTER_TLS_HS_IDLE            (0)
+#define CORE_ADAPTER_TLS_HS_RUNNING         (1)
+#define CORE_ADAPTER_TLS_HS_DONE            (2)
 
+/* 池中内存块的级别数, 各级别大小见g_tls_pool_class_size, 超过最大级别的内存不经过内存池 */
+#define CORE_ADAPTER_TLS_POOL_CLASS_NUM     (21)
+
+#include "mbedtls/ssl_internal.h"
+
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    #define CORE_ADAPTER_TLS_IN_BUF_LEN(ssl)    ((ssl)->in_buf_len)
+    #define CORE_ADAPTER_TLS_OUT_BUF_LEN(ssl)   ((ssl)->out_buf_len)
+#else
+    #define CORE_ADAPTER_TLS_IN_BUF_LEN(ssl)    (MBEDTLS_SSL_IN_BUFFER_LEN)
+    #define CORE_ADAPTER_TLS_OUT_BUF_LEN(ssl)   (MBEDTLS_SSL_OUT_BUFFER_LEN)
+#endif
+
+
+/*
+ *  按证书/PSK配置共享的TLS上下文: 证书与私钥只解析一次, mbedtls_ssl_config只配置一次,
+ *  创建后不再修改, 各连接只持有自己的mbedtls_ssl_context
+ */
 typedef struct {
-    mbedtls_net_context          net_ctx;
-    mbedtls_ssl_context          ssl_ctx;
+    struct core_list_head        linked_node;
+    int32_t                      ref_count;
+    uint64_t                     release_time_ms;
+    core_sysdep_socket_type_t    socket_type;
+    aiot_sysdep_network_cred_option_t option;
+    uint32_t                     max_tls_fragment;
+    uint32_t                     cred_digest;
+    uint8_t                     *cred_data;     /* 证书/私钥/PSK内容的拷贝, 用于精确匹配 */
+    uint32_t                     cred_data_len;
+    void                        *handshake_mutex;
+    uint8_t                      handshake_serial;  /* 为1时整个握手持有handshake_mutex, 否则只在私钥运算时持有 */
     mbedtls_ssl_config           ssl_config;
-    mbedtls_timing_delay_context timer_delay_ctx;
     mbedtls_x509_crt             x509_server_cert;
     mbedtls_x509_crt             x509_client_cert;
     mbedtls_pk_context           x509_client_pk;
+    mbedtls_pk_context           x509_client_pk_alt;  /* 包装x509_client_pk, 私钥运算时加锁 */
+} core_adapter_tls_ctx_t;
+
+typedef struct {
+    mbedtls_net_context          net_ctx;
+    mbedtls_ssl_context          ssl_ctx;
+    core_adapter_tls_ctx_t      *tls_ctx;
+    uint32_t                     read_timeout_ms;
+    uint64_t                     send_deadline_ms;  /* 写入底层socket的截止时间, 由当前的握手/发送/关闭操作设置 */
+    uint32_t                     send_pending_len;  /* 已加密但未完全写出的记录对应的明文长度 */
+    mbedtls_timing_delay_context timer_delay_ctx;
+    uint8_t                      session_offered;
+    uint8_t                      session_master[48];
+    struct core_list_head        linked_node;       /* 挂在g_tls_conn_list上, 供aiot_sysdep_get_tls_conn_stats遍历 */
+    uint64_t                     last_recv_time_ms; /* 只由读方向访问 */
+    uint64_t                     last_send_time_ms; /* 只由写方向访问 */
+    uint32_t                     in_buf_len;        /* 以下三项在g_tls_mutex保护下更新, in/out分别只由读/写方向更新 */
+    uint32_t                     out_buf_len;
+    uint32_t                     peak_buf_len;
+    void                        *hs_pool[CORE_ADAPTER_TLS_POOL_CLASS_NUM];  /* 握手期间释放的小块内存, 按大小分级 */
+    int32_t                      hs_live_bytes;     /* 握手期间净申请的字节数, 可能为负(释放了握手前申请的内存) */
+    uint32_t                     hs_peak_bytes;
+    uint32_t                     hs_alloc_count;
+    uint32_t                     hs_reuse_count;
+    uint64_t                     hs_start_ns;
+    uint8_t                      hs_state;          /* CORE_ADAPTER_TLS_HS_* */
+    uint8_t                      nonblocking;       /* 分步握手期间为1, 底层收发不等待 */
 } core_sysdep_mbedtls_t;
 #endif
 
@@ -66,6 +140,7 @@ typedef struct {
     uint16_t port;
     uint32_t connect_timeout_ms;
 #ifdef CORE_ADAPTER_MBEDTLS_ENABLED
+    aiot_sysdep_network_sockopt_t sockopt;  /* 用户设置的socket调优参数, 握手结束后重新交给底层portfile */
     core_sysdep_psk_t psk;
     core_sysdep_mbedtls_t mbedtls;
 #endif
@@ -74,13 +149,64 @@ typedef struct {
 #ifdef CORE_ADAPTER_MBEDTLS_ENABLED
 #define MBEDTLS_MEM_INFO_MAGIC  (0x12345678)
 
-static uint32_t g_mbedtls_total_mem_used = 0;
-static uint32_t g_mbedtls_max_mem_used = 0;
+/* 所有连接共用, 原子更新; 峰值在并发申请时可能略有偏低, 仅用于日志 */
+static int32_t g_mbedtls_total_mem_used = 0;
+static int32_t g_mbedtls_max_mem_used = 0;
 typedef struct {
     int32_t magic;
     int32_t size;
 } mbedtls_mem_info_t;
 
+/*
+ *  TLS会话缓存: 握手成功后按(host, port, 证书/PSK配置)保存协商出的会话(会话ID及session ticket),
+ *  下次连接同一服务器时通过mbedtls_ssl_set_session提供给服务端, 服务端不接受时mbedtls自动完成完整握手
+ *
+ *  CORE_ADAPTER_TLS_SESSION_CACHE_SIZE为0时关闭会话缓存, 每个缓存的会话约占用一份服务端证书的内存
+ */
+#ifndef CORE_ADAPTER_TLS_SESSION_CACHE_SIZE
+    #define CORE_ADAPTER_TLS_SESSION_CACHE_SIZE     (4)
+#endif
+#define CORE_ADAPTER_TLS_SESSION_HOST_MAXLEN        (128)
+
+/*
+ *  TLS记录缓冲区按需增长(见mbedtls的MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH), 持续这么长时间没有收到数据后,
+ *  在读超时时把接收缓冲区缩回最小尺寸; 持续这么长时间没有发送数据后, 在下一次发送(如心跳)前把发送缓冲区缩回最小尺寸.
+ *  读写可能在不同线程中进行, 两个方向各自只收缩自己的缓冲区. 0表示不主动收缩
+ */
+#ifndef CORE_ADAPTER_TLS_BUFFER_IDLE_MS
+    #define CORE_ADAPTER_TLS_BUFFER_IDLE_MS         (30 * 1000)
+#endif
+
+/* 断开连接时发送close_notify告警最多等待的时间 */
+#ifndef CORE_ADAPTER_TLS_CLOSE_NOTIFY_TIMEOUT_MS
+    #define CORE_ADAPTER_TLS_CLOSE_NOTIFY_TIMEOUT_MS    (1000)
+#endif
+
+/* 引用计数降为0后仍保留的TLS上下文个数, 使重连时不必重新解析证书 */
+#ifndef CORE_ADAPTER_TLS_CTX_IDLE_MAX
+    #define CORE_ADAPTER_TLS_CTX_IDLE_MAX           (2)
+#endif
+
+#if defined(MBEDTLS_SSL_CLI_C) && (CORE_ADAPTER_TLS_SESSION_CACHE_SIZE > 0)
+typedef struct {
+    uint8_t valid;
+    core_sysdep_socket_type_t socket_type;
+    uint8_t cred_option;
+    uint32_t cred_digest;
+    uint16_t port;
+    char host[CORE_ADAPTER_TLS_SESSION_HOST_MAXLEN];
+    uint64_t saved_time_ms;
+    uint64_t used_time_ms;
+    mbedtls_ssl_session session;
+} core_adapter_tls_session_t;
+
+static core_adapter_tls_session_t g_tls_session_cache[CORE_ADAPTER_TLS_SESSION_CACHE_SIZE];
+#endif
+static void *g_tls_mutex = NULL;
+static aiot_sysdep_tls_stats_t g_tls_stats;
+static struct core_list_head g_tls_ctx_list = {&g_tls_ctx_list, &g_tls_ctx_list};
+static struct core_list_head g_tls_conn_list = {&g_tls_conn_list, &g_tls_conn_list};
+
 static uint8_t _host_is_ip(char *host)
 {
     uint32_t idx = 0;
@@ -98,34 +224,128 @@ static uint8_t _host_is_ip(char *host)
     return 1;
 }
 
+#if CORE_ADAPTER_TLS_HANDSHAKE_POOL
+static __thread adapter_network_handle_t *g_tls_pool_owner = NULL;
+
+/*
+ *  内存块大小(含头部)的分级, 每个2的幂之间再分4级, 复用时最多浪费约25%.
+ *  块按实际申请的大小分配, 释放时放入不超过其大小的最大级别, 申请时从不小于所需大小的最小级别取
+ */
+static const uint16_t g_tls_pool_class_size[CORE_ADAPTER_TLS_POOL_CLASS_NUM] = {
+    32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 640, 768, 896, 1024
+};
+
+/* round_up为1时返回不小于block_size的最小级别, 否则返回不超过block_size的最大级别, 不存在时返回-1 */
+static int32_t _core_tls_pool_class(uint32_t block_size, uint8_t round_up)
+{
+    int32_t idx = 0;
+
+    for (idx = 0; idx < CORE_ADAPTER_TLS_POOL_CLASS_NUM; idx++) {
+        if (block_size <= g_tls_pool_class_size[idx]) {
+            if (block_size == g_tls_pool_class_size[idx] || round_up == 1) {
+                return idx;
+            }
+            return idx - 1;
+        }
+    }
+
+    return (round_up == 1) ? -1 : CORE_ADAPTER_TLS_POOL_CLASS_NUM - 1;
+}
+
+/*
+ *  当前线程开始/暂停驱动某个连接的握手, 分步握手时每一步各自进出一次, 池中的内存保留到握手结束后
+ *  由_core_tls_pool_release归还
+ */
+static void _core_tls_pool_enter(adapter_network_handle_t *adapter_handle)
+{
+    g_tls_pool_owner = adapter_handle;
+}
+
+static void _core_tls_pool_leave(adapter_network_handle_t *adapter_handle)
+{
+    g_tls_pool_owner = NULL;
+}
+
+static void _core_tls_pool_release(adapter_network_handle_t *adapter_handle)
+{
+    int32_t idx = 0;
+    mbedtls_mem_info_t *mem_info = NULL;
+
+    for (idx = 0; idx < CORE_ADAPTER_TLS_POOL_CLASS_NUM; idx++) {
+        while ((mem_info = adapter_handle->mbedtls.hs_pool[idx]) != NULL) {
+            adapter_handle->mbedtls.hs_pool[idx] = *(void **)(mem_info + 1);
+            g_origin_portfile->core_sysdep_free(mem_info);
+        }
+    }
+}
+#else
+static void _core_tls_pool_enter(adapter_network_handle_t *adapter_handle)
+{
+}
+
+static void _core_tls_pool_leave(adapter_network_handle_t *adapter_handle)
+{
+}
+
+static void _core_tls_pool_release(adapter_network_handle_t *adapter_handle)
+{
+}
+#endif
+
+static void _core_tls_mem_account(int32_t size)
+{
+    int32_t total = core_atomic_add(g_origin_portfile, g_tls_mutex, &g_mbedtls_total_mem_used, size);
+
+    core_atomic_max(g_origin_portfile, g_tls_mutex, &g_mbedtls_max_mem_used, total);
+#if CORE_ADAPTER_TLS_HANDSHAKE_POOL
+    if (g_tls_pool_owner != NULL) {
+        core_sysdep_mbedtls_t *mbedtls = &g_tls_pool_owner->mbedtls;
+
+        mbedtls->hs_live_bytes += size;
+        if (mbedtls->hs_live_bytes > 0 && (uint32_t)mbedtls->hs_live_bytes > mbedtls->hs_peak_bytes) {
+            mbedtls->hs_peak_bytes = mbedtls->hs_live_bytes;
+        }
+    }
+#endif
+}
+
+/* mem_info->size记录的是内存块的容量, 从握手内存池复用的块可能大于本次申请的大小 */
 static void *_core_mbedtls_calloc(size_t n, size_t size)
 {
     uint8_t *buf = NULL;
     mbedtls_mem_info_t *mem_info = NULL;
 
-    if (n == 0 || size == 0) {
+    if (n == 0 || size == 0 || n > (INT32_MAX - sizeof(mbedtls_mem_info_t)) / size) {
         return NULL;
     }
-    buf = (uint8_t *)g_origin_portfile->core_sysdep_malloc(n * size + sizeof(mbedtls_mem_info_t), "TLS");
-    if (NULL == buf) {
-        core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "error -- mbedtls malloc: %d failed\r\n", &size);
-        return NULL;
-    } else {
-        memset(buf, 0, n * size + sizeof(mbedtls_mem_info_t));
+    size *= n;
+
+#if CORE_ADAPTER_TLS_HANDSHAKE_POOL
+    if (g_tls_pool_owner != NULL) {
+        core_sysdep_mbedtls_t *mbedtls = &g_tls_pool_owner->mbedtls;
+        int32_t idx = _core_tls_pool_class(size + sizeof(mbedtls_mem_info_t), 1);
+
+        mbedtls->hs_alloc_count++;
+        if (idx >= 0 && mbedtls->hs_pool[idx] != NULL) {
+            mem_info = mbedtls->hs_pool[idx];
+            mbedtls->hs_pool[idx] = *(void **)(mem_info + 1);
+            mbedtls->hs_reuse_count++;
+        }
     }
-
-    mem_info = (mbedtls_mem_info_t *)buf;
-    mem_info->magic = MBEDTLS_MEM_INFO_MAGIC;
-    mem_info->size = n * size;
-    buf += sizeof(mbedtls_mem_info_t);
-
-    g_mbedtls_total_mem_used += mem_info->size;
-    if (g_mbedtls_total_mem_used > g_mbedtls_max_mem_used) {
-        g_mbedtls_max_mem_used = g_mbedtls_total_mem_used;
+#endif
+    if (mem_info == NULL) {
+        mem_info = g_origin_portfile->core_sysdep_malloc(size + sizeof(mbedtls_mem_info_t), "TLS");
+        if (NULL == mem_info) {
+            core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "error -- mbedtls malloc: %d failed\r\n", &size);
+            return NULL;
+        }
+        mem_info->size = size;
     }
+    mem_info->magic = MBEDTLS_MEM_INFO_MAGIC;
+    buf = (uint8_t *)(mem_info + 1);
+    memset(buf, 0, size);
 
-    /*core_log3(g_origin_portfile, STATE_ADAPTER_COMMON, "INFO -- mbedtls malloc: %d  total used: %d  max used: %d\r\n",
-                       &size, &g_mbedtls_total_mem_used, &g_mbedtls_max_mem_used);*/
+    _core_tls_mem_account(mem_info->size);
 
     return buf;
 }
@@ -143,10 +363,20 @@ static void _core_mbedtls_free(void *ptr)
         return;
     }
 
-    g_mbedtls_total_mem_used -= mem_info->size;
-    /*core_log3(g_origin_portfile, STATE_ADAPTER_COMMON, "INFO -- mbedtls free: %d  total used: %d  max used: %d\r\n",
-                       &mem_info->size, &g_mbedtls_total_mem_used, &g_mbedtls_max_mem_used);*/
+    _core_tls_mem_account(-mem_info->size);
+    mem_info->magic = 0;
 
+#if CORE_ADAPTER_TLS_HANDSHAKE_POOL
+    if (g_tls_pool_owner != NULL) {
+        int32_t idx = _core_tls_pool_class(mem_info->size + sizeof(mbedtls_mem_info_t), 0);
+
+        if (idx >= 0) {
+            *(void **)ptr = g_tls_pool_owner->mbedtls.hs_pool[idx];
+            g_tls_pool_owner->mbedtls.hs_pool[idx] = mem_info;
+            return;
+        }
+    }
+#endif
     g_origin_portfile->core_sysdep_free(mem_info);
 }
 
@@ -165,29 +395,64 @@ static void _core_mbedtls_debug(void *ctx, int32_t level, const char *file, int3
 }
 
 
+/*
+ *  底层socket的发送最多等到send_deadline_ms, 期间由portfile等待socket可写; 截止时间已到或分步握手时以0超时发送, 只写入socket当前能接受的数据.
+ *  一个字节都没写出时返回MBEDTLS_ERR_SSL_WANT_WRITE, 未写出的数据留在mbedtls的发送缓冲区中
+ */
 static int32_t _core_mbedtls_net_send(void *ctx, const uint8_t *buf, size_t len)
 {
-    int32_t ret = g_origin_portfile->core_sysdep_network_send(ctx, (uint8_t *)buf, len, 5000, NULL);
+    adapter_network_handle_t *adapter_handle = (adapter_network_handle_t *)ctx;
+    uint64_t time_now_ms = core_time_ms(g_origin_portfile);
+    int32_t ret = 0;
+
+    uint32_t timeout_ms = 0;
+
+    if (adapter_handle->mbedtls.nonblocking == 0 && time_now_ms < adapter_handle->mbedtls.send_deadline_ms) {
+        timeout_ms = (uint32_t)(adapter_handle->mbedtls.send_deadline_ms - time_now_ms);
+    }
+    ret = g_origin_portfile->core_sysdep_network_send(adapter_handle->network_handle, (uint8_t *)buf, len,
+            timeout_ms, NULL);
     /*core_log2(g_origin_portfile, STATE_ADAPTER_COMMON, "_core_mbedtls_net_send %d, ret %d\r\n", &len, &ret);*/
+    if (ret == 0) {
+        return (MBEDTLS_ERR_SSL_WANT_WRITE);
+    }
     return ret;
 }
 
 static int32_t _core_mbedtls_net_recv(void *ctx, uint8_t *buf, size_t len)
 {
-    int32_t ret = g_origin_portfile->core_sysdep_network_recv(ctx, buf, len, 5000, NULL);
+    adapter_network_handle_t *adapter_handle = (adapter_network_handle_t *)ctx;
+    int32_t ret = g_origin_portfile->core_sysdep_network_recv(adapter_handle->network_handle, buf, len, 5000, NULL);
     if (ret < 0) {
         return (MBEDTLS_ERR_NET_RECV_FAILED);
     } else {
         return ret;
     }
 }
+/*
+ *  共享的ssl_config中read_timeout为0, 读超时取自连接自己的read_timeout_ms;
+ *  DTLS握手重传时mbedtls会传入非0的timeout, 此时以mbedtls传入的为准.
+ *  分步握手时以0超时读取, 没有数据时立即返回MBEDTLS_ERR_SSL_WANT_READ
+ */
 static int32_t _core_mbedtls_net_recv_timeout(void *ctx, uint8_t *buf, size_t len,
         uint32_t timeout)
 {
-    int32_t ret = g_origin_portfile->core_sysdep_network_recv(ctx, buf, len, timeout, NULL);
+    adapter_network_handle_t *adapter_handle = (adapter_network_handle_t *)ctx;
+    int32_t ret = 0;
+
+    if (adapter_handle->mbedtls.nonblocking == 1) {
+        timeout = 0;
+    } else if (timeout == 0) {
+        timeout = adapter_handle->mbedtls.read_timeout_ms;
+    }
+    ret = g_origin_portfile->core_sysdep_network_recv(adapter_handle->network_handle, buf, len, timeout, NULL);
     /*core_log2(g_origin_portfile, STATE_ADAPTER_COMMON, "_core_mbedtls_net_recv_timeout %d, ret %d\r\n", &len, &ret);*/
     if (ret < 0) {
         return (MBEDTLS_ERR_NET_RECV_FAILED);
+    } else if (ret == 0 && adapter_handle->mbedtls.nonblocking == 1) {
+        return (MBEDTLS_ERR_SSL_WANT_READ);
+    } else if (ret == 0) {
+        return (MBEDTLS_ERR_SSL_TIMEOUT);
     } else {
         return ret;
     }
@@ -246,34 +511,114 @@ int32_t _core_mbedtls_timing_get_delay(void *data)
 }
 #endif 
 
-int32_t _tls_network_establish(void *handle)
+static void _core_tls_lock(void)
 {
-    adapter_network_handle_t *adapter_handle = (adapter_network_handle_t *)handle;
-    int32_t res = 0;
-    core_log2(g_origin_portfile, STATE_ADAPTER_COMMON, "establish mbedtls connection with server(host='%s', port=[%d])\r\n",
-              adapter_handle->host, &adapter_handle->port);
+    if (g_tls_mutex != NULL) {
+        g_origin_portfile->core_sysdep_mutex_lock(g_tls_mutex);
+    }
+}
 
-    if (adapter_handle->cred->max_tls_fragment == 0) {
-        core_log(g_origin_portfile, STATE_ADAPTER_COMMON, "invalid max_tls_fragment parameter\r\n");
-        return STATE_PORT_TLS_INVALID_MAX_FRAGMENT;
+static void _core_tls_unlock(void)
+{
+    if (g_tls_mutex != NULL) {
+        g_origin_portfile->core_sysdep_mutex_unlock(g_tls_mutex);
     }
+}
+
+/* 按[长度][内容]依次写入证书, 私钥与PSK, buf为NULL时只计算总长度 */
+static uint32_t _core_tls_cred_serialize(adapter_network_handle_t *adapter_handle, uint8_t *buf)
+{
+    aiot_sysdep_network_cred_t *cred = adapter_handle->cred;
+    const char *data[5] = {cred->x509_server_cert, cred->x509_client_cert, cred->x509_client_privkey,
+                           adapter_handle->psk.psk_id, adapter_handle->psk.psk
+                          };
+    uint32_t len[5] = {cred->x509_server_cert_len, cred->x509_client_cert_len, cred->x509_client_privkey_len, 0, 0};
+    uint32_t idx = 0, offset = 0;
+
+    len[3] = (data[3] == NULL) ? 0 : strlen(data[3]);
+    len[4] = (data[4] == NULL) ? 0 : strlen(data[4]);
+    for (idx = 0; idx < sizeof(len) / sizeof(len[0]); idx++) {
+        if (data[idx] == NULL) {
+            len[idx] = 0;
+        }
+        if (buf != NULL) {
+            memcpy(buf + offset, &len[idx], sizeof(uint32_t));
+            memcpy(buf + offset + sizeof(uint32_t), data[idx], len[idx]);
+        }
+        offset += sizeof(uint32_t) + len[idx];
+    }
+
+    return offset;
+}
+
+static uint32_t _core_tls_digest(const uint8_t *data, uint32_t len)
+{
+    uint32_t digest = 2166136261, idx = 0;
+
+    for (idx = 0; idx < len; idx++) {
+        digest = (digest ^ data[idx]) * 16777619;
+    }
+
+    return digest;
+}
+
+#if defined(MBEDTLS_PK_RSA_ALT_SUPPORT)
+/* 私钥运算(RSA blinding)会修改私钥上下文, 共享同一私钥的连接只在签名/解密期间互斥, 握手的其余部分可以并行 */
+static int _core_tls_pk_sign(void *ctx, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng, int mode,
+                             mbedtls_md_type_t md_alg, unsigned int hashlen, const unsigned char *hash, unsigned char *sig)
+{
+    core_adapter_tls_ctx_t *tls_ctx = (core_adapter_tls_ctx_t *)ctx;
+    int res = 0;
+
+    g_origin_portfile->core_sysdep_mutex_lock(tls_ctx->handshake_mutex);
+    res = mbedtls_rsa_pkcs1_sign(mbedtls_pk_rsa(tls_ctx->x509_client_pk), f_rng, p_rng, mode, md_alg, hashlen, hash, sig);
+    g_origin_portfile->core_sysdep_mutex_unlock(tls_ctx->handshake_mutex);
+
+    return res;
+}
+
+/* 客户端的密钥交换不需要私钥解密, 仅为满足RSA-alt接口 */
+static int _core_tls_pk_decrypt(void *ctx, int mode, size_t *olen, const unsigned char *input, unsigned char *output,
+                                size_t output_max_len)
+{
+    core_adapter_tls_ctx_t *tls_ctx = (core_adapter_tls_ctx_t *)ctx;
+    int res = 0;
+
+    g_origin_portfile->core_sysdep_mutex_lock(tls_ctx->handshake_mutex);
+    res = mbedtls_rsa_pkcs1_decrypt(mbedtls_pk_rsa(tls_ctx->x509_client_pk), NULL, NULL, mode, olen, input, output,
+                                    output_max_len);
+    g_origin_portfile->core_sysdep_mutex_unlock(tls_ctx->handshake_mutex);
+
+    return res;
+}
+
+static size_t _core_tls_pk_key_len(void *ctx)
+{
+    return mbedtls_rsa_get_len(mbedtls_pk_rsa(((core_adapter_tls_ctx_t *)ctx)->x509_client_pk));
+}
+#endif
+
+static int32_t _core_tls_ctx_setup(core_adapter_tls_ctx_t *tls_ctx, adapter_network_handle_t *adapter_handle)
+{
+    int32_t res = 0;
+
     if (adapter_handle->cred->max_tls_fragment <= 512) {
-        res = mbedtls_ssl_conf_max_frag_len(&adapter_handle->mbedtls.ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_512);
+        res = mbedtls_ssl_conf_max_frag_len(&tls_ctx->ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_512);
     } else if (adapter_handle->cred->max_tls_fragment <= 1024) {
-        res = mbedtls_ssl_conf_max_frag_len(&adapter_handle->mbedtls.ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_1024);
+        res = mbedtls_ssl_conf_max_frag_len(&tls_ctx->ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_1024);
     } else if (adapter_handle->cred->max_tls_fragment <= 2048) {
-        res = mbedtls_ssl_conf_max_frag_len(&adapter_handle->mbedtls.ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_2048);
+        res = mbedtls_ssl_conf_max_frag_len(&tls_ctx->ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_2048);
     } else if (adapter_handle->cred->max_tls_fragment <= 4096) {
-        res = mbedtls_ssl_conf_max_frag_len(&adapter_handle->mbedtls.ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_4096);
+        res = mbedtls_ssl_conf_max_frag_len(&tls_ctx->ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_4096);
     } else {
-        res = mbedtls_ssl_conf_max_frag_len(&adapter_handle->mbedtls.ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_NONE);
+        res = mbedtls_ssl_conf_max_frag_len(&tls_ctx->ssl_config, MBEDTLS_SSL_MAX_FRAG_LEN_NONE);
     }
     if (res < 0) {
         core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_conf_max_frag_len error, res: %x\r\n", &res);
         return res;
     }
     if (adapter_handle->socket_type == CORE_SYSDEP_SOCKET_TCP_CLIENT) {
-        res = mbedtls_ssl_config_defaults(&adapter_handle->mbedtls.ssl_config, MBEDTLS_SSL_IS_CLIENT,
+        res = mbedtls_ssl_config_defaults(&tls_ctx->ssl_config, MBEDTLS_SSL_IS_CLIENT,
                                           MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
         if (res < 0) {
             core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_config_defaults error, res: %x\r\n", &res);
@@ -282,35 +627,33 @@ int32_t _tls_network_establish(void *handle)
     } 
     else if (adapter_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_CLIENT) {
 #ifdef MBEDTLS_SSL_PROTO_DTLS
-        res = mbedtls_ssl_config_defaults(&adapter_handle->mbedtls.ssl_config, MBEDTLS_SSL_IS_CLIENT,
+        res = mbedtls_ssl_config_defaults(&tls_ctx->ssl_config, MBEDTLS_SSL_IS_CLIENT,
                                           MBEDTLS_SSL_TRANSPORT_DATAGRAM, MBEDTLS_SSL_PRESET_DEFAULT);
         if (res < 0) {
             core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_config_defaults error, res: %x\r\n", &res);
             return res;
         }
-        mbedtls_ssl_conf_handshake_timeout(&adapter_handle->mbedtls.ssl_config, (MBEDTLS_SSL_DTLS_TIMEOUT_DFL_MIN * 2),
+        mbedtls_ssl_conf_handshake_timeout(&tls_ctx->ssl_config, (MBEDTLS_SSL_DTLS_TIMEOUT_DFL_MIN * 2),
                                     (MBEDTLS_SSL_DTLS_TIMEOUT_DFL_MIN * 2 * 4));
-        mbedtls_ssl_set_timer_cb(&adapter_handle->mbedtls.ssl_ctx, (void *)&adapter_handle->mbedtls.timer_delay_ctx,
-                                 _core_mbedtls_timing_set_delay, _core_mbedtls_timing_get_delay);
 #else
         return -1;
 #endif
     }
-    mbedtls_ssl_conf_max_version(&adapter_handle->mbedtls.ssl_config, MBEDTLS_SSL_MAJOR_VERSION_3,
+    mbedtls_ssl_conf_max_version(&tls_ctx->ssl_config, MBEDTLS_SSL_MAJOR_VERSION_3,
                                  MBEDTLS_SSL_MINOR_VERSION_3);
-    mbedtls_ssl_conf_min_version(&adapter_handle->mbedtls.ssl_config, MBEDTLS_SSL_MAJOR_VERSION_3,
+    mbedtls_ssl_conf_min_version(&tls_ctx->ssl_config, MBEDTLS_SSL_MAJOR_VERSION_3,
                                  MBEDTLS_SSL_MINOR_VERSION_3);
-    mbedtls_ssl_conf_rng(&adapter_handle->mbedtls.ssl_config, _core_mbedtls_random, NULL);
-    mbedtls_ssl_conf_dbg(&adapter_handle->mbedtls.ssl_config, _core_mbedtls_debug, stdout);
+    mbedtls_ssl_conf_rng(&tls_ctx->ssl_config, _core_mbedtls_random, NULL);
+    mbedtls_ssl_conf_dbg(&tls_ctx->ssl_config, _core_mbedtls_debug, stdout);
+    mbedtls_ssl_conf_read_timeout(&tls_ctx->ssl_config, 0);
 
     if (adapter_handle->cred->option == AIOT_SYSDEP_NETWORK_CRED_SVRCERT_CA) {
         if (adapter_handle->cred->x509_server_cert == NULL && adapter_handle->cred->x509_server_cert_len == 0) {
             core_log(g_origin_portfile, STATE_ADAPTER_COMMON, "invalid x509 server cert\r\n");
             return STATE_PORT_TLS_INVALID_SERVER_CERT;
         }
-        mbedtls_x509_crt_init(&adapter_handle->mbedtls.x509_server_cert);
 
-        res = mbedtls_x509_crt_parse(&adapter_handle->mbedtls.x509_server_cert,
+        res = mbedtls_x509_crt_parse(&tls_ctx->x509_server_cert,
                                      (const uint8_t *)adapter_handle->cred->x509_server_cert, (size_t)adapter_handle->cred->x509_server_cert_len + 1);
         if (res < 0) {
             core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_x509_crt_parse server cert error, res: %x\r\n", &res);
@@ -319,32 +662,43 @@ int32_t _tls_network_establish(void *handle)
 
         if (adapter_handle->cred->x509_client_cert != NULL && adapter_handle->cred->x509_client_cert_len > 0 &&
             adapter_handle->cred->x509_client_privkey != NULL && adapter_handle->cred->x509_client_privkey_len > 0) {
-            mbedtls_x509_crt_init(&adapter_handle->mbedtls.x509_client_cert);
-            mbedtls_pk_init(&adapter_handle->mbedtls.x509_client_pk);
-            res = mbedtls_x509_crt_parse(&adapter_handle->mbedtls.x509_client_cert,
+            res = mbedtls_x509_crt_parse(&tls_ctx->x509_client_cert,
                                          (const uint8_t *)adapter_handle->cred->x509_client_cert, (size_t)adapter_handle->cred->x509_client_cert_len + 1);
             if (res < 0) {
                 core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_x509_crt_parse client cert error, res: %x\r\n", &res);
                 return STATE_PORT_TLS_INVALID_CLIENT_CERT;
             }
-            res = mbedtls_pk_parse_key(&adapter_handle->mbedtls.x509_client_pk,
+            res = mbedtls_pk_parse_key(&tls_ctx->x509_client_pk,
                                        (const uint8_t *)adapter_handle->cred->x509_client_privkey,
                                        (size_t)adapter_handle->cred->x509_client_privkey_len + 1, NULL, 0);
             if (res < 0) {
                 core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_pk_parse_key client pk error, res: %x\r\n", &res);
                 return STATE_PORT_TLS_INVALID_CLIENT_KEY;
             }
-            res = mbedtls_ssl_conf_own_cert(&adapter_handle->mbedtls.ssl_config, &adapter_handle->mbedtls.x509_client_cert,
-                                            &adapter_handle->mbedtls.x509_client_pk);
+            tls_ctx->handshake_mutex = g_origin_portfile->core_sysdep_mutex_init();
+            if (tls_ctx->handshake_mutex == NULL) {
+                return STATE_PORT_MALLOC_FAILED;
+            }
+            /* 私钥运算会修改私钥上下文, RSA私钥经包装后只在运算时加锁, 无法包装时共享同一私钥的连接串行握手 */
+            tls_ctx->handshake_serial = 1;
+#if defined(MBEDTLS_PK_RSA_ALT_SUPPORT)
+            if (mbedtls_pk_get_type(&tls_ctx->x509_client_pk) == MBEDTLS_PK_RSA &&
+                mbedtls_pk_setup_rsa_alt(&tls_ctx->x509_client_pk_alt, tls_ctx, _core_tls_pk_decrypt, _core_tls_pk_sign,
+                                         _core_tls_pk_key_len) == 0) {
+                tls_ctx->handshake_serial = 0;
+            }
+#endif
+            res = mbedtls_ssl_conf_own_cert(&tls_ctx->ssl_config, &tls_ctx->x509_client_cert,
+                                            (tls_ctx->handshake_serial == 1) ? &tls_ctx->x509_client_pk : &tls_ctx->x509_client_pk_alt);
             if (res < 0) {
                 core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_conf_own_cert error, res: %x\r\n", &res);
                 return STATE_PORT_TLS_INVALID_CLIENT_CERT;
             }
         }
-        mbedtls_ssl_conf_ca_chain(&adapter_handle->mbedtls.ssl_config, &adapter_handle->mbedtls.x509_server_cert, NULL);
+        mbedtls_ssl_conf_ca_chain(&tls_ctx->ssl_config, &tls_ctx->x509_server_cert, NULL);
     } else if (adapter_handle->cred->option == AIOT_SYSDEP_NETWORK_CRED_SVRCERT_PSK) {
         static const int32_t ciphersuites[1] = {MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA};
-        res = mbedtls_ssl_conf_psk(&adapter_handle->mbedtls.ssl_config,
+        res = mbedtls_ssl_conf_psk(&tls_ctx->ssl_config,
                                    (const uint8_t *)adapter_handle->psk.psk, (size_t)strlen(adapter_handle->psk.psk),
                                    (const uint8_t *)adapter_handle->psk.psk_id, (size_t)strlen(adapter_handle->psk.psk_id));
         if (res < 0) {
@@ -352,17 +706,401 @@ int32_t _tls_network_establish(void *handle)
             return STATE_PORT_TLS_CONFIG_PSK_FAILED;
         }
 
-        mbedtls_ssl_conf_ciphersuites(&adapter_handle->mbedtls.ssl_config, ciphersuites);
+        mbedtls_ssl_conf_ciphersuites(&tls_ctx->ssl_config, ciphersuites);
     } else {
         core_log(g_origin_portfile, STATE_ADAPTER_COMMON, "unsupported security option\r\n");
         return STATE_PORT_TLS_INVALID_CRED_OPTION;
     }
 
-    res = mbedtls_ssl_setup(&adapter_handle->mbedtls.ssl_ctx, &adapter_handle->mbedtls.ssl_config);
+    return 0;
+}
+
+static void _core_tls_ctx_free(core_adapter_tls_ctx_t *tls_ctx)
+{
+    mbedtls_x509_crt_free(&tls_ctx->x509_server_cert);
+    mbedtls_x509_crt_free(&tls_ctx->x509_client_cert);
+    mbedtls_pk_free(&tls_ctx->x509_client_pk_alt);
+    mbedtls_pk_free(&tls_ctx->x509_client_pk);
+    mbedtls_ssl_config_free(&tls_ctx->ssl_config);
+    if (tls_ctx->handshake_mutex != NULL) {
+        g_origin_portfile->core_sysdep_mutex_deinit(&tls_ctx->handshake_mutex);
+    }
+    if (tls_ctx->cred_data != NULL) {
+        mbedtls_platform_zeroize(tls_ctx->cred_data, tls_ctx->cred_data_len);
+        g_origin_portfile->core_sysdep_free(tls_ctx->cred_data);
+    }
+    g_origin_portfile->core_sysdep_free(tls_ctx);
+}
+
+/* 查找证书/PSK配置完全相同的TLS上下文并增加引用, 不存在时解析证书并创建 */
+static int32_t _core_tls_ctx_acquire(adapter_network_handle_t *adapter_handle)
+{
+    core_adapter_tls_ctx_t *tls_ctx = NULL;
+    uint8_t *cred_data = NULL;
+    uint32_t cred_data_len = 0, cred_digest = 0;
+    int32_t res = 0;
+
+    cred_data_len = _core_tls_cred_serialize(adapter_handle, NULL);
+    cred_data = g_origin_portfile->core_sysdep_malloc(cred_data_len, "TLS");
+    if (cred_data == NULL) {
+        return STATE_PORT_MALLOC_FAILED;
+    }
+    _core_tls_cred_serialize(adapter_handle, cred_data);
+    cred_digest = _core_tls_digest(cred_data, cred_data_len);
+
+    _core_tls_lock();
+    core_list_for_each_entry(tls_ctx, &g_tls_ctx_list, linked_node, core_adapter_tls_ctx_t) {
+        if (tls_ctx->socket_type == adapter_handle->socket_type && tls_ctx->option == adapter_handle->cred->option &&
+            tls_ctx->max_tls_fragment == adapter_handle->cred->max_tls_fragment && tls_ctx->cred_digest == cred_digest &&
+            tls_ctx->cred_data_len == cred_data_len && memcmp(tls_ctx->cred_data, cred_data, cred_data_len) == 0) {
+            tls_ctx->ref_count++;
+            adapter_handle->mbedtls.tls_ctx = tls_ctx;
+            _core_tls_unlock();
+            mbedtls_platform_zeroize(cred_data, cred_data_len);
+            g_origin_portfile->core_sysdep_free(cred_data);
+            return 0;
+        }
+    }
+
+    tls_ctx = g_origin_portfile->core_sysdep_malloc(sizeof(core_adapter_tls_ctx_t), "TLS");
+    if (tls_ctx == NULL) {
+        _core_tls_unlock();
+        g_origin_portfile->core_sysdep_free(cred_data);
+        return STATE_PORT_MALLOC_FAILED;
+    }
+    memset(tls_ctx, 0, sizeof(core_adapter_tls_ctx_t));
+    CORE_INIT_LIST_HEAD(&tls_ctx->linked_node);
+    tls_ctx->socket_type = adapter_handle->socket_type;
+    tls_ctx->option = adapter_handle->cred->option;
+    tls_ctx->max_tls_fragment = adapter_handle->cred->max_tls_fragment;
+    tls_ctx->cred_digest = cred_digest;
+    tls_ctx->cred_data = cred_data;
+    tls_ctx->cred_data_len = cred_data_len;
+    mbedtls_ssl_config_init(&tls_ctx->ssl_config);
+    mbedtls_x509_crt_init(&tls_ctx->x509_server_cert);
+    mbedtls_x509_crt_init(&tls_ctx->x509_client_cert);
+    mbedtls_pk_init(&tls_ctx->x509_client_pk);
+    mbedtls_pk_init(&tls_ctx->x509_client_pk_alt);
+
+    res = _core_tls_ctx_setup(tls_ctx, adapter_handle);
+    if (res != 0) {
+        _core_tls_unlock();
+        _core_tls_ctx_free(tls_ctx);
+        return res;
+    }
+    tls_ctx->ref_count = 1;
+    core_list_add_tail(&tls_ctx->linked_node, &g_tls_ctx_list);
+    adapter_handle->mbedtls.tls_ctx = tls_ctx;
+    _core_tls_unlock();
+
+    return 0;
+}
+
+/* 释放连接对TLS上下文的引用, 空闲的上下文超过CORE_ADAPTER_TLS_CTX_IDLE_MAX个时销毁最早空闲的 */
+static void _core_tls_ctx_release(adapter_network_handle_t *adapter_handle)
+{
+    core_adapter_tls_ctx_t *tls_ctx = NULL, *oldest = NULL;
+    uint32_t idle_count = 0;
+
+    if (adapter_handle->mbedtls.tls_ctx == NULL) {
+        return;
+    }
+
+    _core_tls_lock();
+    adapter_handle->mbedtls.tls_ctx->ref_count--;
+    if (adapter_handle->mbedtls.tls_ctx->ref_count == 0) {
+        adapter_handle->mbedtls.tls_ctx->release_time_ms = core_time_ms(g_origin_portfile);
+    }
+    adapter_handle->mbedtls.tls_ctx = NULL;
+
+    do {
+        idle_count = 0;
+        oldest = NULL;
+        core_list_for_each_entry(tls_ctx, &g_tls_ctx_list, linked_node, core_adapter_tls_ctx_t) {
+            if (tls_ctx->ref_count == 0) {
+                idle_count++;
+                if (oldest == NULL || tls_ctx->release_time_ms < oldest->release_time_ms) {
+                    oldest = tls_ctx;
+                }
+            }
+        }
+        if (idle_count > CORE_ADAPTER_TLS_CTX_IDLE_MAX) {
+            core_list_del(&oldest->linked_node);
+            _core_tls_ctx_free(oldest);
+        }
+    } while (idle_count > CORE_ADAPTER_TLS_CTX_IDLE_MAX);
+    _core_tls_unlock();
+}
+
+#if defined(MBEDTLS_SSL_CLI_C) && (CORE_ADAPTER_TLS_SESSION_CACHE_SIZE > 0)
+/* 证书或PSK配置不同的连接不能复用彼此的会话, 否则服务端会沿用旧会话认证过的身份 */
+static core_adapter_tls_session_t *_core_tls_session_find(adapter_network_handle_t *adapter_handle, uint32_t cred_digest)
+{
+    uint32_t idx = 0;
+
+    for (idx = 0; idx < CORE_ADAPTER_TLS_SESSION_CACHE_SIZE; idx++) {
+        core_adapter_tls_session_t *entry = &g_tls_session_cache[idx];
+        if (entry->valid == 1 && entry->port == adapter_handle->port &&
+            entry->socket_type == adapter_handle->socket_type && entry->cred_option == adapter_handle->cred->option &&
+            entry->cred_digest == cred_digest && strcmp(entry->host, adapter_handle->host) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static void _core_tls_session_remove(core_adapter_tls_session_t *entry)
+{
+    mbedtls_ssl_session_free(&entry->session);
+    memset(entry, 0, sizeof(core_adapter_tls_session_t));
+    g_tls_stats.cached_session_count--;
+}
+
+/* 在握手前调用, 有可用的缓存会话时提供给服务端 */
+static void _core_tls_session_load(adapter_network_handle_t *adapter_handle)
+{
+    core_adapter_tls_session_t *entry = NULL;
+    uint64_t time_now_ms = 0;
+
+    adapter_handle->mbedtls.session_offered = 0;
+    if (strlen(adapter_handle->host) >= CORE_ADAPTER_TLS_SESSION_HOST_MAXLEN) {
+        return;
+    }
+
+    _core_tls_lock();
+    entry = _core_tls_session_find(adapter_handle, adapter_handle->mbedtls.tls_ctx->cred_digest);
+    if (entry != NULL) {
+        time_now_ms = core_time_ms(g_origin_portfile);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        /* 服务端给出了ticket有效期时, 过期的会话不再提供 */
+        if (entry->session.ticket != NULL && entry->session.ticket_lifetime != 0 &&
+            time_now_ms - entry->saved_time_ms >= (uint64_t)entry->session.ticket_lifetime * 1000) {
+            _core_tls_session_remove(entry);
+            entry = NULL;
+        }
+#endif
+    }
+    if (entry != NULL && mbedtls_ssl_set_session(&adapter_handle->mbedtls.ssl_ctx, &entry->session) == 0) {
+        entry->used_time_ms = time_now_ms;
+        memcpy(adapter_handle->mbedtls.session_master, entry->session.master, sizeof(entry->session.master));
+        adapter_handle->mbedtls.session_offered = 1;
+    }
+    _core_tls_unlock();
+}
+
+/* 提供了缓存会话但握手失败, 或会话不可复用时调用, 避免下次连接重复提供 */
+static void _core_tls_session_drop(adapter_network_handle_t *adapter_handle)
+{
+    core_adapter_tls_session_t *entry = NULL;
+
+    _core_tls_lock();
+    entry = _core_tls_session_find(adapter_handle, adapter_handle->mbedtls.tls_ctx->cred_digest);
+    if (entry != NULL) {
+        _core_tls_session_remove(entry);
+    }
+    _core_tls_unlock();
+}
+
+/* 在握手成功后调用, 保存(或更新)本次协商出的会话, 缓存已满时替换最久未使用的会话 */
+static void _core_tls_session_save(adapter_network_handle_t *adapter_handle)
+{
+    const mbedtls_ssl_session *session = adapter_handle->mbedtls.ssl_ctx.session;
+    core_adapter_tls_session_t *entry = NULL;
+    uint32_t cred_digest = 0, idx = 0;
+
+    if (strlen(adapter_handle->host) >= CORE_ADAPTER_TLS_SESSION_HOST_MAXLEN) {
+        return;
+    }
+
+    /* 服务端既未分配会话ID也未下发ticket时, 该会话无法复用 */
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    if (session->id_len == 0 && session->ticket == NULL) {
+#else
+    if (session->id_len == 0) {
+#endif
+        _core_tls_session_drop(adapter_handle);
+        return;
+    }
+
+    _core_tls_lock();
+    cred_digest = adapter_handle->mbedtls.tls_ctx->cred_digest;
+    entry = _core_tls_session_find(adapter_handle, cred_digest);
+    if (entry == NULL) {
+        for (idx = 0; idx < CORE_ADAPTER_TLS_SESSION_CACHE_SIZE; idx++) {
+            if (g_tls_session_cache[idx].valid == 0) {
+                entry = &g_tls_session_cache[idx];
+                break;
+            }
+            if (entry == NULL || g_tls_session_cache[idx].used_time_ms < entry->used_time_ms) {
+                entry = &g_tls_session_cache[idx];
+            }
+        }
+        if (entry->valid == 1) {
+            _core_tls_session_remove(entry);
+        }
+        entry->socket_type = adapter_handle->socket_type;
+        entry->cred_option = adapter_handle->cred->option;
+        entry->cred_digest = cred_digest;
+        entry->port = adapter_handle->port;
+        memcpy(entry->host, adapter_handle->host, strlen(adapter_handle->host));
+        g_tls_stats.cached_session_count++;
+    }
+    entry->valid = 1;
+
+    if (mbedtls_ssl_get_session(&adapter_handle->mbedtls.ssl_ctx, &entry->session) != 0) {
+        _core_tls_session_remove(entry);
+    } else {
+        entry->saved_time_ms = entry->used_time_ms = core_time_ms(g_origin_portfile);
+    }
+    _core_tls_unlock();
+}
+
+/* 服务端接受了提供的会话时, 握手后的master secret与缓存会话相同; 完整握手会重新协商 */
+static uint8_t _core_tls_session_resumed(adapter_network_handle_t *adapter_handle)
+{
+    const mbedtls_ssl_session *session = adapter_handle->mbedtls.ssl_ctx.session;
+
+    return (adapter_handle->mbedtls.session_offered == 1 && session != NULL &&
+            memcmp(session->master, adapter_handle->mbedtls.session_master, sizeof(session->master)) == 0) ? 1 : 0;
+}
+#else
+static void _core_tls_session_load(adapter_network_handle_t *adapter_handle)
+{
+    adapter_handle->mbedtls.session_offered = 0;
+}
+
+static void _core_tls_session_save(adapter_network_handle_t *adapter_handle)
+{
+}
+
+static void _core_tls_session_drop(adapter_network_handle_t *adapter_handle)
+{
+}
+
+static uint8_t _core_tls_session_resumed(adapter_network_handle_t *adapter_handle)
+{
+    return 0;
+}
+#endif
+
+static void _core_tls_handshake_stats(adapter_network_handle_t *adapter_handle, int32_t res, uint64_t time_us)
+{
+    _core_tls_lock();
+    if (res != 0) {
+        g_tls_stats.failed_handshake_count++;
+    } else if (_core_tls_session_resumed(adapter_handle)) {
+        g_tls_stats.resumed_handshake_count++;
+        g_tls_stats.resumed_handshake_time_us += time_us;
+    } else {
+        if (adapter_handle->mbedtls.session_offered == 1) {
+            g_tls_stats.resume_rejected_count++;
+        }
+        g_tls_stats.full_handshake_count++;
+        g_tls_stats.full_handshake_time_us += time_us;
+    }
+    _core_tls_unlock();
+}
+
+/* 记录当前的缓冲区尺寸, 尺寸未变化时不加锁. 读写方向各自只读取和更新自己的缓冲区尺寸 */
+static void _core_tls_conn_update(adapter_network_handle_t *adapter_handle, uint8_t in, uint8_t out)
+{
+    core_sysdep_mbedtls_t *mbedtls = &adapter_handle->mbedtls;
+    uint32_t in_buf_len = 0, out_buf_len = 0;
+
+    if (in == 1) {
+        in_buf_len = CORE_ADAPTER_TLS_IN_BUF_LEN(&mbedtls->ssl_ctx);
+    }
+    if (out == 1) {
+        out_buf_len = CORE_ADAPTER_TLS_OUT_BUF_LEN(&mbedtls->ssl_ctx);
+    }
+    if ((in == 0 || in_buf_len == mbedtls->in_buf_len) && (out == 0 || out_buf_len == mbedtls->out_buf_len)) {
+        return;
+    }
+
+    _core_tls_lock();
+    if (in == 1) {
+        mbedtls->in_buf_len = in_buf_len;
+    }
+    if (out == 1) {
+        mbedtls->out_buf_len = out_buf_len;
+    }
+    if (mbedtls->in_buf_len + mbedtls->out_buf_len > mbedtls->peak_buf_len) {
+        mbedtls->peak_buf_len = mbedtls->in_buf_len + mbedtls->out_buf_len;
+    }
+    _core_tls_unlock();
+}
+
+static void _core_tls_conn_add(adapter_network_handle_t *adapter_handle)
+{
+    _core_tls_lock();
+    if (core_list_empty(&adapter_handle->mbedtls.linked_node)) {
+        core_list_add_tail(&adapter_handle->mbedtls.linked_node, &g_tls_conn_list);
+    }
+    _core_tls_unlock();
+    _core_tls_conn_update(adapter_handle, 1, 1);
+}
+
+static void _core_tls_conn_remove(adapter_network_handle_t *adapter_handle)
+{
+    _core_tls_lock();
+    core_list_del(&adapter_handle->mbedtls.linked_node);
+    _core_tls_unlock();
+}
+
+/* 读超时且已空闲足够久时, 归还按需增长出来的接收缓冲区. 发送缓冲区可能正被另一线程使用, 不在这里收缩 */
+static void _core_tls_conn_recv_idle(adapter_network_handle_t *adapter_handle)
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH) && (CORE_ADAPTER_TLS_BUFFER_IDLE_MS > 0)
+    if (core_time_ms(g_origin_portfile) - adapter_handle->mbedtls.last_recv_time_ms < CORE_ADAPTER_TLS_BUFFER_IDLE_MS) {
+        return;
+    }
+    if (mbedtls_ssl_shrink_in_buffer(&adapter_handle->mbedtls.ssl_ctx) == 0) {
+        _core_tls_conn_update(adapter_handle, 1, 0);
+    }
+#endif
+}
+
+/* 发送前已空闲足够久时, 先归还按需增长出来的发送缓冲区, 本次发送需要时再增长 */
+static void _core_tls_conn_send_idle(adapter_network_handle_t *adapter_handle)
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH) && (CORE_ADAPTER_TLS_BUFFER_IDLE_MS > 0)
+    if (core_time_ms(g_origin_portfile) - adapter_handle->mbedtls.last_send_time_ms < CORE_ADAPTER_TLS_BUFFER_IDLE_MS) {
+        return;
+    }
+    if (mbedtls_ssl_shrink_out_buffer(&adapter_handle->mbedtls.ssl_ctx) == 0) {
+        _core_tls_conn_update(adapter_handle, 0, 1);
+    }
+#endif
+}
+
+/* 建立TLS连接的准备工作: 创建ssl上下文, 设置回调, 取出缓存的会话 */
+static int32_t _core_tls_handshake_prepare(adapter_network_handle_t *adapter_handle)
+{
+    int32_t res = 0;
+    core_log2(g_origin_portfile, STATE_ADAPTER_COMMON, "establish mbedtls connection with server(host='%s', port=[%d])\r\n",
+              adapter_handle->host, &adapter_handle->port);
+
+    if (adapter_handle->cred->max_tls_fragment == 0) {
+        core_log(g_origin_portfile, STATE_ADAPTER_COMMON, "invalid max_tls_fragment parameter\r\n");
+        return STATE_PORT_TLS_INVALID_MAX_FRAGMENT;
+    }
+    res = _core_tls_ctx_acquire(adapter_handle);
+    if (res != 0) {
+        return res;
+    }
+
+    res = mbedtls_ssl_setup(&adapter_handle->mbedtls.ssl_ctx, &adapter_handle->mbedtls.tls_ctx->ssl_config);
     if (res < 0) {
         core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_setup error, res: %x\r\n", &res);
         return res;
     }
+#ifdef MBEDTLS_SSL_PROTO_DTLS
+    if (adapter_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_CLIENT) {
+        mbedtls_ssl_set_timer_cb(&adapter_handle->mbedtls.ssl_ctx, (void *)&adapter_handle->mbedtls.timer_delay_ctx,
+                                 _core_mbedtls_timing_set_delay, _core_mbedtls_timing_get_delay);
+    }
+#endif
 
     if (_host_is_ip(adapter_handle->host) == 0) {
         res = mbedtls_ssl_set_hostname(&adapter_handle->mbedtls.ssl_ctx, adapter_handle->host);
@@ -372,10 +1110,34 @@ int32_t _tls_network_establish(void *handle)
         }
     }
 
-    mbedtls_ssl_set_bio(&adapter_handle->mbedtls.ssl_ctx, adapter_handle->network_handle, _core_mbedtls_net_send,
+    mbedtls_ssl_set_bio(&adapter_handle->mbedtls.ssl_ctx, adapter_handle, _core_mbedtls_net_send,
                         _core_mbedtls_net_recv, _core_mbedtls_net_recv_timeout);
-    mbedtls_ssl_conf_read_timeout(&adapter_handle->mbedtls.ssl_config, adapter_handle->connect_timeout_ms);
+    adapter_handle->mbedtls.read_timeout_ms = adapter_handle->connect_timeout_ms;
+    adapter_handle->mbedtls.send_deadline_ms = core_time_ms(g_origin_portfile) + adapter_handle->connect_timeout_ms;
+
+    _core_tls_session_load(adapter_handle);
+    adapter_handle->mbedtls.hs_start_ns = core_time_ns(g_origin_portfile);
+    adapter_handle->mbedtls.hs_live_bytes = 0;
+    adapter_handle->mbedtls.hs_peak_bytes = 0;
+    adapter_handle->mbedtls.hs_alloc_count = 0;
+    adapter_handle->mbedtls.hs_reuse_count = 0;
+    adapter_handle->mbedtls.hs_state = CORE_ADAPTER_TLS_HS_RUNNING;
+
+    return 0;
+}
 
+/*
+ *  推进握手, 阻塞方式下一直执行到握手结束; 分步方式下底层socket暂时不可读写时返回
+ *  MBEDTLS_ERR_SSL_WANT_READ/MBEDTLS_ERR_SSL_WANT_WRITE. 握手结束时返回0或STATE_PORT_TLS_*错误码
+ */
+static int32_t _core_tls_handshake_run(adapter_network_handle_t *adapter_handle)
+{
+    int32_t res = 0;
+
+    if (adapter_handle->mbedtls.tls_ctx->handshake_serial == 1) {
+        g_origin_portfile->core_sysdep_mutex_lock(adapter_handle->mbedtls.tls_ctx->handshake_mutex);
+    }
+    _core_tls_pool_enter(adapter_handle);
     while ((res = mbedtls_ssl_handshake(&adapter_handle->mbedtls.ssl_ctx)) != 0) {
         if ((res != MBEDTLS_ERR_SSL_WANT_READ) && (res != MBEDTLS_ERR_SSL_WANT_WRITE)) {
             core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_handshake error, res: %x\r\n", &res);
@@ -384,43 +1146,99 @@ int32_t _tls_network_establish(void *handle)
             } else {
                 res = STATE_PORT_TLS_INVALID_HANDSHAKE;
             }
-            return res;
+            break;
+        }
+        if (adapter_handle->mbedtls.nonblocking == 1) {
+            break;
         }
     }
+    _core_tls_pool_leave(adapter_handle);
+    if (adapter_handle->mbedtls.tls_ctx->handshake_serial == 1) {
+        g_origin_portfile->core_sysdep_mutex_unlock(adapter_handle->mbedtls.tls_ctx->handshake_mutex);
+    }
 
-    res = mbedtls_ssl_get_verify_result(&adapter_handle->mbedtls.ssl_ctx);
-    if (res < 0) {
-        core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_get_verify_result error, res: %x\r\n", &res);
+    return res;
+}
+
+/* 握手结束后的收尾: 校验证书, 统计, 保存会话, 登记连接 */
+static int32_t _core_tls_handshake_finish(adapter_network_handle_t *adapter_handle, int32_t res)
+{
+    _core_tls_pool_release(adapter_handle);
+    adapter_handle->mbedtls.nonblocking = 0;
+    adapter_handle->mbedtls.hs_state = CORE_ADAPTER_TLS_HS_IDLE;
+    if (adapter_handle->socket_type == CORE_SYSDEP_SOCKET_TCP_CLIENT) {
+        /* 底层portfile在握手期间关闭了Nagle算法, 握手结束后恢复用户设置的tcp_nodelay */
+        g_origin_portfile->core_sysdep_network_setopt(adapter_handle->network_handle, CORE_SYSDEP_NETWORK_SOCKOPT,
+                &adapter_handle->sockopt);
+    }
+
+    if (res == 0) {
+        res = mbedtls_ssl_get_verify_result(&adapter_handle->mbedtls.ssl_ctx);
+        if (res < 0) {
+            core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_get_verify_result error, res: %x\r\n", &res);
+        }
+    }
+    _core_tls_handshake_stats(adapter_handle, res,
+                              (core_time_ns(g_origin_portfile) - adapter_handle->mbedtls.hs_start_ns) / 1000);
+    if (res != 0) {
+        if (adapter_handle->mbedtls.session_offered == 1) {
+            _core_tls_session_drop(adapter_handle);
+        }
         return res;
     }
+    if (_core_tls_session_resumed(adapter_handle)) {
+        core_log(g_origin_portfile, STATE_ADAPTER_COMMON, "tls session resumed\r\n");
+    }
+    _core_tls_session_save(adapter_handle);
+    mbedtls_platform_zeroize(adapter_handle->mbedtls.session_master, sizeof(adapter_handle->mbedtls.session_master));
 
+    adapter_handle->mbedtls.hs_state = CORE_ADAPTER_TLS_HS_DONE;
+    adapter_handle->mbedtls.last_recv_time_ms = core_time_ms(g_origin_portfile);
+    adapter_handle->mbedtls.last_send_time_ms = adapter_handle->mbedtls.last_recv_time_ms;
+    _core_tls_conn_add(adapter_handle);
     core_log2(g_origin_portfile, STATE_ADAPTER_COMMON,
               "success to establish mbedtls connection, (cost %d bytes in total, max used %d bytes)\r\n",
               &g_mbedtls_total_mem_used, &g_mbedtls_max_mem_used);
+    core_log2(g_origin_portfile, STATE_ADAPTER_COMMON, "tls record buffers: in %d bytes, out %d bytes\r\n",
+              &adapter_handle->mbedtls.in_buf_len, &adapter_handle->mbedtls.out_buf_len);
+    core_log3(g_origin_portfile, STATE_ADAPTER_COMMON, "tls handshake memory: peak %d bytes, %d allocs, %d reused\r\n",
+              &adapter_handle->mbedtls.hs_peak_bytes, &adapter_handle->mbedtls.hs_alloc_count,
+              &adapter_handle->mbedtls.hs_reuse_count);
     return 0;
 }
-int32_t _tls_network_recv(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
-                          core_sysdep_addr_t *addr)
+
+int32_t _tls_network_establish(void *handle)
 {
-    int32_t res = 0;
-    int32_t recv_bytes = 0;
     adapter_network_handle_t *adapter_handle = (adapter_network_handle_t *)handle;
-    if (handle == NULL) {
-        return STATE_PORT_INPUT_NULL_POINTER;
+    int32_t res = 0;
+
+    res = _core_tls_handshake_prepare(adapter_handle);
+    if (res != 0) {
+        return res;
     }
+    res = _core_tls_handshake_run(adapter_handle);
+
+    return _core_tls_handshake_finish(adapter_handle, res);
+}
+/* once为1时读到数据即返回, 否则读满len字节或等到超时 */
+static int32_t _core_tls_network_recv(adapter_network_handle_t *adapter_handle, uint8_t *buffer, uint32_t len,
+                                      uint32_t timeout_ms, uint8_t once)
+{
+    int32_t res = 0;
+    int32_t recv_bytes = 0;
     /*core_log2(g_origin_portfile, STATE_ADAPTER_COMMON, "_tls_network_recv， (cost %d bytes in total, max used %d bytes)\r\n",
         &len, &timeout_ms);*/
 #ifdef MBEDTLS_SSL_PROTO_DTLS
     _core_mbedtls_timing_set_delay(&adapter_handle->mbedtls.timer_delay_ctx, 0, 0);
 #endif
-    mbedtls_ssl_conf_read_timeout(&adapter_handle->mbedtls.ssl_config, timeout_ms);
+    adapter_handle->mbedtls.read_timeout_ms = timeout_ms;
     do {
         res = mbedtls_ssl_read(&adapter_handle->mbedtls.ssl_ctx, buffer + recv_bytes, len - recv_bytes);
         if (res < 0) {
-            if (res == MBEDTLS_ERR_SSL_TIMEOUT) {
+            if (res == MBEDTLS_ERR_SSL_TIMEOUT || res == MBEDTLS_ERR_SSL_WANT_WRITE) {
+                /* WANT_WRITE: 读取中需要回复的告警没能写出, 留待下次发送时写出 */
                 break;
             } else if (res != MBEDTLS_ERR_SSL_WANT_READ &&
-                       res != MBEDTLS_ERR_SSL_WANT_WRITE &&
                        res != MBEDTLS_ERR_SSL_CLIENT_RECONNECT) {
                 if (recv_bytes == 0) {
                     core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_recv error, res: %x\r\n", &res);
@@ -438,60 +1256,99 @@ int32_t _tls_network_recv(void *handle, uint8_t *buffer, uint32_t len, uint32_t
             break;
         } else {
             recv_bytes += res;
-            if(adapter_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_CLIENT) {
+            if(once == 1 || adapter_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_CLIENT) {
                 break;
             }
         }
     } while (recv_bytes < len);
 
+    if (recv_bytes > 0) {
+        adapter_handle->mbedtls.last_recv_time_ms = core_time_ms(g_origin_portfile);
+        _core_tls_conn_update(adapter_handle, 1, 0);
+    } else if (res == MBEDTLS_ERR_SSL_TIMEOUT) {
+        _core_tls_conn_recv_idle(adapter_handle);
+    }
+
     return recv_bytes;
 }
+int32_t _tls_network_recv(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
+                          core_sysdep_addr_t *addr)
+{
+    if (handle == NULL) {
+        return STATE_PORT_INPUT_NULL_POINTER;
+    }
+    return _core_tls_network_recv((adapter_network_handle_t *)handle, buffer, len, timeout_ms, 0);
+}
+/*
+ *  在timeout_ms内尽量写出len字节, 返回已完整写到socket上的明文字节数, 不足len时调用者须从buffer + 返回值处继续发送
+ *
+ *  socket不可写时由底层portfile等待其可写, 最多等到本次调用的截止时间. 截止时一条已加密的记录可能只写出了一部分,
+ *  它的明文不计入返回值, 剩余的密文在下次调用时先写出, 全部写出后才把这条记录的明文计为已发送
+ */
 int32_t _tls_network_send(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
                           core_sysdep_addr_t *addr)
 {
     int32_t res = 0;
-    int32_t send_bytes = 0;
-    uint64_t timestart_ms = 0, timenow_ms = 0;
+    uint32_t send_bytes = 0, record_len = 0;
     adapter_network_handle_t *adapter_handle = (adapter_network_handle_t *)handle;
+    mbedtls_ssl_context *ssl = NULL;
     if (handle == NULL) {
         return STATE_PORT_INPUT_NULL_POINTER;
     }
-    /* Start Time */
-    timestart_ms = g_origin_portfile->core_sysdep_time();
-    timenow_ms = timestart_ms;
-
-    do {
-        timenow_ms = g_origin_portfile->core_sysdep_time();
-
-        if (timenow_ms - timestart_ms >= timenow_ms ||
-            timeout_ms - (timenow_ms - timestart_ms) > timeout_ms) {
-            break;
-        }
-
-        res = mbedtls_ssl_write(&adapter_handle->mbedtls.ssl_ctx, buffer + send_bytes, len - send_bytes);
-        if (res < 0) {
-            if (res != MBEDTLS_ERR_SSL_WANT_READ &&
-                res != MBEDTLS_ERR_SSL_WANT_WRITE) {
-                if (send_bytes == 0) {
-                    core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_send error, res: %x\r\n", &res);
-                    if (res == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
-                        return STATE_PORT_TLS_SEND_CONNECTION_CLOSED;
-                    } else if (res == MBEDTLS_ERR_SSL_INVALID_RECORD) {
-                        return STATE_PORT_TLS_INVALID_RECORD;
-                    } else {
-                        return STATE_PORT_TLS_SEND_FAILED;
-                    }
+    ssl = &adapter_handle->mbedtls.ssl_ctx;
+    adapter_handle->mbedtls.send_deadline_ms = core_time_ms(g_origin_portfile) + timeout_ms;
+    _core_tls_conn_send_idle(adapter_handle);
+
+    while (send_bytes < len) {
+        if (ssl->out_left > 0) {
+            /* 上次调用截止时未写完的记录 */
+            res = mbedtls_ssl_flush_output(ssl);
+            if (res == 0) {
+                record_len = adapter_handle->mbedtls.send_pending_len;
+                adapter_handle->mbedtls.send_pending_len = 0;
+                send_bytes += (record_len > len - send_bytes) ? (len - send_bytes) : record_len;
+                continue;
+            }
+        } else {
+            res = mbedtls_ssl_write(ssl, buffer + send_bytes, len - send_bytes);
+            if (res > 0) {
+                send_bytes += res;
+                continue;
+            }
+            if (res == MBEDTLS_ERR_SSL_WANT_WRITE && ssl->out_left > 0 && ssl->state == MBEDTLS_SSL_HANDSHAKE_OVER &&
+                ssl->out_msgtype == MBEDTLS_SSL_MSG_APPLICATION_DATA) {
+                /* 本次写入的记录已加密, 只写出了一部分, 记下其明文长度, 写完后再计入 */
+                record_len = len - send_bytes;
+                if (record_len > (uint32_t)mbedtls_ssl_get_max_out_record_payload(ssl)) {
+                    record_len = (uint32_t)mbedtls_ssl_get_max_out_record_payload(ssl);
                 }
+                adapter_handle->mbedtls.send_pending_len = record_len;
+            }
+        }
+        if (res == MBEDTLS_ERR_SSL_WANT_WRITE || res == MBEDTLS_ERR_SSL_WANT_READ) {
+            if (core_time_ms(g_origin_portfile) >= adapter_handle->mbedtls.send_deadline_ms) {
                 break;
+            }
+            continue;
+        }
+
+        if (send_bytes == 0) {
+            core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "mbedtls_ssl_send error, res: %x\r\n", &res);
+            if (res == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+                return STATE_PORT_TLS_SEND_CONNECTION_CLOSED;
+            } else if (res == MBEDTLS_ERR_SSL_INVALID_RECORD) {
+                return STATE_PORT_TLS_INVALID_RECORD;
             } else {
-                g_origin_portfile->core_sysdep_sleep(100);
+                return STATE_PORT_TLS_SEND_FAILED;
             }
-        } else if (res == 0) {
-            break;
-        } else {
-            send_bytes += res;
         }
-    } while (((timenow_ms - timestart_ms) < timeout_ms) && (send_bytes < len));
+        break;
+    }
+
+    if (send_bytes > 0) {
+        adapter_handle->mbedtls.last_send_time_ms = core_time_ms(g_origin_portfile);
+        _core_tls_conn_update(adapter_handle, 0, 1);
+    }
 
     return send_bytes;
 }
@@ -512,9 +1369,8 @@ void *adapter_network_init(void)
     adapter_handle->psk.psk = NULL;
     mbedtls_debug_set_threshold(0);
     mbedtls_ssl_init(&adapter_handle->mbedtls.ssl_ctx);
-    mbedtls_ssl_config_init(&adapter_handle->mbedtls.ssl_config);
+    CORE_INIT_LIST_HEAD(&adapter_handle->mbedtls.linked_node);
     mbedtls_platform_set_calloc_free(_core_mbedtls_calloc, _core_mbedtls_free);
-    g_mbedtls_total_mem_used = g_mbedtls_max_mem_used = 0;
 #endif
 
     return adapter_handle;
@@ -592,6 +1448,10 @@ int32_t adapter_network_setopt(void *handle, core_sysdep_network_option_t option
             memcpy(adapter_handle->psk.psk, psk->psk, strlen(psk->psk));
         }
         break;
+        case CORE_SYSDEP_NETWORK_SOCKOPT: {
+            memcpy(&adapter_handle->sockopt, data, sizeof(aiot_sysdep_network_sockopt_t));
+        }
+        break;
 
         default: {
             core_log1(g_origin_portfile, STATE_ADAPTER_COMMON, "adapter_network_setopt unkown option %d\r\n", &option);
@@ -620,6 +1480,60 @@ int32_t adapter_network_establish(void *handle)
 #endif
     return res;
 }
+
+static int32_t adapter_network_get_fd(void *handle)
+{
+    adapter_network_handle_t *adapter_handle = (adapter_network_handle_t *)handle;
+
+    if (handle == NULL) {
+        return STATE_PORT_INPUT_NULL_POINTER;
+    }
+    return g_origin_portfile->core_sysdep_network_get_fd(adapter_handle->network_handle);
+}
+
+int32_t adapter_network_establish_step(void *handle, int32_t *fd)
+{
+    adapter_network_handle_t *adapter_handle = (adapter_network_handle_t *)handle;
+    int32_t res = STATE_SUCCESS;
+
+    if (handle == NULL || fd == NULL) {
+        return STATE_PORT_INPUT_NULL_POINTER;
+    }
+    *fd = -1;
+#ifdef CORE_ADAPTER_MBEDTLS_ENABLED
+    if (adapter_handle->mbedtls.hs_state == CORE_ADAPTER_TLS_HS_DONE) {
+        return STATE_SUCCESS;
+    }
+    if (adapter_handle->mbedtls.hs_state == CORE_ADAPTER_TLS_HS_IDLE) {
+        if (adapter_handle->cred == NULL || adapter_handle->cred->option == AIOT_SYSDEP_NETWORK_CRED_NONE ||
+            adapter_handle->socket_type != CORE_SYSDEP_SOCKET_TCP_CLIENT) {
+            /* 没有握手可分步, DTLS依赖阻塞读超时驱动重传, 也一次完成 */
+            return adapter_network_establish(handle);
+        }
+        res = g_origin_portfile->core_sysdep_network_establish(adapter_handle->network_handle);
+        if (res < STATE_SUCCESS) {
+            return res;
+        }
+        res = _core_tls_handshake_prepare(adapter_handle);
+        if (res != 0) {
+            return res;
+        }
+        adapter_handle->mbedtls.nonblocking = 1;
+    }
+
+    res = _core_tls_handshake_run(adapter_handle);
+    if (res == MBEDTLS_ERR_SSL_WANT_READ || res == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        if (g_origin_portfile->core_sysdep_network_get_fd != NULL) {
+            *fd = g_origin_portfile->core_sysdep_network_get_fd(adapter_handle->network_handle);
+        }
+        return (res == MBEDTLS_ERR_SSL_WANT_READ) ? STATE_PORT_TLS_HANDSHAKE_WANT_READ : STATE_PORT_TLS_HANDSHAKE_WANT_WRITE;
+    }
+
+    return _core_tls_handshake_finish(adapter_handle, res);
+#else
+    return adapter_network_establish(handle);
+#endif
+}
 int32_t adapter_network_recv(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
                              core_sysdep_addr_t *addr)
 {
@@ -639,6 +1553,20 @@ int32_t adapter_network_recv(void *handle, uint8_t *buffer, uint32_t len, uint32
 
     return res;
 }
+static int32_t adapter_network_recv_some(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
+        core_sysdep_addr_t *addr)
+{
+    adapter_network_handle_t *adapter_handle = (adapter_network_handle_t *)handle;
+    if (handle == NULL) {
+        return STATE_PORT_INPUT_NULL_POINTER;
+    }
+#ifdef CORE_ADAPTER_MBEDTLS_ENABLED
+    if (adapter_handle->cred != NULL && adapter_handle->cred->option != AIOT_SYSDEP_NETWORK_CRED_NONE) {
+        return _core_tls_network_recv(adapter_handle, buffer, len, timeout_ms, 1);
+    }
+#endif
+    return g_origin_portfile->core_sysdep_network_recv_some(adapter_handle->network_handle, buffer, len, timeout_ms, addr);
+}
 int32_t adapter_network_send(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
                              core_sysdep_addr_t *addr)
 {
@@ -668,22 +1596,21 @@ int32_t adapter_network_deinit(void **handle)
     }
     adapter_handle = *(adapter_network_handle_t **)handle;
 
-
+#ifdef CORE_ADAPTER_MBEDTLS_ENABLED
+    _core_tls_conn_remove(adapter_handle);
+#endif
     if (adapter_handle->host != NULL) {
         g_origin_portfile->core_sysdep_free(adapter_handle->host);
         adapter_handle->host = NULL;
     }
 #ifdef CORE_ADAPTER_MBEDTLS_ENABLED
+    adapter_handle->mbedtls.nonblocking = 0;
+    adapter_handle->mbedtls.send_deadline_ms = core_time_ms(g_origin_portfile) + CORE_ADAPTER_TLS_CLOSE_NOTIFY_TIMEOUT_MS;
     mbedtls_ssl_close_notify(&adapter_handle->mbedtls.ssl_ctx);
-    if (adapter_handle->cred != NULL && adapter_handle->cred->option == AIOT_SYSDEP_NETWORK_CRED_SVRCERT_CA) {
-        mbedtls_x509_crt_free(&adapter_handle->mbedtls.x509_server_cert);
-        mbedtls_x509_crt_free(&adapter_handle->mbedtls.x509_client_cert);
-        mbedtls_pk_free(&adapter_handle->mbedtls.x509_client_pk);
-    }
     mbedtls_ssl_free(&adapter_handle->mbedtls.ssl_ctx);
-    mbedtls_ssl_config_free(&adapter_handle->mbedtls.ssl_config);
+    _core_tls_pool_release(adapter_handle);
+    _core_tls_ctx_release(adapter_handle);
 
-    g_mbedtls_total_mem_used = g_mbedtls_max_mem_used = 0;
     if (adapter_handle->psk.psk_id != NULL) {
         g_origin_portfile->core_sysdep_free(adapter_handle->psk.psk_id);
         adapter_handle->psk.psk_id = NULL;
@@ -721,12 +1648,81 @@ aiot_sysdep_portfile_t *aiot_sysdep_get_adapter_portfile(aiot_sysdep_portfile_t
     }
     g_origin_portfile = portfile;
     g_aiot_portfile = *portfile;
+#ifdef CORE_ADAPTER_MBEDTLS_ENABLED
+    if (g_tls_mutex == NULL) {
+        g_tls_mutex = portfile->core_sysdep_mutex_init();
+    }
+#endif
     g_aiot_portfile.core_sysdep_network_init = adapter_network.core_sysdep_network_init;
     g_aiot_portfile.core_sysdep_network_setopt = adapter_network.core_sysdep_network_setopt;
     g_aiot_portfile.core_sysdep_network_establish = adapter_network.core_sysdep_network_establish;
     g_aiot_portfile.core_sysdep_network_recv = adapter_network.core_sysdep_network_recv;
     g_aiot_portfile.core_sysdep_network_send = adapter_network.core_sysdep_network_send;
     g_aiot_portfile.core_sysdep_network_deinit = adapter_network.core_sysdep_network_deinit;
+    if (portfile->core_sysdep_network_get_fd != NULL) {
+        g_aiot_portfile.core_sysdep_network_get_fd = adapter_network_get_fd;
+    }
+    if (portfile->core_sysdep_network_recv_some != NULL) {
+        g_aiot_portfile.core_sysdep_network_recv_some = adapter_network_recv_some;
+    }
     return &g_aiot_portfile;
 }
 
+int32_t aiot_sysdep_get_tls_stats(aiot_sysdep_tls_stats_t *stats)
+{
+    if (stats == NULL) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+#ifdef CORE_ADAPTER_MBEDTLS_ENABLED
+    if (g_origin_portfile == NULL) {
+        return STATE_SYS_DEPEND_NOT_SUPPORTED;
+    }
+    _core_tls_lock();
+    memcpy(stats, &g_tls_stats, sizeof(aiot_sysdep_tls_stats_t));
+    _core_tls_unlock();
+
+    return STATE_SUCCESS;
+#else
+    return STATE_SYS_DEPEND_NOT_SUPPORTED;
+#endif
+}
+
+int32_t aiot_sysdep_get_tls_conn_stats(aiot_sysdep_tls_conn_stats_t *stats, uint32_t max_count)
+{
+#ifdef CORE_ADAPTER_MBEDTLS_ENABLED
+    adapter_network_handle_t *adapter_handle = NULL;
+    int32_t count = 0;
+
+    if (stats == NULL && max_count != 0) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+    if (g_origin_portfile == NULL) {
+        return STATE_SYS_DEPEND_NOT_SUPPORTED;
+    }
+
+    _core_tls_lock();
+    core_list_for_each_entry(adapter_handle, &g_tls_conn_list, mbedtls.linked_node, adapter_network_handle_t) {
+        if ((uint32_t)count < max_count) {
+            aiot_sysdep_tls_conn_stats_t *item = &stats[count];
+
+            memset(item, 0, sizeof(aiot_sysdep_tls_conn_stats_t));
+            if (adapter_handle->host != NULL) {
+                strncpy(item->host, adapter_handle->host, AIOT_SYSDEP_TLS_CONN_HOST_MAXLEN - 1);
+            }
+            item->port = adapter_handle->port;
+            item->in_buf_len = adapter_handle->mbedtls.in_buf_len;
+            item->out_buf_len = adapter_handle->mbedtls.out_buf_len;
+            item->peak_buf_len = adapter_handle->mbedtls.peak_buf_len;
+            item->handshake_peak_bytes = adapter_handle->mbedtls.hs_peak_bytes;
+            item->handshake_alloc_count = adapter_handle->mbedtls.hs_alloc_count;
+            item->handshake_reuse_count = adapter_handle->mbedtls.hs_reuse_count;
+        }
+        count++;
+    }
+    _core_tls_unlock();
+
+    return count;
+#else
+    return STATE_SYS_DEPEND_NOT_SUPPORTED;
+#endif
+}
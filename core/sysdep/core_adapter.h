@@ -8,6 +8,28 @@ extern "C" {
 #include "core_stdinc.h"
 #include "aiot_sysdep_api.h"
 
+/**
+ * @brief 分步建立网络连接, 由调用者在同一线程中同时推进多个连接的TLS握手
+ *
+ * @details
+ *
+ * 句柄由设置portfile后的core_sysdep_network_init创建并配置好连接参数. 这个接口并非完全非阻塞:
+ * 首次调用时以阻塞方式建立TCP连接(受连接超时限制), 因为portfile没有非阻塞connect的接口.
+ * 此后每次调用都以0超时读写socket, 把握手推进到socket暂时不可读写为止, 不在SDK内等待; 调用者用poll/epoll等
+ * 等待返回的fd就绪后再次调用. 要求portfile的收发接口接受0超时. 握手的总超时由调用者控制, 放弃时调用core_sysdep_network_deinit.
+ * 不使用TLS或使用DTLS时, 首次调用即以阻塞方式完成建连
+ *
+ * @param[in] handle 网络会话句柄
+ * @param[out] fd 返回WANT_READ/WANT_WRITE时为需要等待的socket描述符, portfile未实现core_sysdep_network_get_fd时为-1
+ *
+ * @return int32_t
+ * @retval STATE_SUCCESS 连接已建立
+ * @retval STATE_PORT_TLS_HANDSHAKE_WANT_READ 等待fd可读后再次调用
+ * @retval STATE_PORT_TLS_HANDSHAKE_WANT_WRITE 等待fd可写后再次调用
+ * @retval <STATE_SUCCESS 建连失败, 与core_sysdep_network_establish的返回值相同
+ */
+int32_t adapter_network_establish_step(void *handle, int32_t *fd);
+
 #if defined(__cplusplus)
 }
 #endif
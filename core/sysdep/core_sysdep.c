@@ -31,3 +31,15 @@ aiot_sysdep_portfile_t * aiot_sysdep_get_portfile(void)
     return g_sysdep_portfile;
 }
 
+
+int32_t aiot_sysdep_get_mem_stats(aiot_sysdep_mem_stats_t *stats, uint32_t max_count)
+{
+    if (stats == NULL && max_count != 0) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+    if (g_sysdep_portfile == NULL || g_sysdep_portfile->core_sysdep_mem_stats == NULL) {
+        return STATE_SYS_DEPEND_NOT_SUPPORTED;
+    }
+
+    return g_sysdep_portfile->core_sysdep_mem_stats(stats, max_count);
+}
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include "core_stdinc.h"
+#include "aiot_state_api.h"
 #include "aiot_sysdep_api.h"
 
 #if defined(__cplusplus)
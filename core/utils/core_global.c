@@ -6,14 +6,39 @@ typedef struct {
     uint32_t used_count;
     int32_t alink_id;
     char mqtt_backup_ip[16];
+    int32_t init_lock;
 } g_core_global_t;
 
-g_core_global_t g_core_global = {NULL, 0, 0, 0, {0}};
+g_core_global_t g_core_global = {NULL, 0, 0, 0, {0}, 0};
+
+/*
+ *  创建/销毁全局互斥锁时还没有可用的互斥锁, portfile提供core_sysdep_atomic_cas时以它实现的自旋锁串行化init/deinit;
+ *  未提供时与以前一样, 要求调用者不要在多个线程中同时初始化/销毁SDK的模块
+ */
+static void _core_global_init_lock(aiot_sysdep_portfile_t *sysdep)
+{
+    if (sysdep->core_sysdep_atomic_cas == NULL) {
+        return;
+    }
+    while (sysdep->core_sysdep_atomic_cas(&g_core_global.init_lock, 0, 1) == 0) {
+        sysdep->core_sysdep_sleep(1);
+    }
+}
+
+static void _core_global_init_unlock(aiot_sysdep_portfile_t *sysdep)
+{
+    if (sysdep->core_sysdep_atomic_cas == NULL) {
+        return;
+    }
+    sysdep->core_sysdep_atomic_cas(&g_core_global.init_lock, 1, 0);
+}
 
 int32_t core_global_init(aiot_sysdep_portfile_t *sysdep)
 {
+    _core_global_init_lock(sysdep);
     if (g_core_global.is_inited == 1) {
         g_core_global.used_count++;
+        _core_global_init_unlock(sysdep);
         return STATE_SUCCESS;
     }
     g_core_global.is_inited = 1;
@@ -21,6 +46,7 @@ int32_t core_global_init(aiot_sysdep_portfile_t *sysdep)
 
     g_core_global.mutex = sysdep->core_sysdep_mutex_init();
     g_core_global.used_count++;
+    _core_global_init_unlock(sysdep);
 
     return STATE_SUCCESS;
 }
@@ -65,11 +91,13 @@ int32_t core_global_get_mqtt_backup_ip(aiot_sysdep_portfile_t *sysdep, char ip[1
 
 int32_t core_global_deinit(aiot_sysdep_portfile_t *sysdep)
 {
+    _core_global_init_lock(sysdep);
     if (g_core_global.used_count > 0) {
         g_core_global.used_count--;
     }
 
     if (g_core_global.used_count != 0) {
+        _core_global_init_unlock(sysdep);
         return STATE_SUCCESS;
     }
     sysdep->core_sysdep_mutex_deinit(&g_core_global.mutex);
@@ -77,7 +105,18 @@ int32_t core_global_deinit(aiot_sysdep_portfile_t *sysdep)
     g_core_global.mutex = NULL;
     g_core_global.is_inited = 0;
     g_core_global.used_count = 0;
+    _core_global_init_unlock(sysdep);
 
     return STATE_SUCCESS;
 }
 
+/* 保护各模块进程级共享资源的创建与销毁, 调用前须已调用core_global_init */
+void core_global_lock(aiot_sysdep_portfile_t *sysdep)
+{
+    sysdep->core_sysdep_mutex_lock(g_core_global.mutex);
+}
+
+void core_global_unlock(aiot_sysdep_portfile_t *sysdep)
+{
+    sysdep->core_sysdep_mutex_unlock(g_core_global.mutex);
+}
@@ -16,6 +16,8 @@ int32_t core_global_alink_id_next(aiot_sysdep_portfile_t *sysdep, int32_t *alink
 int32_t core_global_set_mqtt_backup_ip(aiot_sysdep_portfile_t *sysdep, char ip[16]);
 int32_t core_global_get_mqtt_backup_ip(aiot_sysdep_portfile_t *sysdep, char ip[16]);
 int32_t core_global_deinit(aiot_sysdep_portfile_t *sysdep);
+void core_global_lock(aiot_sysdep_portfile_t *sysdep);
+void core_global_unlock(aiot_sysdep_portfile_t *sysdep);
 
 #if defined(__cplusplus)
 }
@@ -8,6 +8,24 @@
  */
 
 #include "core_http.h"
+#include "core_timer.h"
+#include "core_global.h"
+
+typedef struct {
+    void *network_handle;
+    core_http_conn_key_t key;
+    uint64_t idle_since_ms;
+} core_http_pool_conn_t;
+
+/* 所有HTTP实例共享的空闲连接池, 随第一个实例创建, 最后一个实例销毁时关闭其中的连接 */
+typedef struct {
+    aiot_sysdep_portfile_t *sysdep;
+    void *mutex;
+    uint32_t used_count;
+    core_http_pool_conn_t conn[CORE_HTTP_POOL_MAX_CONNS];
+} core_http_pool_t;
+
+static core_http_pool_t g_core_http_pool;
 
 static void _core_http_exec_inc(core_http_handle_t *http_handle)
 {
@@ -32,6 +50,212 @@ static int32_t _core_http_sysdep_return(int32_t sysdep_code, int32_t core_code)
     }
 }
 
+/* 连接池的引用计数和互斥锁在core_global的锁保护下创建与销毁, 多个线程可以同时创建/销毁HTTP句柄 */
+static int32_t _core_http_pool_init(aiot_sysdep_portfile_t *sysdep)
+{
+    int32_t res = STATE_SUCCESS;
+
+    core_global_lock(sysdep);
+    if (g_core_http_pool.used_count == 0) {
+        g_core_http_pool.mutex = sysdep->core_sysdep_mutex_init();
+        if (g_core_http_pool.mutex == NULL) {
+            res = STATE_SYS_DEPEND_MALLOC_FAILED;
+        } else {
+            g_core_http_pool.sysdep = sysdep;
+        }
+    }
+    if (res == STATE_SUCCESS) {
+        g_core_http_pool.used_count++;
+    }
+    core_global_unlock(sysdep);
+
+    return res;
+}
+
+static void _core_http_conn_key_clean(aiot_sysdep_portfile_t *sysdep, core_http_conn_key_t *key)
+{
+    if (key->host != NULL) {
+        sysdep->core_sysdep_free(key->host);
+    }
+    memset(key, 0, sizeof(core_http_conn_key_t));
+}
+
+static void _core_http_pool_conn_close(core_http_pool_conn_t *conn)
+{
+    g_core_http_pool.sysdep->core_sysdep_network_deinit(&conn->network_handle);
+    _core_http_conn_key_clean(g_core_http_pool.sysdep, &conn->key);
+    conn->idle_since_ms = 0;
+}
+
+static void _core_http_pool_deinit(aiot_sysdep_portfile_t *sysdep)
+{
+    uint32_t idx = 0;
+
+    core_global_lock(sysdep);
+    if (g_core_http_pool.used_count > 0) {
+        g_core_http_pool.used_count--;
+    }
+    if (g_core_http_pool.used_count != 0 || g_core_http_pool.sysdep == NULL) {
+        core_global_unlock(sysdep);
+        return;
+    }
+
+    for (idx = 0; idx < CORE_HTTP_POOL_MAX_CONNS; idx++) {
+        if (g_core_http_pool.conn[idx].network_handle != NULL) {
+            _core_http_pool_conn_close(&g_core_http_pool.conn[idx]);
+        }
+    }
+    g_core_http_pool.sysdep->core_sysdep_mutex_deinit(&g_core_http_pool.mutex);
+    g_core_http_pool.sysdep = NULL;
+    core_global_unlock(sysdep);
+}
+
+/* 结构体逐字节比较, 填充字节不同只会导致不复用 */
+static uint8_t _core_http_conn_key_match(const core_http_conn_key_t *key, core_http_handle_t *http_handle)
+{
+    if (key->host == NULL || strcmp(key->host, http_handle->host) != 0 || key->port != http_handle->port) {
+        return 0;
+    }
+    if (key->has_cred != ((http_handle->cred != NULL) ? 1 : 0) ||
+        (http_handle->cred != NULL && memcmp(&key->cred, http_handle->cred, sizeof(aiot_sysdep_network_cred_t)) != 0)) {
+        return 0;
+    }
+    if (key->has_sockopt != ((http_handle->sockopt != NULL) ? 1 : 0) ||
+        (http_handle->sockopt != NULL &&
+         memcmp(&key->sockopt, http_handle->sockopt, sizeof(aiot_sysdep_network_sockopt_t)) != 0)) {
+        return 0;
+    }
+
+    return 1;
+}
+
+static int32_t _core_http_conn_key_set(core_http_handle_t *http_handle)
+{
+    core_http_conn_key_t *key = &http_handle->conn_key;
+    int32_t res = STATE_SUCCESS;
+
+    _core_http_conn_key_clean(http_handle->sysdep, key);
+    res = core_strdup(http_handle->sysdep, &key->host, http_handle->host, CORE_HTTP_MODULE_NAME);
+    if (res < STATE_SUCCESS) {
+        return res;
+    }
+    key->port = http_handle->port;
+    if (http_handle->cred != NULL) {
+        key->has_cred = 1;
+        memcpy(&key->cred, http_handle->cred, sizeof(aiot_sysdep_network_cred_t));
+    }
+    if (http_handle->sockopt != NULL) {
+        key->has_sockopt = 1;
+        memcpy(&key->sockopt, http_handle->sockopt, sizeof(aiot_sysdep_network_sockopt_t));
+    }
+
+    return STATE_SUCCESS;
+}
+
+/* 接收缓冲区中的数据属于当前连接, 连接断开或重建时一并丢弃 */
+static void _core_http_recv_buffer_reset(core_http_handle_t *http_handle)
+{
+    http_handle->recv_buffer_offset = 0;
+    http_handle->recv_buffer_end = 0;
+}
+
+/*
+ *  交出实例当前的连接: 上一个应答已完整读取且服务端允许保持的连接放回连接池, 池满时替换空闲最久的连接; 其余的直接关闭
+ */
+static void _core_http_conn_release(core_http_handle_t *http_handle)
+{
+    core_http_pool_conn_t evicted;
+    core_http_pool_conn_t *slot = NULL;
+    uint32_t idx = 0;
+
+    memset(&evicted, 0, sizeof(core_http_pool_conn_t));
+    if (http_handle->network_handle != NULL && http_handle->conn_reusable == 1 &&
+        http_handle->recv_buffer_end == http_handle->recv_buffer_offset) {
+        http_handle->sysdep->core_sysdep_mutex_lock(g_core_http_pool.mutex);
+        for (idx = 0; idx < CORE_HTTP_POOL_MAX_CONNS; idx++) {
+            if (g_core_http_pool.conn[idx].network_handle == NULL) {
+                slot = &g_core_http_pool.conn[idx];
+                break;
+            }
+            if (slot == NULL || g_core_http_pool.conn[idx].idle_since_ms < slot->idle_since_ms) {
+                slot = &g_core_http_pool.conn[idx];
+            }
+        }
+        if (slot->network_handle != NULL) {
+            memcpy(&evicted, slot, sizeof(core_http_pool_conn_t));
+        }
+        slot->network_handle = http_handle->network_handle;
+        memcpy(&slot->key, &http_handle->conn_key, sizeof(core_http_conn_key_t));
+        slot->idle_since_ms = http_handle->conn_idle_since_ms;
+        http_handle->sysdep->core_sysdep_mutex_unlock(g_core_http_pool.mutex);
+
+        http_handle->network_handle = NULL;
+        memset(&http_handle->conn_key, 0, sizeof(core_http_conn_key_t));
+        if (evicted.network_handle != NULL) {
+            _core_http_pool_conn_close(&evicted);
+        }
+    } else if (http_handle->network_handle != NULL) {
+        http_handle->sysdep->core_sysdep_network_deinit(&http_handle->network_handle);
+    }
+    _core_http_conn_key_clean(http_handle->sysdep, &http_handle->conn_key);
+    http_handle->conn_reusable = 0;
+    _core_http_recv_buffer_reset(http_handle);
+}
+
+/*
+ *  从连接池中取出与实例当前参数匹配的连接, 顺带关闭超过空闲时长的连接. 空闲较久的连接先试探读取,
+ *  服务端已经关闭(读到断开或出错)或发来了不属于任何请求的数据时丢弃, 由调用者重新建连. 取到时返回1
+ */
+static uint8_t _core_http_conn_acquire(core_http_handle_t *http_handle)
+{
+    core_http_pool_conn_t expired[CORE_HTTP_POOL_MAX_CONNS];
+    core_http_pool_conn_t taken;
+    uint32_t idx = 0, expired_count = 0;
+    uint64_t time_now = core_time_ms(http_handle->sysdep);
+    uint8_t probe = 0;
+    int32_t res = 0;
+
+    memset(&taken, 0, sizeof(core_http_pool_conn_t));
+    http_handle->sysdep->core_sysdep_mutex_lock(g_core_http_pool.mutex);
+    for (idx = 0; idx < CORE_HTTP_POOL_MAX_CONNS; idx++) {
+        core_http_pool_conn_t *conn = &g_core_http_pool.conn[idx];
+
+        if (conn->network_handle == NULL) {
+            continue;
+        }
+        if (time_now - conn->idle_since_ms >= CORE_HTTP_POOL_IDLE_TIMEOUT_MS) {
+            memcpy(&expired[expired_count++], conn, sizeof(core_http_pool_conn_t));
+            memset(conn, 0, sizeof(core_http_pool_conn_t));
+        } else if (taken.network_handle == NULL && _core_http_conn_key_match(&conn->key, http_handle) == 1) {
+            memcpy(&taken, conn, sizeof(core_http_pool_conn_t));
+            memset(conn, 0, sizeof(core_http_pool_conn_t));
+        }
+    }
+    http_handle->sysdep->core_sysdep_mutex_unlock(g_core_http_pool.mutex);
+
+    for (idx = 0; idx < expired_count; idx++) {
+        _core_http_pool_conn_close(&expired[idx]);
+    }
+    if (taken.network_handle == NULL) {
+        return 0;
+    }
+
+    if (time_now - taken.idle_since_ms >= CORE_HTTP_POOL_PROBE_IDLE_MS) {
+        probe = 0;
+        res = http_handle->sysdep->core_sysdep_network_recv(taken.network_handle, &probe, 1, CORE_HTTP_POOL_PROBE_TIMEOUT_MS,
+                NULL);
+        if (res != 0) {
+            _core_http_pool_conn_close(&taken);
+            return 0;
+        }
+    }
+
+    http_handle->network_handle = taken.network_handle;
+    memcpy(&http_handle->conn_key, &taken.key, sizeof(core_http_conn_key_t));
+
+    return 1;
+}
+
 static int32_t _core_http_connect(core_http_handle_t *http_handle)
 {
     int32_t res = STATE_SUCCESS;
@@ -39,13 +263,14 @@ static int32_t _core_http_connect(core_http_handle_t *http_handle)
     uint16_t port = 0;
     uint32_t port_u32 = 0;
     char *ptr = NULL;
-    /* disconnect first if network is already established */
-    if (http_handle->network_handle != NULL) {
-        http_handle->sysdep->core_sysdep_network_deinit(&http_handle->network_handle);
-    }
+    /* hand over the current connection first, then reuse an idle one to the same server if there is any */
+    _core_http_conn_release(http_handle);
     if (http_handle->host == NULL) {
         return STATE_USER_INPUT_MISSING_HOST;
     }
+    if (_core_http_conn_acquire(http_handle) == 1) {
+        return STATE_SUCCESS;
+    }
     if(strlen(http_handle->host) > sizeof(host)){
         return STATE_PORT_INPUT_OUT_RANGE;
     }
@@ -82,6 +307,15 @@ static int32_t _core_http_connect(core_http_handle_t *http_handle)
         return _core_http_sysdep_return(res, STATE_SYS_DEPEND_NWK_INVALID_OPTION);
     }
 
+    if (http_handle->sockopt != NULL) {
+        res = http_handle->sysdep->core_sysdep_network_setopt(http_handle->network_handle, CORE_SYSDEP_NETWORK_SOCKOPT,
+                http_handle->sockopt);
+        if (res < STATE_SUCCESS) {
+            http_handle->sysdep->core_sysdep_network_deinit(&http_handle->network_handle);
+            return _core_http_sysdep_return(res, STATE_SYS_DEPEND_NWK_INVALID_OPTION);
+        }
+    }
+
     if (http_handle->cred != NULL) {
         res = http_handle->sysdep->core_sysdep_network_setopt(http_handle->network_handle, CORE_SYSDEP_NETWORK_CRED,
                 http_handle->cred);
@@ -97,6 +331,12 @@ static int32_t _core_http_connect(core_http_handle_t *http_handle)
         return _core_http_sysdep_return(res, STATE_SYS_DEPEND_NWK_EST_FAILED);
     }
 
+    res = _core_http_conn_key_set(http_handle);
+    if (res < STATE_SUCCESS) {
+        http_handle->sysdep->core_sysdep_network_deinit(&http_handle->network_handle);
+        return res;
+    }
+
     return STATE_SUCCESS;
 }
 
@@ -108,6 +348,7 @@ static int32_t _core_http_send(core_http_handle_t *http_handle, uint8_t *buffer,
         res = http_handle->sysdep->core_sysdep_network_send(http_handle->network_handle, buffer, len, timeout_ms, NULL);
         if (res < STATE_SUCCESS) {
             http_handle->sysdep->core_sysdep_network_deinit(&http_handle->network_handle);
+            _core_http_recv_buffer_reset(http_handle);
             core_log(http_handle->sysdep, STATE_HTTP_LOG_DISCONNECT, "HTTP network error when sending data, disconnect\r\n");
             res = _core_http_sysdep_return(res, STATE_SYS_DEPEND_NWK_SEND_ERR);
         } else if (res != len) {
@@ -147,13 +388,18 @@ static void _core_http_header_print(core_http_handle_t *http_handle, char *prefi
     }
 }
 
+/*
+ *  content不为NULL时与首部拼接后一次发出. 首部和body分两次发送时, 第二次发送要等对端确认第一次(Nagle),
+ *  而服务端收到完整请求前不会应答, 只能等延迟确认超时, 每个请求因此多出几十毫秒
+ */
 static int32_t _core_http_send_header(core_http_handle_t *http_handle, char *method, char *path, char *host,
-                                      char *header, char *content_lenstr)
+                                      char *header, char *content_lenstr, uint8_t *content, uint32_t content_len)
 {
     int32_t res = STATE_SUCCESS;
     char *combine_header = NULL;
     char *combine_header_src[] = { method, path, host, header, content_lenstr};
     uint32_t combine_header_len = 0;
+    uint8_t *combine_request = NULL;
 
     res = core_sprintf(http_handle->sysdep, &combine_header, "%s %s HTTP/1.1\r\nHost: %s\r\n%sContent-Length: %s\r\n\r\n",
                        combine_header_src, sizeof(combine_header_src) / sizeof(char *), CORE_HTTP_MODULE_NAME);
@@ -164,6 +410,20 @@ static int32_t _core_http_send_header(core_http_handle_t *http_handle, char *met
 
     _core_http_header_print(http_handle, ">", combine_header, combine_header_len);
 
+    if (content != NULL) {
+        combine_request = http_handle->sysdep->core_sysdep_malloc(combine_header_len + content_len, CORE_HTTP_MODULE_NAME);
+        if (combine_request == NULL) {
+            http_handle->sysdep->core_sysdep_free(combine_header);
+            return STATE_SYS_DEPEND_MALLOC_FAILED;
+        }
+        memcpy(combine_request, combine_header, combine_header_len);
+        memcpy(combine_request + combine_header_len, content, content_len);
+        http_handle->sysdep->core_sysdep_free(combine_header);
+        combine_header = (char *)combine_request;
+        combine_header_len += content_len;
+        core_log_hexdump(STATE_HTTP_LOG_SEND_CONTENT, '>', content, content_len);
+    }
+
     http_handle->sysdep->core_sysdep_mutex_lock(http_handle->send_mutex);
     res = _core_http_send(http_handle, (uint8_t *)combine_header, combine_header_len, http_handle->send_timeout_ms);
     http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->send_mutex);
@@ -201,6 +461,16 @@ void *core_http_init(void)
     http_handle->send_mutex = http_handle->sysdep->core_sysdep_mutex_init();
     http_handle->recv_mutex = http_handle->sysdep->core_sysdep_mutex_init();
 
+    core_global_init(sysdep);
+    if (_core_http_pool_init(sysdep) < STATE_SUCCESS) {
+        core_global_deinit(sysdep);
+        http_handle->sysdep->core_sysdep_mutex_deinit(&http_handle->data_mutex);
+        http_handle->sysdep->core_sysdep_mutex_deinit(&http_handle->send_mutex);
+        http_handle->sysdep->core_sysdep_mutex_deinit(&http_handle->recv_mutex);
+        sysdep->core_sysdep_free(http_handle);
+        return NULL;
+    }
+
     http_handle->core_exec_enabled = 1;
 
     return http_handle;
@@ -254,6 +524,20 @@ int32_t core_http_setopt(void *handle, core_http_option_t option, void *data)
             http_handle->connect_timeout_ms = *(uint32_t *)data;
         }
         break;
+        case CORE_HTTPOPT_NETWORK_SOCKOPT: {
+            if (http_handle->sockopt != NULL) {
+                http_handle->sysdep->core_sysdep_free(http_handle->sockopt);
+                http_handle->sockopt = NULL;
+            }
+            http_handle->sockopt = http_handle->sysdep->core_sysdep_malloc(sizeof(aiot_sysdep_network_sockopt_t),
+                                   CORE_HTTP_MODULE_NAME);
+            if (http_handle->sockopt != NULL) {
+                memcpy(http_handle->sockopt, data, sizeof(aiot_sysdep_network_sockopt_t));
+            } else {
+                res = STATE_SYS_DEPEND_MALLOC_FAILED;
+            }
+        }
+        break;
         case CORE_HTTPOPT_SEND_TIMEOUT_MS: {
             http_handle->send_timeout_ms = *(uint32_t *)data;
         }
@@ -286,6 +570,26 @@ int32_t core_http_setopt(void *handle, core_http_option_t option, void *data)
             http_handle->core_recv_handler = (aiot_http_recv_handler_t)data;
         }
         break;
+        case CORE_HTTPOPT_BODY_BUFFER: {
+            core_http_body_buffer_t *body_buffer = (core_http_body_buffer_t *)data;
+
+            /* 正在读取的内部缓冲区已被读取方取走, 这里只释放句柄缓存的那一块 */
+            http_handle->sysdep->core_sysdep_mutex_lock(http_handle->recv_mutex);
+            if (http_handle->body_buffer != NULL && http_handle->body_buffer_external == 0) {
+                http_handle->sysdep->core_sysdep_free(http_handle->body_buffer);
+            }
+            if (body_buffer->buffer != NULL && body_buffer->len > 0) {
+                http_handle->body_buffer = body_buffer->buffer;
+                http_handle->body_buffer_len = body_buffer->len;
+                http_handle->body_buffer_external = 1;
+            } else {
+                http_handle->body_buffer = NULL;
+                http_handle->body_buffer_len = 0;
+                http_handle->body_buffer_external = 0;
+            }
+            http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->recv_mutex);
+        }
+        break;
         default: {
             res = STATE_USER_INPUT_UNKNOWN_OPTION;
         }
@@ -329,6 +633,7 @@ int32_t core_http_send(void *handle, const core_http_request_t *request)
 {
     int32_t res = STATE_SUCCESS;
     char content_lenstr[11] = {0};
+    uint8_t merge_content = 0;
     core_http_handle_t *http_handle = (core_http_handle_t *)handle;
 
     if (http_handle == NULL || request == NULL ||
@@ -349,22 +654,27 @@ int32_t core_http_send(void *handle, const core_http_request_t *request)
     }
 
     memset(&http_handle->session, 0, sizeof(core_http_session_t));
+    /* 请求发出后, 连接要等到应答完整读取才能再次复用 */
+    http_handle->conn_reusable = 0;
 
     _core_http_exec_inc(http_handle);
 
-    /* send http header */
+    /* send http header, together with the content if it is small enough */
+    if (request->content != NULL && request->content_len > 0 && request->content_len <= CORE_HTTP_SEND_MERGE_MAX_LEN) {
+        merge_content = 1;
+    }
     core_uint2str(request->content_len, content_lenstr, NULL);
     res = _core_http_send_header(http_handle, request->method, request->path, http_handle->host, request->header,
-                                 content_lenstr);
+                                 content_lenstr, (merge_content == 1) ? request->content : NULL, request->content_len);
     if (res < STATE_SUCCESS) {
         _core_http_exec_dec(http_handle);
         return res;
     } else {
-        res = STATE_SUCCESS;
+        res = (merge_content == 1) ? (int32_t)request->content_len : STATE_SUCCESS;
     }
 
     /* send http content */
-    if (request->content != NULL && request->content_len > 0) {
+    if (merge_content == 0 && request->content != NULL && request->content_len > 0) {
         res = _core_http_send_body(http_handle, request->content, request->content_len);
         if (res < STATE_SUCCESS) {
             _core_http_exec_dec(http_handle);
@@ -427,14 +737,21 @@ static void _core_http_recv_header_pair(core_http_handle_t *http_handle, char *k
     http_handle->sysdep->core_sysdep_free(pair_value);
 }
 
-static int32_t _core_http_recv(core_http_handle_t *http_handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms)
+/* some为1时使用core_sysdep_network_recv_some, 收到数据即返回 */
+static int32_t _core_http_recv(core_http_handle_t *http_handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
+                               uint8_t some)
 {
     int32_t res = STATE_SUCCESS;
 
     if (http_handle->network_handle != NULL) {
-        res = http_handle->sysdep->core_sysdep_network_recv(http_handle->network_handle, buffer, len, timeout_ms, NULL);
+        if (some == 1) {
+            res = http_handle->sysdep->core_sysdep_network_recv_some(http_handle->network_handle, buffer, len, timeout_ms, NULL);
+        } else {
+            res = http_handle->sysdep->core_sysdep_network_recv(http_handle->network_handle, buffer, len, timeout_ms, NULL);
+        }
         if (res < STATE_SUCCESS) {
             http_handle->sysdep->core_sysdep_network_deinit(&http_handle->network_handle);
+            _core_http_recv_buffer_reset(http_handle);
             core_log(http_handle->sysdep, STATE_HTTP_LOG_DISCONNECT, "HTTP network error when receving data, disconnect\r\n");
             res = _core_http_sysdep_return(res, STATE_SYS_DEPEND_NWK_RECV_ERR);
         }
@@ -445,58 +762,176 @@ static int32_t _core_http_recv(core_http_handle_t *http_handle, uint8_t *buffer,
     return res;
 }
 
-static int32_t _core_http_recv_header(core_http_handle_t *http_handle, uint32_t *body_total_len)
+/* 接收缓冲区至少要能放下一整行header, 已缓存的数据在重新分配时保留 */
+static int32_t _core_http_recv_buffer_prepare(core_http_handle_t *http_handle)
 {
-    int32_t res = STATE_SUCCESS;
-    char *line = NULL;
-    uint32_t idx = 0, line_max_len = http_handle->header_line_max_len;
-    uint64_t timenow_ms = 0;
+    uint8_t *buffer = NULL;
+    uint32_t buffer_len = CORE_HTTP_DEFAULT_RECV_BUFFER_LEN, buffered_len = 0;
+
+    if (http_handle->header_line_max_len > buffer_len) {
+        buffer_len = http_handle->header_line_max_len;
+    }
+    if (http_handle->recv_buffer != NULL && http_handle->recv_buffer_len >= buffer_len) {
+        return STATE_SUCCESS;
+    }
 
-    line = http_handle->sysdep->core_sysdep_malloc(line_max_len, CORE_HTTP_MODULE_NAME);
-    if (line == NULL) {
+    buffer = http_handle->sysdep->core_sysdep_malloc(buffer_len, CORE_HTTP_MODULE_NAME);
+    if (buffer == NULL) {
         return STATE_SYS_DEPEND_MALLOC_FAILED;
     }
-    memset(line, 0, line_max_len);
+    if (http_handle->recv_buffer != NULL) {
+        buffered_len = http_handle->recv_buffer_end - http_handle->recv_buffer_offset;
+        memcpy(buffer, http_handle->recv_buffer + http_handle->recv_buffer_offset, buffered_len);
+        http_handle->sysdep->core_sysdep_free(http_handle->recv_buffer);
+    }
+    http_handle->recv_buffer = buffer;
+    http_handle->recv_buffer_len = buffer_len;
+    http_handle->recv_buffer_offset = 0;
+    http_handle->recv_buffer_end = buffered_len;
+
+    return STATE_SUCCESS;
+}
+
+/*
+ *  向接收缓冲区追加数据, 最多等待timeout_ms, 返回本次追加的字节数. 一次调用通常就能拿到完整的应答头以及紧随其后的部分body
+ *
+ *  portfile实现了core_sysdep_network_recv_some时收到数据即返回; 否则先等待第1个字节,
+ *  再以CORE_HTTP_RECV_READAHEAD_TIMEOUT_MS把已经到达的数据尽量读满缓冲区
+ */
+static int32_t _core_http_recv_buffer_fill(core_http_handle_t *http_handle, uint32_t timeout_ms)
+{
+    int32_t res = STATE_SUCCESS;
+    uint32_t buffered_len = http_handle->recv_buffer_end - http_handle->recv_buffer_offset;
+    uint32_t prev_end = 0;
+
+    if (http_handle->recv_buffer_offset > 0) {
+        memmove(http_handle->recv_buffer, http_handle->recv_buffer + http_handle->recv_buffer_offset, buffered_len);
+        http_handle->recv_buffer_offset = 0;
+        http_handle->recv_buffer_end = buffered_len;
+    }
+    prev_end = http_handle->recv_buffer_end;
+    if (prev_end == http_handle->recv_buffer_len) {
+        return 0;
+    }
 
-    timenow_ms = http_handle->sysdep->core_sysdep_time();
-    for (idx = 0; idx < line_max_len;) {
-        if (timenow_ms > http_handle->sysdep->core_sysdep_time()) {
-            timenow_ms = http_handle->sysdep->core_sysdep_time();
+    if (http_handle->sysdep->core_sysdep_network_recv_some != NULL) {
+        res = _core_http_recv(http_handle, http_handle->recv_buffer + prev_end, http_handle->recv_buffer_len - prev_end,
+                              timeout_ms, 1);
+        if (res > 0) {
+            http_handle->recv_buffer_end += res;
         }
-        if (http_handle->sysdep->core_sysdep_time() - timenow_ms >= http_handle->recv_timeout_ms) {
-            res =  STATE_HTTP_HEADER_INVALID;
-            break;
+        return res;
+    }
+
+    res = _core_http_recv(http_handle, http_handle->recv_buffer + prev_end, 1, timeout_ms, 0);
+    if (res <= 0) {
+        return res;
+    }
+    http_handle->recv_buffer_end += res;
+
+    if (CORE_HTTP_RECV_READAHEAD_TIMEOUT_MS > 0 && http_handle->recv_buffer_end < http_handle->recv_buffer_len) {
+        res = _core_http_recv(http_handle, http_handle->recv_buffer + http_handle->recv_buffer_end,
+                              http_handle->recv_buffer_len - http_handle->recv_buffer_end, CORE_HTTP_RECV_READAHEAD_TIMEOUT_MS, 0);
+        if (res < STATE_SUCCESS) {
+            return res;
         }
-        if (idx + 2 > line_max_len) {
-            res = STATE_HTTP_HEADER_BUFFER_TOO_SHORT;
-            break;
+        http_handle->recv_buffer_end += res;
+    }
+
+    return (int32_t)(http_handle->recv_buffer_end - prev_end);
+}
+
+static uint8_t _core_http_header_name_is(char *key, uint32_t key_len, char *name)
+{
+    uint32_t idx = 0;
+
+    if (key_len != strlen(name)) {
+        return 0;
+    }
+    /* 头部字段名和Connection的取值都不区分大小写 */
+    for (idx = 0; idx < key_len; idx++) {
+        char c = (key[idx] >= 'A' && key[idx] <= 'Z') ? (key[idx] - 'A' + 'a') : key[idx];
+        char n = (name[idx] >= 'A' && name[idx] <= 'Z') ? (name[idx] - 'A' + 'a') : name[idx];
+        if (c != n) {
+            return 0;
         }
-        /* read http header, "\r\n" in the end */
-        if ((res = _core_http_recv(http_handle, (uint8_t *)&line[idx], 1,
-                                   http_handle->recv_timeout_ms)) < STATE_SUCCESS) {
-            break;
+    }
+
+    return 1;
+}
+
+static int32_t _core_http_recv_header(core_http_handle_t *http_handle, uint32_t *body_total_len)
+{
+    int32_t res = STATE_SUCCESS;
+    char *line = NULL, *lf = NULL;
+    uint32_t idx = 0, scan_len = 0, buffered_len = 0, line_max_len = http_handle->header_line_max_len;
+    uint32_t status_code = 0;
+    uint8_t content_length_found = 0;
+    uint64_t timeout_at = 0, time_now = 0;
+
+    /* 只有HTTP/1.1且能确定应答边界的连接才允许复用 */
+    http_handle->keep_alive = 0;
+
+    res = _core_http_recv_buffer_prepare(http_handle);
+    if (res < STATE_SUCCESS) {
+        return res;
+    }
+
+    timeout_at = core_time_ms(http_handle->sysdep) + http_handle->recv_timeout_ms;
+    while (1) {
+        /* 在已缓存的数据中查找行尾的"\r\n", scan_len之前的部分已确认不含行尾 */
+        line = (char *)http_handle->recv_buffer + http_handle->recv_buffer_offset;
+        buffered_len = http_handle->recv_buffer_end - http_handle->recv_buffer_offset;
+        lf = NULL;
+        while (scan_len < buffered_len) {
+            lf = memchr(line + scan_len, '\n', buffered_len - scan_len);
+            if (lf == NULL) {
+                scan_len = buffered_len;
+            } else if (lf == line || *(lf - 1) != '\r') {
+                scan_len = (uint32_t)(lf - line) + 1;
+                lf = NULL;
+            } else {
+                break;
+            }
         }
-        idx++;
-        if (res == 0 || (line[idx - 1] != '\r')) {
+
+        if (lf == NULL) {
+            if (buffered_len >= line_max_len) {
+                res = STATE_HTTP_HEADER_BUFFER_TOO_SHORT;
+                break;
+            }
+            time_now = core_time_ms(http_handle->sysdep);
+            if (time_now >= timeout_at) {
+                res = STATE_HTTP_HEADER_INVALID;
+                break;
+            }
+            res = _core_http_recv_buffer_fill(http_handle, (uint32_t)(timeout_at - time_now));
+            if (res < STATE_SUCCESS) {
+                break;
+            }
             continue;
         }
-        if ((res = _core_http_recv(http_handle, (uint8_t *)&line[idx], 1,
-                                   http_handle->recv_timeout_ms)) < STATE_SUCCESS) {
+
+        idx = (uint32_t)(lf - line) + 1;
+        scan_len = 0;
+        if (idx > line_max_len) {
+            res = STATE_HTTP_HEADER_BUFFER_TOO_SHORT;
             break;
         }
-        idx++;
-        if (res == 0 || (line[idx - 1] != '\n')) {
-            continue;
-        }
+        http_handle->recv_buffer_offset += idx;
+        res = STATE_SUCCESS;
 
         core_log2(http_handle->sysdep, STATE_HTTP_LOG_RECV_HEADER, "< %.*s", &idx, line);
         /* next line should be http response body */
         if (idx == 2) {
+            if (content_length_found == 0 && status_code != 204 && status_code != 304) {
+                http_handle->keep_alive = 0;
+            }
             break;
         }
         /* status code */
         if ((idx > (strlen("HTTP/1.1 ") + 3)) && (memcmp(line, "HTTP/1.1 ", strlen("HTTP/1.1 "))) == 0) {
-            uint32_t status_code = 0, code_idx = 0;
+            uint32_t code_idx = 0;
             for (code_idx = strlen("HTTP/1.1 "); code_idx < idx; code_idx++) {
                 if (line[code_idx] < '0' || line[code_idx] > '9') {
                     break;
@@ -508,6 +943,7 @@ static int32_t _core_http_recv_header(core_http_handle_t *http_handle, uint32_t
                 break;
             }
             _core_http_recv_status_code(http_handle, status_code);
+            http_handle->keep_alive = 1;
         }
         /* header */
         {
@@ -516,25 +952,92 @@ static int32_t _core_http_recv_header(core_http_handle_t *http_handle, uint32_t
                 if (line[deli_idx] == ':' && line[deli_idx + 1] == ' ') {
                     if ((deli_idx + 2 == strlen("Content-Length: ")) && (memcmp(line, "Content-Length: ", deli_idx + 2) == 0)) {
                         core_str2uint(&line[deli_idx + 2], (uint32_t)(idx - deli_idx - 4), body_total_len);
+                        content_length_found = 1;
+                    }
+                    if ((_core_http_header_name_is(line, deli_idx, "Connection") == 1 &&
+                         _core_http_header_name_is(&line[deli_idx + 2], (uint32_t)(idx - deli_idx - 4), "close") == 1) ||
+                        _core_http_header_name_is(line, deli_idx, "Transfer-Encoding") == 1) {
+                        http_handle->keep_alive = 0;
                     }
                     _core_http_recv_header_pair(http_handle, line, deli_idx, &line[deli_idx + 2], (uint32_t)(idx - deli_idx - 4));
                 }
             }
         }
-        idx = 0;
-        memset(line, 0, line_max_len);
     }
 
-    http_handle->sysdep->core_sysdep_free(line);
-
     return res;
 }
 
+static void _core_http_recv_body_notify(core_http_handle_t *http_handle, uint8_t *buffer, uint32_t len)
+{
+    aiot_http_recv_t packet;
+
+    core_log_hexdump(STATE_HTTP_LOG_RECV_CONTENT, '<', buffer, len);
+
+    if (http_handle->core_recv_handler != NULL) {
+        http_handle->session.body_read_len += len;
+        memset(&packet, 0, sizeof(aiot_http_recv_t));
+        packet.type = AIOT_HTTPRECV_BODY;
+        packet.data.body.buffer = buffer;
+        packet.data.body.len = len;
+
+        http_handle->core_recv_handler(http_handle, &packet, http_handle->core_userdata);
+    }
+}
+
+/*
+ *  取出本次读取body使用的缓冲区, 长度为chunk_len: 设置了用户缓冲区时直接使用它; 否则取走句柄缓存的内部缓冲区,
+ *  没有缓存或长度与body_buffer_max_len不符时重新分配. 须在recv_mutex保护下调用
+ */
+static uint8_t *_core_http_body_buffer_take(core_http_handle_t *http_handle, uint32_t chunk_len)
+{
+    uint8_t *buffer = NULL;
+
+    if (http_handle->body_buffer_external == 1) {
+        return http_handle->body_buffer;
+    }
+
+    buffer = http_handle->body_buffer;
+    if (buffer != NULL && http_handle->body_buffer_len != chunk_len) {
+        http_handle->sysdep->core_sysdep_free(buffer);
+        buffer = NULL;
+    }
+    http_handle->body_buffer = NULL;
+    http_handle->body_buffer_len = 0;
+
+    if (buffer == NULL) {
+        buffer = http_handle->sysdep->core_sysdep_malloc(chunk_len, CORE_HTTP_MODULE_NAME);
+    }
+
+    return buffer;
+}
+
+/* 回调返回后放回内部缓冲区供下次复用; 期间设置了新的缓冲区或改变了长度时释放它. 须在recv_mutex保护下调用 */
+static void _core_http_body_buffer_put(core_http_handle_t *http_handle, uint8_t *buffer, uint32_t chunk_len,
+                                       uint8_t external)
+{
+    if (external == 1) {
+        return;
+    }
+
+    if (http_handle->body_buffer == NULL && http_handle->body_buffer_external == 0 &&
+        chunk_len == http_handle->body_buffer_max_len) {
+        http_handle->body_buffer = buffer;
+        http_handle->body_buffer_len = chunk_len;
+    } else {
+        http_handle->sysdep->core_sysdep_free(buffer);
+    }
+}
+
+/*
+ *  读取一段body并交给回调. 与读取应答头一样只在读网络时持有recv_mutex, 回调前释放, 回调中可以再调用本句柄的接口.
+ *  内部缓冲区在回调期间归本次读取独占, 回调中设置新的缓冲区不会释放正在使用的这一块
+ */
 static int32_t _core_http_recv_body(core_http_handle_t *http_handle, uint32_t body_total_len)
 {
     int32_t res = STATE_SUCCESS;
-    char *buffer = NULL;
-    uint32_t remaining_len = 0, buffer_len = 0;
+    uint8_t *buffer = NULL, external = 0;
+    uint32_t remaining_len = 0, buffer_len = 0, chunk_len = 0, copied_len = 0;
 
     if (http_handle->session.body_total_len == 0 && body_total_len == 0) {
         return STATE_HTTP_READ_BODY_EMPTY;
@@ -551,33 +1054,58 @@ static int32_t _core_http_recv_body(core_http_handle_t *http_handle, uint32_t bo
         return STATE_HTTP_READ_BODY_FINISHED;
     }
 
-    buffer_len = (remaining_len < http_handle->body_buffer_max_len) ? (remaining_len) : (http_handle->body_buffer_max_len);
+    http_handle->sysdep->core_sysdep_mutex_lock(http_handle->recv_mutex);
+    external = http_handle->body_buffer_external;
+    chunk_len = (external == 1) ? http_handle->body_buffer_len : http_handle->body_buffer_max_len;
+    buffer_len = (remaining_len < chunk_len) ? (remaining_len) : (chunk_len);
 
-    buffer = http_handle->sysdep->core_sysdep_malloc(buffer_len, CORE_HTTP_MODULE_NAME);
+    /* 读取应答头时已经收到的body直接从接收缓冲区交给回调, 不再拷贝 */
+    if (external == 0 && http_handle->recv_buffer_end > http_handle->recv_buffer_offset) {
+        uint8_t *body = http_handle->recv_buffer + http_handle->recv_buffer_offset;
+
+        res = http_handle->recv_buffer_end - http_handle->recv_buffer_offset;
+        if ((uint32_t)res > buffer_len) {
+            res = buffer_len;
+        }
+        http_handle->recv_buffer_offset += res;
+        http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->recv_mutex);
+        _core_http_recv_body_notify(http_handle, body, res);
+        return res;
+    }
+
+    buffer = _core_http_body_buffer_take(http_handle, chunk_len);
     if (buffer == NULL) {
+        http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->recv_mutex);
         return STATE_SYS_DEPEND_MALLOC_FAILED;
     }
-    memset(buffer, 0, buffer_len);
 
-    http_handle->sysdep->core_sysdep_mutex_lock(http_handle->recv_mutex);
-    res = _core_http_recv(http_handle, (uint8_t *)buffer, buffer_len, http_handle->recv_timeout_ms);
+    /* 用户缓冲区要求回调中的body总在其中, 已缓存的部分先拷贝过去, 再从网络读满本次的长度 */
+    if (http_handle->recv_buffer_end > http_handle->recv_buffer_offset) {
+        copied_len = http_handle->recv_buffer_end - http_handle->recv_buffer_offset;
+        if (copied_len > buffer_len) {
+            copied_len = buffer_len;
+        }
+        memcpy(buffer, http_handle->recv_buffer + http_handle->recv_buffer_offset, copied_len);
+        http_handle->recv_buffer_offset += copied_len;
+    }
+    if (copied_len < buffer_len) {
+        res = _core_http_recv(http_handle, buffer + copied_len, buffer_len - copied_len, http_handle->recv_timeout_ms, 0);
+    }
     http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->recv_mutex);
-    if (res > 0) {
-        aiot_http_recv_t packet;
-
-        core_log_hexdump(STATE_HTTP_LOG_RECV_CONTENT, '<', (uint8_t *)buffer, res);
 
-        if (http_handle->core_recv_handler != NULL) {
-            http_handle->session.body_read_len += res;
-            memset(&packet, 0, sizeof(aiot_http_recv_t));
-            packet.type = AIOT_HTTPRECV_BODY;
-            packet.data.body.buffer = (uint8_t *)buffer;
-            packet.data.body.len = res;
-
-            http_handle->core_recv_handler(http_handle, &packet, http_handle->core_userdata);
-        }
+    /* 已拷贝的数据先交给用户, 读取出错留到下一次调用时返回 */
+    if (res >= STATE_SUCCESS) {
+        res += copied_len;
+    } else if (copied_len > 0) {
+        res = copied_len;
+    }
+    if (res > 0) {
+        _core_http_recv_body_notify(http_handle, buffer, res);
     }
-    http_handle->sysdep->core_sysdep_free(buffer);
+
+    http_handle->sysdep->core_sysdep_mutex_lock(http_handle->recv_mutex);
+    _core_http_body_buffer_put(http_handle, buffer, chunk_len, external);
+    http_handle->sysdep->core_sysdep_mutex_unlock(http_handle->recv_mutex);
 
     return res;
 }
@@ -616,6 +1144,10 @@ int32_t core_http_recv(void *handle)
     res = _core_http_recv_body(http_handle, body_total_len);
     if (res == STATE_HTTP_READ_BODY_FINISHED || res == STATE_HTTP_READ_BODY_EMPTY) {
         memset(&http_handle->session, 0, sizeof(core_http_session_t));
+        /* 应答之后还有多余数据时无法确定其归属, 这样的连接不复用 */
+        http_handle->conn_reusable = (http_handle->keep_alive == 1 &&
+                                      http_handle->recv_buffer_end == http_handle->recv_buffer_offset) ? 1 : 0;
+        http_handle->conn_idle_since_ms = core_time_ms(http_handle->sysdep);
     }
 
     _core_http_exec_dec(http_handle);
@@ -651,9 +1183,9 @@ int32_t core_http_deinit(void **p_handle)
         return STATE_HTTP_DEINIT_TIMEOUT;
     }
 
-    if (http_handle->network_handle != NULL) {
-        http_handle->sysdep->core_sysdep_network_deinit(&http_handle->network_handle);
-    }
+    _core_http_conn_release(http_handle);
+    _core_http_pool_deinit(http_handle->sysdep);
+    core_global_deinit(http_handle->sysdep);
 
     if (http_handle->host != NULL) {
         http_handle->sysdep->core_sysdep_free(http_handle->host);
@@ -661,6 +1193,15 @@ int32_t core_http_deinit(void **p_handle)
     if (http_handle->cred != NULL) {
         http_handle->sysdep->core_sysdep_free(http_handle->cred);
     }
+    if (http_handle->sockopt != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->sockopt);
+    }
+    if (http_handle->recv_buffer != NULL) {
+        http_handle->sysdep->core_sysdep_free(http_handle->recv_buffer);
+    }
+    if (http_handle->body_buffer != NULL && http_handle->body_buffer_external == 0) {
+        http_handle->sysdep->core_sysdep_free(http_handle->body_buffer);
+    }
 
     http_handle->sysdep->core_sysdep_mutex_deinit(&http_handle->data_mutex);
     http_handle->sysdep->core_sysdep_mutex_deinit(&http_handle->send_mutex);
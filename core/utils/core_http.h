@@ -25,6 +25,22 @@ typedef struct {
     uint32_t body_read_len;
 } core_http_session_t;
 
+/* 连接复用的匹配条件: 目标地址与建连参数都相同的连接才可以复用 */
+typedef struct {
+    char *host;
+    uint16_t port;
+    uint8_t has_cred;
+    uint8_t has_sockopt;
+    aiot_sysdep_network_cred_t cred;
+    aiot_sysdep_network_sockopt_t sockopt;
+} core_http_conn_key_t;
+
+/* 用户提供的body接收缓冲区, body直接读入其中, 在回调中原地交给用户, 不再经过内部缓冲区 */
+typedef struct {
+    uint8_t *buffer;
+    uint32_t len;
+} core_http_body_buffer_t;
+
 typedef struct {
     uint32_t code;
     uint8_t *content;
@@ -49,6 +65,7 @@ typedef struct {
     uint32_t header_line_max_len;
     uint32_t body_buffer_max_len;
     aiot_sysdep_network_cred_t *cred;
+    aiot_sysdep_network_sockopt_t *sockopt;
     char *token;
     uint8_t long_connection;
     uint8_t exec_enabled;
@@ -58,7 +75,27 @@ typedef struct {
     void *data_mutex;
     void *send_mutex;
     void *recv_mutex;
+    void *report_mutex;
     core_http_session_t session;
+    uint8_t *recv_buffer;
+    uint32_t recv_buffer_len;
+    uint32_t recv_buffer_offset;
+    uint32_t recv_buffer_end;
+    core_http_conn_key_t conn_key;
+    uint8_t keep_alive;
+    uint8_t conn_reusable;
+    uint64_t conn_idle_since_ms;
+    uint8_t *body_buffer;
+    uint32_t body_buffer_len;
+    uint8_t body_buffer_external;
+    core_http_response_t response;
+    uint32_t pipeline_max_count;
+    uint32_t pipeline_count;
+    uint8_t *batch_buffer;
+    uint32_t batch_buffer_len;
+    uint32_t batch_max_len;
+    uint32_t batch_len;
+    char *batch_topic;
     aiot_http_event_handler_t event_handler;
     aiot_http_recv_handler_t recv_handler;
     aiot_http_recv_handler_t core_recv_handler;
@@ -74,8 +111,39 @@ typedef struct {
 #define CORE_HTTP_DEFAULT_SEND_TIMEOUT_MS          (5 * 1000)
 #define CORE_HTTP_DEFAULT_RECV_TIMEOUT_MS          (5 * 1000)
 #define CORE_HTTP_DEFAULT_HEADER_LINE_MAX_LEN      (128)
-#define CORE_HTTP_DEFAULT_BODY_MAX_LEN             (128)
+#define CORE_HTTP_DEFAULT_BODY_MAX_LEN             (1024)
 #define CORE_HTTP_DEFAULT_DEINIT_TIMEOUT_MS        (2 * 1000)
+#define CORE_HTTP_DEFAULT_HOST                     "iot-as-http.cn-shanghai.aliyuncs.com"
+#define CORE_HTTP_DEFAULT_PORT                     (443)
+#define CORE_HTTP_DEFAULT_PIPELINE_MAX_COUNT       (1)
+/* 应答body中只需要解析code和token等字段, 超出该长度的部分不保存 */
+#define CORE_HTTP_RESPONSE_MAX_LEN                 (1024)
+/* 连接池中最多保留的空闲连接数 */
+#ifndef CORE_HTTP_POOL_MAX_CONNS
+    #define CORE_HTTP_POOL_MAX_CONNS               (4)
+#endif
+/* 空闲连接的保留时长, 应小于服务端的keep-alive超时 */
+#ifndef CORE_HTTP_POOL_IDLE_TIMEOUT_MS
+    #define CORE_HTTP_POOL_IDLE_TIMEOUT_MS         (15 * 1000)
+#endif
+/* 空闲超过该时长的连接在复用前先试探读取一次, 服务端已关闭的连接直接丢弃并重新建连 */
+#ifndef CORE_HTTP_POOL_PROBE_IDLE_MS
+    #define CORE_HTTP_POOL_PROBE_IDLE_MS           (1000)
+#endif
+#define CORE_HTTP_POOL_PROBE_TIMEOUT_MS            (1)
+/* 不超过该长度的请求body与首部拼接后一次发送, 更长的body单独发送以免整段拷贝 */
+#ifndef CORE_HTTP_SEND_MERGE_MAX_LEN
+    #define CORE_HTTP_SEND_MERGE_MAX_LEN           (4 * 1024)
+#endif
+/* 连接级接收缓冲区的最小长度, 小于header_line_max_len时取header_line_max_len */
+#define CORE_HTTP_DEFAULT_RECV_BUFFER_LEN          (1024)
+/*
+ *  portfile未实现core_sysdep_network_recv_some时, 接收缓冲区收到第1个字节后继续读取已到达的数据最多等待的时间.
+ *  应答小于接收缓冲区时每次都要等满这段时间; 定义为0时不预读, 逐字节读取应答头
+ */
+#ifndef CORE_HTTP_RECV_READAHEAD_TIMEOUT_MS
+    #define CORE_HTTP_RECV_READAHEAD_TIMEOUT_MS    (1)
+#endif
 
 typedef enum {
     CORE_HTTPOPT_HOST,                  /* 数据类型: (char *), 服务器域名, 默认值: iot-as-http.cn-shanghai.aliyuncs.com        */
@@ -91,6 +159,8 @@ typedef enum {
     /* 以上选项配置的数据与 AIOT_HTTPOPT_XXX 共用 */
     CORE_HTTPOPT_USERDATA,              /* 数据类型: (void *), 用户上下文数据指针, 默认值: NULL                                */
     CORE_HTTPOPT_RECV_HANDLER,          /* 数据类型: (aiot_http_event_handler_t), 用户数据接受回调函数, 默认值: NULL           */
+    CORE_HTTPOPT_NETWORK_SOCKOPT,       /* 数据类型: (aiot_sysdep_network_sockopt_t *), socket调优参数, 默认值: NULL           */
+    CORE_HTTPOPT_BODY_BUFFER,           /* 数据类型: (core_http_body_buffer_t *), 用户提供的body接收缓冲区, 默认值: NULL        */
     CORE_HTTPOPT_MAX
 } core_http_option_t;
 
@@ -129,6 +199,11 @@ int32_t core_http_setopt(void *handle, core_http_option_t option, void *data);
 /**
  * @brief 建立网络连接
  *
+ * @details
+ *
+ * 进程内所有HTTP实例共享一个连接池: 应答读取完毕且服务端未要求关闭(Connection: close)的连接在实例改连其它服务器或销毁时
+ * 放回连接池, 目标地址, 端口, 安全凭证与socket参数都相同的实例再次建连时直接取用, 不必重新握手
+ *
  * @param handle HTTP句柄
  * @return int32_t
  * @retval STATE_SUCCESS 网络连接建立成功
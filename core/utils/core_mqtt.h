@@ -12,6 +12,8 @@ extern "C" {
 #include "core_auth.h"
 #include "core_global.h"
 #include "core_diag.h"
+#include "core_timer.h"
+#include "core_sync.h"
 #include "aiot_state_api.h"
 #include "aiot_sysdep_api.h"
 #include "aiot_mqtt_api.h"
@@ -175,6 +177,7 @@ typedef struct {
     uint8_t     max_lost_times;
     uint32_t    lost_times;
     uint64_t    last_send_time;
+    int32_t     send_res;        /* 本轮process中心跳定时器发送PINGREQ的结果 */
 } core_mqtt_heartbeat_t;
 
 typedef struct {
@@ -186,6 +189,19 @@ typedef struct {
     int32_t  reconnect_counter;
 } core_mqtt_reconnect_t;
 
+/*
+ * 建连/重连分阶段执行, 只有PREPARE/PACKET阶段短暂持有data_mutex, SWAP阶段短暂持有send_mutex和recv_mutex,
+ * 耗时的DNS解析、TCP建连、TLS握手和CONNACK等待都在新的network handle上无锁完成, 成功后再原子替换
+ */
+typedef enum {
+    CORE_MQTT_CONN_STAGE_IDLE,          /* 当前没有建连流程在执行 */
+    CORE_MQTT_CONN_STAGE_PREPARE,       /* 生成认证信息, 创建并配置新的network handle */
+    CORE_MQTT_CONN_STAGE_ESTABLISH,     /* 建立TCP/TLS连接 */
+    CORE_MQTT_CONN_STAGE_PACKET,        /* 生成clientid和CONNECT报文 */
+    CORE_MQTT_CONN_STAGE_CONNACK,       /* 发送CONNECT报文并等待CONNACK */
+    CORE_MQTT_CONN_STAGE_SWAP           /* 用新的network handle替换旧的network handle */
+} core_mqtt_conn_stage_t;
+
 typedef struct {
     /* network info */
     uint8_t network_type;       /* 0: TCP, 1: TLS */
@@ -250,18 +266,21 @@ typedef struct {
     uint32_t recv_timeout_ms;
     uint32_t repub_timeout_ms;
     aiot_sysdep_network_cred_t *cred;
+    aiot_sysdep_network_sockopt_t *sockopt;
     uint8_t topic_header_check;
     uint8_t has_connected;
     uint8_t disconnected;
     uint8_t disconnect_api_called;
+    core_mqtt_conn_stage_t conn_stage;
     uint8_t exec_enabled;
-    uint32_t exec_count;
+    int32_t exec_count;
+    void *exec_cond;    /* exec_count降为0时唤醒aiot_mqtt_deinit, 与data_mutex配合使用 */
     uint32_t deinit_timeout_ms;
     uint16_t packet_id;
     void *data_mutex;
     void *send_mutex;
     void *recv_mutex;
-    void *sub_mutex;
+    void *sub_rwlock;   /* 收到PUBLISH时查找订阅列表持有读锁, 增删订阅持有写锁 */
     void *pub_mutex;
     void *process_handler_mutex;
     struct core_list_head sub_list;
@@ -273,6 +292,10 @@ typedef struct {
     core_mqtt_compress_data_t decompress;
     /* network info stats */
     core_mqtt_nwkstats_info_t nwkstats_info;
+    /* 心跳与QoS1重发定时器, 由aiot_mqtt_process驱动 */
+    core_timer_service_t timer_service;
+    core_timer_t heartbeat_timer;
+    core_timer_t repub_timer;
 
     void *userdata;
     uint16_t repub_list_limit;
@@ -0,0 +1,132 @@
+#include "core_sync.h"
+
+static uint8_t _core_rwlock_supported(aiot_sysdep_portfile_t *sysdep)
+{
+    return (sysdep->core_sysdep_rwlock_init != NULL && sysdep->core_sysdep_rwlock_rdlock != NULL &&
+            sysdep->core_sysdep_rwlock_wrlock != NULL && sysdep->core_sysdep_rwlock_unlock != NULL &&
+            sysdep->core_sysdep_rwlock_deinit != NULL) ? 1 : 0;
+}
+
+static uint8_t _core_cond_supported(aiot_sysdep_portfile_t *sysdep)
+{
+    return (sysdep->core_sysdep_cond_init != NULL && sysdep->core_sysdep_cond_wait != NULL &&
+            sysdep->core_sysdep_cond_broadcast != NULL && sysdep->core_sysdep_cond_deinit != NULL) ? 1 : 0;
+}
+
+void *core_rwlock_init(aiot_sysdep_portfile_t *sysdep)
+{
+    if (_core_rwlock_supported(sysdep)) {
+        return sysdep->core_sysdep_rwlock_init();
+    }
+
+    return sysdep->core_sysdep_mutex_init();
+}
+
+void core_rwlock_rdlock(aiot_sysdep_portfile_t *sysdep, void *rwlock)
+{
+    if (_core_rwlock_supported(sysdep)) {
+        sysdep->core_sysdep_rwlock_rdlock(rwlock);
+    } else {
+        sysdep->core_sysdep_mutex_lock(rwlock);
+    }
+}
+
+void core_rwlock_wrlock(aiot_sysdep_portfile_t *sysdep, void *rwlock)
+{
+    if (_core_rwlock_supported(sysdep)) {
+        sysdep->core_sysdep_rwlock_wrlock(rwlock);
+    } else {
+        sysdep->core_sysdep_mutex_lock(rwlock);
+    }
+}
+
+void core_rwlock_unlock(aiot_sysdep_portfile_t *sysdep, void *rwlock)
+{
+    if (_core_rwlock_supported(sysdep)) {
+        sysdep->core_sysdep_rwlock_unlock(rwlock);
+    } else {
+        sysdep->core_sysdep_mutex_unlock(rwlock);
+    }
+}
+
+void core_rwlock_deinit(aiot_sysdep_portfile_t *sysdep, void **rwlock)
+{
+    if (_core_rwlock_supported(sysdep)) {
+        sysdep->core_sysdep_rwlock_deinit(rwlock);
+    } else {
+        sysdep->core_sysdep_mutex_deinit(rwlock);
+    }
+}
+
+void *core_cond_init(aiot_sysdep_portfile_t *sysdep)
+{
+    if (_core_cond_supported(sysdep)) {
+        return sysdep->core_sysdep_cond_init();
+    }
+
+    return NULL;
+}
+
+void core_cond_wait(aiot_sysdep_portfile_t *sysdep, void *cond, void *mutex, uint32_t timeout_ms)
+{
+    if (cond != NULL) {
+        sysdep->core_sysdep_cond_wait(cond, mutex, timeout_ms);
+        return;
+    }
+
+    sysdep->core_sysdep_mutex_unlock(mutex);
+    sysdep->core_sysdep_sleep((timeout_ms < CORE_SYNC_COND_POLL_INTERVAL_MS) ? timeout_ms : CORE_SYNC_COND_POLL_INTERVAL_MS);
+    sysdep->core_sysdep_mutex_lock(mutex);
+}
+
+void core_cond_broadcast(aiot_sysdep_portfile_t *sysdep, void *cond)
+{
+    if (cond != NULL) {
+        sysdep->core_sysdep_cond_broadcast(cond);
+    }
+}
+
+void core_cond_deinit(aiot_sysdep_portfile_t *sysdep, void **cond)
+{
+    if (*cond != NULL) {
+        sysdep->core_sysdep_cond_deinit(cond);
+    }
+}
+
+int32_t core_atomic_add(aiot_sysdep_portfile_t *sysdep, void *mutex, int32_t *value, int32_t delta)
+{
+    int32_t res = 0;
+
+    if (sysdep->core_sysdep_atomic_add != NULL) {
+        return sysdep->core_sysdep_atomic_add(value, delta);
+    }
+
+    sysdep->core_sysdep_mutex_lock(mutex);
+    *value += delta;
+    res = *value;
+    sysdep->core_sysdep_mutex_unlock(mutex);
+
+    return res;
+}
+
+/* *value小于candidate时更新为candidate, 用于并发更新峰值; 比较与写入之间被其它线程改写时重试 */
+void core_atomic_max(aiot_sysdep_portfile_t *sysdep, void *mutex, int32_t *value, int32_t candidate)
+{
+    int32_t current = 0;
+
+    if (sysdep->core_sysdep_atomic_cas != NULL) {
+        do {
+            current = *(volatile int32_t *)value;
+            if (current >= candidate) {
+                return;
+            }
+        } while (sysdep->core_sysdep_atomic_cas(value, current, candidate) == 0);
+        return;
+    }
+
+    sysdep->core_sysdep_mutex_lock(mutex);
+    if (*value < candidate) {
+        *value = candidate;
+    }
+    sysdep->core_sysdep_mutex_unlock(mutex);
+}
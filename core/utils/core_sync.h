@@ -0,0 +1,43 @@
+#ifndef _CORE_SYNC_H_
+#define _CORE_SYNC_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "core_stdinc.h"
+#include "aiot_state_api.h"
+#include "aiot_sysdep_api.h"
+
+/*
+ * 读写锁、条件变量与原子操作
+ *
+ * + portfile实现了对应的可选接口时直接使用, 否则退化为互斥锁实现
+ * + 读写锁退化为互斥锁: 读锁与写锁都是独占的
+ * + 条件变量退化为睡眠轮询: core_cond_create返回NULL, core_cond_wait释放mutex后最多睡眠CORE_SYNC_COND_POLL_INTERVAL_MS
+ * + 原子操作退化为在调用者传入的mutex保护下计算
+ */
+
+/* 条件变量不可用时, 每次轮询的最长睡眠时间 */
+#define CORE_SYNC_COND_POLL_INTERVAL_MS     (10)
+
+void *core_rwlock_init(aiot_sysdep_portfile_t *sysdep);
+void core_rwlock_rdlock(aiot_sysdep_portfile_t *sysdep, void *rwlock);
+void core_rwlock_wrlock(aiot_sysdep_portfile_t *sysdep, void *rwlock);
+void core_rwlock_unlock(aiot_sysdep_portfile_t *sysdep, void *rwlock);
+void core_rwlock_deinit(aiot_sysdep_portfile_t *sysdep, void **rwlock);
+
+void *core_cond_init(aiot_sysdep_portfile_t *sysdep);
+void core_cond_wait(aiot_sysdep_portfile_t *sysdep, void *cond, void *mutex, uint32_t timeout_ms);
+void core_cond_broadcast(aiot_sysdep_portfile_t *sysdep, void *cond);
+void core_cond_deinit(aiot_sysdep_portfile_t *sysdep, void **cond);
+
+int32_t core_atomic_add(aiot_sysdep_portfile_t *sysdep, void *mutex, int32_t *value, int32_t delta);
+void core_atomic_max(aiot_sysdep_portfile_t *sysdep, void *mutex, int32_t *value, int32_t candidate);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
+
@@ -0,0 +1,150 @@
+#include "core_timer.h"
+
+#define CORE_TIMER_NS_PER_MS    (1000000)
+#define CORE_TIMER_WAIT_FOREVER (0xFFFFFFFF)
+
+uint64_t core_time_ns(aiot_sysdep_portfile_t *sysdep)
+{
+    if (sysdep->core_sysdep_time_ns != NULL) {
+        return sysdep->core_sysdep_time_ns();
+    }
+
+    return sysdep->core_sysdep_time() * CORE_TIMER_NS_PER_MS;
+}
+
+uint64_t core_time_ms(aiot_sysdep_portfile_t *sysdep)
+{
+    if (sysdep->core_sysdep_time_ns != NULL) {
+        return sysdep->core_sysdep_time_ns() / CORE_TIMER_NS_PER_MS;
+    }
+
+    return sysdep->core_sysdep_time();
+}
+
+int32_t core_timer_service_init(core_timer_service_t *service, aiot_sysdep_portfile_t *sysdep)
+{
+    memset(service, 0, sizeof(core_timer_service_t));
+    service->sysdep = sysdep;
+    service->mutex = sysdep->core_sysdep_mutex_init();
+    if (service->mutex == NULL) {
+        return STATE_SYS_DEPEND_MALLOC_FAILED;
+    }
+    CORE_INIT_LIST_HEAD(&service->timer_list);
+
+    return STATE_SUCCESS;
+}
+
+void core_timer_service_deinit(core_timer_service_t *service)
+{
+    core_timer_t *node = NULL, *next = NULL;
+
+    if (service->mutex == NULL) {
+        return;
+    }
+
+    service->sysdep->core_sysdep_mutex_lock(service->mutex);
+    core_list_for_each_entry_safe(node, next, &service->timer_list, linked_node, core_timer_t) {
+        core_list_del(&node->linked_node);
+        node->active = 0;
+    }
+    service->sysdep->core_sysdep_mutex_unlock(service->mutex);
+
+    service->sysdep->core_sysdep_mutex_deinit(&service->mutex);
+}
+
+void core_timer_init(core_timer_t *timer, core_timer_handler_t handler, void *userdata)
+{
+    memset(timer, 0, sizeof(core_timer_t));
+    timer->handler = handler;
+    timer->userdata = userdata;
+    CORE_INIT_LIST_HEAD(&timer->linked_node);
+}
+
+static void _core_timer_insert(core_timer_service_t *service, core_timer_t *timer, uint64_t deadline_ns)
+{
+    core_timer_t *node = NULL;
+
+    if (timer->active) {
+        core_list_del(&timer->linked_node);
+    }
+    timer->deadline_ns = deadline_ns;
+    timer->active = 1;
+
+    core_list_for_each_entry(node, &service->timer_list, linked_node, core_timer_t) {
+        if (node->deadline_ns > deadline_ns) {
+            break;
+        }
+    }
+    /* 插入到第一个更晚到期的定时器之前 */
+    core_list_add_tail(&timer->linked_node, &node->linked_node);
+}
+
+void core_timer_start(core_timer_service_t *service, core_timer_t *timer, uint64_t timeout_ms)
+{
+    uint64_t deadline_ns = core_time_ns(service->sysdep) + timeout_ms * CORE_TIMER_NS_PER_MS;
+
+    service->sysdep->core_sysdep_mutex_lock(service->mutex);
+    _core_timer_insert(service, timer, deadline_ns);
+    service->sysdep->core_sysdep_mutex_unlock(service->mutex);
+}
+
+void core_timer_start_at(core_timer_service_t *service, core_timer_t *timer, uint64_t deadline_ms)
+{
+    service->sysdep->core_sysdep_mutex_lock(service->mutex);
+    _core_timer_insert(service, timer, deadline_ms * CORE_TIMER_NS_PER_MS);
+    service->sysdep->core_sysdep_mutex_unlock(service->mutex);
+}
+
+void core_timer_stop(core_timer_service_t *service, core_timer_t *timer)
+{
+    service->sysdep->core_sysdep_mutex_lock(service->mutex);
+    if (timer->active) {
+        core_list_del(&timer->linked_node);
+        timer->active = 0;
+    }
+    service->sysdep->core_sysdep_mutex_unlock(service->mutex);
+}
+
+uint8_t core_timer_active(core_timer_service_t *service, core_timer_t *timer)
+{
+    uint8_t active = 0;
+
+    service->sysdep->core_sysdep_mutex_lock(service->mutex);
+    active = timer->active;
+    service->sysdep->core_sysdep_mutex_unlock(service->mutex);
+
+    return active;
+}
+
+/* 执行所有到期的定时器, 返回距离下一个定时器到期的毫秒数, 没有定时器时返回0xFFFFFFFF */
+uint32_t core_timer_process(core_timer_service_t *service)
+{
+    uint64_t time_now_ns = core_time_ns(service->sysdep), wait_ns = 0;
+    core_timer_t *timer = NULL;
+    uint32_t wait_ms = CORE_TIMER_WAIT_FOREVER;
+
+    while (1) {
+        service->sysdep->core_sysdep_mutex_lock(service->mutex);
+        if (core_list_empty(&service->timer_list)) {
+            service->sysdep->core_sysdep_mutex_unlock(service->mutex);
+            break;
+        }
+        timer = core_list_first_entry(&service->timer_list, core_timer_t, linked_node);
+        if (timer->deadline_ns > time_now_ns) {
+            wait_ns = timer->deadline_ns - time_now_ns;
+            wait_ms = (wait_ns / CORE_TIMER_NS_PER_MS >= CORE_TIMER_WAIT_FOREVER) ?
+                      CORE_TIMER_WAIT_FOREVER - 1 : (uint32_t)((wait_ns + CORE_TIMER_NS_PER_MS - 1) / CORE_TIMER_NS_PER_MS);
+            service->sysdep->core_sysdep_mutex_unlock(service->mutex);
+            break;
+        }
+        core_list_del(&timer->linked_node);
+        timer->active = 0;
+        service->sysdep->core_sysdep_mutex_unlock(service->mutex);
+
+        /* 回调中重新启动的定时器, 其到期时间基于新读取的时钟, 不会在本轮再次执行 */
+        timer->handler(timer, time_now_ns / CORE_TIMER_NS_PER_MS, timer->userdata);
+    }
+
+    return wait_ms;
+}
+
@@ -0,0 +1,64 @@
+#ifndef _CORE_TIMER_H_
+#define _CORE_TIMER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "core_stdinc.h"
+#include "core_list.h"
+#include "aiot_state_api.h"
+#include "aiot_sysdep_api.h"
+
+/*
+ * 单调时间与定时器服务
+ *
+ * + core_time_ns/core_time_ms优先使用portfile中的core_sysdep_time_ns, 不受系统时间调整影响;
+ *   portfile未实现时退化为core_sysdep_time
+ * + 各模块把超时/周期任务注册为定时器, 由所属模块的process接口调用core_timer_process统一检查,
+ *   每次检查只读取一次时钟, 到期的定时器回调在不持有服务锁的情况下执行, 回调中可以重新启动定时器
+ */
+
+typedef struct core_timer core_timer_t;
+
+/**
+ * @brief 定时器到期回调
+ *
+ * @param[in] timer 到期的定时器
+ * @param[in] time_now_ms 本轮检查读取的单调时间
+ * @param[in] userdata 启动定时器时传入的用户数据
+ */
+typedef void (*core_timer_handler_t)(core_timer_t *timer, uint64_t time_now_ms, void *userdata);
+
+struct core_timer {
+    uint64_t deadline_ns;
+    uint8_t active;
+    core_timer_handler_t handler;
+    void *userdata;
+    struct core_list_head linked_node;
+};
+
+typedef struct {
+    aiot_sysdep_portfile_t *sysdep;
+    void *mutex;
+    struct core_list_head timer_list;   /* 按deadline_ns升序 */
+} core_timer_service_t;
+
+uint64_t core_time_ns(aiot_sysdep_portfile_t *sysdep);
+uint64_t core_time_ms(aiot_sysdep_portfile_t *sysdep);
+
+int32_t core_timer_service_init(core_timer_service_t *service, aiot_sysdep_portfile_t *sysdep);
+void core_timer_service_deinit(core_timer_service_t *service);
+void core_timer_init(core_timer_t *timer, core_timer_handler_t handler, void *userdata);
+void core_timer_start(core_timer_service_t *service, core_timer_t *timer, uint64_t timeout_ms);
+void core_timer_start_at(core_timer_service_t *service, core_timer_t *timer, uint64_t deadline_ms);
+void core_timer_stop(core_timer_service_t *service, core_timer_t *timer);
+uint8_t core_timer_active(core_timer_service_t *service, core_timer_t *timer);
+uint32_t core_timer_process(core_timer_service_t *service);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
+
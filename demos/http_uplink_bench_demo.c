@@ -0,0 +1,349 @@
+/*
+ * 这个例程用于测量通过aiot_http接口上报数据的消息速率, 对比不同的连接使用方式.
+ *
+ * 例程在本机启动一个HTTP服务作为物联网平台HTTP接入点的替身, 处理/auth认证请求和/topic/...上报请求,
+ * 然后分别以下列方式上报同样数量的消息, 输出每种方式的消息速率和实际发出的HTTP请求数:
+ *  + short connection:  AIOT_HTTPOPT_LONG_CONNECTION为0, 每条消息都重新建连
+ *  + keep-alive:        长连接, 每条消息发送后等待应答
+ *  + pipeline 16:       AIOT_HTTPOPT_PIPELINE_MAX_COUNT为16, 连续发出请求, 最多16个请求等待应答
+ *  + pipeline 16 batch: 在pipeline 16的基础上, AIOT_HTTPOPT_BATCH_MAX_LEN为4KB, 同一topic的消息以换行拼接后上报
+ *
+ * 流水线默认关闭, 这里显式启用只是为了对比. 上报使用的POST不是幂等请求, 连接中途断开时丢失的请求通过AIOT_HTTPEVT_REPORT_LOST通知,
+ * 实际业务中只有能够容忍重复或丢失的消息时才应启用, 见AIOT_HTTPOPT_PIPELINE_MAX_COUNT的说明
+ *
+ * 用法: ./output/http-uplink-bench-demo [消息数量] [消息长度]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "aiot_state_api.h"
+#include "aiot_sysdep_api.h"
+#include "aiot_http_api.h"
+
+#define BENCH_DEFAULT_MESSAGES      (20000)
+#define BENCH_DEFAULT_PAYLOAD_LEN   (64)
+#define BENCH_SHORT_CONN_DIVISOR    (10)
+#define BENCH_REQUEST_MAX_LEN       (8 * 1024)
+#define BENCH_TOKEN                 "bench-token-0123456789abcdef"
+#define BENCH_TOPIC                 "/a1bench/device1/user/update"
+
+extern aiot_sysdep_portfile_t g_aiot_sysdep_portfile;
+
+typedef struct {
+    int listen_fd;
+    pthread_mutex_t mutex;
+    uint32_t requests;
+    uint32_t messages;
+    uint32_t bad;
+} bench_server_t;
+
+typedef struct {
+    bench_server_t *server;
+    int fd;
+} bench_conn_t;
+
+typedef struct {
+    uint32_t responses;
+    uint32_t failed;
+} bench_recv_t;
+
+static uint64_t bench_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_send_all(int fd, const char *buffer, uint32_t len)
+{
+    uint32_t offset = 0;
+    ssize_t res = 0;
+
+    while (offset < len) {
+        res = send(fd, buffer + offset, len - offset, MSG_NOSIGNAL);
+        if (res <= 0) {
+            return -1;
+        }
+        offset += res;
+    }
+
+    return 0;
+}
+
+/* 按接收顺序逐个处理一个连接上的请求, 流水线发来的请求依次应答 */
+static void *bench_conn_thread(void *arg)
+{
+    bench_conn_t *conn = (bench_conn_t *)arg;
+    bench_server_t *server = conn->server;
+    char request[BENCH_REQUEST_MAX_LEN + 1];
+    char response[256];
+    const char *body = NULL;
+    char *header_end = NULL, *length = NULL, *cursor = NULL;
+    uint32_t request_len = 0, header_len = 0, content_len = 0, lines = 0;
+    uint32_t message_id = 0;
+    int flag = 1;
+    ssize_t res = 0;
+
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    while (1) {
+        request[request_len] = '\0';
+        while ((header_end = strstr(request, "\r\n\r\n")) == NULL) {
+            if (request_len == BENCH_REQUEST_MAX_LEN) {
+                goto exit;
+            }
+            res = recv(conn->fd, request + request_len, BENCH_REQUEST_MAX_LEN - request_len, 0);
+            if (res <= 0) {
+                goto exit;
+            }
+            request_len += res;
+            request[request_len] = '\0';
+        }
+        header_len = header_end + 4 - request;
+        length = strstr(request, "Content-Length: ");
+        content_len = (length != NULL && length < header_end) ? strtoul(length + strlen("Content-Length: "), NULL, 10) : 0;
+        if (header_len + content_len > BENCH_REQUEST_MAX_LEN) {
+            goto exit;
+        }
+        while (request_len < header_len + content_len) {
+            res = recv(conn->fd, request + request_len, BENCH_REQUEST_MAX_LEN - request_len, 0);
+            if (res <= 0) {
+                goto exit;
+            }
+            request_len += res;
+        }
+
+        if (strncmp(request, "POST /auth ", strlen("POST /auth ")) == 0) {
+            body = "{\"code\":0,\"message\":\"success\",\"info\":{\"token\":\"" BENCH_TOKEN "\"}}";
+        } else if (strncmp(request, "POST /topic/", strlen("POST /topic/")) == 0) {
+            pthread_mutex_lock(&server->mutex);
+            if (strstr(request, "Password: " BENCH_TOKEN "\r\n") == NULL) {
+                server->bad++;
+            }
+            lines = 1;
+            for (cursor = request + header_len; cursor < request + header_len + content_len; cursor++) {
+                if (*cursor == '\n') {
+                    lines++;
+                }
+            }
+            server->requests++;
+            server->messages += lines;
+            message_id = server->requests;
+            pthread_mutex_unlock(&server->mutex);
+            body = NULL;
+        } else {
+            goto exit;
+        }
+
+        if (body != NULL) {
+            snprintf(response, sizeof(response), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                     "Content-Length: %u\r\nConnection: keep-alive\r\n\r\n%s", (uint32_t)strlen(body), body);
+        } else {
+            char info[96];
+
+            snprintf(info, sizeof(info), "{\"code\":0,\"message\":\"success\",\"info\":{\"messageId\":%u}}", message_id);
+            snprintf(response, sizeof(response), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                     "Content-Length: %u\r\nConnection: keep-alive\r\n\r\n%s", (uint32_t)strlen(info), info);
+        }
+        if (bench_send_all(conn->fd, response, strlen(response)) < 0) {
+            goto exit;
+        }
+
+        memmove(request, request + header_len + content_len, request_len - header_len - content_len);
+        request_len -= header_len + content_len;
+    }
+
+exit:
+    close(conn->fd);
+    free(conn);
+    return NULL;
+}
+
+static void *bench_server_thread(void *arg)
+{
+    bench_server_t *server = (bench_server_t *)arg;
+    bench_conn_t *conn = NULL;
+    pthread_t conn_thread;
+    int fd = -1;
+
+    while ((fd = accept(server->listen_fd, NULL, NULL)) >= 0) {
+        conn = malloc(sizeof(bench_conn_t));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->server = server;
+        conn->fd = fd;
+        if (pthread_create(&conn_thread, NULL, bench_conn_thread, conn) != 0) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+        pthread_detach(conn_thread);
+    }
+
+    return NULL;
+}
+
+/* 用户回调: 统计收到的应答, 以及状态码不为200的应答 */
+static void bench_http_recv_handler(void *handle, const aiot_http_recv_t *packet, void *userdata)
+{
+    bench_recv_t *recv = (bench_recv_t *)userdata;
+
+    if (packet->type != AIOT_HTTPRECV_STATUS_CODE) {
+        return;
+    }
+    recv->responses++;
+    if (packet->data.status_code.code != 200) {
+        recv->failed++;
+    }
+}
+
+static void bench_run(const char *name, uint16_t port, bench_server_t *server, uint32_t messages, uint32_t payload_len,
+                      uint8_t long_connection, uint32_t pipeline_max_count, uint32_t batch_max_len)
+{
+    void *handle = NULL;
+    bench_recv_t recv;
+    uint8_t *payload = NULL;
+    uint64_t time_start = 0, cost_ns = 0;
+    uint32_t idx = 0, requests = 0, received = 0;
+    int32_t res = STATE_SUCCESS;
+
+    memset(&recv, 0, sizeof(recv));
+    payload = malloc(payload_len);
+    if (payload == NULL) {
+        return;
+    }
+    memset(payload, 'x', payload_len);
+
+    handle = aiot_http_init();
+    if (handle == NULL) {
+        free(payload);
+        return;
+    }
+    aiot_http_setopt(handle, AIOT_HTTPOPT_HOST, "127.0.0.1");
+    aiot_http_setopt(handle, AIOT_HTTPOPT_PORT, &port);
+    aiot_http_setopt(handle, AIOT_HTTPOPT_PRODUCT_KEY, "a1bench");
+    aiot_http_setopt(handle, AIOT_HTTPOPT_DEVICE_NAME, "device1");
+    aiot_http_setopt(handle, AIOT_HTTPOPT_DEVICE_SECRET, "secret");
+    aiot_http_setopt(handle, AIOT_HTTPOPT_LONG_CONNECTION, &long_connection);
+    aiot_http_setopt(handle, AIOT_HTTPOPT_PIPELINE_MAX_COUNT, &pipeline_max_count);
+    aiot_http_setopt(handle, AIOT_HTTPOPT_BATCH_MAX_LEN, &batch_max_len);
+    aiot_http_setopt(handle, AIOT_HTTPOPT_RECV_HANDLER, (void *)bench_http_recv_handler);
+    aiot_http_setopt(handle, AIOT_HTTPOPT_USERDATA, &recv);
+
+    res = aiot_http_auth(handle);
+    if (res < STATE_SUCCESS) {
+        printf("%-18s auth failed, res: -0x%04X\n", name, -res);
+        aiot_http_deinit(&handle);
+        free(payload);
+        return;
+    }
+
+    pthread_mutex_lock(&server->mutex);
+    server->requests = 0;
+    server->messages = 0;
+    server->bad = 0;
+    pthread_mutex_unlock(&server->mutex);
+
+    time_start = bench_time_ns();
+    for (idx = 0; idx < messages && res >= STATE_SUCCESS; idx++) {
+        res = aiot_http_send(handle, BENCH_TOPIC, payload, payload_len);
+        /* 不使用流水线时每条消息都等待应答, 否则由aiot_http_send在流水线满时自行接收 */
+        if (res >= STATE_SUCCESS && pipeline_max_count == 1 && batch_max_len == 0) {
+            res = aiot_http_recv(handle);
+        }
+    }
+    /* 发出剩余的合并内容, 并接收流水线中全部的应答 */
+    while (res >= STATE_SUCCESS) {
+        res = aiot_http_recv(handle);
+        if (res == STATE_SUCCESS) {
+            break;
+        }
+    }
+    cost_ns = bench_time_ns() - time_start;
+
+    aiot_http_deinit(&handle);
+    free(payload);
+
+    if (res < STATE_SUCCESS) {
+        printf("%-18s failed, res: -0x%04X\n", name, -res);
+        return;
+    }
+
+    pthread_mutex_lock(&server->mutex);
+    requests = server->requests;
+    received = server->messages;
+    res = (server->bad == 0 && recv.failed == 0 && received == messages) ? STATE_SUCCESS : -1;
+    pthread_mutex_unlock(&server->mutex);
+
+    if (res < STATE_SUCCESS) {
+        printf("%-18s mismatch: %u/%u messages, %u responses, %u failed\n", name, received, messages, recv.responses,
+               recv.failed);
+        return;
+    }
+
+    printf("%-18s %9.0f msgs/s, %6u messages in %6u requests\n", name,
+           (double)messages / ((double)cost_ns / 1000000000), messages, requests);
+}
+
+int main(int argc, char *argv[])
+{
+    bench_server_t server;
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    pthread_t server_thread;
+    uint32_t messages = BENCH_DEFAULT_MESSAGES, payload_len = BENCH_DEFAULT_PAYLOAD_LEN;
+    uint16_t port = 0;
+
+    if (argc > 1) {
+        messages = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        payload_len = atoi(argv[2]);
+    }
+    if (messages < BENCH_SHORT_CONN_DIVISOR || payload_len == 0 || payload_len >= 4 * 1024) {
+        printf("usage: %s [messages, at least %u] [payload length, less than 4096]\n", argv[0], BENCH_SHORT_CONN_DIVISOR);
+        return -1;
+    }
+
+    aiot_sysdep_set_portfile(&g_aiot_sysdep_portfile);
+
+    memset(&server, 0, sizeof(server));
+    pthread_mutex_init(&server.mutex, NULL);
+    server.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (server.listen_fd < 0 || bind(server.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(server.listen_fd, 64) < 0 || getsockname(server.listen_fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        printf("start server failed\n");
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    pthread_create(&server_thread, NULL, bench_server_thread, &server);
+
+    printf("%u messages of %u bytes to http://127.0.0.1:%u, short connection sends 1/%u of them\n", messages,
+           payload_len, port, BENCH_SHORT_CONN_DIVISOR);
+    bench_run("short connection", port, &server, messages / BENCH_SHORT_CONN_DIVISOR, payload_len, 0, 1, 0);
+    bench_run("keep-alive", port, &server, messages, payload_len, 1, 1, 0);
+    bench_run("pipeline 16", port, &server, messages, payload_len, 1, 16, 0);
+    bench_run("pipeline 16 batch", port, &server, messages, payload_len, 1, 16, 4 * 1024);
+
+    shutdown(server.listen_fd, SHUT_RDWR);
+    close(server.listen_fd);
+    pthread_join(server_thread, NULL);
+    pthread_mutex_destroy(&server.mutex);
+
+    return 0;
+}
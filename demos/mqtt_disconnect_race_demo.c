@@ -0,0 +1,244 @@
+/*
+ * 这个例程用于验证: 后台重连尚未完成时调用aiot_mqtt_disconnect, 重连建立的新连接不会被启用.
+ *
+ * 例程在本机启动一个MQTT服务作为broker的替身:
+ *  + 第一个连接: 立即回复CONNACK, 随后主动断开, 使SDK进入重连
+ *  + 第二个连接: 收到CONNECT后延迟回复CONNACK, 例程在这段时间内调用aiot_mqtt_disconnect
+ *
+ * 期望的结果:
+ *  + 重连返回STATE_MQTT_DISCONNECT_API_CALLED
+ *  + 替身服务观察到第二个连接被SDK关闭
+ *  + 之后的aiot_mqtt_pub返回STATE_SYS_DEPEND_NWK_CLOSED
+ *  + 整个过程只通知一次AIOT_MQTTEVT_DISCONNECT, 且之后没有AIOT_MQTTEVT_RECONNECT
+ *
+ * 用法: ./output/mqtt-disconnect-race-demo
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "aiot_state_api.h"
+#include "aiot_sysdep_api.h"
+#include "aiot_mqtt_api.h"
+
+#define RACE_CONNACK_DELAY_MS       (500)
+#define RACE_RECONN_INTERVAL_MS     (50)
+#define RACE_WAIT_MAX_MS            (5000)
+
+extern aiot_sysdep_portfile_t g_aiot_sysdep_portfile;
+
+typedef struct {
+    int listen_fd;
+    volatile uint8_t second_connect_received;
+    volatile uint8_t second_closed_by_client;
+} race_server_t;
+
+typedef struct {
+    void *mqtt_handle;
+    volatile uint8_t running;
+    volatile int32_t reconnect_res;
+} race_recv_t;
+
+static volatile uint32_t g_disconnect_events = 0;
+static volatile uint32_t g_reconnect_events = 0;
+
+int32_t race_state_logcb(int32_t code, char *message)
+{
+    return 0;
+}
+
+/* 读取并丢弃一个完整的MQTT报文 */
+static int race_read_packet(int fd)
+{
+    uint8_t byte = 0, buffer[256];
+    uint32_t remain_len = 0, multiplier = 1, len = 0;
+    ssize_t res = 0;
+
+    if (recv(fd, &byte, 1, MSG_WAITALL) != 1) {
+        return -1;
+    }
+    do {
+        if (recv(fd, &byte, 1, MSG_WAITALL) != 1) {
+            return -1;
+        }
+        remain_len += (byte & 0x7F) * multiplier;
+        multiplier *= 128;
+    } while ((byte & 0x80) != 0);
+
+    while (remain_len > 0) {
+        len = (remain_len > sizeof(buffer)) ? sizeof(buffer) : remain_len;
+        res = recv(fd, buffer, len, MSG_WAITALL);
+        if (res <= 0) {
+            return -1;
+        }
+        remain_len -= res;
+    }
+
+    return 0;
+}
+
+static void *race_server_thread(void *arg)
+{
+    race_server_t *server = (race_server_t *)arg;
+    uint8_t connack[4] = {0x20, 0x02, 0x00, 0x00};
+    uint8_t byte = 0;
+    int fd = -1;
+
+    /* 第一个连接: 正常建连后断开 */
+    fd = accept(server->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (race_read_packet(fd) == 0) {
+        send(fd, connack, sizeof(connack), MSG_NOSIGNAL);
+        usleep(100 * 1000);
+    }
+    close(fd);
+
+    /* 第二个连接: 延迟回复CONNACK, 然后等待SDK关闭连接 */
+    fd = accept(server->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (race_read_packet(fd) == 0) {
+        server->second_connect_received = 1;
+        usleep(RACE_CONNACK_DELAY_MS * 1000);
+        send(fd, connack, sizeof(connack), MSG_NOSIGNAL);
+        while (recv(fd, &byte, 1, 0) > 0) {
+        }
+        server->second_closed_by_client = 1;
+    }
+    close(fd);
+
+    return NULL;
+}
+
+static void race_event_handler(void *handle, const aiot_mqtt_event_t *event, void *userdata)
+{
+    if (event->type == AIOT_MQTTEVT_DISCONNECT) {
+        g_disconnect_events++;
+    } else if (event->type == AIOT_MQTTEVT_RECONNECT) {
+        g_reconnect_events++;
+    }
+}
+
+/* 循环调用aiot_mqtt_recv, 第一个连接断开后由它触发后台重连 */
+static void *race_recv_thread(void *arg)
+{
+    race_recv_t *recv = (race_recv_t *)arg;
+    int32_t res = STATE_SUCCESS;
+
+    while (recv->running) {
+        res = aiot_mqtt_recv(recv->mqtt_handle);
+        if (res == STATE_MQTT_DISCONNECT_API_CALLED) {
+            recv->reconnect_res = res;
+        }
+        if (res < STATE_SUCCESS) {
+            usleep(10 * 1000);
+        }
+    }
+
+    return NULL;
+}
+
+static void race_wait(volatile uint8_t *flag)
+{
+    uint32_t waited_ms = 0;
+
+    while (*flag == 0 && waited_ms < RACE_WAIT_MAX_MS) {
+        usleep(10 * 1000);
+        waited_ms += 10;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    race_server_t server;
+    race_recv_t recv;
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    pthread_t server_thread, recv_thread;
+    aiot_sysdep_network_cred_t cred;
+    uint32_t reconn_interval_ms = RACE_RECONN_INTERVAL_MS;
+    uint16_t port = 0;
+    int32_t res = STATE_SUCCESS, pub_res = STATE_SUCCESS;
+    uint8_t passed = 0;
+
+    aiot_sysdep_set_portfile(&g_aiot_sysdep_portfile);
+    aiot_state_set_logcb(race_state_logcb);
+
+    memset(&server, 0, sizeof(server));
+    server.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (server.listen_fd < 0 || bind(server.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(server.listen_fd, 4) < 0 || getsockname(server.listen_fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        printf("start server failed\n");
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    pthread_create(&server_thread, NULL, race_server_thread, &server);
+
+    memset(&cred, 0, sizeof(cred));
+    cred.option = AIOT_SYSDEP_NETWORK_CRED_NONE;
+
+    memset(&recv, 0, sizeof(recv));
+    recv.mqtt_handle = aiot_mqtt_init();
+    if (recv.mqtt_handle == NULL) {
+        printf("aiot_mqtt_init failed\n");
+        return -1;
+    }
+    aiot_mqtt_setopt(recv.mqtt_handle, AIOT_MQTTOPT_HOST, "127.0.0.1");
+    aiot_mqtt_setopt(recv.mqtt_handle, AIOT_MQTTOPT_PORT, &port);
+    aiot_mqtt_setopt(recv.mqtt_handle, AIOT_MQTTOPT_PRODUCT_KEY, "a1race");
+    aiot_mqtt_setopt(recv.mqtt_handle, AIOT_MQTTOPT_DEVICE_NAME, "device1");
+    aiot_mqtt_setopt(recv.mqtt_handle, AIOT_MQTTOPT_DEVICE_SECRET, "secret");
+    aiot_mqtt_setopt(recv.mqtt_handle, AIOT_MQTTOPT_NETWORK_CRED, &cred);
+    aiot_mqtt_setopt(recv.mqtt_handle, AIOT_MQTTOPT_RECONN_INTERVAL_MS, &reconn_interval_ms);
+    aiot_mqtt_setopt(recv.mqtt_handle, AIOT_MQTTOPT_EVENT_HANDLER, (void *)race_event_handler);
+
+    res = aiot_mqtt_connect(recv.mqtt_handle);
+    if (res < STATE_SUCCESS) {
+        printf("aiot_mqtt_connect failed: -0x%04X\n", -res);
+        return -1;
+    }
+
+    recv.running = 1;
+    pthread_create(&recv_thread, NULL, race_recv_thread, &recv);
+
+    /* 重连已发出CONNECT, 正在等待CONNACK, 此时调用aiot_mqtt_disconnect */
+    race_wait(&server.second_connect_received);
+    if (server.second_connect_received == 0) {
+        printf("reconnect not started\n");
+        return -1;
+    }
+    aiot_mqtt_disconnect(recv.mqtt_handle);
+
+    race_wait(&server.second_closed_by_client);
+    usleep(2 * RACE_RECONN_INTERVAL_MS * 1000);
+    recv.running = 0;
+    pthread_join(recv_thread, NULL);
+
+    pub_res = aiot_mqtt_pub(recv.mqtt_handle, "/a1race/device1/user/update", (uint8_t *)"x", 1, 0);
+
+    passed = (recv.reconnect_res == STATE_MQTT_DISCONNECT_API_CALLED && server.second_closed_by_client == 1 &&
+              pub_res == STATE_SYS_DEPEND_NWK_CLOSED && g_disconnect_events == 1 && g_reconnect_events == 0) ? 1 : 0;
+    printf("reconnect res: -0x%04X, second connection closed: %u, pub res: -0x%04X, disconnect events: %u, "
+           "reconnect events: %u\n", (uint32_t)(-recv.reconnect_res), server.second_closed_by_client,
+           (uint32_t)(-pub_res), g_disconnect_events, g_reconnect_events);
+    printf("%s\n", passed ? "PASS" : "FAIL");
+
+    aiot_mqtt_deinit(&recv.mqtt_handle);
+    shutdown(server.listen_fd, SHUT_RDWR);
+    close(server.listen_fd);
+    pthread_join(server_thread, NULL);
+
+    return passed ? 0 : -1;
+}
@@ -0,0 +1,331 @@
+/*
+ * 这个例程用于对比portfile中基于select的socket收发与linux_epoll_port.c中基于epoll的收发性能。
+ *
+ * 例程在本机启动一个TCP回显服务, 分别通过以下两种方式收发:
+ *  + portfile: g_aiot_sysdep_portfile中的network接口(默认select, 定义CORE_SYSDEP_NETWORK_LINUX_EPOLL编译后为epoll)
+ *  + epoll:    直接调用core_sysdep_epoll_io_recv/send
+ *
+ * 每种方式测量两项:
+ *  + round trip: N次请求-应答往返的平均耗时
+ *  + idle poll:  连接上没有数据时, 以0超时调用N次接收的平均耗时. 两种方式每次都只有一个系统调用(select或recv),
+ *                差别来自select的开销随fd数值增长: 每次都要拷贝并扫描fd+1位的fd_set
+ *
+ * 用法: ./output/network-epoll-bench-demo [次数] [报文长度] [预先占用的fd个数]
+ *  + 预先占用若干fd, 之后创建的socket的fd都不小于该值, 模拟多连接网关中fd数值较大的情况
+ *  + 预先占用的fd个数不小于FD_SETSIZE时跳过select用例: select无法处理这样的fd, FD_SET会越界写栈上的fd_set
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "aiot_state_api.h"
+#include "aiot_sysdep_api.h"
+
+#if defined(__linux__)
+#include "linux_epoll_port.h"
+
+#define BENCH_DEFAULT_ROUNDS    (20000)
+#define BENCH_DEFAULT_MSG_LEN   (64)
+#define BENCH_TIMEOUT_MS        (5000)
+/* 回显服务, 两个客户端连接及epoll实例等需要的fd */
+#define BENCH_EXTRA_FDS         (16)
+
+extern aiot_sysdep_portfile_t g_aiot_sysdep_portfile;
+
+typedef struct {
+    int listen_fd;
+    uint32_t msg_len;
+} bench_server_t;
+
+static uint64_t bench_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/* 回显服务: 依次接受连接, 每个连接收满msg_len字节后原样发回, 直到对端关闭 */
+static void *bench_server_thread(void *arg)
+{
+    bench_server_t *server = (bench_server_t *)arg;
+    uint8_t *buffer = malloc(server->msg_len);
+    uint32_t offset = 0;
+    ssize_t res = 0;
+    int fd = -1;
+
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    while ((fd = accept(server->listen_fd, NULL, NULL)) >= 0) {
+        while (1) {
+            for (offset = 0; offset < server->msg_len; offset += res) {
+                res = recv(fd, buffer + offset, server->msg_len - offset, 0);
+                if (res <= 0) {
+                    break;
+                }
+            }
+            if (offset < server->msg_len || send(fd, buffer, server->msg_len, MSG_NOSIGNAL) != (ssize_t)server->msg_len) {
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+static int bench_connect(uint16_t port)
+{
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* 占用最小的fd_min个fd, 之后新建的fd都不小于fd_min */
+static int *bench_fds_fill(uint32_t fd_min)
+{
+    int *fds = NULL;
+    uint32_t idx = 0;
+
+    fds = malloc(sizeof(int) * (fd_min + 1));
+    if (fds == NULL) {
+        return NULL;
+    }
+    for (idx = 0; idx < fd_min; idx++) {
+        fds[idx] = open("/dev/null", O_RDONLY);
+        if (fds[idx] < 0) {
+            break;
+        }
+        if ((uint32_t)fds[idx] >= fd_min) {
+            close(fds[idx]);
+            break;
+        }
+    }
+    fds[idx] = -1;
+
+    return fds;
+}
+
+static void bench_fds_release(int *fds)
+{
+    uint32_t idx = 0;
+
+    for (idx = 0; fds[idx] >= 0; idx++) {
+        close(fds[idx]);
+    }
+    free(fds);
+}
+
+static int32_t bench_portfile(uint16_t port, uint32_t rounds, uint8_t *buffer, uint32_t msg_len, uint64_t *rtt_ns,
+                              uint64_t *poll_ns)
+{
+    void *handle = NULL;
+    core_sysdep_socket_type_t socket_type = CORE_SYSDEP_SOCKET_TCP_CLIENT;
+    uint32_t idx = 0;
+    uint64_t time_start = 0;
+    int32_t res = STATE_SUCCESS;
+
+    handle = g_aiot_sysdep_portfile.core_sysdep_network_init();
+    if (handle == NULL) {
+        return STATE_SYS_DEPEND_MALLOC_FAILED;
+    }
+    g_aiot_sysdep_portfile.core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_SOCKET_TYPE, &socket_type);
+    g_aiot_sysdep_portfile.core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_HOST, "127.0.0.1");
+    g_aiot_sysdep_portfile.core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_PORT, &port);
+    res = g_aiot_sysdep_portfile.core_sysdep_network_establish(handle);
+    if (res < STATE_SUCCESS) {
+        g_aiot_sysdep_portfile.core_sysdep_network_deinit(&handle);
+        return res;
+    }
+
+    time_start = bench_time_ns();
+    for (idx = 0; idx < rounds; idx++) {
+        res = g_aiot_sysdep_portfile.core_sysdep_network_send(handle, buffer, msg_len, BENCH_TIMEOUT_MS, NULL);
+        if (res != (int32_t)msg_len) {
+            break;
+        }
+        res = g_aiot_sysdep_portfile.core_sysdep_network_recv(handle, buffer, msg_len, BENCH_TIMEOUT_MS, NULL);
+        if (res != (int32_t)msg_len) {
+            break;
+        }
+    }
+    *rtt_ns = bench_time_ns() - time_start;
+
+    time_start = bench_time_ns();
+    for (idx = (idx == rounds) ? 0 : rounds; idx < rounds; idx++) {
+        res = g_aiot_sysdep_portfile.core_sysdep_network_recv(handle, buffer, msg_len, 0, NULL);
+        if (res != 0) {
+            break;
+        }
+    }
+    *poll_ns = bench_time_ns() - time_start;
+
+    g_aiot_sysdep_portfile.core_sysdep_network_deinit(&handle);
+    return (idx == rounds) ? STATE_SUCCESS : res;
+}
+
+static int32_t bench_epoll(uint16_t port, uint32_t rounds, uint8_t *buffer, uint32_t msg_len, uint64_t *rtt_ns,
+                           uint64_t *poll_ns)
+{
+    core_sysdep_epoll_io_t io;
+    uint32_t idx = 0;
+    uint64_t time_start = 0;
+    int32_t res = STATE_SUCCESS;
+    int fd = bench_connect(port);
+
+    if (fd < 0) {
+        return STATE_PORT_NETWORK_CONNECT_FAILED;
+    }
+
+    core_sysdep_epoll_io_init(&io, fd);
+    time_start = bench_time_ns();
+    for (idx = 0; idx < rounds; idx++) {
+        res = core_sysdep_epoll_io_send(&io, buffer, msg_len, BENCH_TIMEOUT_MS);
+        if (res != (int32_t)msg_len) {
+            break;
+        }
+        res = core_sysdep_epoll_io_recv(&io, buffer, msg_len, BENCH_TIMEOUT_MS, 0);
+        if (res != (int32_t)msg_len) {
+            break;
+        }
+    }
+    *rtt_ns = bench_time_ns() - time_start;
+
+    time_start = bench_time_ns();
+    for (idx = (idx == rounds) ? 0 : rounds; idx < rounds; idx++) {
+        res = core_sysdep_epoll_io_recv(&io, buffer, msg_len, 0, 0);
+        if (res != 0) {
+            break;
+        }
+    }
+    *poll_ns = bench_time_ns() - time_start;
+
+    core_sysdep_epoll_io_deinit(&io);
+    close(fd);
+    return (idx == rounds) ? STATE_SUCCESS : res;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t rounds = (argc > 1) ? (uint32_t)atoi(argv[1]) : BENCH_DEFAULT_ROUNDS;
+    uint32_t msg_len = (argc > 2) ? (uint32_t)atoi(argv[2]) : BENCH_DEFAULT_MSG_LEN;
+    uint32_t fd_min = (argc > 3) ? (uint32_t)atoi(argv[3]) : 0;
+    bench_server_t server;
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    struct rlimit limit;
+    pthread_t server_thread;
+    uint8_t *buffer = NULL;
+    int *fds = NULL;
+    uint64_t rtt_ns = 0, poll_ns = 0;
+    uint16_t port = 0;
+    int32_t res = STATE_SUCCESS;
+
+    if (rounds == 0 || msg_len == 0) {
+        printf("usage: %s [rounds] [msg_len] [fd_min]\n", argv[0]);
+        return -1;
+    }
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < fd_min + BENCH_EXTRA_FDS) {
+        limit.rlim_cur = (fd_min + BENCH_EXTRA_FDS <= limit.rlim_max) ? fd_min + BENCH_EXTRA_FDS : limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    fds = bench_fds_fill(fd_min);
+    if (fds == NULL) {
+        return -1;
+    }
+
+    memset(&server, 0, sizeof(server));
+    server.msg_len = msg_len;
+    server.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (server.listen_fd < 0 || bind(server.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(server.listen_fd, 4) < 0 || getsockname(server.listen_fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        printf("echo server start failed\n");
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    pthread_create(&server_thread, NULL, bench_server_thread, &server);
+
+    buffer = malloc(msg_len);
+    if (buffer == NULL) {
+        return -1;
+    }
+    memset(buffer, 'a', msg_len);
+
+    printf("rounds: %u, msg_len: %u, fd_min: %u, listen fd: %d\n", rounds, msg_len, fd_min, server.listen_fd);
+
+#if !defined(CORE_SYSDEP_NETWORK_LINUX_EPOLL)
+    if ((uint32_t)server.listen_fd + 2 >= FD_SETSIZE) {
+        printf("portfile(select): skipped, fd >= FD_SETSIZE\n");
+    } else
+#endif
+    {
+        res = bench_portfile(port, rounds, buffer, msg_len, &rtt_ns, &poll_ns);
+        if (res < STATE_SUCCESS) {
+            printf("portfile: failed, res: -0x%04X\n", -res);
+        } else {
+#if defined(CORE_SYSDEP_NETWORK_LINUX_EPOLL)
+            printf("portfile(epoll):  round trip %8.2f us, idle poll %6.3f us\n",
+#else
+            printf("portfile(select): round trip %8.2f us, idle poll %6.3f us\n",
+#endif
+                   (double)rtt_ns / 1000 / rounds, (double)poll_ns / 1000 / rounds);
+        }
+    }
+
+    res = bench_epoll(port, rounds, buffer, msg_len, &rtt_ns, &poll_ns);
+    if (res < STATE_SUCCESS) {
+        printf("epoll: failed, res: -0x%04X\n", -res);
+    } else {
+        printf("epoll:            round trip %8.2f us, idle poll %6.3f us\n",
+               (double)rtt_ns / 1000 / rounds, (double)poll_ns / 1000 / rounds);
+    }
+
+    shutdown(server.listen_fd, SHUT_RDWR);
+    close(server.listen_fd);
+    pthread_join(server_thread, NULL);
+    free(buffer);
+    bench_fds_release(fds);
+
+    return (res < STATE_SUCCESS) ? -1 : 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    printf("epoll benchmark is only available on Linux\n");
+    return 0;
+}
+
+#endif /* __linux__ */
+
@@ -0,0 +1,330 @@
+/*
+ * 这个例程用于测量通过aiot_download接口下载固件的吞吐量, 对比不同的body缓冲区配置.
+ *
+ * 例程在本机启动一个HTTP服务作为固件服务器的替身, 按请求中的Range返回固件内容, 然后分别以下列配置完整下载固件,
+ * 输出每种配置的吞吐量, 用户回调的次数和下载过程中SDK占用的堆内存:
+ *  + chunk default:     不做设置, 使用SDK的默认值(16KB, 即一个TLS记录的长度)
+ *  + chunk 2KB:         AIOT_DLOPT_BODY_BUFFER_MAX_LEN为2KB, 内存紧张的设备可以这样设置
+ *  + chunk 64KB:        AIOT_DLOPT_BODY_BUFFER_MAX_LEN为64KB
+ *  + user buffer 64KB:  通过AIOT_DLOPT_BODY_BUFFER提供64KB的用户缓冲区, 固件内容直接读入其中
+ *
+ * 用法: ./output/ota-download-bench-demo [固件大小(MB)] [每种配置的下载次数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "aiot_state_api.h"
+#include "aiot_sysdep_api.h"
+#include "aiot_ota_api.h"
+
+#define BENCH_DEFAULT_IMAGE_MB      (64)
+#define BENCH_DEFAULT_ROUNDS        (3)
+#define BENCH_REQUEST_MAX_LEN       (2048)
+#define BENCH_SEND_CHUNK_LEN        (64 * 1024)
+#define BENCH_USER_BUFFER_LEN       (64 * 1024)
+/* 记录申请长度的块头, 保持16字节对齐 */
+#define BENCH_HEAP_HEADER_LEN       (16)
+
+extern aiot_sysdep_portfile_t g_aiot_sysdep_portfile;
+
+/* 在系统portfile之上统计SDK当前持有的堆内存, 下载只在主线程中进行, 不需要加锁 */
+static aiot_sysdep_portfile_t g_bench_portfile;
+static uint64_t g_bench_heap_bytes = 0;
+
+typedef struct {
+    int listen_fd;
+    uint8_t *image;
+    uint32_t image_len;
+} bench_server_t;
+
+typedef struct {
+    const uint8_t *image;
+    uint32_t offset;
+    uint32_t chunks;
+    uint32_t bad;
+    uint64_t heap_bytes;
+} bench_recv_t;
+
+static uint64_t bench_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_send_all(int fd, const uint8_t *buffer, uint32_t len)
+{
+    uint32_t offset = 0;
+    ssize_t res = 0;
+
+    while (offset < len) {
+        res = send(fd, buffer + offset, len - offset, MSG_NOSIGNAL);
+        if (res <= 0) {
+            return -1;
+        }
+        offset += res;
+    }
+
+    return 0;
+}
+
+/* 处理一个连接上的全部请求: 解析"Range: bytes=start-[end]", 返回206和对应的固件片段, 连接保持到对端关闭 */
+static void bench_server_serve(bench_server_t *server, int fd)
+{
+    char request[BENCH_REQUEST_MAX_LEN + 1];
+    char header[256];
+    uint32_t request_len = 0, start = 0, end = 0, offset = 0, len = 0;
+    char *range = NULL, *tail = NULL;
+    ssize_t res = 0;
+
+    while (1) {
+        request_len = 0;
+        request[0] = '\0';
+        while (strstr(request, "\r\n\r\n") == NULL) {
+            if (request_len == BENCH_REQUEST_MAX_LEN) {
+                return;
+            }
+            res = recv(fd, request + request_len, BENCH_REQUEST_MAX_LEN - request_len, 0);
+            if (res <= 0) {
+                return;
+            }
+            request_len += res;
+            request[request_len] = '\0';
+        }
+
+        start = 0;
+        end = server->image_len - 1;
+        range = strstr(request, "Range: bytes=");
+        if (range != NULL) {
+            start = strtoul(range + strlen("Range: bytes="), &tail, 10);
+            if (*tail == '-' && *(tail + 1) >= '0' && *(tail + 1) <= '9') {
+                end = strtoul(tail + 1, NULL, 10);
+            }
+        }
+        if (end >= server->image_len) {
+            end = server->image_len - 1;
+        }
+        if (start > end) {
+            return;
+        }
+
+        snprintf(header, sizeof(header), "HTTP/1.1 206 Partial Content\r\nContent-Type: application/octet-stream\r\n"
+                 "Content-Length: %u\r\nContent-Range: bytes %u-%u/%u\r\nConnection: keep-alive\r\n\r\n",
+                 end - start + 1, start, end, server->image_len);
+        if (bench_send_all(fd, (uint8_t *)header, strlen(header)) < 0) {
+            return;
+        }
+        for (offset = start; offset <= end; offset += len) {
+            len = end - offset + 1;
+            if (len > BENCH_SEND_CHUNK_LEN) {
+                len = BENCH_SEND_CHUNK_LEN;
+            }
+            if (bench_send_all(fd, server->image + offset, len) < 0) {
+                return;
+            }
+        }
+    }
+}
+
+static void *bench_server_thread(void *arg)
+{
+    bench_server_t *server = (bench_server_t *)arg;
+    int fd = -1;
+
+    while ((fd = accept(server->listen_fd, NULL, NULL)) >= 0) {
+        bench_server_serve(server, fd);
+        close(fd);
+    }
+
+    return NULL;
+}
+
+static void *bench_malloc(uint32_t size, char *name)
+{
+    uint8_t *block = g_aiot_sysdep_portfile.core_sysdep_malloc(size + BENCH_HEAP_HEADER_LEN, name);
+
+    if (block == NULL) {
+        return NULL;
+    }
+    memcpy(block, &size, sizeof(size));
+    g_bench_heap_bytes += size;
+
+    return block + BENCH_HEAP_HEADER_LEN;
+}
+
+static void bench_free(void *ptr)
+{
+    uint8_t *block = (uint8_t *)ptr - BENCH_HEAP_HEADER_LEN;
+    uint32_t size = 0;
+
+    memcpy(&size, block, sizeof(size));
+    g_bench_heap_bytes -= size;
+    g_aiot_sysdep_portfile.core_sysdep_free(block);
+}
+
+/* 用户回调: 与固件原文逐段比较, 统计回调次数, 并记录下载过程中SDK堆内存占用的最大值 */
+static void bench_download_recv_handler(void *handle, const aiot_download_recv_t *packet, void *userdata)
+{
+    bench_recv_t *recv = (bench_recv_t *)userdata;
+
+    if (packet->type != AIOT_DLRECV_HTTPBODY) {
+        return;
+    }
+    if (g_bench_heap_bytes > recv->heap_bytes) {
+        recv->heap_bytes = g_bench_heap_bytes;
+    }
+    if (memcmp(packet->data.buffer, recv->image + recv->offset, packet->data.len) != 0) {
+        recv->bad++;
+    }
+    recv->offset += packet->data.len;
+    recv->chunks++;
+}
+
+static int32_t bench_download(uint16_t port, bench_server_t *server, uint32_t chunk_len, uint8_t *user_buffer,
+                              uint64_t *cost_ns, uint32_t *chunks, uint64_t *heap_bytes)
+{
+    void *handle = NULL;
+    aiot_download_task_desc_t task_desc;
+    aiot_download_body_buffer_t body_buffer;
+    bench_recv_t recv;
+    uint64_t time_start = 0;
+    int32_t res = STATE_SUCCESS;
+
+    memset(&recv, 0, sizeof(recv));
+    recv.image = server->image;
+
+    memset(&task_desc, 0, sizeof(task_desc));
+    task_desc.url = "http://127.0.0.1/firmware.bin";
+    task_desc.size_total = server->image_len;
+    /* 不做摘要校验, 只测量数据通路本身 */
+    task_desc.digest_method = AIOT_OTA_DIGEST_MAX;
+
+    handle = aiot_download_init();
+    if (handle == NULL) {
+        return STATE_SYS_DEPEND_MALLOC_FAILED;
+    }
+    aiot_download_setopt(handle, AIOT_DLOPT_NETWORK_PORT, &port);
+    aiot_download_setopt(handle, AIOT_DLOPT_TASK_DESC, &task_desc);
+    aiot_download_setopt(handle, AIOT_DLOPT_RECV_HANDLER, (void *)bench_download_recv_handler);
+    aiot_download_setopt(handle, AIOT_DLOPT_USERDATA, &recv);
+    if (user_buffer != NULL) {
+        body_buffer.buffer = user_buffer;
+        body_buffer.len = chunk_len;
+        aiot_download_setopt(handle, AIOT_DLOPT_BODY_BUFFER, &body_buffer);
+    } else if (chunk_len > 0) {
+        aiot_download_setopt(handle, AIOT_DLOPT_BODY_BUFFER_MAX_LEN, &chunk_len);
+    }
+
+    time_start = bench_time_ns();
+    res = aiot_download_send_request(handle);
+    while (res >= STATE_SUCCESS) {
+        res = aiot_download_recv(handle);
+    }
+    *cost_ns = bench_time_ns() - time_start;
+    *chunks = recv.chunks;
+    *heap_bytes = recv.heap_bytes;
+
+    aiot_download_deinit(&handle);
+
+    if (res != STATE_DOWNLOAD_FINISHED) {
+        return res;
+    }
+    return (recv.offset == server->image_len && recv.bad == 0) ? STATE_SUCCESS : STATE_DOWNLOAD_FETCH_TOO_MANY;
+}
+
+static void bench_run(const char *name, uint16_t port, bench_server_t *server, uint32_t rounds, uint32_t chunk_len,
+                      uint8_t *user_buffer)
+{
+    uint64_t cost_ns = 0, best_ns = 0, heap_bytes = 0;
+    uint32_t idx = 0, chunks = 0;
+    int32_t res = STATE_SUCCESS;
+
+    for (idx = 0; idx < rounds; idx++) {
+        res = bench_download(port, server, chunk_len, user_buffer, &cost_ns, &chunks, &heap_bytes);
+        if (res < STATE_SUCCESS) {
+            printf("%-18s failed, res: -0x%04X\n", name, -res);
+            return;
+        }
+        if (best_ns == 0 || cost_ns < best_ns) {
+            best_ns = cost_ns;
+        }
+    }
+
+    printf("%-18s %9.1f MB/s, %7u callbacks, %6.1f KB heap, best of %u\n", name,
+           (double)server->image_len / (1024 * 1024) / ((double)best_ns / 1000000000), chunks,
+           (double)heap_bytes / 1024, rounds);
+}
+
+int main(int argc, char *argv[])
+{
+    bench_server_t server;
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    pthread_t server_thread;
+    uint32_t image_mb = BENCH_DEFAULT_IMAGE_MB, rounds = BENCH_DEFAULT_ROUNDS, idx = 0;
+    uint8_t *user_buffer = NULL;
+    uint16_t port = 0;
+
+    if (argc > 1) {
+        image_mb = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        rounds = atoi(argv[2]);
+    }
+    if (image_mb == 0 || rounds == 0) {
+        printf("usage: %s [image size in MB] [rounds]\n", argv[0]);
+        return -1;
+    }
+
+    memcpy(&g_bench_portfile, &g_aiot_sysdep_portfile, sizeof(aiot_sysdep_portfile_t));
+    g_bench_portfile.core_sysdep_malloc = bench_malloc;
+    g_bench_portfile.core_sysdep_free = bench_free;
+    aiot_sysdep_set_portfile(&g_bench_portfile);
+
+    memset(&server, 0, sizeof(server));
+    server.image_len = image_mb * 1024 * 1024;
+    server.image = malloc(server.image_len);
+    user_buffer = malloc(BENCH_USER_BUFFER_LEN);
+    if (server.image == NULL || user_buffer == NULL) {
+        printf("malloc failed\n");
+        return -1;
+    }
+    for (idx = 0; idx < server.image_len; idx++) {
+        server.image[idx] = (uint8_t)(idx % 251);
+    }
+
+    server.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (server.listen_fd < 0 || bind(server.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(server.listen_fd, 8) < 0 || getsockname(server.listen_fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        printf("start server failed\n");
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    pthread_create(&server_thread, NULL, bench_server_thread, &server);
+
+    printf("image %u MB from http://127.0.0.1:%u\n", image_mb, port);
+    bench_run("chunk default", port, &server, rounds, 0, NULL);
+    bench_run("chunk 2KB", port, &server, rounds, 2 * 1024, NULL);
+    bench_run("chunk 64KB", port, &server, rounds, 64 * 1024, NULL);
+    bench_run("user buffer 64KB", port, &server, rounds, BENCH_USER_BUFFER_LEN, user_buffer);
+
+    shutdown(server.listen_fd, SHUT_RDWR);
+    close(server.listen_fd);
+    pthread_join(server_thread, NULL);
+    free(user_buffer);
+    free(server.image);
+
+    return 0;
+}
@@ -4,6 +4,8 @@
  *  + 正常结束后会输出TEST SUCCESS，其它会输出TEST ERROR + ERRORCODE
  *  + 如遇长时间卡住也为测试失败
  *
+ * 以"bench"参数运行时改为测量各接口的性能，输出以"BENCH "开头的JSON行，详见sysdep_bench
+ *
  * 该测试工具会使用多线程/多任务的能力，在RTOS下使用需要自行适配任务创建。
  * 需要用户关注或修改的部分, 已经用 TODO 在注释中标明
  *
@@ -20,6 +22,8 @@
 typedef void *(*TASK_FUNC)(void* argv);
 /* 定义适配任务创建函数*/
 void task_start(TASK_FUNC entry,void* argv);
+/* 定义适配基准测试回环服务启动函数 */
+uint16_t bench_loopback_server_start(void);
 /*>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> TODO START >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>*/
 /*
  * TODO: task_start功能实现，创建任务，并执行任务，待任务结束后自行退出
@@ -38,6 +42,90 @@ void task_start(TASK_FUNC entry,void* argv)
 }
 /*TODO: 堆最大空间，单位字节 */
 #define HEAP_MAX    ( 20 * 1024 )
+
+/*
+ * TODO: bench_loopback_server_start功能实现，在本机127.0.0.1上启动一个TCP服务，供基准测试的网络用例连接
+ * 每个连接的第一个字节指定模式:
+ *  + 'E': 回显模式，收到什么就发回什么，直到对端关闭
+ *  + 'S': 接收模式，随后4字节(大端)为总长度，收完该长度的数据后回复1字节'A'
+ *  + 连接后直接关闭: 仅用于测试建连耗时
+ * @return 服务监听的端口，0表示启动失败
+ */
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+static int bench_recv_all(int fd, uint8_t *buf, uint32_t len)
+{
+    uint32_t offset = 0;
+    while(offset < len) {
+        ssize_t res = recv(fd, buf + offset, len - offset, 0);
+        if(res <= 0) {
+            return -1;
+        }
+        offset += res;
+    }
+    return 0;
+}
+
+static void *bench_loopback_server(void *argv)
+{
+    int listen_fd = (int)(intptr_t)argv;
+    uint8_t buf[16 * 1024];
+
+    while(1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        uint8_t mode = 0;
+        if(fd < 0) {
+            continue;
+        }
+        if(bench_recv_all(fd, &mode, 1) == 0) {
+            if(mode == 'E') {
+                ssize_t res = 0;
+                while((res = recv(fd, buf, sizeof(buf), 0)) > 0) {
+                    if(send(fd, buf, res, 0) != res) {
+                        break;
+                    }
+                }
+            } else if(mode == 'S' && bench_recv_all(fd, buf, 4) == 0) {
+                uint32_t total = ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+                while(total > 0) {
+                    ssize_t res = recv(fd, buf, (total < sizeof(buf)) ? total : sizeof(buf), 0);
+                    if(res <= 0) {
+                        break;
+                    }
+                    total -= res;
+                }
+                if(total == 0) {
+                    send(fd, "A", 1, 0);
+                }
+            }
+        }
+        close(fd);
+    }
+    return NULL;
+}
+
+uint16_t bench_loopback_server_start(void)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0) {
+        return 0;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0
+       || getsockname(fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        close(fd);
+        return 0;
+    }
+    task_start(bench_loopback_server, (void *)(intptr_t)fd);
+    return ntohs(addr.sin_port);
+}
 /*<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< TODO END <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<*/
 
 /**
@@ -813,12 +901,542 @@ sysdep_test_suite test_list[]= {
  */
 extern aiot_sysdep_portfile_t g_aiot_sysdep_portfile;
 
+/**
+ * 基准测试
+ *
+ * 以"./sysdep-api-test-demo bench"运行时不做上面的功能测试，而是测量portfile各接口的开销，
+ * 每项结果输出一行"BENCH "加一个JSON对象，便于用脚本提取后在不同平台/不同portfile实现之间对比:
+ *  + bench: 用例名称，param: 用例参数(内存块大小、线程数、报文长度等，无参数时为0)
+ *  + ops/elapsed_ns/ns_per_op/ops_per_s: 操作次数、总耗时及换算结果
+ *  + 其余字段为用例特有的结果(如mb_per_s、时钟分辨率、往返时延分位数)
+ */
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define BENCH_MALLOC_ROUNDS          (4096)
+#define BENCH_MALLOC_BATCH           (32)
+#define BENCH_TIME_CALLS             (1000000)
+#define BENCH_TIME_RESOLUTION_ROUNDS (20)
+#define BENCH_MUTEX_OPS              (1000000)
+#define BENCH_MUTEX_THREADS          (4)
+#define BENCH_MUTEX_THREAD_OPS       (200000)
+#define BENCH_RAND_BUF_LEN           (4096)
+#define BENCH_RAND_TOTAL_LEN         (4 * 1024 * 1024)
+#define BENCH_RAND_SMALL_LEN         (4)
+#define BENCH_RAND_SMALL_OPS         (1000000)
+#define BENCH_RAND_THREADS           (4)
+#define BENCH_NET_TIMEOUT_MS         (5000)
+#define BENCH_NET_CONNECT_ROUNDS     (200)
+#define BENCH_NET_CHUNK_LEN          (16 * 1024)
+#define BENCH_NET_TOTAL_LEN          (64 * 1024 * 1024)
+#define BENCH_NET_PINGPONG_ROUNDS    (2000)
+
+typedef struct {
+    aiot_sysdep_portfile_t *sysdep;
+    void      *mutex;
+    uint64_t  *counter;
+    uint32_t   ops;
+    volatile uint8_t *start;
+    volatile uint64_t end_ns;
+    volatile uint8_t  finished;
+} bench_mutex_task_t;
+
+/* portfile实现了core_sysdep_time_ns时使用纳秒时钟，否则用毫秒时钟换算 */
+static uint64_t bench_now_ns(aiot_sysdep_portfile_t *sysdep)
+{
+    if(sysdep->core_sysdep_time_ns != NULL) {
+        return sysdep->core_sysdep_time_ns();
+    }
+    return sysdep->core_sysdep_time() * 1000000;
+}
+
+static void bench_report_begin(const char *bench, uint32_t param, uint64_t ops, uint64_t elapsed_ns)
+{
+    double ns = (elapsed_ns == 0) ? 1 : (double)elapsed_ns;
+    printf("BENCH {\"bench\":\"%s\",\"param\":%"PRIu32",\"ops\":%"PRIu64",\"elapsed_ns\":%"PRIu64",\"ns_per_op\":%.1f,\"ops_per_s\":%.0f",
+           bench, param, ops, elapsed_ns, (ops == 0) ? 0 : ns / ops, ops * 1e9 / ns);
+}
+
+static void bench_report_end(void)
+{
+    printf("}\n");
+}
+
+static void bench_report(const char *bench, uint32_t param, uint64_t ops, uint64_t elapsed_ns)
+{
+    bench_report_begin(bench, param, ops, elapsed_ns);
+    bench_report_end();
+}
+
+static void bench_report_error(const char *bench, uint32_t param, const char *reason)
+{
+    printf("BENCH {\"bench\":\"%s\",\"param\":%"PRIu32",\"error\":\"%s\"}\n", bench, param, reason);
+}
+
+static void bench_malloc(aiot_sysdep_portfile_t *sysdep)
+{
+    static const uint32_t sizes[] = {16, 64, 256, 1024, 4096, 16384};
+    void *ptrs[BENCH_MALLOC_BATCH];
+    uint32_t i = 0, round = 0, j = 0;
+
+    for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint64_t start = 0, elapsed = 0;
+        uint8_t failed = 0;
+
+        start = bench_now_ns(sysdep);
+        for(round = 0; round < BENCH_MALLOC_ROUNDS && failed == 0; round++) {
+            for(j = 0; j < BENCH_MALLOC_BATCH; j++) {
+                ptrs[j] = sysdep->core_sysdep_malloc(sizes[i], "BENCH");
+                if(ptrs[j] == NULL) {
+                    failed = 1;
+                    break;
+                }
+            }
+            while(j > 0) {
+                sysdep->core_sysdep_free(ptrs[--j]);
+            }
+        }
+        elapsed = bench_now_ns(sysdep) - start;
+
+        if(failed) {
+            bench_report_error("malloc_free", sizes[i], "malloc failed");
+            continue;
+        }
+        bench_report("malloc_free", sizes[i], (uint64_t)BENCH_MALLOC_ROUNDS * BENCH_MALLOC_BATCH, elapsed);
+    }
+}
+
+/* 连续读时钟直到数值变化，取多次变化量的最小值作为分辨率 */
+static uint64_t bench_clock_resolution_ns(aiot_sysdep_portfile_t *sysdep, uint8_t use_ns)
+{
+    uint64_t min_delta = UINT64_MAX;
+    uint32_t i = 0;
+
+    for(i = 0; i < BENCH_TIME_RESOLUTION_ROUNDS; i++) {
+        uint64_t t0 = use_ns ? sysdep->core_sysdep_time_ns() : sysdep->core_sysdep_time();
+        uint64_t t1 = t0;
+        while(t1 == t0) {
+            t1 = use_ns ? sysdep->core_sysdep_time_ns() : sysdep->core_sysdep_time();
+        }
+        if(t1 - t0 < min_delta) {
+            min_delta = t1 - t0;
+        }
+    }
+
+    return use_ns ? min_delta : min_delta * 1000000;
+}
+
+static void bench_time(aiot_sysdep_portfile_t *sysdep)
+{
+    volatile uint64_t sink = 0;
+    uint64_t start = 0, elapsed = 0;
+    uint32_t i = 0;
+
+    start = bench_now_ns(sysdep);
+    for(i = 0; i < BENCH_TIME_CALLS; i++) {
+        sink += sysdep->core_sysdep_time();
+    }
+    elapsed = bench_now_ns(sysdep) - start;
+    bench_report_begin("time_ms", 0, BENCH_TIME_CALLS, elapsed);
+    printf(",\"resolution_ns\":%"PRIu64, bench_clock_resolution_ns(sysdep, 0));
+    bench_report_end();
+
+    if(sysdep->core_sysdep_time_ns == NULL) {
+        bench_report_error("time_ns", 0, "not implemented");
+        return;
+    }
+    start = bench_now_ns(sysdep);
+    for(i = 0; i < BENCH_TIME_CALLS; i++) {
+        sink += sysdep->core_sysdep_time_ns();
+    }
+    elapsed = bench_now_ns(sysdep) - start;
+    bench_report_begin("time_ns", 0, BENCH_TIME_CALLS, elapsed);
+    printf(",\"resolution_ns\":%"PRIu64, bench_clock_resolution_ns(sysdep, 1));
+    bench_report_end();
+}
+
+static void *bench_mutex_task(void *user_data)
+{
+    bench_mutex_task_t *task = (bench_mutex_task_t *)user_data;
+    uint32_t i = 0;
+
+    while(*task->start == 0) {
+        task->sysdep->core_sysdep_sleep(1);
+    }
+    for(i = 0; i < task->ops; i++) {
+        task->sysdep->core_sysdep_mutex_lock(task->mutex);
+        (*task->counter)++;
+        task->sysdep->core_sysdep_mutex_unlock(task->mutex);
+    }
+    task->end_ns = bench_now_ns(task->sysdep);
+    task->finished = 1;
+    return NULL;
+}
+
+static void bench_mutex(aiot_sysdep_portfile_t *sysdep)
+{
+    bench_mutex_task_t tasks[BENCH_MUTEX_THREADS];
+    volatile uint8_t start_flag = 0;
+    uint64_t counter = 0, start = 0, end = 0;
+    void *mutex = NULL;
+    uint32_t i = 0;
+
+    mutex = sysdep->core_sysdep_mutex_init();
+    if(mutex == NULL) {
+        bench_report_error("mutex_uncontended", 0, "mutex init failed");
+        return;
+    }
+
+    start = bench_now_ns(sysdep);
+    for(i = 0; i < BENCH_MUTEX_OPS; i++) {
+        sysdep->core_sysdep_mutex_lock(mutex);
+        counter++;
+        sysdep->core_sysdep_mutex_unlock(mutex);
+    }
+    bench_report("mutex_uncontended", 0, BENCH_MUTEX_OPS, bench_now_ns(sysdep) - start);
+
+    /* 多个任务竞争同一把锁，从放开起跑标志到最后一个任务结束计时 */
+    counter = 0;
+    for(i = 0; i < BENCH_MUTEX_THREADS; i++) {
+        tasks[i].sysdep = sysdep;
+        tasks[i].mutex = mutex;
+        tasks[i].counter = &counter;
+        tasks[i].ops = BENCH_MUTEX_THREAD_OPS;
+        tasks[i].start = &start_flag;
+        tasks[i].end_ns = 0;
+        tasks[i].finished = 0;
+        task_start(bench_mutex_task, &tasks[i]);
+    }
+    sysdep->core_sysdep_sleep(100);
+    start = bench_now_ns(sysdep);
+    start_flag = 1;
+    for(i = 0; i < BENCH_MUTEX_THREADS; i++) {
+        while(tasks[i].finished == 0) {
+            sysdep->core_sysdep_sleep(1);
+        }
+        if(tasks[i].end_ns > end) {
+            end = tasks[i].end_ns;
+        }
+    }
+
+    if(counter != (uint64_t)BENCH_MUTEX_THREADS * BENCH_MUTEX_THREAD_OPS) {
+        bench_report_error("mutex_contended", BENCH_MUTEX_THREADS, "counter mismatch");
+    } else {
+        bench_report("mutex_contended", BENCH_MUTEX_THREADS, counter, end - start);
+    }
+    sysdep->core_sysdep_mutex_deinit(&mutex);
+}
+
+typedef struct {
+    aiot_sysdep_portfile_t *sysdep;
+    void (*rand)(uint8_t *output, uint32_t output_len);
+    volatile uint8_t *start;
+    volatile uint64_t end_ns;
+    volatile uint8_t  finished;
+} bench_rand_task_t;
+
+/* 改用ChaCha20之前posix portfile中core_sysdep_rand的实现: 每次调用都以当前时间重置libc的rand()种子, 作为对比基线 */
+static void bench_rand_legacy(uint8_t *output, uint32_t output_len)
+{
+    uint32_t idx = 0, bytes = 0, rand_num = 0;
+    struct timeval time;
+
+    memset(&time, 0, sizeof(struct timeval));
+    gettimeofday(&time, NULL);
+
+    srand((unsigned int)(time.tv_sec * 1000 + time.tv_usec / 1000) + rand());
+
+    for (idx = 0; idx < output_len;) {
+        if (output_len - idx < 4) {
+            bytes = output_len - idx;
+        } else {
+            bytes = 4;
+        }
+        rand_num = rand();
+        while (bytes-- > 0) {
+            output[idx++] = (uint8_t)(rand_num >> bytes * 8);
+        }
+    }
+}
+
+static void *bench_rand_task(void *arg)
+{
+    bench_rand_task_t *task = (bench_rand_task_t *)arg;
+    uint8_t buf[BENCH_RAND_SMALL_LEN];
+    uint32_t i = 0;
+
+    while(*task->start == 0) {
+        task->sysdep->core_sysdep_sleep(1);
+    }
+    for(i = 0; i < BENCH_RAND_SMALL_OPS; i++) {
+        task->rand(buf, BENCH_RAND_SMALL_LEN);
+    }
+    task->end_ns = bench_now_ns(task->sysdep);
+    task->finished = 1;
+    return NULL;
+}
+
+static void bench_rand_run(aiot_sysdep_portfile_t *sysdep, const char *name,
+                           void (*rand_func)(uint8_t *output, uint32_t output_len))
+{
+    bench_rand_task_t tasks[BENCH_RAND_THREADS];
+    volatile uint8_t start_flag = 0;
+    char bench[32];
+    uint8_t *buf = NULL;
+    uint64_t start = 0, end = 0, elapsed = 0;
+    uint32_t total = 0, i = 0;
+
+    buf = sysdep->core_sysdep_malloc(BENCH_RAND_BUF_LEN, "BENCH");
+    if(buf == NULL) {
+        bench_report_error(name, BENCH_RAND_BUF_LEN, "malloc failed");
+        return;
+    }
+
+    /* 大块输出的吞吐 */
+    start = bench_now_ns(sysdep);
+    for(total = 0; total < BENCH_RAND_TOTAL_LEN; total += BENCH_RAND_BUF_LEN) {
+        rand_func(buf, BENCH_RAND_BUF_LEN);
+    }
+    elapsed = bench_now_ns(sysdep) - start;
+    bench_report_begin(name, BENCH_RAND_BUF_LEN, BENCH_RAND_TOTAL_LEN / BENCH_RAND_BUF_LEN, elapsed);
+    printf(",\"mb_per_s\":%.2f", BENCH_RAND_TOTAL_LEN * 1e9 / 1048576 / (elapsed ? elapsed : 1));
+    bench_report_end();
+
+    /* SDK内部的典型用法: 每次只取4字节(消息id, 重连随机偏移等) */
+    start = bench_now_ns(sysdep);
+    for(i = 0; i < BENCH_RAND_SMALL_OPS; i++) {
+        rand_func(buf, BENCH_RAND_SMALL_LEN);
+    }
+    bench_report(name, BENCH_RAND_SMALL_LEN, BENCH_RAND_SMALL_OPS, bench_now_ns(sysdep) - start);
+
+    /* 多个任务同时取小块随机数, 从放开起跑标志到最后一个任务结束计时 */
+    for(i = 0; i < BENCH_RAND_THREADS; i++) {
+        tasks[i].sysdep = sysdep;
+        tasks[i].rand = rand_func;
+        tasks[i].start = &start_flag;
+        tasks[i].end_ns = 0;
+        tasks[i].finished = 0;
+        task_start(bench_rand_task, &tasks[i]);
+    }
+    sysdep->core_sysdep_sleep(100);
+    start = bench_now_ns(sysdep);
+    start_flag = 1;
+    for(i = 0; i < BENCH_RAND_THREADS; i++) {
+        while(tasks[i].finished == 0) {
+            sysdep->core_sysdep_sleep(1);
+        }
+        if(tasks[i].end_ns > end) {
+            end = tasks[i].end_ns;
+        }
+    }
+    snprintf(bench, sizeof(bench), "%s_threads", name);
+    bench_report(bench, BENCH_RAND_THREADS, (uint64_t)BENCH_RAND_THREADS * BENCH_RAND_SMALL_OPS, end - start);
+
+    sysdep->core_sysdep_free(buf);
+}
+
+static void bench_rand(aiot_sysdep_portfile_t *sysdep)
+{
+    bench_rand_run(sysdep, "rand", sysdep->core_sysdep_rand);
+    bench_rand_run(sysdep, "rand_legacy", bench_rand_legacy);
+}
+
+static void *bench_net_connect(aiot_sysdep_portfile_t *sysdep, uint16_t port)
+{
+    core_sysdep_socket_type_t type = CORE_SYSDEP_SOCKET_TCP_CLIENT;
+    uint32_t timeout_ms = BENCH_NET_TIMEOUT_MS;
+    void *network_hd = sysdep->core_sysdep_network_init();
+
+    if(network_hd == NULL) {
+        return NULL;
+    }
+    sysdep->core_sysdep_network_setopt(network_hd, CORE_SYSDEP_NETWORK_SOCKET_TYPE, &type);
+    sysdep->core_sysdep_network_setopt(network_hd, CORE_SYSDEP_NETWORK_HOST, "127.0.0.1");
+    sysdep->core_sysdep_network_setopt(network_hd, CORE_SYSDEP_NETWORK_PORT, &port);
+    sysdep->core_sysdep_network_setopt(network_hd, CORE_SYSDEP_NETWORK_CONNECT_TIMEOUT_MS, &timeout_ms);
+    if(sysdep->core_sysdep_network_establish(network_hd) != 0) {
+        sysdep->core_sysdep_network_deinit(&network_hd);
+        return NULL;
+    }
+    return network_hd;
+}
+
+static int32_t bench_net_send_all(aiot_sysdep_portfile_t *sysdep, void *network_hd, uint8_t *buf, uint32_t len)
+{
+    uint32_t offset = 0;
+    while(offset < len) {
+        int32_t res = sysdep->core_sysdep_network_send(network_hd, buf + offset, len - offset, BENCH_NET_TIMEOUT_MS, NULL);
+        if(res <= 0) {
+            return -1;
+        }
+        offset += res;
+    }
+    return 0;
+}
+
+static int32_t bench_net_recv_all(aiot_sysdep_portfile_t *sysdep, void *network_hd, uint8_t *buf, uint32_t len)
+{
+    uint32_t offset = 0;
+    while(offset < len) {
+        int32_t res = sysdep->core_sysdep_network_recv(network_hd, buf + offset, len - offset, BENCH_NET_TIMEOUT_MS, NULL);
+        if(res <= 0) {
+            return -1;
+        }
+        offset += res;
+    }
+    return 0;
+}
+
+static int bench_u64_compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void bench_net_connect_cycle(aiot_sysdep_portfile_t *sysdep, uint16_t port)
+{
+    uint64_t start = 0;
+    uint32_t i = 0;
+
+    start = bench_now_ns(sysdep);
+    for(i = 0; i < BENCH_NET_CONNECT_ROUNDS; i++) {
+        void *network_hd = bench_net_connect(sysdep, port);
+        if(network_hd == NULL) {
+            bench_report_error("tcp_connect", 0, "connect failed");
+            return;
+        }
+        sysdep->core_sysdep_network_deinit(&network_hd);
+    }
+    bench_report("tcp_connect", 0, BENCH_NET_CONNECT_ROUNDS, bench_now_ns(sysdep) - start);
+}
+
+static void bench_net_throughput(aiot_sysdep_portfile_t *sysdep, uint16_t port)
+{
+    uint8_t header[5] = {'S', (BENCH_NET_TOTAL_LEN >> 24) & 0xFF, (BENCH_NET_TOTAL_LEN >> 16) & 0xFF,
+                         (BENCH_NET_TOTAL_LEN >> 8) & 0xFF, BENCH_NET_TOTAL_LEN & 0xFF};
+    uint8_t *buf = NULL, ack = 0;
+    uint64_t start = 0, elapsed = 0;
+    uint32_t total = 0;
+    void *network_hd = NULL;
+
+    buf = sysdep->core_sysdep_malloc(BENCH_NET_CHUNK_LEN, "BENCH");
+    network_hd = bench_net_connect(sysdep, port);
+    if(buf == NULL || network_hd == NULL) {
+        bench_report_error("tcp_send", BENCH_NET_CHUNK_LEN, "init failed");
+        goto end;
+    }
+    memset(buf, 0x5A, BENCH_NET_CHUNK_LEN);
+
+    /* 服务端收完全部数据后才回复确认，计时包含数据真正到达对端的时间 */
+    start = bench_now_ns(sysdep);
+    if(bench_net_send_all(sysdep, network_hd, header, sizeof(header)) != 0) {
+        bench_report_error("tcp_send", BENCH_NET_CHUNK_LEN, "send failed");
+        goto end;
+    }
+    for(total = 0; total < BENCH_NET_TOTAL_LEN; total += BENCH_NET_CHUNK_LEN) {
+        if(bench_net_send_all(sysdep, network_hd, buf, BENCH_NET_CHUNK_LEN) != 0) {
+            bench_report_error("tcp_send", BENCH_NET_CHUNK_LEN, "send failed");
+            goto end;
+        }
+    }
+    if(bench_net_recv_all(sysdep, network_hd, &ack, 1) != 0 || ack != 'A') {
+        bench_report_error("tcp_send", BENCH_NET_CHUNK_LEN, "ack failed");
+        goto end;
+    }
+    elapsed = bench_now_ns(sysdep) - start;
+    bench_report_begin("tcp_send", BENCH_NET_CHUNK_LEN, BENCH_NET_TOTAL_LEN / BENCH_NET_CHUNK_LEN, elapsed);
+    printf(",\"mb_per_s\":%.2f", BENCH_NET_TOTAL_LEN * 1e9 / 1048576 / (elapsed ? elapsed : 1));
+    bench_report_end();
+end:
+    if(network_hd != NULL) {
+        sysdep->core_sysdep_network_deinit(&network_hd);
+    }
+    if(buf != NULL) {
+        sysdep->core_sysdep_free(buf);
+    }
+}
+
+static void bench_net_pingpong(aiot_sysdep_portfile_t *sysdep, uint16_t port, uint32_t len)
+{
+    uint8_t *buf = NULL, mode = 'E';
+    uint64_t *samples = NULL, start = 0, total = 0;
+    uint32_t i = 0;
+    void *network_hd = NULL;
+
+    buf = sysdep->core_sysdep_malloc(len, "BENCH");
+    samples = sysdep->core_sysdep_malloc(sizeof(uint64_t) * BENCH_NET_PINGPONG_ROUNDS, "BENCH");
+    network_hd = bench_net_connect(sysdep, port);
+    if(buf == NULL || samples == NULL || network_hd == NULL
+       || bench_net_send_all(sysdep, network_hd, &mode, 1) != 0) {
+        bench_report_error("tcp_pingpong", len, "init failed");
+        goto end;
+    }
+    memset(buf, 0x5A, len);
+
+    for(i = 0; i < BENCH_NET_PINGPONG_ROUNDS; i++) {
+        start = bench_now_ns(sysdep);
+        if(bench_net_send_all(sysdep, network_hd, buf, len) != 0
+           || bench_net_recv_all(sysdep, network_hd, buf, len) != 0) {
+            bench_report_error("tcp_pingpong", len, "echo failed");
+            goto end;
+        }
+        samples[i] = bench_now_ns(sysdep) - start;
+        total += samples[i];
+    }
+    qsort(samples, BENCH_NET_PINGPONG_ROUNDS, sizeof(uint64_t), bench_u64_compare);
+    bench_report_begin("tcp_pingpong", len, BENCH_NET_PINGPONG_ROUNDS, total);
+    printf(",\"p50_ns\":%"PRIu64",\"p99_ns\":%"PRIu64",\"max_ns\":%"PRIu64,
+           samples[BENCH_NET_PINGPONG_ROUNDS / 2], samples[BENCH_NET_PINGPONG_ROUNDS * 99 / 100],
+           samples[BENCH_NET_PINGPONG_ROUNDS - 1]);
+    bench_report_end();
+end:
+    if(network_hd != NULL) {
+        sysdep->core_sysdep_network_deinit(&network_hd);
+    }
+    if(samples != NULL) {
+        sysdep->core_sysdep_free(samples);
+    }
+    if(buf != NULL) {
+        sysdep->core_sysdep_free(buf);
+    }
+}
+
+static void bench_network(aiot_sysdep_portfile_t *sysdep)
+{
+    uint16_t port = bench_loopback_server_start();
+
+    if(port == 0) {
+        bench_report_error("tcp_connect", 0, "loopback server start failed");
+        return;
+    }
+    bench_net_connect_cycle(sysdep, port);
+    bench_net_throughput(sysdep, port);
+    bench_net_pingpong(sysdep, port, 64);
+    bench_net_pingpong(sysdep, port, 1024);
+}
+
+int32_t sysdep_bench(aiot_sysdep_portfile_t *sysdep)
+{
+    printf("BENCH {\"bench\":\"info\",\"time_source\":\"%s\"}\n", (sysdep->core_sysdep_time_ns != NULL) ? "time_ns" : "time_ms");
+    bench_malloc(sysdep);
+    bench_time(sysdep);
+    bench_mutex(sysdep);
+    bench_rand(sysdep);
+    bench_network(sysdep);
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     aiot_sysdep_portfile_t *sysdep = &g_aiot_sysdep_portfile;
     int32_t size = sizeof(test_list) / sizeof(test_list[0]);
     sysdep_test_result_t ret = TEST_SUCCESS;
     int32_t i = 0;
+
+    if(argc > 1 && strcmp(argv[1], "bench") == 0) {
+        return sysdep_bench(sysdep);
+    }
+
     DEBUG_INFO("TOTAL TEST START");
     for(i = 0; i < size; i++) {
         DEBUG_INFO("TEST [%d/%d] [%s] .....................................[START]", i + 1, size, test_list[i].name);
@@ -0,0 +1,357 @@
+/*
+ * 这个例程用于测量TLS层的密码运算性能, 对比默认编译与加速编译(make PROFILE=accel)的差异。
+ *
+ * 例程先用FIPS-197/FIPS-180-2的标准向量校验AES和SHA-256的结果, 再输出以下指标:
+ *  + aes-128-cbc / sha-256:       原始吞吐(MB/s)
+ *  + record seal / record open:   TLS1.2 AES-128-CBC-SHA256记录的加密+MAC / 解密+校验速率(records/s)
+ *  + handshake client / server:   RSA-2048完整握手中客户端(验签+加密预主密钥)与服务端(解密预主密钥)
+ *                                 的公钥运算速率(handshakes/s), 双向认证时客户端还需一次与服务端相同代价的私钥运算
+ *
+ * 用法: ./output/tls-crypto-bench-demo [记录长度] [每项测量时长(ms)]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "mbedtls/aes.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/cipher.h"
+#include "mbedtls/md.h"
+#include "mbedtls/rsa.h"
+#if defined(MBEDTLS_AESNI_C)
+#include "mbedtls/aesni.h"
+#endif
+#if defined(MBEDTLS_AESCE_C)
+#include "mbedtls/aesce.h"
+#endif
+
+#define BENCH_DEFAULT_RECORD_LEN    (1024)
+#define BENCH_DEFAULT_DURATION_MS   (1000)
+#define BENCH_RSA_BITS              (2048)
+#define BENCH_RECORD_HDR_LEN        (13)
+#define BENCH_RECORD_MAC_LEN        (32)
+
+static uint64_t bench_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/* 测量用的伪随机数, 只用于生成测试密钥和填充, 不具备密码学强度 */
+static int bench_rng(void *ctx, unsigned char *output, size_t len)
+{
+    static uint64_t state = 0x9E3779B97F4A7C15ULL;
+    size_t idx = 0;
+
+    for (idx = 0; idx < len; idx++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        output[idx] = (unsigned char)state;
+    }
+    return 0;
+}
+
+static const char *bench_aes_impl(void)
+{
+#if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
+    if (mbedtls_aesni_has_support(MBEDTLS_AESNI_AES)) {
+        return "aes-ni";
+    }
+#endif
+#if defined(MBEDTLS_AESCE_C) && defined(MBEDTLS_HAVE_ARM64)
+    if (mbedtls_aesce_has_support()) {
+        return "armv8-ce";
+    }
+#endif
+    return "portable";
+}
+
+static const char *bench_bignum_impl(void)
+{
+#if defined(MBEDTLS_HAVE_ASM)
+    return "asm";
+#else
+    return "portable";
+#endif
+}
+
+/* FIPS-197 附录C的AES-128/192/256向量, 以及FIPS-180-2的SHA-256 "abc"向量 */
+static int32_t bench_self_test(void)
+{
+    static const unsigned char aes_plain[16] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+    };
+    static const unsigned char aes_cipher[3][16] = {
+        {0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a},
+        {0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c, 0xdf, 0xe0, 0x6e, 0xaf, 0x70, 0xa0, 0xec, 0x0d, 0x71, 0x91},
+        {0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89}
+    };
+    static const unsigned char sha256_abc[32] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+    };
+    unsigned char key[32], output[32];
+    mbedtls_aes_context aes;
+    uint32_t idx = 0;
+    int32_t res = 0;
+
+    for (idx = 0; idx < sizeof(key); idx++) {
+        key[idx] = (unsigned char)idx;
+    }
+
+    mbedtls_aes_init(&aes);
+    for (idx = 0; idx < 3 && res == 0; idx++) {
+        res = mbedtls_aes_setkey_enc(&aes, key, 128 + 64 * idx);
+        res |= mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, aes_plain, output);
+        if (res == 0 && memcmp(output, aes_cipher[idx], 16) != 0) {
+            printf("self test: aes-%u encrypt mismatch\n", 128 + 64 * idx);
+            res = -1;
+        }
+        res |= mbedtls_aes_setkey_dec(&aes, key, 128 + 64 * idx);
+        res |= mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_DECRYPT, aes_cipher[idx], output);
+        if (res == 0 && memcmp(output, aes_plain, 16) != 0) {
+            printf("self test: aes-%u decrypt mismatch\n", 128 + 64 * idx);
+            res = -1;
+        }
+    }
+    mbedtls_aes_free(&aes);
+
+    if (res == 0) {
+        res = mbedtls_sha256_ret((const unsigned char *)"abc", 3, output, 0);
+        if (res == 0 && memcmp(output, sha256_abc, 32) != 0) {
+            printf("self test: sha-256 mismatch\n");
+            res = -1;
+        }
+    }
+
+    return res;
+}
+
+static void bench_print(const char *name, uint64_t count, uint64_t bytes, uint64_t cost_ns, const char *unit)
+{
+    double seconds = (double)cost_ns / 1000000000;
+
+    if (bytes > 0) {
+        printf("%-20s %12.0f %-13s %9.2f MB/s\n", name, count / seconds, unit, bytes / seconds / 1000000);
+    } else {
+        printf("%-20s %12.0f %s\n", name, count / seconds, unit);
+    }
+}
+
+static void bench_primitives(unsigned char *buffer, uint32_t len, uint64_t duration_ns)
+{
+    mbedtls_aes_context aes;
+    unsigned char key[16], iv[16], digest[32];
+    uint64_t time_start = 0, cost_ns = 0, count = 0;
+
+    bench_rng(NULL, key, sizeof(key));
+    memset(iv, 0, sizeof(iv));
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, key, 128);
+
+    time_start = bench_time_ns();
+    do {
+        mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, len, iv, buffer, buffer);
+        count++;
+        cost_ns = bench_time_ns() - time_start;
+    } while (cost_ns < duration_ns);
+    bench_print("aes-128-cbc", count, count * len, cost_ns, "calls/s");
+    mbedtls_aes_free(&aes);
+
+    count = 0;
+    time_start = bench_time_ns();
+    do {
+        mbedtls_sha256_ret(buffer, len, digest, 0);
+        count++;
+        cost_ns = bench_time_ns() - time_start;
+    } while (cost_ns < duration_ns);
+    bench_print("sha-256", count, count * len, cost_ns, "calls/s");
+}
+
+/* 按TLS1.2 CBC模式(MAC-then-encrypt)处理记录: HMAC-SHA256(序号+头部+明文), 补齐后AES-128-CBC加密, 接收方反之 */
+static int32_t bench_records(unsigned char *record, unsigned char *sealed, uint32_t len, uint64_t duration_ns)
+{
+    const mbedtls_cipher_info_t *cipher_info = mbedtls_cipher_info_from_type(MBEDTLS_CIPHER_AES_128_CBC);
+    const mbedtls_md_info_t *md_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    mbedtls_cipher_context_t enc, dec;
+    mbedtls_md_context_t md_enc, md_dec;
+    unsigned char key[16], iv[16], mac_key[32], header[BENCH_RECORD_HDR_LEN], mac[BENCH_RECORD_MAC_LEN];
+    uint32_t pad_len = 16 - (len + BENCH_RECORD_MAC_LEN) % 16;
+    uint32_t total_len = len + BENCH_RECORD_MAC_LEN + pad_len;
+    uint64_t time_start = 0, cost_ns = 0, count = 0;
+    size_t olen = 0;
+    int32_t res = 0;
+
+    bench_rng(NULL, key, sizeof(key));
+    bench_rng(NULL, iv, sizeof(iv));
+    bench_rng(NULL, mac_key, sizeof(mac_key));
+    memset(header, 0, sizeof(header));
+
+    mbedtls_cipher_init(&enc);
+    mbedtls_cipher_init(&dec);
+    mbedtls_md_init(&md_enc);
+    mbedtls_md_init(&md_dec);
+    res |= mbedtls_cipher_setup(&enc, cipher_info);
+    res |= mbedtls_cipher_setup(&dec, cipher_info);
+    res |= mbedtls_cipher_setkey(&enc, key, 128, MBEDTLS_ENCRYPT);
+    res |= mbedtls_cipher_setkey(&dec, key, 128, MBEDTLS_DECRYPT);
+    res |= mbedtls_cipher_set_padding_mode(&enc, MBEDTLS_PADDING_NONE);
+    res |= mbedtls_cipher_set_padding_mode(&dec, MBEDTLS_PADDING_NONE);
+    res |= mbedtls_md_setup(&md_enc, md_info, 1);
+    res |= mbedtls_md_setup(&md_dec, md_info, 1);
+    res |= mbedtls_md_hmac_starts(&md_enc, mac_key, sizeof(mac_key));
+    res |= mbedtls_md_hmac_starts(&md_dec, mac_key, sizeof(mac_key));
+    if (res != 0) {
+        printf("record setup failed, res: -0x%04X\n", -res);
+        goto exit;
+    }
+
+    time_start = bench_time_ns();
+    do {
+        mbedtls_md_hmac_update(&md_enc, header, sizeof(header));
+        mbedtls_md_hmac_update(&md_enc, record, len);
+        mbedtls_md_hmac_finish(&md_enc, record + len);
+        mbedtls_md_hmac_reset(&md_enc);
+        memset(record + len + BENCH_RECORD_MAC_LEN, pad_len - 1, pad_len);
+        mbedtls_cipher_crypt(&enc, iv, sizeof(iv), record, total_len, sealed, &olen);
+        count++;
+        cost_ns = bench_time_ns() - time_start;
+    } while (cost_ns < duration_ns);
+    bench_print("record seal", count, count * len, cost_ns, "records/s");
+
+    /* 每次都解密最后一次seal的结果并校验MAC */
+    count = 0;
+    time_start = bench_time_ns();
+    do {
+        mbedtls_cipher_crypt(&dec, iv, sizeof(iv), sealed, total_len, record, &olen);
+        mbedtls_md_hmac_update(&md_dec, header, sizeof(header));
+        mbedtls_md_hmac_update(&md_dec, record, len);
+        mbedtls_md_hmac_finish(&md_dec, mac);
+        mbedtls_md_hmac_reset(&md_dec);
+        res = memcmp(mac, record + len, sizeof(mac));
+        count++;
+        cost_ns = bench_time_ns() - time_start;
+    } while (res == 0 && cost_ns < duration_ns);
+    if (res != 0) {
+        printf("record open: mac mismatch\n");
+        goto exit;
+    }
+    bench_print("record open", count, count * len, cost_ns, "records/s");
+
+exit:
+    mbedtls_md_free(&md_enc);
+    mbedtls_md_free(&md_dec);
+    mbedtls_cipher_free(&enc);
+    mbedtls_cipher_free(&dec);
+    return res;
+}
+
+/* TLS_RSA_*握手中的公钥运算: 客户端验证服务端证书签名并用其公钥加密预主密钥, 服务端用私钥解密预主密钥 */
+static int32_t bench_handshakes(uint64_t duration_ns)
+{
+    mbedtls_rsa_context rsa;
+    unsigned char hash[32], sig[BENCH_RSA_BITS / 8], premaster[48], encrypted[BENCH_RSA_BITS / 8], decrypted[48];
+    uint64_t time_start = 0, cost_ns = 0, count = 0;
+    size_t olen = 0;
+    int32_t res = 0;
+
+    mbedtls_rsa_init(&rsa, MBEDTLS_RSA_PKCS_V15, 0);
+
+    time_start = bench_time_ns();
+    res = mbedtls_rsa_gen_key(&rsa, bench_rng, NULL, BENCH_RSA_BITS, 65537);
+    if (res != 0) {
+        printf("rsa key generation failed, res: -0x%04X\n", -res);
+        goto exit;
+    }
+    printf("%-20s %12.2f ms\n", "rsa-2048 keygen", (double)(bench_time_ns() - time_start) / 1000000);
+
+    bench_rng(NULL, hash, sizeof(hash));
+    bench_rng(NULL, premaster, sizeof(premaster));
+    res = mbedtls_rsa_pkcs1_sign(&rsa, bench_rng, NULL, MBEDTLS_RSA_PRIVATE, MBEDTLS_MD_SHA256, 0, hash, sig);
+    if (res != 0) {
+        printf("rsa sign failed, res: -0x%04X\n", -res);
+        goto exit;
+    }
+
+    time_start = bench_time_ns();
+    do {
+        res = mbedtls_rsa_pkcs1_verify(&rsa, NULL, NULL, MBEDTLS_RSA_PUBLIC, MBEDTLS_MD_SHA256, 0, hash, sig);
+        res |= mbedtls_rsa_pkcs1_encrypt(&rsa, bench_rng, NULL, MBEDTLS_RSA_PUBLIC, sizeof(premaster), premaster,
+                                         encrypted);
+        count++;
+        cost_ns = bench_time_ns() - time_start;
+    } while (res == 0 && cost_ns < duration_ns);
+    if (res != 0) {
+        printf("rsa public operation failed, res: -0x%04X\n", -res);
+        goto exit;
+    }
+    bench_print("handshake client", count, 0, cost_ns, "handshakes/s");
+
+    count = 0;
+    time_start = bench_time_ns();
+    do {
+        res = mbedtls_rsa_pkcs1_decrypt(&rsa, bench_rng, NULL, MBEDTLS_RSA_PRIVATE, &olen, encrypted, decrypted,
+                                        sizeof(decrypted));
+        count++;
+        cost_ns = bench_time_ns() - time_start;
+    } while (res == 0 && cost_ns < duration_ns);
+    if (res != 0 || olen != sizeof(premaster) || memcmp(decrypted, premaster, olen) != 0) {
+        printf("rsa private operation failed, res: -0x%04X\n", -res);
+        res = (res != 0) ? res : -1;
+        goto exit;
+    }
+    bench_print("handshake server", count, 0, cost_ns, "handshakes/s");
+
+exit:
+    mbedtls_rsa_free(&rsa);
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t record_len = (argc > 1) ? (uint32_t)atoi(argv[1]) : BENCH_DEFAULT_RECORD_LEN;
+    uint32_t duration_ms = (argc > 2) ? (uint32_t)atoi(argv[2]) : BENCH_DEFAULT_DURATION_MS;
+    uint64_t duration_ns = (uint64_t)duration_ms * 1000000;
+    unsigned char *buffer = NULL, *sealed = NULL;
+    int32_t res = 0;
+
+    /* 原始吞吐按16字节对齐的长度测量, 记录长度本身不要求对齐 */
+    if (record_len < 16 || record_len > 16384 || duration_ms == 0) {
+        printf("usage: %s [record_len(16~16384)] [duration_ms]\n", argv[0]);
+        return -1;
+    }
+
+    buffer = malloc(record_len + BENCH_RECORD_MAC_LEN + 16);
+    sealed = malloc(record_len + BENCH_RECORD_MAC_LEN + 16);
+    if (buffer == NULL || sealed == NULL) {
+        free(buffer);
+        free(sealed);
+        return -1;
+    }
+    bench_rng(NULL, buffer, record_len);
+
+    printf("aes: %s, bignum: %s, record_len: %u\n", bench_aes_impl(), bench_bignum_impl(), record_len);
+
+    res = bench_self_test();
+    if (res != 0) {
+        printf("self test failed\n");
+        free(buffer);
+        free(sealed);
+        return -1;
+    }
+
+    bench_primitives(buffer, record_len & ~15u, duration_ns);
+    res = bench_records(buffer, sealed, record_len, duration_ns);
+    if (res == 0) {
+        res = bench_handshakes(duration_ns);
+    }
+
+    free(buffer);
+    free(sealed);
+    return (res != 0) ? -1 : 0;
+}
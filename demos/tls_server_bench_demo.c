@@ -0,0 +1,489 @@
+/*
+ * 这个例程用于离线测试与压测core_adapter.c中的TLS连接: 握手速率, 会话复用率, 不同分片长度下的收发吞吐.
+ *
+ * SDK自带的mbedtls只包含客户端代码, 例程借用本机的openssl命令行作为TLS服务端:
+ *  + 启动时在临时目录中生成测试CA与服务端证书(CN=localhost), 客户端以该CA校验服务端
+ *  + 证书模式: 一个开启会话缓存的服务端测复用握手, 一个关闭会话缓存与session ticket的服务端测完整握手,
+ *    完整握手分别在默认socket参数与开启TCP_NODELAY时各测一次
+ *  + PSK模式: 服务端只接受PSK密码套件
+ *  + 下载吞吐: 服务端以-WWW方式返回临时目录中的文件, 客户端按指定的max_tls_fragment协商记录长度
+ *  + 上传吞吐: 服务端把收到的数据写到/dev/null
+ *  + mbedtls不支持跨记录的握手消息, 分片长度小于服务端证书时无法完成完整握手, 所以吞吐测试前先以默认分片长度
+ *    建连一次, 之后各分片长度的连接复用该会话, 不再传输证书
+ *
+ * 所有收发都经过aiot_sysdep_get_portfile()返回的对接层接口, 即adapter_network_send/recv
+ *
+ * 用法: ./output/tls-server-bench-demo [握手次数] [吞吐测试字节数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "aiot_state_api.h"
+#include "aiot_sysdep_api.h"
+
+#if defined(__linux__)
+
+#define BENCH_DEFAULT_HANDSHAKES    (200)
+#define BENCH_DEFAULT_BULK_BYTES    (16 * 1024 * 1024)
+#define BENCH_TIMEOUT_MS            (5000)
+#define BENCH_IO_CHUNK              (16 * 1024)
+#define BENCH_PSK_ID                "bench-device"
+#define BENCH_PSK                   "bench-psk-0123456789"
+
+extern aiot_sysdep_portfile_t g_aiot_sysdep_portfile;
+
+typedef struct {
+    pid_t pid;
+    int stdin_fd;       /* 保持服务端的标准输入打开, 否则openssl s_server读到EOF后会断开连接 */
+    uint16_t port;
+} bench_server_t;
+
+static char g_bench_dir[64];
+static uint8_t g_bench_nodelay = 0;
+static char *g_bench_ca = NULL;
+static uint32_t g_bench_ca_len = 0;
+
+static uint64_t bench_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/* 例程只关心统计结果, 丢弃SDK日志 */
+static int32_t bench_logcb(int32_t code, char *message)
+{
+    return 0;
+}
+
+/* 在临时目录中执行一条openssl命令 */
+static int32_t bench_openssl(const char *args)
+{
+    char cmd[512];
+
+    snprintf(cmd, sizeof(cmd), "cd %s && openssl %s >/dev/null 2>&1", g_bench_dir, args);
+    return system(cmd);
+}
+
+/* 生成测试CA, 由它签发的服务端证书, 以及供下载的文件 */
+static int32_t bench_gen_files(uint32_t bulk_bytes)
+{
+    FILE *fp = NULL;
+    char path[128];
+    long len = 0;
+
+    if (bench_openssl("req -x509 -newkey rsa:2048 -nodes -keyout ca.key -out ca.pem -days 1 -subj /CN=bench-ca") != 0 ||
+        bench_openssl("req -newkey rsa:2048 -nodes -keyout srv.key -out srv.csr -subj /CN=localhost") != 0 ||
+        bench_openssl("x509 -req -in srv.csr -CA ca.pem -CAkey ca.key -CAcreateserial -out srv.pem -days 1") != 0) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/bulk.bin", g_bench_dir);
+    fp = fopen(path, "w");
+    if (fp == NULL || ftruncate(fileno(fp), bulk_bytes) != 0) {
+        if (fp != NULL) {
+            fclose(fp);
+        }
+        return -1;
+    }
+    fclose(fp);
+
+    /* 对接层解析PEM时把结尾的'\0'一并交给mbedtls, 缓冲区需多留一个字节 */
+    snprintf(path, sizeof(path), "%s/ca.pem", g_bench_dir);
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    g_bench_ca = calloc(1, len + 1);
+    if (g_bench_ca == NULL || fread(g_bench_ca, 1, len, fp) != (size_t)len) {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    g_bench_ca_len = (uint32_t)len;
+
+    return 0;
+}
+
+static uint16_t bench_free_port(void)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    uint16_t port = 0;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+        getsockname(fd, (struct sockaddr *)&addr, &addr_len) == 0) {
+        port = ntohs(addr.sin_port);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    return port;
+}
+
+static int bench_port_ready(uint16_t port)
+{
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_STREAM, 0), res = -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0) {
+        res = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+        close(fd);
+    }
+
+    return res;
+}
+
+/* 启动openssl s_server, extra为附加的命令行参数(以NULL结尾), 端口可连接后返回 */
+static int32_t bench_server_start(bench_server_t *server, const char **extra)
+{
+    const char *argv[32];
+    char port_str[8];
+    int pipe_fd[2], null_fd = -1;
+    uint32_t argc = 0, retry = 0;
+
+    server->port = bench_free_port();
+    snprintf(port_str, sizeof(port_str), "%u", server->port);
+    argv[argc++] = "openssl";
+    argv[argc++] = "s_server";
+    argv[argc++] = "-quiet";
+    argv[argc++] = "-accept";
+    argv[argc++] = port_str;
+    while (*extra != NULL && argc < sizeof(argv) / sizeof(argv[0]) - 1) {
+        argv[argc++] = *extra++;
+    }
+    argv[argc] = NULL;
+
+    if (server->port == 0 || pipe(pipe_fd) != 0) {
+        return -1;
+    }
+    server->pid = fork();
+    if (server->pid == 0) {
+        null_fd = open("/dev/null", O_WRONLY);
+        dup2(pipe_fd[0], STDIN_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        close(pipe_fd[1]);
+        if (chdir(g_bench_dir) != 0) {
+            _exit(1);
+        }
+        execvp(argv[0], (char *const *)argv);
+        _exit(1);
+    }
+    close(pipe_fd[0]);
+    server->stdin_fd = pipe_fd[1];
+    if (server->pid < 0) {
+        return -1;
+    }
+
+    for (retry = 0; retry < 300; retry++) {
+        if (bench_port_ready(server->port) == 0) {
+            return 0;
+        }
+        if (waitpid(server->pid, NULL, WNOHANG) == server->pid) {
+            break;
+        }
+        usleep(10 * 1000);
+    }
+
+    return -1;
+}
+
+static void bench_server_stop(bench_server_t *server)
+{
+    if (server->pid > 0) {
+        kill(server->pid, SIGTERM);
+        waitpid(server->pid, NULL, 0);
+        close(server->stdin_fd);
+    }
+    server->pid = 0;
+}
+
+static void *bench_connect(uint16_t port, aiot_sysdep_network_cred_option_t option, uint32_t max_fragment,
+                           int32_t *res)
+{
+    aiot_sysdep_portfile_t *sysdep = aiot_sysdep_get_portfile();
+    aiot_sysdep_network_cred_t cred;
+    core_sysdep_psk_t psk = {BENCH_PSK_ID, BENCH_PSK};
+    aiot_sysdep_network_sockopt_t sockopt;
+    core_sysdep_socket_type_t socket_type = CORE_SYSDEP_SOCKET_TCP_CLIENT;
+    uint32_t timeout_ms = BENCH_TIMEOUT_MS;
+    void *handle = sysdep->core_sysdep_network_init();
+
+    if (handle == NULL) {
+        *res = STATE_SYS_DEPEND_MALLOC_FAILED;
+        return NULL;
+    }
+    memset(&cred, 0, sizeof(cred));
+    cred.option = option;
+    cred.max_tls_fragment = max_fragment;
+    cred.x509_server_cert = g_bench_ca;
+    cred.x509_server_cert_len = g_bench_ca_len;
+
+    sysdep->core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_SOCKET_TYPE, &socket_type);
+    sysdep->core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_HOST, "127.0.0.1");
+    sysdep->core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_PORT, &port);
+    sysdep->core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_CONNECT_TIMEOUT_MS, &timeout_ms);
+    sysdep->core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_CRED, &cred);
+    if (g_bench_nodelay == 1) {
+        memset(&sockopt, 0, sizeof(sockopt));
+        sockopt.tcp_nodelay = 1;
+        sysdep->core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_SOCKOPT, &sockopt);
+    }
+    if (option == AIOT_SYSDEP_NETWORK_CRED_SVRCERT_PSK) {
+        sysdep->core_sysdep_network_setopt(handle, CORE_SYSDEP_NETWORK_PSK, &psk);
+    }
+    *res = sysdep->core_sysdep_network_establish(handle);
+    if (*res < STATE_SUCCESS) {
+        sysdep->core_sysdep_network_deinit(&handle);
+        return NULL;
+    }
+
+    return handle;
+}
+
+/* 连续建立并断开rounds个连接, 输出握手速率以及其中复用会话的比例 */
+static int32_t bench_handshake(const char *name, uint16_t port, aiot_sysdep_network_cred_option_t option,
+                               uint32_t rounds)
+{
+    aiot_sysdep_tls_stats_t before, after;
+    uint64_t full = 0, resumed = 0, cost_ns = 0, time_start = 0;
+    uint32_t idx = 0;
+    int32_t res = STATE_SUCCESS;
+    void *handle = NULL;
+
+    aiot_sysdep_get_tls_stats(&before);
+    time_start = bench_time_ns();
+    for (idx = 0; idx < rounds; idx++) {
+        handle = bench_connect(port, option, 16384, &res);
+        if (handle == NULL) {
+            printf("%-20s failed, res: -0x%04X\n", name, -res);
+            return res;
+        }
+        aiot_sysdep_get_portfile()->core_sysdep_network_deinit(&handle);
+    }
+    cost_ns = bench_time_ns() - time_start;
+    aiot_sysdep_get_tls_stats(&after);
+
+    full = after.full_handshake_count - before.full_handshake_count;
+    resumed = after.resumed_handshake_count - before.resumed_handshake_count;
+    printf("%-20s %8.1f handshakes/s, %6.2f ms each, resumed %5.1f%% (full %llu, resumed %llu)\n", name,
+           (double)rounds * 1000000000 / cost_ns, (double)cost_ns / 1000000 / rounds,
+           (full + resumed > 0) ? (double)resumed * 100 / (full + resumed) : 0.0,
+           (unsigned long long)full, (unsigned long long)resumed);
+
+    return STATE_SUCCESS;
+}
+
+/* 以默认分片长度完成一次完整握手, 缓存会话供后续小分片的连接复用 */
+static int32_t bench_warmup(uint16_t port)
+{
+    int32_t res = STATE_SUCCESS;
+    void *handle = bench_connect(port, AIOT_SYSDEP_NETWORK_CRED_SVRCERT_CA, 16384, &res);
+
+    if (handle != NULL) {
+        aiot_sysdep_get_portfile()->core_sysdep_network_deinit(&handle);
+    }
+
+    return res;
+}
+
+/*
+ *  通过HTTP GET下载bulk.bin. 服务端发完文件后不关闭连接, 而对接层的recv会等待读满len字节,
+ *  所以逐字节读完响应头, 之后按剩余的文件长度读取
+ */
+static int32_t bench_download(uint16_t port, uint32_t max_fragment, uint32_t bulk_bytes, uint8_t *buffer)
+{
+    aiot_sysdep_portfile_t *sysdep = aiot_sysdep_get_portfile();
+    char *request = "GET /bulk.bin HTTP/1.0\r\n\r\n";
+    uint64_t received = 0, time_start = 0, cost_ns = 0;
+    uint32_t header_match = 0, len = 0;
+    int32_t res = STATE_SUCCESS;
+    void *handle = bench_connect(port, AIOT_SYSDEP_NETWORK_CRED_SVRCERT_CA, max_fragment, &res);
+
+    if (handle == NULL) {
+        printf("download  frag %5u failed, res: -0x%04X\n", max_fragment, -res);
+        return res;
+    }
+    time_start = bench_time_ns();
+    res = sysdep->core_sysdep_network_send(handle, (uint8_t *)request, strlen(request), BENCH_TIMEOUT_MS, NULL);
+    while (res > 0 && header_match < 4) {
+        res = sysdep->core_sysdep_network_recv(handle, buffer, 1, BENCH_TIMEOUT_MS, NULL);
+        if (res == 1) {
+            header_match = (buffer[0] == "\r\n\r\n"[header_match]) ? header_match + 1 : (buffer[0] == '\r');
+        }
+    }
+    while (res > 0 && received < bulk_bytes) {
+        len = (bulk_bytes - received < BENCH_IO_CHUNK) ? (uint32_t)(bulk_bytes - received) : BENCH_IO_CHUNK;
+        res = sysdep->core_sysdep_network_recv(handle, buffer, len, BENCH_TIMEOUT_MS, NULL);
+        if (res > 0) {
+            received += res;
+        }
+    }
+    cost_ns = bench_time_ns() - time_start;
+    sysdep->core_sysdep_network_deinit(&handle);
+
+    if (received < bulk_bytes) {
+        printf("download  frag %5u incomplete, %llu bytes, res: -0x%04X\n", max_fragment,
+               (unsigned long long)received, -res);
+        return STATE_PORT_TLS_RECV_FAILED;
+    }
+    printf("download  frag %5u %8.1f MB/s\n", max_fragment, (double)received * 1000 / cost_ns);
+
+    return STATE_SUCCESS;
+}
+
+static int32_t bench_upload(uint16_t port, uint32_t max_fragment, uint32_t bulk_bytes, uint8_t *buffer)
+{
+    aiot_sysdep_portfile_t *sysdep = aiot_sysdep_get_portfile();
+    uint64_t sent = 0, time_start = 0, cost_ns = 0;
+    uint32_t len = 0;
+    int32_t res = STATE_SUCCESS;
+    void *handle = bench_connect(port, AIOT_SYSDEP_NETWORK_CRED_SVRCERT_CA, max_fragment, &res);
+
+    if (handle == NULL) {
+        printf("upload    frag %5u failed, res: -0x%04X\n", max_fragment, -res);
+        return res;
+    }
+    time_start = bench_time_ns();
+    while (sent < bulk_bytes) {
+        len = (bulk_bytes - sent < BENCH_IO_CHUNK) ? (uint32_t)(bulk_bytes - sent) : BENCH_IO_CHUNK;
+        res = sysdep->core_sysdep_network_send(handle, buffer, len, BENCH_TIMEOUT_MS, NULL);
+        if (res <= 0) {
+            break;
+        }
+        sent += res;
+    }
+    cost_ns = bench_time_ns() - time_start;
+    sysdep->core_sysdep_network_deinit(&handle);
+
+    if (sent < bulk_bytes) {
+        printf("upload    frag %5u incomplete, %llu bytes, res: -0x%04X\n", max_fragment,
+               (unsigned long long)sent, -res);
+        return STATE_PORT_TLS_SEND_FAILED;
+    }
+    printf("upload    frag %5u %8.1f MB/s\n", max_fragment, (double)sent * 1000 / cost_ns);
+
+    return STATE_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t rounds = (argc > 1) ? (uint32_t)atoi(argv[1]) : BENCH_DEFAULT_HANDSHAKES;
+    uint32_t bulk_bytes = (argc > 2) ? (uint32_t)atoi(argv[2]) : BENCH_DEFAULT_BULK_BYTES;
+    const uint32_t fragments[] = {512, 1024, 2048, 4096, 16384};
+    const char *cert_args[] = {"-cert", "srv.pem", "-key", "srv.key", "-cipher", "ALL:@SECLEVEL=0", NULL};
+    const char *full_args[] = {"-cert", "srv.pem", "-key", "srv.key", "-cipher", "ALL:@SECLEVEL=0",
+                               "-no_cache", "-no_ticket", NULL
+                              };
+    const char *www_args[] = {"-cert", "srv.pem", "-key", "srv.key", "-cipher", "ALL:@SECLEVEL=0", "-WWW", NULL};
+    char psk_hex[2 * sizeof(BENCH_PSK)];
+    const char *psk_args[] = {"-nocert", "-psk_identity", BENCH_PSK_ID, "-psk", psk_hex,
+                              "-cipher", "PSK:@SECLEVEL=0", "-tls1_2", NULL
+                             };
+    bench_server_t server;
+    char path[128];
+    uint8_t *buffer = NULL;
+    uint32_t idx = 0;
+    int32_t res = STATE_SUCCESS;
+
+    if (rounds == 0 || bulk_bytes == 0) {
+        printf("usage: %s [handshakes] [bulk_bytes]\n", argv[0]);
+        return -1;
+    }
+    for (idx = 0; idx < strlen(BENCH_PSK); idx++) {
+        snprintf(psk_hex + 2 * idx, 3, "%02x", (uint8_t)BENCH_PSK[idx]);
+    }
+
+    aiot_sysdep_set_portfile(&g_aiot_sysdep_portfile);
+    aiot_state_set_logcb(bench_logcb);
+    signal(SIGPIPE, SIG_IGN);
+
+    snprintf(g_bench_dir, sizeof(g_bench_dir), "/tmp/tls-bench-XXXXXX");
+    if (mkdtemp(g_bench_dir) == NULL || bench_gen_files(bulk_bytes) != 0) {
+        printf("failed to generate test certificates, is the openssl command line tool installed?\n");
+        return -1;
+    }
+    buffer = malloc(BENCH_IO_CHUNK);
+    if (buffer == NULL) {
+        return -1;
+    }
+    memset(buffer, 'a', BENCH_IO_CHUNK);
+
+    printf("handshakes: %u, bulk bytes: %u\n", rounds, bulk_bytes);
+
+    memset(&server, 0, sizeof(server));
+    if (bench_server_start(&server, full_args) == 0) {
+        res = bench_handshake("cert full", server.port, AIOT_SYSDEP_NETWORK_CRED_SVRCERT_CA, rounds);
+        /* 客户端的ClientKeyExchange/ChangeCipherSpec/Finished分多次写出, Nagle算法会让后两条等待服务端的延迟确认 */
+        g_bench_nodelay = 1;
+        if (res >= STATE_SUCCESS) {
+            res = bench_handshake("cert full nodelay", server.port, AIOT_SYSDEP_NETWORK_CRED_SVRCERT_CA, rounds);
+        }
+        g_bench_nodelay = 0;
+    } else {
+        res = STATE_PORT_NETWORK_CONNECT_FAILED;
+    }
+    bench_server_stop(&server);
+
+    if (res >= STATE_SUCCESS && bench_server_start(&server, cert_args) == 0) {
+        res = bench_handshake("cert resumed", server.port, AIOT_SYSDEP_NETWORK_CRED_SVRCERT_CA, rounds);
+        for (idx = 0; res >= STATE_SUCCESS && idx < sizeof(fragments) / sizeof(fragments[0]); idx++) {
+            res = bench_upload(server.port, fragments[idx], bulk_bytes, buffer);
+        }
+    }
+    bench_server_stop(&server);
+
+    if (res >= STATE_SUCCESS && bench_server_start(&server, psk_args) == 0) {
+        res = bench_handshake("psk", server.port, AIOT_SYSDEP_NETWORK_CRED_SVRCERT_PSK, rounds);
+    }
+    bench_server_stop(&server);
+
+    if (res >= STATE_SUCCESS && bench_server_start(&server, www_args) == 0) {
+        res = bench_warmup(server.port);
+        for (idx = 0; res >= STATE_SUCCESS && idx < sizeof(fragments) / sizeof(fragments[0]); idx++) {
+            res = bench_download(server.port, fragments[idx], bulk_bytes, buffer);
+        }
+    }
+    bench_server_stop(&server);
+
+    snprintf(path, sizeof(path), "rm -rf %s", g_bench_dir);
+    system(path);
+    free(buffer);
+    free(g_bench_ca);
+
+    return (res < STATE_SUCCESS) ? -1 : 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    printf("tls server benchmark is only available on Linux\n");
+    return 0;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,70 @@
+/**
+ * \file aesce.h
+ *
+ * \brief ARMv8 Cryptography Extensions for hardware AES acceleration
+ *        on AArch64 processors
+ *
+ * \warning These functions are only for internal use by other library
+ *          functions; you must not call them directly.
+ */
+/*
+ *  Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Written for this SDK, not taken from upstream mbed TLS. It provides the
+ *  functions that aes.c calls when MBEDTLS_AESCE_C is defined.
+ */
+#ifndef MBEDTLS_AESCE_H
+#define MBEDTLS_AESCE_H
+
+#include "aes.h"
+
+#if defined(MBEDTLS_HAVE_ASM) && defined(__GNUC__) &&  \
+    defined(__aarch64__) && ! defined(__AARCH64EB__) &&  \
+    ! defined(MBEDTLS_HAVE_ARM64)
+#define MBEDTLS_HAVE_ARM64
+#endif
+
+#if defined(MBEDTLS_HAVE_ARM64)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Internal function to detect the AES instructions of the
+ *                 ARMv8 Cryptography Extensions at runtime.
+ *
+ * \note           This function is only for internal use by other library
+ *                 functions; you must not call it directly.
+ *
+ * \return         1 if CPU has support for the feature, 0 otherwise
+ */
+int mbedtls_aesce_has_support( void );
+
+/**
+ * \brief          Internal AES-CE AES-ECB block encryption and decryption
+ *
+ * \note           This function is only for internal use by other library
+ *                 functions; you must not call it directly. It uses the
+ *                 round keys of the portable key schedule in aes.c.
+ *
+ * \param ctx      AES context
+ * \param mode     MBEDTLS_AES_ENCRYPT or MBEDTLS_AES_DECRYPT
+ * \param input    16-byte input block
+ * \param output   16-byte output block
+ *
+ * \return         0 on success (cannot fail)
+ */
+int mbedtls_aesce_crypt_ecb( mbedtls_aes_context *ctx,
+                             int mode,
+                             const unsigned char input[16],
+                             unsigned char output[16] );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_HAVE_ARM64 */
+
+#endif /* MBEDTLS_AESCE_H */
@@ -981,7 +981,7 @@
  *
  * Comment this macro to disable support for external private RSA keys.
  */
-//#define MBEDTLS_PK_RSA_ALT_SUPPORT
+#define MBEDTLS_PK_RSA_ALT_SUPPORT
 
 /**
  * \def MBEDTLS_PKCS1_V15
@@ -1038,6 +1038,37 @@
  */
 //#define MBEDTLS_SHA256_SMALLER
 
+/**
+ * \def MBEDTLS_SHA256_USE_SHANI_IF_PRESENT
+ *
+ * Use the Intel SHA Extensions (SHA-NI) for SHA-256 when the CPU reports them
+ * at runtime, falling back to the C implementation otherwise.
+ *
+ * Module:  library/sha256.c
+ *
+ * Requires: GCC or Clang on x86-64
+ *
+ * Uncomment to enable the runtime-detected SHA-NI path.
+ */
+//#define MBEDTLS_SHA256_USE_SHANI_IF_PRESENT
+
+/**
+ * \def MBEDTLS_SHA256_USE_A64_CRYPTO_IF_PRESENT
+ *
+ * Use the SHA-256 instructions of the ARMv8 Cryptography Extensions when the
+ * CPU reports them at runtime, falling back to the C implementation otherwise.
+ *
+ * Module:  library/sha256.c
+ *
+ * Requires: GCC or Clang on little-endian AArch64
+ *
+ * \warning This path has not yet been compiled for an AArch64 target, and
+ *          MBEDTLS_ACCEL_PROFILE does not enable it.
+ *
+ * Uncomment to enable the runtime-detected A64 crypto path.
+ */
+//#define MBEDTLS_SHA256_USE_A64_CRYPTO_IF_PRESENT
+
 /**
  * \def MBEDTLS_SSL_ALL_ALERT_MESSAGES
  *
@@ -1187,6 +1218,27 @@
  */
 #define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
 
+/**
+ * \def MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+ *
+ * Size the record buffers of each SSL context to what the connection
+ * actually carries instead of always allocating two buffers of
+ * MBEDTLS_SSL_MAX_CONTENT_LEN bytes.
+ *
+ * The input buffer starts at MBEDTLS_SSL_VARIABLE_BUFFER_MIN_CONTENT_LEN
+ * and grows when a larger record header arrives; the output buffer is full
+ * size during the handshake and grows with the application data written
+ * afterwards, bounded by the negotiated maximum fragment length. Both are
+ * brought back to the minimum by mbedtls_ssl_shrink_buffers() once the
+ * handshake is over, so an idle connection keeps about 2KB instead of 32KB.
+ * Datagram (DTLS) contexts keep full size buffers.
+ *
+ * Requires: MBEDTLS_SSL_TLS_C, and MBEDTLS_ZLIB_SUPPORT disabled
+ *
+ * Comment this macro to always allocate full size record buffers
+ */
+#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+
 /**
  * \def MBEDTLS_SSL_PROTO_SSL3
  *
@@ -1505,6 +1557,25 @@
  */
 //#define MBEDTLS_AESNI_C
 
+/**
+ * \def MBEDTLS_AESCE_C
+ *
+ * Enable the AES instructions of the ARMv8 Cryptography Extensions on
+ * AArch64. Support is detected at runtime; CPUs without them keep using
+ * the table-based implementation.
+ *
+ * Module:  library/aesce.c
+ * Caller:  library/aes.c
+ *
+ * Requires: MBEDTLS_HAVE_ASM
+ *
+ * This module adds support for the AESE/AESD instructions on AArch64
+ *
+ * \warning This module has not yet been compiled for an AArch64 target, and
+ *          MBEDTLS_ACCEL_PROFILE does not enable it.
+ */
+//#define MBEDTLS_AESCE_C
+
 /**
  * \def MBEDTLS_AES_C
  *
@@ -2654,6 +2725,7 @@
 
 /* SSL options */
 #define MBEDTLS_SSL_MAX_CONTENT_LEN               16384 /**< Maxium fragment length in bytes, determines the size of each of the two internal I/O buffers */
+//#define MBEDTLS_SSL_VARIABLE_BUFFER_MIN_CONTENT_LEN 512 /**< Content length the record buffers start from and shrink back to, if MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH is set */
 //#define MBEDTLS_SSL_DEFAULT_TICKET_LIFETIME     86400 /**< Lifetime of session tickets (if enabled) */
 #define MBEDTLS_PSK_MAX_LEN                 64 /**< Max size of TLS pre-shared keys, in bytes (default 256 bits) */
 //#define MBEDTLS_SSL_COOKIE_TIMEOUT        60 /**< Default expiration delay of DTLS cookies, in seconds if HAVE_TIME, or in number of cookies issued */
@@ -2698,6 +2770,34 @@
 
 /* \} name SECTION: Customisation configuration options */
 
+/**
+ * \def MBEDTLS_ACCEL_PROFILE
+ *
+ * Accelerated build profile, usually set from the build system
+ * (make PROFILE=accel) rather than here.
+ *
+ * Turns on assembly for the bignum inner loops (RSA), and on x86-64 the
+ * AES-NI and SHA-NI paths for AES and SHA-256. The crypto instructions are
+ * detected at runtime, so the resulting library still runs on CPUs without
+ * them.
+ *
+ * The AArch64 paths (MBEDTLS_AESCE_C and
+ * MBEDTLS_SHA256_USE_A64_CRYPTO_IF_PRESENT) are not part of the profile:
+ * they have never been compiled for an AArch64 target. Enable them
+ * explicitly once they have been built and run there.
+ */
+//#define MBEDTLS_ACCEL_PROFILE
+
+#if defined(MBEDTLS_ACCEL_PROFILE)
+#define MBEDTLS_HAVE_ASM
+#if defined(__GNUC__) && ( defined(__amd64__) || defined(__x86_64__) )
+#define MBEDTLS_AESNI_C
+#define MBEDTLS_SHA256_USE_SHANI_IF_PRESENT
+#elif defined(__GNUC__) && defined(__i386__) && defined(__SSE2__)
+#define MBEDTLS_HAVE_SSE2
+#endif
+#endif /* MBEDTLS_ACCEL_PROFILE */
+
 /* Target and application specific configurations */
 //#define YOTTA_CFG_MBEDTLS_TARGET_CONFIG_FILE "mbedtls/target_config.h"
 
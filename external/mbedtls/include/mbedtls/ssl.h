@@ -243,6 +243,14 @@
 #define MBEDTLS_SSL_OUT_CONTENT_LEN MBEDTLS_SSL_MAX_CONTENT_LEN
 #endif
 
+/*
+ * Content length the record buffers are first allocated for and shrunk back
+ * to when MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH is enabled.
+ */
+#if !defined(MBEDTLS_SSL_VARIABLE_BUFFER_MIN_CONTENT_LEN)
+#define MBEDTLS_SSL_VARIABLE_BUFFER_MIN_CONTENT_LEN 512
+#endif
+
 /*
  * Maximum number of heap-allocated bytes for the purpose of
  * DTLS handshake message reassembly and future message buffering.
@@ -1078,6 +1086,9 @@ struct mbedtls_ssl_context
      * Record layer (incoming data)
      */
     unsigned char *in_buf;      /*!< input buffer                     */
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t in_buf_len;          /*!< current length of in_buf         */
+#endif
     unsigned char *in_ctr;      /*!< 64-bit incoming message counter
                                      TLS: maintained by us
                                      DTLS: read from peer             */
@@ -1116,6 +1127,9 @@ struct mbedtls_ssl_context
      * Record layer (outgoing data)
      */
     unsigned char *out_buf;     /*!< output buffer                    */
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t out_buf_len;         /*!< current length of out_buf        */
+#endif
     unsigned char *out_ctr;     /*!< 64-bit outgoing message counter  */
     unsigned char *out_hdr;     /*!< start of record header           */
     unsigned char *out_len;     /*!< two-bytes message length field   */
@@ -2860,6 +2874,56 @@ size_t mbedtls_ssl_get_max_frag_len( const mbedtls_ssl_context *ssl );
  */
 int mbedtls_ssl_get_max_out_record_payload( const mbedtls_ssl_context *ssl );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/**
+ * \brief          Give back the memory of record buffers that grew beyond
+ *                 their minimum size.
+ *
+ *                 The buffers are reallocated to the largest of
+ *                 MBEDTLS_SSL_VARIABLE_BUFFER_MIN_CONTENT_LEN and what
+ *                 they still hold (unread input, unsent output), so no
+ *                 data is lost; they grow again on demand.
+ *
+ * \note           Does nothing during a handshake or on a DTLS context.
+ *                 Meant to be called when the connection has been idle
+ *                 for a while, it costs one allocation and copy per buffer.
+ *
+ * \param ssl      SSL context
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_SSL_ALLOC_FAILED (the
+ *                 context is left unchanged and remains usable).
+ */
+int mbedtls_ssl_shrink_buffers( mbedtls_ssl_context *ssl );
+
+/**
+ * \brief          Same as mbedtls_ssl_shrink_buffers(), for the input
+ *                 buffer only.
+ *
+ * \note           The input buffer is only used by the read path, so this
+ *                 may run in a thread reading from the context while
+ *                 another one writes to it, as long as reads themselves are
+ *                 serialized.
+ *
+ * \param ssl      SSL context
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_SSL_ALLOC_FAILED.
+ */
+int mbedtls_ssl_shrink_in_buffer( mbedtls_ssl_context *ssl );
+
+/**
+ * \brief          Same as mbedtls_ssl_shrink_buffers(), for the output
+ *                 buffer only.
+ *
+ * \note           Same threading rule as mbedtls_ssl_shrink_in_buffer(),
+ *                 on the write side.
+ *
+ * \param ssl      SSL context
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_SSL_ALLOC_FAILED.
+ */
+int mbedtls_ssl_shrink_out_buffer( mbedtls_ssl_context *ssl );
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
 /**
  * \brief          Return the peer certificate from the current connection
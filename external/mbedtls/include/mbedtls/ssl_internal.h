@@ -192,6 +192,12 @@
 #error "Bad configuration - outgoing protected record payload too large."
 #endif
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH) &&                              \
+    ( MBEDTLS_SSL_VARIABLE_BUFFER_MIN_CONTENT_LEN > MBEDTLS_SSL_IN_CONTENT_LEN || \
+      MBEDTLS_SSL_VARIABLE_BUFFER_MIN_CONTENT_LEN > MBEDTLS_SSL_OUT_CONTENT_LEN )
+#error "Bad configuration - minimum record buffer content larger than the maximum."
+#endif
+
 /* Calculate buffer sizes */
 
 /* Note: Even though the TLS record header is only 5 bytes
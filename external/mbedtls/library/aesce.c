@@ -0,0 +1,103 @@
+/*
+ *  ARMv8 Cryptography Extensions AES support functions
+ *
+ *  Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Written for this SDK, not taken from upstream mbed TLS. It provides the
+ *  functions that aes.c calls when MBEDTLS_AESCE_C is defined.
+ */
+
+/*
+ * AESE/AESD perform AddRoundKey before SubBytes/ShiftRows, so the round keys
+ * of aes.c are used one step earlier than in the FIPS-197 description and the
+ * last one is added with a plain XOR. The decryption keys produced by
+ * mbedtls_aes_setkey_dec() are already those of the equivalent inverse
+ * cipher, which is the order AESD/AESIMC expect.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_AESCE_C)
+
+#include "mbedtls/aesce.h"
+
+#if defined(MBEDTLS_HAVE_ARM64)
+
+#include <arm_neon.h>
+
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_AES
+#define HWCAP_AES   ( 1 << 3 )
+#endif
+#endif
+
+#if defined(__clang__)
+#define AESCE_TARGET __attribute__((target("crypto")))
+#else
+#define AESCE_TARGET __attribute__((target("+crypto")))
+#endif
+
+/*
+ * AES-CE support detection routine
+ */
+int mbedtls_aesce_has_support( void )
+{
+#if defined(__linux__)
+    static int done = 0;
+    static int c = 0;
+
+    if( ! done )
+    {
+        c = ( getauxval( AT_HWCAP ) & HWCAP_AES ) != 0;
+        done = 1;
+    }
+
+    return( c );
+#elif defined(__APPLE__) || defined(__ARM_FEATURE_CRYPTO)
+    return( 1 );
+#else
+    return( 0 );
+#endif
+}
+
+/*
+ * AES-CE AES-ECB block en(de)cryption
+ */
+AESCE_TARGET
+int mbedtls_aesce_crypt_ecb( mbedtls_aes_context *ctx,
+                             int mode,
+                             const unsigned char input[16],
+                             unsigned char output[16] )
+{
+    const unsigned char *rk = (const unsigned char *) ctx->rk;
+    uint8x16_t state = vld1q_u8( input );
+    int i;
+
+    if( mode == MBEDTLS_AES_ENCRYPT )
+    {
+        for( i = 0; i < ctx->nr - 1; i++, rk += 16 )
+            state = vaesmcq_u8( vaeseq_u8( state, vld1q_u8( rk ) ) );
+        state = vaeseq_u8( state, vld1q_u8( rk ) );
+    }
+    else
+    {
+        for( i = 0; i < ctx->nr - 1; i++, rk += 16 )
+            state = vaesimcq_u8( vaesdq_u8( state, vld1q_u8( rk ) ) );
+        state = vaesdq_u8( state, vld1q_u8( rk ) );
+    }
+
+    state = veorq_u8( state, vld1q_u8( rk + 16 ) );
+    vst1q_u8( output, state );
+
+    return( 0 );
+}
+
+#endif /* MBEDTLS_HAVE_ARM64 */
+
+#endif /* MBEDTLS_AESCE_C */
@@ -0,0 +1,177 @@
+/*
+ *  AES-NI support functions
+ *
+ *  Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Written for this SDK, not taken from upstream mbed TLS. It provides the
+ *  functions that aes.c calls when MBEDTLS_AESNI_C is defined.
+ */
+
+/*
+ * [AES-WP] http://software.intel.com/en-us/articles/intel-advanced-encryption-standard-aes-instructions-set
+ *
+ * The instructions are reached through compiler intrinsics on functions
+ * carrying a target attribute, so the rest of the library keeps being
+ * compiled for the baseline ISA; mbedtls_aesni_has_support() decides at
+ * runtime whether aes.c takes this path or its portable tables.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_AESNI_C)
+
+#include "mbedtls/aesni.h"
+#include "mbedtls/platform_util.h"
+
+#include <string.h>
+
+#if defined(MBEDTLS_HAVE_X86_64)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+
+/*
+ * AES-NI support detection routine
+ */
+int mbedtls_aesni_has_support( unsigned int what )
+{
+    static int done = 0;
+    static unsigned int c = 0;
+
+    if( ! done )
+    {
+        unsigned int a, b, d;
+
+        if( __get_cpuid( 1, &a, &b, &c, &d ) == 0 )
+            c = 0;
+        done = 1;
+    }
+
+    return( ( c & what ) != 0 );
+}
+
+/*
+ * AES-NI AES-ECB block en(de)cryption
+ */
+AESNI_TARGET
+int mbedtls_aesni_crypt_ecb( mbedtls_aes_context *ctx,
+                             int mode,
+                             const unsigned char input[16],
+                             unsigned char output[16] )
+{
+    const __m128i *rk = (const __m128i *) ctx->rk;
+    __m128i state;
+    int i;
+
+    state = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) input ),
+                           _mm_loadu_si128( rk ) );
+
+    if( mode == MBEDTLS_AES_ENCRYPT )
+    {
+        for( i = 1; i < ctx->nr; i++ )
+            state = _mm_aesenc_si128( state, _mm_loadu_si128( rk + i ) );
+        state = _mm_aesenclast_si128( state, _mm_loadu_si128( rk + ctx->nr ) );
+    }
+    else
+    {
+        for( i = 1; i < ctx->nr; i++ )
+            state = _mm_aesdec_si128( state, _mm_loadu_si128( rk + i ) );
+        state = _mm_aesdeclast_si128( state, _mm_loadu_si128( rk + ctx->nr ) );
+    }
+
+    _mm_storeu_si128( (__m128i *) output, state );
+
+    return( 0 );
+}
+
+/*
+ * Compute decryption round keys from encryption round keys
+ */
+AESNI_TARGET
+void mbedtls_aesni_inverse_key( unsigned char *invkey,
+                                const unsigned char *fwdkey,
+                                int nr )
+{
+    unsigned char *ik = invkey;
+    const unsigned char *fk = fwdkey + 16 * nr;
+
+    memcpy( ik, fk, 16 );
+
+    for( fk -= 16, ik += 16; fk > fwdkey; fk -= 16, ik += 16 )
+        _mm_storeu_si128( (__m128i *) ik,
+                          _mm_aesimc_si128( _mm_loadu_si128( (const __m128i *) fk ) ) );
+
+    memcpy( ik, fk, 16 );
+}
+
+/*
+ * SubWord(w), and RotWord(SubWord(w)) in *rot, through AESKEYGENASSIST
+ * with a zero round constant (the caller adds its own)
+ */
+AESNI_TARGET
+static uint32_t aesni_sub_word( uint32_t w, uint32_t *rot )
+{
+    __m128i x = _mm_aeskeygenassist_si128( _mm_set_epi32( 0, 0, (int) w, 0 ), 0 );
+
+    *rot = (uint32_t) _mm_cvtsi128_si32( _mm_shuffle_epi32( x, 0x55 ) );
+
+    return( (uint32_t) _mm_cvtsi128_si32( x ) );
+}
+
+/*
+ * Key expansion, same schedule and layout as the portable code in aes.c
+ * (x86-64 is little-endian, so a word copy matches GET_UINT32_LE)
+ */
+int mbedtls_aesni_setkey_enc( unsigned char *rk,
+                              const unsigned char *key,
+                              size_t bits )
+{
+    uint32_t w[60];
+    uint32_t t, rot, rcon = 0x01;
+    unsigned int i, nk, total;
+
+    switch( bits )
+    {
+        case 128: nk = 4; break;
+        case 192: nk = 6; break;
+        case 256: nk = 8; break;
+        default : return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+    }
+    total = 4 * ( nk + 7 );
+
+    memcpy( w, key, 4 * nk );
+
+    for( i = nk; i < total; i++ )
+    {
+        t = w[i - 1];
+
+        if( i % nk == 0 )
+        {
+            aesni_sub_word( t, &rot );
+            t = rot ^ rcon;
+            rcon = ( ( rcon << 1 ) ^ ( ( rcon & 0x80 ) ? 0x1B : 0x00 ) ) & 0xFF;
+        }
+        else if( nk > 6 && i % nk == 4 )
+        {
+            t = aesni_sub_word( t, &rot );
+        }
+
+        w[i] = w[i - nk] ^ t;
+    }
+
+    memcpy( rk, w, 4 * total );
+    mbedtls_platform_zeroize( w, sizeof( w ) );
+
+    return( 0 );
+}
+
+#endif /* MBEDTLS_HAVE_X86_64 */
+
+#endif /* MBEDTLS_AESNI_C */
@@ -160,6 +160,160 @@ static const uint32_t K[] =
     0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
 };
 
+/*
+ * Runtime-detected instruction set paths: SHA-NI on x86-64 and the SHA-256
+ * instructions of the ARMv8 Cryptography Extensions on AArch64. Both are
+ * reached through intrinsics on functions with a target attribute, and the
+ * portable code below stays the fallback when the CPU lacks them.
+ */
+#if defined(MBEDTLS_SHA256_USE_SHANI_IF_PRESENT) && defined(__GNUC__) && \
+    ( defined(__amd64__) || defined(__x86_64__) )
+#define SHA256_SHANI
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+static int sha256_accel_has_support( void )
+{
+    static int done = 0;
+    static int c = 0;
+
+    if( ! done )
+    {
+        unsigned int a, b, cx, d;
+
+        /* SHA-NI (leaf 7, EBX bit 29), plus SSSE3 and SSE4.1 (leaf 1, ECX) */
+        c = __get_cpuid( 1, &a, &b, &cx, &d ) != 0 &&
+            ( cx & ( 1u << 9 ) ) != 0 && ( cx & ( 1u << 19 ) ) != 0 &&
+            __get_cpuid_count( 7, 0, &a, &b, &cx, &d ) != 0 &&
+            ( b & ( 1u << 29 ) ) != 0;
+        done = 1;
+    }
+
+    return( c );
+}
+
+__attribute__((target("sha,sse4.1")))
+static void sha256_accel_process( uint32_t state[8], const unsigned char data[64] )
+{
+    const __m128i MASK = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL,
+                                         0x0405060700010203ULL );
+    __m128i STATE0, STATE1, ABEF_SAVE, CDGH_SAVE, MSG, TMP;
+    __m128i M[4];
+    unsigned int i;
+
+    /* state[] is ABCD EFGH, SHA256RNDS2 works on ABEF and CDGH */
+    TMP    = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *) &state[0] ), 0xB1 );
+    STATE1 = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *) &state[4] ), 0x1B );
+    STATE0 = _mm_alignr_epi8( TMP, STATE1, 8 );
+    STATE1 = _mm_blend_epi16( STATE1, TMP, 0xF0 );
+
+    ABEF_SAVE = STATE0;
+    CDGH_SAVE = STATE1;
+
+    for( i = 0; i < 4; i++ )
+        M[i] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) ( data + 16 * i ) ), MASK );
+
+    /* Four rounds per step; M[] holds the message schedule W[4i..4i+15] */
+    for( i = 0; i < 16; i++ )
+    {
+        MSG = _mm_add_epi32( M[i & 3], _mm_loadu_si128( (const __m128i *) &K[4 * i] ) );
+        STATE1 = _mm_sha256rnds2_epu32( STATE1, STATE0, MSG );
+
+        if( i >= 3 && i < 15 )
+        {
+            TMP = _mm_alignr_epi8( M[i & 3], M[( i - 1 ) & 3], 4 );
+            M[( i + 1 ) & 3] = _mm_sha256msg2_epu32( _mm_add_epi32( M[( i + 1 ) & 3], TMP ), M[i & 3] );
+        }
+
+        MSG = _mm_shuffle_epi32( MSG, 0x0E );
+        STATE0 = _mm_sha256rnds2_epu32( STATE0, STATE1, MSG );
+
+        if( i >= 1 && i < 13 )
+            M[( i - 1 ) & 3] = _mm_sha256msg1_epu32( M[( i - 1 ) & 3], M[i & 3] );
+    }
+
+    STATE0 = _mm_add_epi32( STATE0, ABEF_SAVE );
+    STATE1 = _mm_add_epi32( STATE1, CDGH_SAVE );
+
+    TMP    = _mm_shuffle_epi32( STATE0, 0x1B );
+    STATE1 = _mm_shuffle_epi32( STATE1, 0xB1 );
+    STATE0 = _mm_blend_epi16( TMP, STATE1, 0xF0 );
+    STATE1 = _mm_alignr_epi8( STATE1, TMP, 8 );
+
+    _mm_storeu_si128( (__m128i *) &state[0], STATE0 );
+    _mm_storeu_si128( (__m128i *) &state[4], STATE1 );
+}
+
+#elif defined(MBEDTLS_SHA256_USE_A64_CRYPTO_IF_PRESENT) && defined(__GNUC__) && \
+    defined(__aarch64__) && ! defined(__AARCH64EB__)
+#define SHA256_A64_CRYPTO
+
+#include <arm_neon.h>
+
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2  ( 1 << 6 )
+#endif
+#endif
+
+static int sha256_accel_has_support( void )
+{
+#if defined(__linux__)
+    static int done = 0;
+    static int c = 0;
+
+    if( ! done )
+    {
+        c = ( getauxval( AT_HWCAP ) & HWCAP_SHA2 ) != 0;
+        done = 1;
+    }
+
+    return( c );
+#elif defined(__APPLE__) || defined(__ARM_FEATURE_CRYPTO)
+    return( 1 );
+#else
+    return( 0 );
+#endif
+}
+
+#if defined(__clang__)
+__attribute__((target("crypto")))
+#else
+__attribute__((target("+crypto")))
+#endif
+static void sha256_accel_process( uint32_t state[8], const unsigned char data[64] )
+{
+    uint32x4_t abcd = vld1q_u32( &state[0] );
+    uint32x4_t efgh = vld1q_u32( &state[4] );
+    uint32x4_t abcd_orig = abcd, efgh_orig = efgh;
+    uint32x4_t abcd_prev, tmp;
+    uint32x4_t M[4];
+    unsigned int i;
+
+    for( i = 0; i < 4; i++ )
+        M[i] = vreinterpretq_u32_u8( vrev32q_u8( vld1q_u8( data + 16 * i ) ) );
+
+    /* Four rounds per step; M[] holds the message schedule W[4i..4i+15] */
+    for( i = 0; i < 16; i++ )
+    {
+        if( i >= 4 )
+            M[i & 3] = vsha256su1q_u32( vsha256su0q_u32( M[i & 3], M[( i + 1 ) & 3] ),
+                                        M[( i + 2 ) & 3], M[( i + 3 ) & 3] );
+
+        tmp = vaddq_u32( M[i & 3], vld1q_u32( &K[4 * i] ) );
+        abcd_prev = abcd;
+        abcd = vsha256hq_u32( abcd_prev, efgh, tmp );
+        efgh = vsha256h2q_u32( efgh, abcd_prev, tmp );
+    }
+
+    vst1q_u32( &state[0], vaddq_u32( abcd, abcd_orig ) );
+    vst1q_u32( &state[4], vaddq_u32( efgh, efgh_orig ) );
+}
+
+#endif /* SHA256_A64_CRYPTO */
+
 #define  SHR(x,n) ((x & 0xFFFFFFFF) >> n)
 #define ROTR(x,n) (SHR(x,n) | (x << (32 - n)))
 
@@ -192,6 +346,14 @@ int mbedtls_internal_sha256_process( mbedtls_sha256_context *ctx,
     uint32_t A[8];
     unsigned int i;
 
+#if defined(SHA256_SHANI) || defined(SHA256_A64_CRYPTO)
+    if( sha256_accel_has_support() )
+    {
+        sha256_accel_process( ctx->state, data );
+        return( 0 );
+    }
+#endif
+
     for( i = 0; i < 8; i++ )
         A[i] = ctx->state[i];
 
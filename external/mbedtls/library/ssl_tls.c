@@ -107,6 +107,26 @@ static void ssl_update_in_pointers( mbedtls_ssl_context *ssl,
 #define SSL_DONT_FORCE_FLUSH 0
 #define SSL_FORCE_FLUSH      1
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+#define SSL_IN_BUFFER_LEN( ssl )    ( ( ssl )->in_buf_len )
+#define SSL_OUT_BUFFER_LEN( ssl )   ( ( ssl )->out_buf_len )
+
+/* Size of a record buffer able to hold a protected record carrying
+ * the given amount of plaintext */
+#define SSL_BUFFER_LEN_FOR_CONTENT( content )                           \
+    ( MBEDTLS_SSL_HEADER_LEN + MBEDTLS_SSL_PAYLOAD_OVERHEAD + ( content ) )
+
+#define SSL_VARIABLE_BUFFER_MIN_LEN                                     \
+    SSL_BUFFER_LEN_FOR_CONTENT( MBEDTLS_SSL_VARIABLE_BUFFER_MIN_CONTENT_LEN )
+
+/* Buffers grow in steps of this size, so that a peer sending slowly
+ * increasing records does not cause one reallocation per record */
+#define SSL_VARIABLE_BUFFER_STEP    1024
+#else
+#define SSL_IN_BUFFER_LEN( ssl )    MBEDTLS_SSL_IN_BUFFER_LEN
+#define SSL_OUT_BUFFER_LEN( ssl )   MBEDTLS_SSL_OUT_BUFFER_LEN
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
 
 /* Forward declarations for functions related to message buffering. */
@@ -2516,6 +2536,169 @@ static int ssl_resend_hello_request( mbedtls_ssl_context *ssl )
 #endif
 #endif /* MBEDTLS_SSL_SRV_C && MBEDTLS_SSL_RENEGOTIATION */
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/*
+ * Reallocate the record buffers to len bytes. The first min(old, new) bytes
+ * are kept, the callers make sure nothing in use lies beyond that, and all
+ * the pointers into the buffer are moved along.
+ */
+static int ssl_resize_in_buffer( mbedtls_ssl_context *ssl, size_t len )
+{
+    unsigned char *buf;
+
+    if( len == ssl->in_buf_len )
+        return( 0 );
+
+    if( ( buf = mbedtls_calloc( 1, len ) ) == NULL )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", len ) );
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+
+    memcpy( buf, ssl->in_buf, len < ssl->in_buf_len ? len : ssl->in_buf_len );
+
+    ssl->in_ctr = buf + ( ssl->in_ctr - ssl->in_buf );
+    ssl->in_hdr = buf + ( ssl->in_hdr - ssl->in_buf );
+    ssl->in_len = buf + ( ssl->in_len - ssl->in_buf );
+    ssl->in_iv  = buf + ( ssl->in_iv  - ssl->in_buf );
+    ssl->in_msg = buf + ( ssl->in_msg - ssl->in_buf );
+    if( ssl->in_offt != NULL )
+        ssl->in_offt = buf + ( ssl->in_offt - ssl->in_buf );
+
+    MBEDTLS_SSL_DEBUG_MSG( 3, ( "input buffer: %d -> %d bytes",
+                                ssl->in_buf_len, len ) );
+
+    mbedtls_platform_zeroize( ssl->in_buf, ssl->in_buf_len );
+    mbedtls_free( ssl->in_buf );
+    ssl->in_buf = buf;
+    ssl->in_buf_len = len;
+
+    return( 0 );
+}
+
+static int ssl_resize_out_buffer( mbedtls_ssl_context *ssl, size_t len )
+{
+    unsigned char *buf;
+
+    if( len == ssl->out_buf_len )
+        return( 0 );
+
+    if( ( buf = mbedtls_calloc( 1, len ) ) == NULL )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", len ) );
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+
+    memcpy( buf, ssl->out_buf, len < ssl->out_buf_len ? len : ssl->out_buf_len );
+
+    ssl->out_ctr = buf + ( ssl->out_ctr - ssl->out_buf );
+    ssl->out_hdr = buf + ( ssl->out_hdr - ssl->out_buf );
+    ssl->out_len = buf + ( ssl->out_len - ssl->out_buf );
+    ssl->out_iv  = buf + ( ssl->out_iv  - ssl->out_buf );
+    ssl->out_msg = buf + ( ssl->out_msg - ssl->out_buf );
+
+    MBEDTLS_SSL_DEBUG_MSG( 3, ( "output buffer: %d -> %d bytes",
+                                ssl->out_buf_len, len ) );
+
+    mbedtls_platform_zeroize( ssl->out_buf, ssl->out_buf_len );
+    mbedtls_free( ssl->out_buf );
+    ssl->out_buf = buf;
+    ssl->out_buf_len = len;
+
+    return( 0 );
+}
+
+/*
+ * Make a buffer at least len bytes long, rounded up to the growth step and
+ * capped at the static maximum (larger requests are rejected by the callers)
+ */
+static size_t ssl_grown_buffer_len( size_t len, size_t max_len )
+{
+    len = ( len + SSL_VARIABLE_BUFFER_STEP - 1 ) /
+          SSL_VARIABLE_BUFFER_STEP * SSL_VARIABLE_BUFFER_STEP;
+
+    return( len < max_len ? len : max_len );
+}
+
+static int ssl_grow_in_buffer( mbedtls_ssl_context *ssl, size_t len )
+{
+    if( len <= ssl->in_buf_len )
+        return( 0 );
+
+    return( ssl_resize_in_buffer( ssl,
+                ssl_grown_buffer_len( len, MBEDTLS_SSL_IN_BUFFER_LEN ) ) );
+}
+
+static int ssl_grow_out_buffer( mbedtls_ssl_context *ssl, size_t len )
+{
+    if( len <= ssl->out_buf_len )
+        return( 0 );
+
+    return( ssl_resize_out_buffer( ssl,
+                ssl_grown_buffer_len( len, MBEDTLS_SSL_OUT_BUFFER_LEN ) ) );
+}
+
+static int ssl_shrink_check( const mbedtls_ssl_context *ssl )
+{
+    if( ssl == NULL || ssl->conf == NULL )
+        return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
+
+    if( ssl->conf->transport != MBEDTLS_SSL_TRANSPORT_STREAM ||
+        ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER || ssl->handshake != NULL )
+        return( 1 );
+
+    return( 0 );
+}
+
+int mbedtls_ssl_shrink_in_buffer( mbedtls_ssl_context *ssl )
+{
+    int ret;
+    size_t in_len, used;
+
+    if( ( ret = ssl_shrink_check( ssl ) ) != 0 )
+        return( ret < 0 ? ret : 0 );
+
+    /* Keep the partially received record and the current message, which
+     * may still hold unread application data */
+    in_len = SSL_VARIABLE_BUFFER_MIN_LEN;
+    used = (size_t)( ssl->in_hdr - ssl->in_buf ) + ssl->in_left;
+    if( used > in_len )
+        in_len = used;
+    used = (size_t)( ssl->in_msg - ssl->in_buf ) + ssl->in_msglen;
+    if( used > in_len )
+        in_len = used;
+
+    if( in_len < ssl->in_buf_len )
+        return( ssl_resize_in_buffer( ssl, in_len ) );
+
+    return( 0 );
+}
+
+int mbedtls_ssl_shrink_out_buffer( mbedtls_ssl_context *ssl )
+{
+    int ret;
+
+    if( ( ret = ssl_shrink_check( ssl ) ) != 0 )
+        return( ret < 0 ? ret : 0 );
+
+    /* A record that has not been completely written out must stay */
+    if( ssl->out_left == 0 && SSL_VARIABLE_BUFFER_MIN_LEN < ssl->out_buf_len )
+        return( ssl_resize_out_buffer( ssl, SSL_VARIABLE_BUFFER_MIN_LEN ) );
+
+    return( 0 );
+}
+
+int mbedtls_ssl_shrink_buffers( mbedtls_ssl_context *ssl )
+{
+    int ret;
+
+    if( ( ret = mbedtls_ssl_shrink_in_buffer( ssl ) ) != 0 )
+        return( ret );
+
+    return( mbedtls_ssl_shrink_out_buffer( ssl ) );
+}
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 /*
  * Fill the input message buffer by appending data to it.
  * The amount of data already fetched is in ssl->in_left.
@@ -2545,7 +2728,17 @@ int mbedtls_ssl_fetch_input( mbedtls_ssl_context *ssl, size_t nb_want )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
     }
 
-    if( nb_want > MBEDTLS_SSL_IN_BUFFER_LEN - (size_t)( ssl->in_hdr - ssl->in_buf ) )
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* The constant-time CBC padding check reads up to 256 bytes past the
+     * padding, so the record alone is not enough room */
+    if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_STREAM &&
+        nb_want <= MBEDTLS_SSL_IN_BUFFER_LEN - (size_t)( ssl->in_hdr - ssl->in_buf ) &&
+        ( ret = ssl_grow_in_buffer( ssl, (size_t)( ssl->in_hdr - ssl->in_buf ) +
+                                         nb_want + MBEDTLS_SSL_PADDING_ADD ) ) != 0 )
+        return( ret );
+#endif
+
+    if( nb_want > SSL_IN_BUFFER_LEN( ssl ) - (size_t)( ssl->in_hdr - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "requesting more data than fits" ) );
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
@@ -2631,7 +2824,7 @@ int mbedtls_ssl_fetch_input( mbedtls_ssl_context *ssl, size_t nb_want )
         }
         else
         {
-            len = MBEDTLS_SSL_IN_BUFFER_LEN - ( ssl->in_hdr - ssl->in_buf );
+            len = SSL_IN_BUFFER_LEN( ssl ) - ( ssl->in_hdr - ssl->in_buf );
 
             if( ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER )
                 timeout = ssl->handshake->retransmit_timeout;
@@ -4878,7 +5071,7 @@ static int ssl_load_buffered_record( mbedtls_ssl_context *ssl )
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "Found buffered record from current epoch - load" ) );
 
     /* Double-check that the record is not too large */
-    if( rec_len > MBEDTLS_SSL_IN_BUFFER_LEN -
+    if( rec_len > SSL_IN_BUFFER_LEN( ssl ) -
         (size_t)( ssl->in_hdr - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "should never happen" ) );
@@ -6342,6 +6535,12 @@ void mbedtls_ssl_handshake_wrapup( mbedtls_ssl_context *ssl )
 
     ssl->state++;
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* Give back the full size handshake buffers; on allocation failure
+     * they are simply kept */
+    (void) mbedtls_ssl_shrink_buffers( ssl );
+#endif
+
     MBEDTLS_SSL_DEBUG_MSG( 3, ( "<= handshake wrapup" ) );
 }
 
@@ -6819,9 +7018,19 @@ int mbedtls_ssl_setup( mbedtls_ssl_context *ssl,
                        const mbedtls_ssl_config *conf )
 {
     int ret;
+    size_t in_buf_len = MBEDTLS_SSL_IN_BUFFER_LEN;
 
     ssl->conf = conf;
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* With TLS the input buffer grows when a larger record arrives; the
+     * output buffer is needed at full size for the handshake anyway */
+    if( conf->transport == MBEDTLS_SSL_TRANSPORT_STREAM )
+        in_buf_len = SSL_VARIABLE_BUFFER_MIN_LEN;
+    ssl->in_buf_len = in_buf_len;
+    ssl->out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
+#endif
+
     /*
      * Prepare base structures
      */
@@ -6829,10 +7038,10 @@ int mbedtls_ssl_setup( mbedtls_ssl_context *ssl,
     /* Set to NULL in case of an error condition */
     ssl->out_buf = NULL;
 
-    ssl->in_buf = mbedtls_calloc( 1, MBEDTLS_SSL_IN_BUFFER_LEN );
+    ssl->in_buf = mbedtls_calloc( 1, in_buf_len );
     if( ssl->in_buf == NULL )
     {
-        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", MBEDTLS_SSL_IN_BUFFER_LEN) );
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", in_buf_len ) );
         ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
         goto error;
     }
@@ -6941,14 +7150,14 @@ static int ssl_session_reset_int( mbedtls_ssl_context *ssl, int partial )
     ssl->session_in = NULL;
     ssl->session_out = NULL;
 
-    memset( ssl->out_buf, 0, MBEDTLS_SSL_OUT_BUFFER_LEN );
+    memset( ssl->out_buf, 0, SSL_OUT_BUFFER_LEN( ssl ) );
 
 #if defined(MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE) && defined(MBEDTLS_SSL_SRV_C)
     if( partial == 0 )
 #endif /* MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE && MBEDTLS_SSL_SRV_C */
     {
         ssl->in_left = 0;
-        memset( ssl->in_buf, 0, MBEDTLS_SSL_IN_BUFFER_LEN );
+        memset( ssl->in_buf, 0, SSL_IN_BUFFER_LEN( ssl ) );
     }
 
 #if defined(MBEDTLS_SSL_HW_RECORD_ACCEL)
@@ -8003,6 +8212,14 @@ int mbedtls_ssl_handshake_step( mbedtls_ssl_context *ssl )
     if( ssl == NULL || ssl->conf == NULL )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* Handshake messages are written in place without knowing the buffer
+     * size, so the output buffer is full size until the handshake is over */
+    if( ( ret = ssl_grow_out_buffer( ssl, MBEDTLS_SSL_OUT_BUFFER_LEN ) ) != 0 )
+        return( ret );
+    ret = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+#endif
+
 #if defined(MBEDTLS_SSL_CLI_C)
     if( ssl->conf->endpoint == MBEDTLS_SSL_IS_CLIENT )
         ret = mbedtls_ssl_handshake_client_step( ssl );
@@ -8564,6 +8781,11 @@ static int ssl_write_real( mbedtls_ssl_context *ssl,
          * copy the data into the internal buffers and setup the data structure
          * to keep track of partial writes
          */
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+        if( ( ret = ssl_grow_out_buffer( ssl,
+                        SSL_BUFFER_LEN_FOR_CONTENT( len ) ) ) != 0 )
+            return( ret );
+#endif
         ssl->out_msglen  = len;
         ssl->out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
         memcpy( ssl->out_msg, buf, len );
@@ -8874,13 +9096,13 @@ void mbedtls_ssl_free( mbedtls_ssl_context *ssl )
 
     if( ssl->out_buf != NULL )
     {
-        mbedtls_platform_zeroize( ssl->out_buf, MBEDTLS_SSL_OUT_BUFFER_LEN );
+        mbedtls_platform_zeroize( ssl->out_buf, SSL_OUT_BUFFER_LEN( ssl ) );
         mbedtls_free( ssl->out_buf );
     }
 
     if( ssl->in_buf != NULL )
     {
-        mbedtls_platform_zeroize( ssl->in_buf, MBEDTLS_SSL_IN_BUFFER_LEN );
+        mbedtls_platform_zeroize( ssl->in_buf, SSL_IN_BUFFER_LEN( ssl ) );
         mbedtls_free( ssl->in_buf );
     }
 
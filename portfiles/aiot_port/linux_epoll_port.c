@@ -0,0 +1,197 @@
+/*
+ * Linux下基于epoll的socket收发实现, 用于替换posix_port.c中基于select的TCP/UDP客户端收发。
+ * 编译时定义CORE_SYSDEP_NETWORK_LINUX_EPOLL后, posix_port.c会使用这里的实现。
+ *
+ * + select每次调用都要重建fd_set, 且fd超过FD_SETSIZE(1024)后行为未定义;
+ *   这里每个连接只创建一个epoll实例并注册一次可读事件, 对fd大小没有限制。
+ * + 收发时先以MSG_DONTWAIT直接调用recv/send, 数据已就绪时一次系统调用即可完成, 仅在EAGAIN时才等待。
+ * + 只有发送缓冲区满时才需要等待可写, 这时用poll等待. 不把EPOLLOUT注册到同一个epoll实例中,
+ *   否则另一个线程中阻塞接收的一方会被可写事件反复唤醒。
+ * + 超时基于CLOCK_MONOTONIC计算。
+ */
+#if defined(__linux__)
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "aiot_state_api.h"
+#include "linux_epoll_port.h"
+
+extern aiot_state_logcb_t g_logcb_handler;
+
+static void _core_sysdep_epoll_log_errno(const char *func)
+{
+    char buffer[100] = {0};
+
+    if (g_logcb_handler == NULL) {
+        return;
+    }
+
+    snprintf(buffer, sizeof(buffer), "%s, errno: %d, %s\n", func, errno, strerror(errno));
+    g_logcb_handler(STATE_PORT_BASE, buffer);
+}
+
+static uint64_t _core_sysdep_epoll_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/* 返回值: >0 可以重试收发, 0 已到截止时间, <0 epoll失败 */
+static int32_t _core_sysdep_epoll_wait_readable(core_sysdep_epoll_io_t *io, uint64_t deadline_ms)
+{
+    int res = 0;
+    uint64_t time_now = 0;
+    struct epoll_event event;
+
+    if (io->epfd < 0) {
+        io->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (io->epfd < 0) {
+            _core_sysdep_epoll_log_errno("epoll_create1");
+            return -1;
+        }
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = io->fd;
+        if (epoll_ctl(io->epfd, EPOLL_CTL_ADD, io->fd, &event) < 0) {
+            _core_sysdep_epoll_log_errno("epoll_ctl");
+            close(io->epfd);
+            io->epfd = -1;
+            return -1;
+        }
+    }
+
+    time_now = _core_sysdep_epoll_time_ms();
+    if (time_now >= deadline_ms) {
+        return 0;
+    }
+
+    res = epoll_wait(io->epfd, &event, 1, (int)(deadline_ms - time_now));
+    if (res < 0) {
+        if (errno == EINTR) {
+            return 1;
+        }
+        _core_sysdep_epoll_log_errno("epoll_wait");
+        return -1;
+    }
+
+    /* EPOLLERR/EPOLLHUP同样视为就绪, 由recv返回具体错误 */
+    return (res == 0) ? 0 : 1;
+}
+
+/* 返回值同上 */
+static int32_t _core_sysdep_epoll_wait_writable(core_sysdep_epoll_io_t *io, uint64_t deadline_ms)
+{
+    int res = 0;
+    uint64_t time_now = _core_sysdep_epoll_time_ms();
+    struct pollfd pfd;
+
+    if (time_now >= deadline_ms) {
+        return 0;
+    }
+
+    memset(&pfd, 0, sizeof(pfd));
+    pfd.fd = io->fd;
+    pfd.events = POLLOUT;
+    res = poll(&pfd, 1, (int)(deadline_ms - time_now));
+    if (res < 0) {
+        if (errno == EINTR) {
+            return 1;
+        }
+        _core_sysdep_epoll_log_errno("poll");
+        return -1;
+    }
+
+    return (res == 0) ? 0 : 1;
+}
+
+void core_sysdep_epoll_io_init(core_sysdep_epoll_io_t *io, int fd)
+{
+    io->fd = fd;
+    io->epfd = -1;
+}
+
+int32_t core_sysdep_epoll_io_recv(core_sysdep_epoll_io_t *io, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
+                                  uint8_t once)
+{
+    int32_t res = 0;
+    uint32_t recv_bytes = 0;
+    ssize_t recv_res = 0;
+    uint64_t deadline_ms = _core_sysdep_epoll_time_ms() + timeout_ms;
+
+    while (recv_bytes < len) {
+        recv_res = recv(io->fd, buffer + recv_bytes, len - recv_bytes, MSG_DONTWAIT);
+        if (recv_res > 0) {
+            recv_bytes += recv_res;
+            if (once) {
+                break;
+            }
+            continue;
+        } else if (recv_res == 0) {
+            return STATE_PORT_NETWORK_RECV_CONNECTION_CLOSED;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            _core_sysdep_epoll_log_errno("core_sysdep_epoll_io_recv");
+            return STATE_PORT_NETWORK_RECV_FAILED;
+        }
+
+        res = _core_sysdep_epoll_wait_readable(io, deadline_ms);
+        if (res < 0) {
+            return STATE_PORT_NETWORK_SELECT_FAILED;
+        } else if (res == 0) {
+            break;
+        }
+    }
+
+    return (int32_t)recv_bytes;
+}
+
+int32_t core_sysdep_epoll_io_send(core_sysdep_epoll_io_t *io, uint8_t *buffer, uint32_t len, uint32_t timeout_ms)
+{
+    int32_t res = 0;
+    uint32_t send_bytes = 0;
+    ssize_t send_res = 0;
+    uint64_t deadline_ms = _core_sysdep_epoll_time_ms() + timeout_ms;
+
+    while (send_bytes < len) {
+        send_res = send(io->fd, buffer + send_bytes, len - send_bytes, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (send_res > 0) {
+            send_bytes += send_res;
+            continue;
+        } else if (send_res < 0 && errno == EINTR) {
+            continue;
+        } else if (send_res < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            _core_sysdep_epoll_log_errno("core_sysdep_epoll_io_send");
+            return STATE_PORT_NETWORK_SEND_FAILED;
+        }
+
+        res = _core_sysdep_epoll_wait_writable(io, deadline_ms);
+        if (res < 0) {
+            return STATE_PORT_NETWORK_SELECT_FAILED;
+        } else if (res == 0) {
+            break;
+        }
+    }
+
+    return (int32_t)send_bytes;
+}
+
+void core_sysdep_epoll_io_deinit(core_sysdep_epoll_io_t *io)
+{
+    if (io->epfd >= 0) {
+        close(io->epfd);
+        io->epfd = -1;
+    }
+}
+
+#endif /* __linux__ */
+
@@ -0,0 +1,85 @@
+/**
+ * @file linux_epoll_port.h
+ * @brief Linux下基于epoll的socket收发实现, 供posix_port.c在定义CORE_SYSDEP_NETWORK_LINUX_EPOLL时使用
+ *
+ * + 每个连接在首次需要等待可读时创建一个epoll实例并注册一次, 之后不再重复注册
+ * + 发送缓冲区满时才需要等待可写, 这种情况用poll等待, 不占用epoll实例
+ * + 先以MSG_DONTWAIT直接收发, 仅在EAGAIN时才等待可读/可写
+ * + 超时基于CLOCK_MONOTONIC, 不受系统时间调整影响, 也不受FD_SETSIZE限制
+ *
+ */
+#ifndef _LINUX_EPOLL_PORT_H_
+#define _LINUX_EPOLL_PORT_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @brief 单个连接的epoll收发上下文
+ *
+ * @details
+ *
+ * epoll实例只注册可读事件, 收发在不同线程并发进行时, 可写事件不会唤醒正在等待接收的线程
+ */
+typedef struct {
+    int fd;
+    int epfd;       /* 只注册EPOLLIN, -1表示尚未创建 */
+} core_sysdep_epoll_io_t;
+
+/**
+ * @brief 初始化收发上下文, 不会创建epoll实例
+ *
+ * @param[in] io 收发上下文
+ * @param[in] fd 已建连的socket
+ */
+void core_sysdep_epoll_io_init(core_sysdep_epoll_io_t *io, int fd);
+
+/**
+ * @brief 接收数据
+ *
+ * @param[in] io 收发上下文
+ * @param[in] buffer 接收缓冲区
+ * @param[in] len 期望接收的长度
+ * @param[in] timeout_ms 超时时间
+ * @param[in] once 为1时收到任意数据即返回(用于UDP)
+ *
+ * @return int32_t
+ * @retval >=0 实际接收的字节数, 超时返回已接收的部分
+ * @retval STATE_PORT_NETWORK_RECV_CONNECTION_CLOSED 对端关闭连接
+ * @retval STATE_PORT_NETWORK_RECV_FAILED 接收失败
+ * @retval STATE_PORT_NETWORK_SELECT_FAILED epoll失败
+ */
+int32_t core_sysdep_epoll_io_recv(core_sysdep_epoll_io_t *io, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
+                                  uint8_t once);
+
+/**
+ * @brief 发送数据
+ *
+ * @param[in] io 收发上下文
+ * @param[in] buffer 待发送数据
+ * @param[in] len 待发送长度
+ * @param[in] timeout_ms 超时时间
+ *
+ * @return int32_t
+ * @retval >=0 实际发送的字节数, 超时返回已发送的部分
+ * @retval STATE_PORT_NETWORK_SEND_FAILED 发送失败
+ * @retval STATE_PORT_NETWORK_SELECT_FAILED poll失败
+ */
+int32_t core_sysdep_epoll_io_send(core_sysdep_epoll_io_t *io, uint8_t *buffer, uint32_t len, uint32_t timeout_ms);
+
+/**
+ * @brief 释放epoll实例, 不关闭socket
+ *
+ * @param[in] io 收发上下文
+ */
+void core_sysdep_epoll_io_deinit(core_sysdep_epoll_io_t *io);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
+
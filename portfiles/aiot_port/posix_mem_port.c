@@ -0,0 +1,423 @@
+/*
+ * 带模块统计的内存分配实现, 编译时定义CORE_SYSDEP_MEM_POOL_ENABLE(或CORE_SYSDEP_MEM_STATIC)后,
+ * posix_port.c中的core_sysdep_malloc/core_sysdep_free才使用这里的实现, 否则直接调用malloc/free。
+ * slab中的chunk不归还系统, 适合内存用量平稳、需要按模块统计或使用静态arena的场景。
+ *
+ * + 每块内存前有16字节的头部, 记录申请大小、所属模块与slab级别, 释放时据此更新统计
+ * + 头部+申请大小不超过最大级别的内存从对应级别的slab中分配, 释放的内存块挂回该级别的空闲链表, 不归还系统
+ * + 模块统计使用原子操作更新, 模块名在首次出现时登记, 之后按指针或字符串匹配
+ *
+ * 默认模式下slab每次向系统申请一整块chunk并按级别切分, 超过2048字节的内存直接使用malloc/free;
+ * 定义CORE_SYSDEP_MEM_STATIC时为静态模式, 所有内存都从@ref core_sysdep_mem_pool_arena_add 提供的arena中切分,
+ * 最大级别扩大到64KB, arena用尽或超过最大级别时返回NULL, 不会调用malloc
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "aiot_state_api.h"
+#include "posix_mem_port.h"
+
+/* 头部大小, 同时也是返回给调用者的内存的对齐字节数 */
+#define CORE_SYSDEP_MEM_HEADER_SIZE         (16)
+#define CORE_SYSDEP_MEM_MAGIC               (0xA5)
+/* slab级别个数, 第i级内存块(含头部)大小为32 << i; 默认模式为32~2048字节, 静态模式为32~65536字节 */
+#if defined(CORE_SYSDEP_MEM_STATIC)
+#define CORE_SYSDEP_MEM_CLASS_NUM           (12)
+#else
+#define CORE_SYSDEP_MEM_CLASS_NUM           (7)
+#endif
+#define CORE_SYSDEP_MEM_CLASS_MIN_SIZE      (32)
+#define CORE_SYSDEP_MEM_CLASS_NONE          (0xFF)
+/* 默认模式下slab每次向系统申请的chunk大小 */
+#define CORE_SYSDEP_MEM_CHUNK_SIZE          (32 * 1024)
+/* 静态模式下可添加的arena个数 */
+#define CORE_SYSDEP_MEM_ARENA_MAX           (8)
+/* 可登记的模块个数, 最后一项固定用于统计登记不下的模块 */
+#define CORE_SYSDEP_MEM_MODULE_MAX          (32)
+#define CORE_SYSDEP_MEM_MODULE_UNKNOWN      "unknown"
+#define CORE_SYSDEP_MEM_MODULE_OTHER        "other"
+
+typedef struct _core_sysdep_mem_header {
+    uint32_t size;
+    uint16_t module;
+    uint8_t size_class;
+    uint8_t magic;
+    struct _core_sysdep_mem_header *next;   /* 位于slab空闲链表时有效 */
+} _core_sysdep_mem_header_t;
+
+typedef char _core_sysdep_mem_header_size_check[(sizeof(_core_sysdep_mem_header_t) <= CORE_SYSDEP_MEM_HEADER_SIZE) ? 1 : -1];
+
+typedef struct {
+    pthread_mutex_t mutex;
+    _core_sysdep_mem_header_t *free_list;
+    uint8_t *chunk_pos;
+    uint8_t *chunk_end;
+} _core_sysdep_mem_class_t;
+
+/*
+ * 内存块的来源. 默认模式只有一个arena, 各级别的chunk向系统申请;
+ * 静态模式下每个arena是调用者提供的一段内存, 各级别直接从[pos, end)中切分内存块
+ */
+typedef struct {
+    char name[AIOT_SYSDEP_MEM_MODULE_NAME_MAXLEN];  /* 专属的模块名, 空字符串表示默认arena */
+    pthread_mutex_t mutex;
+    uint8_t *begin;
+    uint8_t *pos;
+    uint8_t *end;
+    _core_sysdep_mem_class_t mem_class[CORE_SYSDEP_MEM_CLASS_NUM];
+} _core_sysdep_mem_arena_t;
+
+typedef struct {
+    const char *name_ptr;   /* 首次登记时的模块名地址, 用于快速匹配 */
+    char name[AIOT_SYSDEP_MEM_MODULE_NAME_MAXLEN];
+    _core_sysdep_mem_arena_t *arena;
+    uint64_t live_bytes;
+    uint64_t peak_bytes;
+    uint64_t live_count;
+    uint64_t total_count;
+    uint64_t failed_count;
+} _core_sysdep_mem_module_t;
+
+#if defined(CORE_SYSDEP_MEM_STATIC)
+static _core_sysdep_mem_arena_t g_core_sysdep_mem_arena[CORE_SYSDEP_MEM_ARENA_MAX];
+static uint32_t g_core_sysdep_mem_arena_count = 0;
+#else
+static _core_sysdep_mem_arena_t g_core_sysdep_mem_arena[1];
+static uint32_t g_core_sysdep_mem_arena_count = 1;
+#endif
+static pthread_once_t g_core_sysdep_mem_arena_once = PTHREAD_ONCE_INIT;
+
+static _core_sysdep_mem_module_t g_core_sysdep_mem_module[CORE_SYSDEP_MEM_MODULE_MAX];
+static uint32_t g_core_sysdep_mem_module_count = 0;
+static pthread_mutex_t g_core_sysdep_mem_module_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void _core_sysdep_mem_arena_once(void)
+{
+    uint32_t idx = 0, class_idx = 0;
+
+    for (idx = 0; idx < sizeof(g_core_sysdep_mem_arena) / sizeof(g_core_sysdep_mem_arena[0]); idx++) {
+        pthread_mutex_init(&g_core_sysdep_mem_arena[idx].mutex, NULL);
+        for (class_idx = 0; class_idx < CORE_SYSDEP_MEM_CLASS_NUM; class_idx++) {
+            pthread_mutex_init(&g_core_sysdep_mem_arena[idx].mem_class[class_idx].mutex, NULL);
+        }
+    }
+}
+
+/* 模块使用的arena: 有同名的专属arena时使用专属arena, 否则使用默认arena, 都没有时返回NULL */
+static _core_sysdep_mem_arena_t *_core_sysdep_mem_arena_find(const char *name)
+{
+    uint32_t idx = 0, count = __atomic_load_n(&g_core_sysdep_mem_arena_count, __ATOMIC_ACQUIRE);
+    _core_sysdep_mem_arena_t *arena = NULL;
+
+    for (idx = 0; idx < count; idx++) {
+        if (g_core_sysdep_mem_arena[idx].name[0] == 0) {
+            if (arena == NULL) {
+                arena = &g_core_sysdep_mem_arena[idx];
+            }
+        } else if (strncmp(g_core_sysdep_mem_arena[idx].name, name, AIOT_SYSDEP_MEM_MODULE_NAME_MAXLEN - 1) == 0) {
+            return &g_core_sysdep_mem_arena[idx];
+        }
+    }
+
+    return arena;
+}
+
+static uint8_t _core_sysdep_mem_module_match(_core_sysdep_mem_module_t *module, const char *name)
+{
+    return (module->name_ptr == name ||
+            strncmp(module->name, name, AIOT_SYSDEP_MEM_MODULE_NAME_MAXLEN - 1) == 0) ? 1 : 0;
+}
+
+static uint16_t _core_sysdep_mem_module_index(const char *name)
+{
+    uint32_t idx = 0, count = 0;
+
+    if (name == NULL) {
+        name = CORE_SYSDEP_MEM_MODULE_UNKNOWN;
+    }
+
+    count = __atomic_load_n(&g_core_sysdep_mem_module_count, __ATOMIC_ACQUIRE);
+    for (idx = 0; idx < count; idx++) {
+        if (_core_sysdep_mem_module_match(&g_core_sysdep_mem_module[idx], name)) {
+            return (uint16_t)idx;
+        }
+    }
+
+    /* 首次出现的模块名, 加锁后再检查一次, 避免重复登记 */
+    pthread_mutex_lock(&g_core_sysdep_mem_module_mutex);
+    count = g_core_sysdep_mem_module_count;
+    for (; idx < count; idx++) {
+        if (_core_sysdep_mem_module_match(&g_core_sysdep_mem_module[idx], name)) {
+            pthread_mutex_unlock(&g_core_sysdep_mem_module_mutex);
+            return (uint16_t)idx;
+        }
+    }
+    if (count < CORE_SYSDEP_MEM_MODULE_MAX - 1) {
+        g_core_sysdep_mem_module[count].name_ptr = name;
+        strncpy(g_core_sysdep_mem_module[count].name, name, AIOT_SYSDEP_MEM_MODULE_NAME_MAXLEN - 1);
+    } else {
+        count = CORE_SYSDEP_MEM_MODULE_MAX - 1;
+        if (g_core_sysdep_mem_module_count == count) {
+            memcpy(g_core_sysdep_mem_module[count].name, CORE_SYSDEP_MEM_MODULE_OTHER, strlen(CORE_SYSDEP_MEM_MODULE_OTHER));
+        }
+    }
+    if (g_core_sysdep_mem_module_count == count) {
+        __atomic_store_n(&g_core_sysdep_mem_module[count].arena,
+                         _core_sysdep_mem_arena_find(g_core_sysdep_mem_module[count].name), __ATOMIC_RELAXED);
+        __atomic_store_n(&g_core_sysdep_mem_module_count, count + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_core_sysdep_mem_module_mutex);
+
+    return (uint16_t)count;
+}
+
+static void _core_sysdep_mem_module_alloc(uint16_t index, uint32_t size)
+{
+    _core_sysdep_mem_module_t *module = &g_core_sysdep_mem_module[index];
+    uint64_t live_bytes = 0, peak_bytes = 0;
+
+    live_bytes = __atomic_add_fetch(&module->live_bytes, size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&module->live_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&module->total_count, 1, __ATOMIC_RELAXED);
+
+    peak_bytes = __atomic_load_n(&module->peak_bytes, __ATOMIC_RELAXED);
+    while (live_bytes > peak_bytes &&
+           !__atomic_compare_exchange_n(&module->peak_bytes, &peak_bytes, live_bytes, 1, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+    }
+}
+
+static void _core_sysdep_mem_module_free(uint16_t index, uint32_t size)
+{
+    _core_sysdep_mem_module_t *module = &g_core_sysdep_mem_module[index];
+
+    __atomic_sub_fetch(&module->live_bytes, size, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&module->live_count, 1, __ATOMIC_RELAXED);
+}
+
+static uint8_t _core_sysdep_mem_size_class(uint64_t block_size)
+{
+    uint8_t size_class = 0;
+    uint64_t class_size = CORE_SYSDEP_MEM_CLASS_MIN_SIZE;
+
+    while (size_class < CORE_SYSDEP_MEM_CLASS_NUM) {
+        if (block_size <= class_size) {
+            return size_class;
+        }
+        size_class++;
+        class_size <<= 1;
+    }
+
+    return CORE_SYSDEP_MEM_CLASS_NONE;
+}
+
+#if defined(CORE_SYSDEP_MEM_STATIC)
+/* 从arena的剩余空间中切分一块, 空间不足时返回NULL */
+static uint8_t *_core_sysdep_mem_arena_carve(_core_sysdep_mem_arena_t *arena, uint32_t block_size)
+{
+    uint8_t *block = NULL;
+
+    pthread_mutex_lock(&arena->mutex);
+    if ((uint64_t)(arena->end - arena->pos) >= block_size) {
+        block = arena->pos;
+        arena->pos += block_size;
+    }
+    pthread_mutex_unlock(&arena->mutex);
+
+    return block;
+}
+#endif
+
+static _core_sysdep_mem_header_t *_core_sysdep_mem_class_alloc(_core_sysdep_mem_arena_t *arena, uint8_t size_class)
+{
+    _core_sysdep_mem_class_t *mem_class = &arena->mem_class[size_class];
+    uint32_t block_size = CORE_SYSDEP_MEM_CLASS_MIN_SIZE << size_class;
+    _core_sysdep_mem_header_t *header = NULL;
+
+    pthread_mutex_lock(&mem_class->mutex);
+    if (mem_class->free_list != NULL) {
+        header = mem_class->free_list;
+        mem_class->free_list = header->next;
+    } else {
+#if defined(CORE_SYSDEP_MEM_STATIC)
+        header = (_core_sysdep_mem_header_t *)_core_sysdep_mem_arena_carve(arena, block_size);
+#else
+        if (mem_class->chunk_pos == NULL || mem_class->chunk_pos + block_size > mem_class->chunk_end) {
+            /* 当前chunk的剩余部分不足一块, 直接丢弃; chunk不会被释放 */
+            mem_class->chunk_pos = malloc(CORE_SYSDEP_MEM_CHUNK_SIZE);
+            mem_class->chunk_end = (mem_class->chunk_pos == NULL) ? NULL : mem_class->chunk_pos + CORE_SYSDEP_MEM_CHUNK_SIZE;
+        }
+        if (mem_class->chunk_pos != NULL) {
+            header = (_core_sysdep_mem_header_t *)mem_class->chunk_pos;
+            mem_class->chunk_pos += block_size;
+        }
+#endif
+    }
+    pthread_mutex_unlock(&mem_class->mutex);
+
+    return header;
+}
+
+static void _core_sysdep_mem_class_free(_core_sysdep_mem_arena_t *arena, _core_sysdep_mem_header_t *header)
+{
+    _core_sysdep_mem_class_t *mem_class = &arena->mem_class[header->size_class];
+
+    pthread_mutex_lock(&mem_class->mutex);
+    header->next = mem_class->free_list;
+    mem_class->free_list = header;
+    pthread_mutex_unlock(&mem_class->mutex);
+}
+
+/* 内存块所属的arena. 默认模式只有一个arena; 静态模式按地址查找 */
+static _core_sysdep_mem_arena_t *_core_sysdep_mem_arena_of(_core_sysdep_mem_header_t *header)
+{
+#if defined(CORE_SYSDEP_MEM_STATIC)
+    uint32_t idx = 0, count = __atomic_load_n(&g_core_sysdep_mem_arena_count, __ATOMIC_ACQUIRE);
+
+    for (idx = 0; idx < count; idx++) {
+        if ((uint8_t *)header >= g_core_sysdep_mem_arena[idx].begin && (uint8_t *)header < g_core_sysdep_mem_arena[idx].end) {
+            return &g_core_sysdep_mem_arena[idx];
+        }
+    }
+    return NULL;
+#else
+    (void)header;
+    return &g_core_sysdep_mem_arena[0];
+#endif
+}
+
+int32_t core_sysdep_mem_pool_arena_add(char *name, void *buffer, uint32_t len)
+{
+#if defined(CORE_SYSDEP_MEM_STATIC)
+    _core_sysdep_mem_arena_t *arena = NULL;
+    uint8_t *begin = NULL, *end = NULL;
+    uint32_t idx = 0;
+    int32_t res = STATE_SUCCESS;
+
+    if (buffer == NULL) {
+        return STATE_USER_INPUT_NULL_POINTER;
+    }
+    /* 起止地址按头部大小对齐, 保证切分出的内存块满足对齐要求 */
+    begin = (uint8_t *)(((uintptr_t)buffer + CORE_SYSDEP_MEM_HEADER_SIZE - 1) & ~(uintptr_t)(CORE_SYSDEP_MEM_HEADER_SIZE - 1));
+    end = (uint8_t *)(((uintptr_t)buffer + len) & ~(uintptr_t)(CORE_SYSDEP_MEM_HEADER_SIZE - 1));
+    if (end <= begin) {
+        return STATE_USER_INPUT_OUT_RANGE;
+    }
+
+    pthread_once(&g_core_sysdep_mem_arena_once, _core_sysdep_mem_arena_once);
+    pthread_mutex_lock(&g_core_sysdep_mem_module_mutex);
+    if (g_core_sysdep_mem_arena_count >= CORE_SYSDEP_MEM_ARENA_MAX) {
+        res = STATE_USER_INPUT_OUT_RANGE;
+    } else {
+        arena = &g_core_sysdep_mem_arena[g_core_sysdep_mem_arena_count];
+        if (name != NULL) {
+            strncpy(arena->name, name, AIOT_SYSDEP_MEM_MODULE_NAME_MAXLEN - 1);
+        }
+        arena->begin = begin;
+        arena->pos = begin;
+        arena->end = end;
+        __atomic_store_n(&g_core_sysdep_mem_arena_count, g_core_sysdep_mem_arena_count + 1, __ATOMIC_RELEASE);
+
+        /* 已登记的模块改用新的arena, 之前申请的内存仍释放回原arena */
+        for (idx = 0; idx < g_core_sysdep_mem_module_count; idx++) {
+            __atomic_store_n(&g_core_sysdep_mem_module[idx].arena,
+                             _core_sysdep_mem_arena_find(g_core_sysdep_mem_module[idx].name), __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&g_core_sysdep_mem_module_mutex);
+
+    return res;
+#else
+    (void)name;
+    (void)buffer;
+    (void)len;
+    return STATE_SYS_DEPEND_NOT_SUPPORTED;
+#endif
+}
+
+void *core_sysdep_mem_pool_malloc(uint32_t size, char *name)
+{
+    uint16_t module = 0;
+    uint8_t size_class = _core_sysdep_mem_size_class((uint64_t)size + CORE_SYSDEP_MEM_HEADER_SIZE);
+    _core_sysdep_mem_arena_t *arena = NULL;
+    _core_sysdep_mem_header_t *header = NULL;
+
+    pthread_once(&g_core_sysdep_mem_arena_once, _core_sysdep_mem_arena_once);
+    module = _core_sysdep_mem_module_index(name);
+    arena = __atomic_load_n(&g_core_sysdep_mem_module[module].arena, __ATOMIC_RELAXED);
+
+    if (size_class != CORE_SYSDEP_MEM_CLASS_NONE) {
+        if (arena != NULL) {
+            header = _core_sysdep_mem_class_alloc(arena, size_class);
+        }
+    } else {
+#if !defined(CORE_SYSDEP_MEM_STATIC)
+        header = malloc((size_t)size + CORE_SYSDEP_MEM_HEADER_SIZE);
+#endif
+    }
+    if (header == NULL) {
+        __atomic_add_fetch(&g_core_sysdep_mem_module[module].failed_count, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    header->size = size;
+    header->module = module;
+    header->size_class = size_class;
+    header->magic = CORE_SYSDEP_MEM_MAGIC;
+    header->next = NULL;
+    _core_sysdep_mem_module_alloc(module, size);
+
+    return (uint8_t *)header + CORE_SYSDEP_MEM_HEADER_SIZE;
+}
+
+void core_sysdep_mem_pool_free(void *ptr)
+{
+    _core_sysdep_mem_header_t *header = NULL;
+    _core_sysdep_mem_arena_t *arena = NULL;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    header = (_core_sysdep_mem_header_t *)((uint8_t *)ptr - CORE_SYSDEP_MEM_HEADER_SIZE);
+    if (header->magic != CORE_SYSDEP_MEM_MAGIC) {
+        /* 重复释放或非本模块申请的内存, 不做处理 */
+        return;
+    }
+
+    if (header->size_class != CORE_SYSDEP_MEM_CLASS_NONE) {
+        arena = _core_sysdep_mem_arena_of(header);
+        if (arena == NULL) {
+            return;
+        }
+        header->magic = 0;
+        _core_sysdep_mem_module_free(header->module, header->size);
+        _core_sysdep_mem_class_free(arena, header);
+    } else {
+        header->magic = 0;
+        _core_sysdep_mem_module_free(header->module, header->size);
+        free(header);
+    }
+}
+
+int32_t core_sysdep_mem_pool_stats(aiot_sysdep_mem_stats_t *stats, uint32_t max_count)
+{
+    uint32_t idx = 0, count = __atomic_load_n(&g_core_sysdep_mem_module_count, __ATOMIC_ACQUIRE);
+    _core_sysdep_mem_module_t *module = NULL;
+
+    for (idx = 0; idx < count && idx < max_count; idx++) {
+        module = &g_core_sysdep_mem_module[idx];
+        memset(&stats[idx], 0, sizeof(aiot_sysdep_mem_stats_t));
+        memcpy(stats[idx].module, module->name, AIOT_SYSDEP_MEM_MODULE_NAME_MAXLEN);
+        stats[idx].live_bytes = __atomic_load_n(&module->live_bytes, __ATOMIC_RELAXED);
+        stats[idx].peak_bytes = __atomic_load_n(&module->peak_bytes, __ATOMIC_RELAXED);
+        stats[idx].live_count = __atomic_load_n(&module->live_count, __ATOMIC_RELAXED);
+        stats[idx].total_count = __atomic_load_n(&module->total_count, __ATOMIC_RELAXED);
+        stats[idx].failed_count = __atomic_load_n(&module->failed_count, __ATOMIC_RELAXED);
+    }
+
+    return (int32_t)count;
+}
+
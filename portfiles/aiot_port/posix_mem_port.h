@@ -0,0 +1,75 @@
+/**
+ * @file posix_mem_port.h
+ * @brief 支持pthread的POSIX平台上带模块统计的内存分配实现, 定义CORE_SYSDEP_MEM_POOL_ENABLE时
+ *        供posix_port.c的core_sysdep_malloc/core_sysdep_free使用, 默认不启用
+ *
+ * + 按调用core_sysdep_malloc时传入的模块名(如"MQTT", "TLS", "OTA")统计当前/峰值占用
+ * + 小块内存(订阅/发布节点, 回调拷贝, 短报文等)从按大小分级的slab中分配, 释放后留在slab中复用, 不归还系统
+ * + 超过最大级别的内存直接使用malloc/free, 同样计入模块统计
+ * + 定义CORE_SYSDEP_MEM_STATIC时, 所有内存都从调用者提供的arena中切分, 不调用malloc, 用尽时申请失败
+ *
+ */
+#ifndef _POSIX_MEM_PORT_H_
+#define _POSIX_MEM_PORT_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "aiot_sysdep_api.h"
+
+/**
+ * @brief 静态模式下添加一段供SDK使用的内存(arena), 需在aiot_sysdep_set_portfile之前调用
+ *
+ * @details
+ *
+ * name不为NULL时, 该arena只供同名模块(如"MQTT", "TLS")使用, 模块用尽自己的arena时申请失败, 不影响其它模块;
+ * name为NULL时作为默认arena, 供没有专属arena的模块使用. 内存块按2的幂取整后切分, 单次最多申请65520字节,
+ * 估算arena大小时应按各模块同时持有内存的峰值(见@ref core_sysdep_mem_pool_stats)预留
+ *
+ * @param[in] name 专属的模块名, 为NULL时添加默认arena
+ * @param[in] buffer arena内存, 需在SDK使用期间一直有效
+ * @param[in] len arena长度
+ *
+ * @return int32_t
+ * @retval STATE_SUCCESS 添加成功
+ * @retval STATE_USER_INPUT_NULL_POINTER buffer为NULL
+ * @retval STATE_USER_INPUT_OUT_RANGE len过小, 或arena个数超过上限
+ * @retval STATE_SYS_DEPEND_NOT_SUPPORTED 未定义CORE_SYSDEP_MEM_STATIC
+ */
+int32_t core_sysdep_mem_pool_arena_add(char *name, void *buffer, uint32_t len);
+
+/**
+ * @brief 申请内存, 并计入name对应模块的统计
+ *
+ * @param[in] size 申请的字节数
+ * @param[in] name 模块名, 为NULL时计入"unknown"
+ *
+ * @return void*
+ */
+void *core_sysdep_mem_pool_malloc(uint32_t size, char *name);
+
+/**
+ * @brief 释放@ref core_sysdep_mem_pool_malloc 申请的内存
+ *
+ * @param[in] ptr 待释放的内存, 可以为NULL
+ */
+void core_sysdep_mem_pool_free(void *ptr);
+
+/**
+ * @brief 获取各模块的内存统计, 语义同@ref aiot_sysdep_portfile_t::core_sysdep_mem_stats
+ *
+ * @param[out] stats 统计结果数组
+ * @param[in] max_count stats数组的元素个数
+ *
+ * @return int32_t 模块个数
+ */
+int32_t core_sysdep_mem_pool_stats(aiot_sysdep_mem_stats_t *stats, uint32_t max_count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
+
@@ -15,11 +15,14 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <errno.h>
@@ -27,10 +30,86 @@
 #include "aiot_state_api.h"
 #include "aiot_sysdep_api.h"
 
+/*
+ * 内存分配默认直接调用malloc/free. 定义CORE_SYSDEP_MEM_POOL_ENABLE时改用posix_mem_port.c中带模块统计的slab实现,
+ * slab的chunk不归还系统, 各级别之间的空闲内存也不能互相挪用, 内存占用会一直保持在历史峰值;
+ * 定义CORE_SYSDEP_MEM_STATIC时所有内存从core_sysdep_mem_pool_arena_add提供的arena中分配, 隐含CORE_SYSDEP_MEM_POOL_ENABLE
+ */
+#if defined(CORE_SYSDEP_MEM_STATIC) && !defined(CORE_SYSDEP_MEM_POOL_ENABLE)
+#define CORE_SYSDEP_MEM_POOL_ENABLE
+#endif
+#if defined(CORE_SYSDEP_MEM_POOL_ENABLE)
+#include "posix_mem_port.h"
+#endif
+
+/*
+ * TCP/UDP客户端收发的实现方式:
+ * + 定义CORE_SYSDEP_NETWORK_LINUX_EPOLL: 使用linux_epoll_port.c
+ * + 默认: 使用本文件中基于select的实现
+ */
+#if defined(CORE_SYSDEP_NETWORK_LINUX_EPOLL)
+#if !defined(__linux__)
+#error "CORE_SYSDEP_NETWORK_LINUX_EPOLL requires Linux"
+#endif
+#define CORE_SYSDEP_NETWORK_IO_BACKEND
+#endif
+
+#if defined(CORE_SYSDEP_NETWORK_LINUX_EPOLL)
+#include "linux_epoll_port.h"
+typedef core_sysdep_epoll_io_t core_sysdep_network_io_t;
+#define _core_sysdep_network_io_init    core_sysdep_epoll_io_init
+#define _core_sysdep_network_io_recv    core_sysdep_epoll_io_recv
+#define _core_sysdep_network_io_send    core_sysdep_epoll_io_send
+#define _core_sysdep_network_io_deinit  core_sysdep_epoll_io_deinit
+#endif
+
+/*
+ *  默认用getaddrinfo解析, DNS缓存使用固定的有效期CORE_SYSDEP_DNS_DEFAULT_TTL_S.
+ *  定义CORE_SYSDEP_DNS_TTL_ENABLE后改为直接查询AAAA/A记录, 地址和TTL取自同一个应答, 查询次数与getaddrinfo相同;
+ *  这种方式不读取/etc/hosts, 查不到记录时回退到getaddrinfo. glibc 2.34之前需要额外链接libresolv
+ */
+#ifdef CORE_SYSDEP_DNS_TTL_ENABLE
+#include <arpa/nameser.h>
+#include <resolv.h>
+#endif
+
+/* glibc 2.25起提供getrandom, 更早的版本读取/dev/urandom作为随机数种子 */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 25))
+#include <sys/random.h>
+#define CORE_SYSDEP_RAND_GETRANDOM
+#endif
+
 
 /* socket建联时间默认最大值 */
 #define CORE_SYSDEP_DEFAULT_CONNECT_TIMEOUT_MS (10 * 1000)
 #define MAX_LOG_SIZE 200
+/* 本文件内部申请内存时使用的模块名 */
+#define CORE_SYSDEP_MODULE_NAME                "sysdep"
+/* 并行建连时, 相邻两次发起connect的间隔(RFC 8305 Connection Attempt Delay) */
+#define CORE_SYSDEP_CONNECT_ATTEMPT_DELAY_MS   (250)
+/* 单次建连最多尝试的候选地址个数(DNS解析结果 + 备用IP) */
+#define CORE_SYSDEP_CONNECT_CANDIDATES_MAX     (8)
+/* 记录建连耗时的地址个数 */
+#define CORE_SYSDEP_ADDR_STATS_MAX             (16)
+/* DNS缓存的域名个数, 以及每个域名缓存的地址个数 */
+#define CORE_SYSDEP_DNS_CACHE_MAX              (8)
+#define CORE_SYSDEP_DNS_ADDR_MAX               (CORE_SYSDEP_CONNECT_CANDIDATES_MAX)
+#define CORE_SYSDEP_DNS_HOST_MAXLEN            (128)
+/* 无法获取TTL时使用的默认值, 以及TTL的上下限, 单位秒 */
+#define CORE_SYSDEP_DNS_DEFAULT_TTL_S          (60)
+#define CORE_SYSDEP_DNS_MIN_TTL_S              (5)
+#define CORE_SYSDEP_DNS_MAX_TTL_S              (3600)
+/* 后台刷新失败后的重试间隔 */
+#define CORE_SYSDEP_DNS_RETRY_INTERVAL_MS      (5 * 1000)
+/* 条目超过该时长未被使用则不再后台刷新 */
+#define CORE_SYSDEP_DNS_IDLE_TIMEOUT_MS        (10 * 60 * 1000)
+/* 解析失败时, 过期结果最多可继续使用的时长 */
+#define CORE_SYSDEP_DNS_MAX_STALE_MS           (24 * 60 * 60 * 1000)
+/* 后台刷新线程的检查周期 */
+#define CORE_SYSDEP_DNS_REFRESH_INTERVAL_MS    (1000)
+/* 随机数生成器一次生成的密钥流长度(ChaCha20块长度的整数倍), 以及两次混入系统熵之间最多输出的字节数 */
+#define CORE_SYSDEP_RAND_BUFFER_LEN            (512)
+#define CORE_SYSDEP_RAND_RESEED_BYTES          (1024 * 1024)
 
 typedef struct {
     int fd;
@@ -39,8 +118,36 @@ typedef struct {
     char backup_ip[16];
     uint16_t port;
     uint32_t connect_timeout_ms;
+    aiot_sysdep_network_sockopt_t sockopt;
+    uint8_t tls;    /* 设置了TLS凭据, 连接建立后由对接层在其上握手 */
+#if defined(CORE_SYSDEP_NETWORK_IO_BACKEND)
+    core_sysdep_network_io_t network_io;
+#endif
 } core_network_handle_t;
 
+typedef struct {
+    uint32_t key[8];
+    uint8_t buffer[CORE_SYSDEP_RAND_BUFFER_LEN];
+    uint32_t buffer_left;
+    uint32_t fork_gen;
+    uint64_t output_bytes;
+    uint8_t seeded;
+} core_sysdep_rand_ctx_t;
+
+/* 随机数生成器按线程保存, 编译器不支持线程局部变量时所有线程共用一个并加锁 */
+#if defined(__GNUC__)
+#define CORE_SYSDEP_RAND_THREAD_LOCAL __thread
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_THREADS__)
+#define CORE_SYSDEP_RAND_THREAD_LOCAL _Thread_local
+#else
+#define CORE_SYSDEP_RAND_THREAD_LOCAL
+#define CORE_SYSDEP_RAND_SHARED
+static pthread_mutex_t g_core_sysdep_rand_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static CORE_SYSDEP_RAND_THREAD_LOCAL core_sysdep_rand_ctx_t g_core_sysdep_rand_ctx;
+static volatile uint32_t g_core_sysdep_rand_fork_gen = 0;
+static pthread_once_t g_core_sysdep_rand_once = PTHREAD_ONCE_INIT;
+
 
 /*
  * 日志会通过用户设置的日志回调函数g_logcb_handler输出，若未设置，则不输出。
@@ -85,7 +192,11 @@ static void _core_printf(const char* format, ...)
 
 void *core_sysdep_malloc(uint32_t size, char *name)
 {
+#if defined(CORE_SYSDEP_MEM_POOL_ENABLE)
+    void *res = core_sysdep_mem_pool_malloc(size, name);
+#else
     void *res = malloc(size);
+#endif
     if(res == NULL) {
          _core_printf("sysdep malloc failed \n");
     }
@@ -94,7 +205,11 @@ void *core_sysdep_malloc(uint32_t size, char *name)
 
 void core_sysdep_free(void *ptr)
 {
+#if defined(CORE_SYSDEP_MEM_POOL_ENABLE)
+    core_sysdep_mem_pool_free(ptr);
+#else
     free(ptr);
+#endif
 }
 
 uint64_t core_sysdep_time(void)
@@ -107,6 +222,28 @@ uint64_t core_sysdep_time(void)
     return ((uint64_t)time.tv_sec * 1000 + (uint64_t)time.tv_usec / 1000);
 }
 
+uint64_t core_sysdep_time_ns(void)
+{
+    struct timespec ts;
+    struct timeval time;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+    }
+
+    /* 不支持CLOCK_MONOTONIC时退化为系统时间 */
+    memset(&time, 0, sizeof(struct timeval));
+    gettimeofday(&time, NULL);
+
+    return (uint64_t)time.tv_sec * 1000000000 + (uint64_t)time.tv_usec * 1000;
+}
+
+/* 端口内部的超时/缓存有效期计算使用单调时间 */
+static uint64_t _core_sysdep_monotonic_ms(void)
+{
+    return core_sysdep_time_ns() / 1000000;
+}
+
 void core_sysdep_sleep(uint64_t time_ms)
 {
     usleep(time_ms * 1000);
@@ -114,17 +251,27 @@ void core_sysdep_sleep(uint64_t time_ms)
 
 static void *core_sysdep_network_init(void)
 {
-    core_network_handle_t *handle = malloc(sizeof(core_network_handle_t));
+    core_network_handle_t *handle = core_sysdep_malloc(sizeof(core_network_handle_t), CORE_SYSDEP_MODULE_NAME);
     if (handle == NULL) {
         return NULL;
     }
     memset(handle, 0, sizeof(core_network_handle_t));
     handle->connect_timeout_ms = CORE_SYSDEP_DEFAULT_CONNECT_TIMEOUT_MS;
     handle->fd = -1;
+#if defined(CORE_SYSDEP_NETWORK_IO_BACKEND)
+    _core_sysdep_network_io_init(&handle->network_io, -1);
+#endif
 
     return handle;
 }
 
+static void _core_sysdep_sockopt_set(int fd, int level, int name, const char *desc, int value)
+{
+    if (setsockopt(fd, level, name, &value, sizeof(value)) != 0) {
+        _core_printf("setsockopt(%s) failed, errno: %d, %s\n", desc, errno, strerror(errno));
+    }
+}
+
 static int32_t core_sysdep_network_setopt(void *handle, core_sysdep_network_option_t option, void *data)
 {
     core_network_handle_t *network_handle = (core_network_handle_t *)handle;
@@ -143,7 +290,7 @@ static int32_t core_sysdep_network_setopt(void *handle, core_sysdep_network_opti
         }
         break;
         case CORE_SYSDEP_NETWORK_HOST: {
-            network_handle->host = malloc(strlen(data) + 1);
+            network_handle->host = core_sysdep_malloc(strlen(data) + 1, CORE_SYSDEP_MODULE_NAME);
             if (network_handle->host == NULL) {
                  _core_printf("malloc failed\n");
                 return STATE_PORT_MALLOC_FAILED;
@@ -164,6 +311,19 @@ static int32_t core_sysdep_network_setopt(void *handle, core_sysdep_network_opti
             network_handle->connect_timeout_ms = *(uint32_t *)data;
         }
         break;
+        case CORE_SYSDEP_NETWORK_CRED: {
+            network_handle->tls = (((aiot_sysdep_network_cred_t *)data)->option != AIOT_SYSDEP_NETWORK_CRED_NONE);
+        }
+        break;
+        case CORE_SYSDEP_NETWORK_SOCKOPT: {
+            memcpy(&network_handle->sockopt, data, sizeof(aiot_sysdep_network_sockopt_t));
+            /* 连接建立后再次设置时, 只有tcp_nodelay立即生效, 对接层在TLS握手结束后据此恢复用户的设置 */
+            if (network_handle->fd >= 0 && network_handle->socket_type == CORE_SYSDEP_SOCKET_TCP_CLIENT) {
+                _core_sysdep_sockopt_set(network_handle->fd, IPPROTO_TCP, TCP_NODELAY, "TCP_NODELAY",
+                                         network_handle->sockopt.tcp_nodelay ? 1 : 0);
+            }
+        }
+        break;
         default: {
             break;
         }
@@ -172,143 +332,768 @@ static int32_t core_sysdep_network_setopt(void *handle, core_sysdep_network_opti
     return STATE_SUCCESS;
 }
 
-static void _port_uint2str(uint16_t input, char *output)
+/*
+ * 并行建连(Happy Eyeballs, RFC 8305)
+ *
+ * DNS解析结果和备用IP一起作为候选地址, 按历史建连耗时排序后依次发起非阻塞connect,
+ * 相邻两次发起间隔CORE_SYSDEP_CONNECT_ATTEMPT_DELAY_MS, 先完成的连接胜出, 其余连接关闭。
+ * 某个地址建连失败时立即发起下一个, 不必等满connect_timeout_ms。
+ */
+typedef struct {
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    int family;
+    int fd;
+    uint64_t start_ms;
+    uint32_t order;
+} _core_sysdep_connect_candidate_t;
+
+typedef struct {
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    uint32_t latency_ms;    /* 建连耗时的平滑值, 0表示没有成功记录 */
+    uint32_t fail_count;    /* 最近连续失败次数 */
+    uint64_t update_time;
+} _core_sysdep_addr_stats_t;
+
+static _core_sysdep_addr_stats_t g_core_sysdep_addr_stats[CORE_SYSDEP_ADDR_STATS_MAX];
+static pthread_mutex_t g_core_sysdep_addr_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint8_t _core_sysdep_addr_equal(const struct sockaddr_storage *a, socklen_t a_len,
+                                       const struct sockaddr_storage *b, socklen_t b_len)
+{
+    return (a_len == b_len && memcmp(a, b, a_len) == 0) ? 1 : 0;
+}
+
+static _core_sysdep_addr_stats_t *_core_sysdep_addr_stats_find(const struct sockaddr_storage *addr, socklen_t addrlen)
 {
-    uint8_t i = 0, j = 0;
-    char temp[6] = {0};
+    uint32_t idx = 0;
 
-    do {
-        temp[i++] = input % 10 + '0';
-    } while ((input /= 10) > 0);
+    for (idx = 0; idx < CORE_SYSDEP_ADDR_STATS_MAX; idx++) {
+        if (g_core_sysdep_addr_stats[idx].addrlen != 0 &&
+            _core_sysdep_addr_equal(&g_core_sysdep_addr_stats[idx].addr, g_core_sysdep_addr_stats[idx].addrlen, addr, addrlen)) {
+            return &g_core_sysdep_addr_stats[idx];
+        }
+    }
 
-    do {
-        output[--i] = temp[j++];
-    } while (i > 0);
+    return NULL;
 }
 
-static int32_t _core_sysdep_network_connect(char *host, uint16_t port, int family, int socktype, int protocol,
-        uint32_t timeout_ms, int *fd_out)
+static void _core_sysdep_addr_stats_update(const struct sockaddr_storage *addr, socklen_t addrlen, int32_t success,
+        uint32_t latency_ms)
+{
+    uint32_t idx = 0;
+    _core_sysdep_addr_stats_t *stats = NULL;
+
+    pthread_mutex_lock(&g_core_sysdep_addr_stats_mutex);
+    stats = _core_sysdep_addr_stats_find(addr, addrlen);
+    if (stats == NULL) {
+        /* 没有记录时, 替换最久未更新的条目 */
+        stats = &g_core_sysdep_addr_stats[0];
+        for (idx = 1; idx < CORE_SYSDEP_ADDR_STATS_MAX; idx++) {
+            if (g_core_sysdep_addr_stats[idx].update_time < stats->update_time) {
+                stats = &g_core_sysdep_addr_stats[idx];
+            }
+        }
+        memset(stats, 0, sizeof(_core_sysdep_addr_stats_t));
+        memcpy(&stats->addr, addr, addrlen);
+        stats->addrlen = addrlen;
+    }
+
+    if (success) {
+        if (latency_ms == 0) {
+            latency_ms = 1;
+        }
+        stats->latency_ms = (stats->latency_ms == 0) ? latency_ms : (stats->latency_ms * 3 + latency_ms) / 4;
+        stats->fail_count = 0;
+    } else {
+        stats->fail_count++;
+    }
+    stats->update_time = _core_sysdep_monotonic_ms();
+    pthread_mutex_unlock(&g_core_sysdep_addr_stats_mutex);
+}
+
+/* 排序键: 有成功记录的地址按耗时升序在前, 未知地址保持解析顺序居中, 最近失败过的地址排在最后 */
+static uint64_t _core_sysdep_candidate_rank(_core_sysdep_connect_candidate_t *candidate)
+{
+    uint64_t rank = ((uint64_t)1 << 40) + candidate->order;
+    _core_sysdep_addr_stats_t *stats = _core_sysdep_addr_stats_find(&candidate->addr, candidate->addrlen);
+
+    if (stats != NULL) {
+        if (stats->fail_count > 0) {
+            rank = ((uint64_t)2 << 40) + ((uint64_t)stats->fail_count << 8) + candidate->order;
+        } else if (stats->latency_ms > 0) {
+            rank = ((uint64_t)stats->latency_ms << 8) + candidate->order;
+        }
+    }
+
+    return rank;
+}
+
+static void _core_sysdep_candidates_sort(_core_sysdep_connect_candidate_t *candidates, uint32_t count)
+{
+    uint32_t i = 0, j = 0;
+    uint64_t rank[CORE_SYSDEP_CONNECT_CANDIDATES_MAX];
+    uint64_t rank_tmp = 0;
+    _core_sysdep_connect_candidate_t tmp;
+
+    pthread_mutex_lock(&g_core_sysdep_addr_stats_mutex);
+    for (i = 0; i < count; i++) {
+        rank[i] = _core_sysdep_candidate_rank(&candidates[i]);
+    }
+    pthread_mutex_unlock(&g_core_sysdep_addr_stats_mutex);
+
+    for (i = 1; i < count; i++) {
+        for (j = i; j > 0 && rank[j - 1] > rank[j]; j--) {
+            memcpy(&tmp, &candidates[j], sizeof(tmp));
+            memcpy(&candidates[j], &candidates[j - 1], sizeof(tmp));
+            memcpy(&candidates[j - 1], &tmp, sizeof(tmp));
+            rank_tmp = rank[j];
+            rank[j] = rank[j - 1];
+            rank[j - 1] = rank_tmp;
+        }
+    }
+}
+
+/*
+ * 进程级DNS缓存
+ *
+ * 所有网络句柄共享, 按域名缓存解析结果, 有效期为默认值, 定义CORE_SYSDEP_DNS_TTL_ENABLE时取自DNS应答的TTL。
+ * 后台线程在有效期剩余1/4时提前刷新最近使用过的条目, 建连路径上通常不会阻塞在解析上;
+ * 解析失败时继续使用上一次成功的结果(RFC 8767 serve-stale)。
+ */
+typedef struct {
+    uint32_t count;
+    struct sockaddr_storage addr[CORE_SYSDEP_DNS_ADDR_MAX];
+    socklen_t addrlen[CORE_SYSDEP_DNS_ADDR_MAX];
+} _core_sysdep_dns_addrs_t;
+
+typedef struct {
+    char host[CORE_SYSDEP_DNS_HOST_MAXLEN];
+    _core_sysdep_dns_addrs_t addrs;
+    uint64_t resolve_time;  /* 最近一次解析成功的时间 */
+    uint64_t expire_time;   /* 按TTL计算的过期时间 */
+    uint64_t refresh_time;  /* 后台刷新的时间 */
+    uint64_t last_used;
+    uint32_t fail_count;    /* 最近连续刷新失败次数 */
+    uint8_t refreshing;
+} _core_sysdep_dns_entry_t;
+
+static _core_sysdep_dns_entry_t g_core_sysdep_dns_cache[CORE_SYSDEP_DNS_CACHE_MAX];
+static pthread_mutex_t g_core_sysdep_dns_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_core_sysdep_dns_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t g_core_sysdep_dns_once = PTHREAD_ONCE_INIT;
+
+#ifdef CORE_SYSDEP_DNS_TTL_ENABLE
+static const uint8_t *_core_sysdep_dns_skip_name(const uint8_t *pos, const uint8_t *end)
+{
+    while (pos < end) {
+        if (*pos == 0) {
+            return pos + 1;
+        }
+        if ((*pos & 0xC0) == 0xC0) {
+            return (pos + 2 <= end) ? pos + 2 : NULL;
+        }
+        pos += *pos + 1;
+    }
+
+    return NULL;
+}
+
+/* 查询一种地址记录(ns_t_a/ns_t_aaaa), 把应答中的地址追加到addrs, 并用这些地址及其CNAME链的最小TTL更新ttl */
+static void _core_sysdep_dns_query(const char *host, int type, _core_sysdep_dns_addrs_t *addrs, int32_t *ttl)
+{
+    uint8_t answer[1024];
+    const uint8_t *pos = NULL, *end = NULL;
+    int len = 0;
+    uint32_t qdcount = 0, ancount = 0, idx = 0, rr_type = 0, rdlen = 0, rr_ttl = 0, found = 0;
+    uint32_t min_ttl = CORE_SYSDEP_DNS_MAX_TTL_S;
+    struct sockaddr_in *addr4 = NULL;
+    struct sockaddr_in6 *addr6 = NULL;
+
+    len = res_search(host, ns_c_in, type, answer, sizeof(answer));
+    if (len < NS_HFIXEDSZ) {
+        return;
+    }
+    if (len > (int)sizeof(answer)) {
+        len = sizeof(answer);
+    }
+    end = answer + len;
+    qdcount = ((uint32_t)answer[4] << 8) | answer[5];
+    ancount = ((uint32_t)answer[6] << 8) | answer[7];
+
+    pos = answer + NS_HFIXEDSZ;
+    for (idx = 0; idx < qdcount && pos != NULL; idx++) {
+        pos = _core_sysdep_dns_skip_name(pos, end);
+        if (pos != NULL) {
+            pos += NS_QFIXEDSZ;
+        }
+    }
+    for (idx = 0; idx < ancount && pos != NULL; idx++) {
+        pos = _core_sysdep_dns_skip_name(pos, end);
+        if (pos == NULL || pos + NS_RRFIXEDSZ > end) {
+            break;
+        }
+        rr_type = ((uint32_t)pos[0] << 8) | pos[1];
+        rr_ttl = ((uint32_t)pos[4] << 24) | ((uint32_t)pos[5] << 16) | ((uint32_t)pos[6] << 8) | pos[7];
+        rdlen = ((uint32_t)pos[8] << 8) | pos[9];
+        pos += NS_RRFIXEDSZ;
+        if (pos + rdlen > end) {
+            break;
+        }
+        if (rr_type == (uint32_t)type || rr_type == ns_t_cname) {
+            if (rr_ttl < min_ttl) {
+                min_ttl = rr_ttl;
+            }
+        }
+        if (addrs->count < CORE_SYSDEP_DNS_ADDR_MAX) {
+            if (rr_type == ns_t_a && type == ns_t_a && rdlen == NS_INADDRSZ) {
+                addr4 = (struct sockaddr_in *)&addrs->addr[addrs->count];
+                memset(addr4, 0, sizeof(struct sockaddr_storage));
+                addr4->sin_family = AF_INET;
+                memcpy(&addr4->sin_addr, pos, NS_INADDRSZ);
+                addrs->addrlen[addrs->count++] = sizeof(struct sockaddr_in);
+                found++;
+            } else if (rr_type == ns_t_aaaa && type == ns_t_aaaa && rdlen == NS_IN6ADDRSZ) {
+                addr6 = (struct sockaddr_in6 *)&addrs->addr[addrs->count];
+                memset(addr6, 0, sizeof(struct sockaddr_storage));
+                addr6->sin6_family = AF_INET6;
+                memcpy(&addr6->sin6_addr, pos, NS_IN6ADDRSZ);
+                addrs->addrlen[addrs->count++] = sizeof(struct sockaddr_in6);
+                found++;
+            }
+        }
+        pos += rdlen;
+    }
+
+    /* 只有实际缓存了地址的记录类型参与TTL计算 */
+    if (found > 0 && (*ttl < 0 || min_ttl < (uint32_t)*ttl)) {
+        *ttl = (int32_t)min_ttl;
+    }
+}
+#endif
+
+static int32_t _core_sysdep_dns_resolve(const char *host, int flags, _core_sysdep_dns_addrs_t *addrs, uint32_t *ttl_s)
 {
-    int32_t res = STATE_SUCCESS;
-    int fd = 0, sock_option = 0;
-    char service[6] = {0};
     struct addrinfo hints;
-    struct addrinfo *addrInfoList = NULL, *pos = NULL;
-    struct sockaddr_in loc_addr;
-    socklen_t len = sizeof(sizeof(loc_addr));
-    fd_set write_sets;
-    struct timeval timeselect;
+    struct addrinfo *list = NULL, *pos = NULL;
+    int32_t ttl = -1;
+#ifdef CORE_SYSDEP_DNS_TTL_ENABLE
+    struct in6_addr literal;
+#endif
+
+    memset(addrs, 0, sizeof(_core_sysdep_dns_addrs_t));
+#ifdef CORE_SYSDEP_DNS_TTL_ENABLE
+    /* IP字面量直接交给getaddrinfo */
+    if (ttl_s != NULL && (flags & AI_NUMERICHOST) == 0 && inet_pton(AF_INET, host, &literal) != 1 &&
+        inet_pton(AF_INET6, host, &literal) != 1) {
+        _core_sysdep_dns_query(host, ns_t_aaaa, addrs, &ttl);
+        _core_sysdep_dns_query(host, ns_t_a, addrs, &ttl);
+    }
+#endif
 
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_family = family; /* only IPv4 */
-    hints.ai_socktype = socktype;
-    hints.ai_protocol = protocol;
-    hints.ai_flags = 0;
-    _port_uint2str(port, service);
+    if (addrs->count == 0) {
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = flags;
 
-    signal(SIGPIPE, SIG_IGN);
+        if (getaddrinfo(host, NULL, &hints, &list) != 0) {
+            return STATE_PORT_NETWORK_DNS_FAILED;
+        }
 
-    res = getaddrinfo(host, service, &hints, &addrInfoList);
-    if (res == 0) {
-        for (pos = addrInfoList; pos != NULL; pos = pos->ai_next) {
-            fd = socket(pos->ai_family, pos->ai_socktype, pos->ai_protocol);
-            if (fd < 0) {
-                 _core_printf("create socket error\n");
-                res = STATE_PORT_NETWORK_SOCKET_CREATE_FAILED;
+        for (pos = list; pos != NULL && addrs->count < CORE_SYSDEP_DNS_ADDR_MAX; pos = pos->ai_next) {
+            if ((pos->ai_family != AF_INET && pos->ai_family != AF_INET6) ||
+                pos->ai_addrlen > sizeof(struct sockaddr_storage)) {
                 continue;
             }
+            memcpy(&addrs->addr[addrs->count], pos->ai_addr, pos->ai_addrlen);
+            addrs->addrlen[addrs->count] = pos->ai_addrlen;
+            addrs->count++;
+        }
+        freeaddrinfo(list);
+    }
 
-            res = fcntl(fd, F_GETFL);
-            if (res != -1) {
-                res = fcntl(fd, F_SETFL, sock_option | O_NONBLOCK);
-            }
+    if (addrs->count == 0) {
+        return STATE_PORT_NETWORK_DNS_FAILED;
+    }
 
-            if (res == -1) {
-                /* block connect */
-                if (connect(fd, pos->ai_addr, pos->ai_addrlen) == 0) {
-                    *fd_out = fd;
-                    res = STATE_SUCCESS;
-                    break;
-                } else {
-                    res = STATE_PORT_NETWORK_CONNECT_FAILED;
-                }
-            } else {
-                /* non-block connect */
-                FD_ZERO(&write_sets);
-                FD_SET(fd, &write_sets);
-
-                timeselect.tv_sec = timeout_ms / 1000;
-                timeselect.tv_usec = timeout_ms % 1000 * 1000;
-
-                if (connect(fd, pos->ai_addr, pos->ai_addrlen) == 0) {
-                    *fd_out = fd;
-                    res = STATE_SUCCESS;
-                    break;
-                } else if (errno != EINPROGRESS) {
-                    res = STATE_PORT_NETWORK_CONNECT_FAILED;
-                } else {
-                    res = select(fd + 1, NULL, &write_sets, NULL, &timeselect);
-                    if (res == 0) {
-                        res = STATE_MQTT_LOG_CONNECT_TIMEOUT;
-                    } else if (res < 0) {
-                        res = STATE_PORT_NETWORK_CONNECT_FAILED;
-                    } else {
-                        if (FD_ISSET(fd, &write_sets)) {
-                            res = connect(fd, pos->ai_addr, pos->ai_addrlen);
-                            if ((res != 0 && errno == EISCONN) || res == 0) {
-                                *fd_out = fd;
-                                res = STATE_SUCCESS;
-                                break;
-                            } else {
-                                res = STATE_PORT_NETWORK_CONNECT_FAILED;
-                            }
-                        }
-                    }
-                }
+    if (ttl_s != NULL) {
+        if (ttl < 0) {
+            ttl = CORE_SYSDEP_DNS_DEFAULT_TTL_S;
+        } else if (ttl < CORE_SYSDEP_DNS_MIN_TTL_S) {
+            ttl = CORE_SYSDEP_DNS_MIN_TTL_S;
+        }
+        *ttl_s = (uint32_t)ttl;
+    }
+
+    return STATE_SUCCESS;
+}
+
+static _core_sysdep_dns_entry_t *_core_sysdep_dns_entry_find(const char *host)
+{
+    uint32_t idx = 0;
+
+    for (idx = 0; idx < CORE_SYSDEP_DNS_CACHE_MAX; idx++) {
+        if (strcmp(g_core_sysdep_dns_cache[idx].host, host) == 0) {
+            return &g_core_sysdep_dns_cache[idx];
+        }
+    }
+
+    return NULL;
+}
+
+static void _core_sysdep_dns_entry_store(_core_sysdep_dns_entry_t *entry, _core_sysdep_dns_addrs_t *addrs,
+        uint32_t ttl_s, uint64_t time_now)
+{
+    memcpy(&entry->addrs, addrs, sizeof(_core_sysdep_dns_addrs_t));
+    entry->resolve_time = time_now;
+    entry->expire_time = time_now + (uint64_t)ttl_s * 1000;
+    entry->refresh_time = time_now + (uint64_t)ttl_s * 750;
+    entry->fail_count = 0;
+}
+
+static _core_sysdep_dns_entry_t *_core_sysdep_dns_entry_alloc(const char *host)
+{
+    uint32_t idx = 0;
+    _core_sysdep_dns_entry_t *entry = &g_core_sysdep_dns_cache[0];
+
+    /* 替换最久未使用的条目, 正在后台刷新的条目除外 */
+    for (idx = 0; idx < CORE_SYSDEP_DNS_CACHE_MAX; idx++) {
+        if (g_core_sysdep_dns_cache[idx].host[0] == 0) {
+            entry = &g_core_sysdep_dns_cache[idx];
+            break;
+        }
+        if (entry->refreshing ||
+            (!g_core_sysdep_dns_cache[idx].refreshing && g_core_sysdep_dns_cache[idx].last_used < entry->last_used)) {
+            entry = &g_core_sysdep_dns_cache[idx];
+        }
+    }
+    if (entry->refreshing) {
+        return NULL;
+    }
+
+    memset(entry, 0, sizeof(_core_sysdep_dns_entry_t));
+    memcpy(entry->host, host, strlen(host));
+
+    return entry;
+}
+
+static void *_core_sysdep_dns_refresh_thread(void *arg)
+{
+    uint32_t idx = 0, ttl_s = 0;
+    int32_t res = STATE_SUCCESS;
+    uint64_t time_now = 0, wakeup_ms = 0;
+    char host[CORE_SYSDEP_DNS_HOST_MAXLEN];
+    _core_sysdep_dns_addrs_t addrs;
+    _core_sysdep_dns_entry_t *entry = NULL;
+    struct timespec abstime;
+
+    pthread_mutex_lock(&g_core_sysdep_dns_mutex);
+    while (1) {
+        time_now = _core_sysdep_monotonic_ms();
+        entry = NULL;
+        for (idx = 0; idx < CORE_SYSDEP_DNS_CACHE_MAX; idx++) {
+            _core_sysdep_dns_entry_t *pos = &g_core_sysdep_dns_cache[idx];
+            if (pos->host[0] != 0 && !pos->refreshing && time_now >= pos->refresh_time &&
+                time_now - pos->last_used < CORE_SYSDEP_DNS_IDLE_TIMEOUT_MS) {
+                entry = pos;
+                break;
             }
+        }
 
-            close(fd);
-             _core_printf("connect error, errno: %d\n", errno);
+        if (entry == NULL) {
+            /* pthread_cond_timedwait使用CLOCK_REALTIME */
+            wakeup_ms = core_sysdep_time() + CORE_SYSDEP_DNS_REFRESH_INTERVAL_MS;
+            abstime.tv_sec = wakeup_ms / 1000;
+            abstime.tv_nsec = (wakeup_ms % 1000) * 1000000;
+            pthread_cond_timedwait(&g_core_sysdep_dns_cond, &g_core_sysdep_dns_mutex, &abstime);
+            continue;
+        }
+
+        memcpy(host, entry->host, sizeof(host));
+        entry->refreshing = 1;
+        pthread_mutex_unlock(&g_core_sysdep_dns_mutex);
+
+        res = _core_sysdep_dns_resolve(host, 0, &addrs, &ttl_s);
+
+        pthread_mutex_lock(&g_core_sysdep_dns_mutex);
+        entry = _core_sysdep_dns_entry_find(host);
+        if (entry == NULL) {
+            continue;
+        }
+        entry->refreshing = 0;
+        time_now = _core_sysdep_monotonic_ms();
+        if (res == STATE_SUCCESS) {
+            _core_sysdep_dns_entry_store(entry, &addrs, ttl_s, time_now);
+        } else {
+            _core_printf("dns refresh failed, host: %s\n", host);
+            entry->fail_count++;
+            entry->refresh_time = time_now + CORE_SYSDEP_DNS_RETRY_INTERVAL_MS;
         }
-    } else {
-        res = STATE_PORT_NETWORK_DNS_FAILED;
     }
 
-    if (res < 0) {
-         _core_printf("fail to establish tcp\n");
-    } else {
-         _core_printf("success to establish tcp, fd=%d\n", *fd_out);
-        memset(&loc_addr, 0, len);
-        /* 获取本地的port并打印 */
-        if (0 == getsockname(*fd_out, (struct sockaddr *)&loc_addr, &len)
-            && loc_addr.sin_family == AF_INET) {
-            _core_printf("local port: %u\n", ntohs(loc_addr.sin_port));
+    return NULL;
+}
+
+static void _core_sysdep_dns_refresh_start(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    /* 线程创建失败时仍可正常解析, 只是没有后台刷新 */
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, _core_sysdep_dns_refresh_thread, NULL) != 0) {
+        _core_printf("dns refresh thread create failed\n");
+    }
+    pthread_attr_destroy(&attr);
+}
+
+static int32_t _core_sysdep_dns_lookup(const char *host, _core_sysdep_dns_addrs_t *addrs)
+{
+    int32_t res = STATE_SUCCESS;
+    uint32_t ttl_s = 0;
+    uint64_t time_now = 0;
+    uint8_t numeric[sizeof(struct in6_addr)];
+    _core_sysdep_dns_entry_t *entry = NULL;
+
+    /* IP地址及超长域名不经过缓存 */
+    if (inet_pton(AF_INET, host, numeric) == 1 || inet_pton(AF_INET6, host, numeric) == 1) {
+        return _core_sysdep_dns_resolve(host, AI_NUMERICHOST, addrs, NULL);
+    }
+    if (strlen(host) >= CORE_SYSDEP_DNS_HOST_MAXLEN) {
+        return _core_sysdep_dns_resolve(host, 0, addrs, NULL);
+    }
+
+    pthread_mutex_lock(&g_core_sysdep_dns_mutex);
+    time_now = _core_sysdep_monotonic_ms();
+    entry = _core_sysdep_dns_entry_find(host);
+    if (entry != NULL) {
+        /* 未过期, 或后台刷新正在失败时直接使用已有结果, 刷新交给后台线程 */
+        if (time_now < entry->expire_time ||
+            (entry->fail_count > 0 && time_now - entry->resolve_time < CORE_SYSDEP_DNS_MAX_STALE_MS)) {
+            memcpy(addrs, &entry->addrs, sizeof(_core_sysdep_dns_addrs_t));
+            entry->last_used = time_now;
+            if (time_now >= entry->refresh_time) {
+                pthread_cond_signal(&g_core_sysdep_dns_cond);
+            }
+            pthread_mutex_unlock(&g_core_sysdep_dns_mutex);
+            return STATE_SUCCESS;
         }
+    }
+    pthread_mutex_unlock(&g_core_sysdep_dns_mutex);
+
+    res = _core_sysdep_dns_resolve(host, 0, addrs, &ttl_s);
 
+    pthread_mutex_lock(&g_core_sysdep_dns_mutex);
+    time_now = _core_sysdep_monotonic_ms();
+    entry = _core_sysdep_dns_entry_find(host);
+    if (res == STATE_SUCCESS) {
+        if (entry == NULL) {
+            entry = _core_sysdep_dns_entry_alloc(host);
+        }
+        if (entry != NULL) {
+            _core_sysdep_dns_entry_store(entry, addrs, ttl_s, time_now);
+            entry->last_used = time_now;
+        }
+    } else if (entry != NULL && time_now - entry->resolve_time < CORE_SYSDEP_DNS_MAX_STALE_MS) {
+        _core_printf("dns resolve failed, using cached result, host: %s\n", host);
+        memcpy(addrs, &entry->addrs, sizeof(_core_sysdep_dns_addrs_t));
+        entry->last_used = time_now;
+        entry->fail_count++;
         res = STATE_SUCCESS;
     }
+    pthread_mutex_unlock(&g_core_sysdep_dns_mutex);
 
-    if(addrInfoList) {
-        freeaddrinfo(addrInfoList);
+    if (res == STATE_SUCCESS) {
+        pthread_once(&g_core_sysdep_dns_once, _core_sysdep_dns_refresh_start);
     }
 
     return res;
 }
 
-static int32_t _core_sysdep_network_tcp_establish(core_network_handle_t *network_handle)
+static uint32_t _core_sysdep_candidates_append(_core_sysdep_connect_candidate_t *candidates, uint32_t count,
+        _core_sysdep_dns_addrs_t *addrs, int family, uint16_t port)
+{
+    uint32_t i = 0, idx = 0, base = count * 2, family_seen[2] = {0, 0};
+    _core_sysdep_connect_candidate_t *candidate = NULL;
+
+    for (i = 0; i < addrs->count && count < CORE_SYSDEP_CONNECT_CANDIDATES_MAX; i++) {
+        if (family != AF_UNSPEC && addrs->addr[i].ss_family != family) {
+            continue;
+        }
+        candidate = &candidates[count];
+        memset(candidate, 0, sizeof(_core_sysdep_connect_candidate_t));
+        memcpy(&candidate->addr, &addrs->addr[i], addrs->addrlen[i]);
+        candidate->addrlen = addrs->addrlen[i];
+        candidate->family = addrs->addr[i].ss_family;
+        candidate->fd = -1;
+        if (candidate->family == AF_INET6) {
+            ((struct sockaddr_in6 *)&candidate->addr)->sin6_port = htons(port);
+        } else {
+            ((struct sockaddr_in *)&candidate->addr)->sin_port = htons(port);
+        }
+        for (idx = 0; idx < count; idx++) {
+            if (_core_sysdep_addr_equal(&candidates[idx].addr, candidates[idx].addrlen,
+                                        &candidate->addr, candidate->addrlen)) {
+                break;
+            }
+        }
+        if (idx < count) {
+            continue;
+        }
+        /* 同一批解析结果中IPv6/IPv4交替排列 */
+        idx = (candidate->family == AF_INET6) ? 0 : 1;
+        candidate->order = base + family_seen[idx] * 2 + idx;
+        family_seen[idx]++;
+        count++;
+    }
+
+    return count;
+}
+
+/* 在connect之前设置调优参数, 设置失败只打印日志, 不影响建连 */
+static void _core_sysdep_sockopt_apply(int fd, int family, int socktype, const aiot_sysdep_network_sockopt_t *sockopt)
+{
+    if (sockopt->send_buffer_size > 0) {
+        _core_sysdep_sockopt_set(fd, SOL_SOCKET, SO_SNDBUF, "SO_SNDBUF", (int)sockopt->send_buffer_size);
+    }
+    if (sockopt->recv_buffer_size > 0) {
+        _core_sysdep_sockopt_set(fd, SOL_SOCKET, SO_RCVBUF, "SO_RCVBUF", (int)sockopt->recv_buffer_size);
+    }
+    if (sockopt->ip_tos > 0) {
+        if (family == AF_INET6) {
+            _core_sysdep_sockopt_set(fd, IPPROTO_IPV6, IPV6_TCLASS, "IPV6_TCLASS", sockopt->ip_tos);
+        } else {
+            _core_sysdep_sockopt_set(fd, IPPROTO_IP, IP_TOS, "IP_TOS", sockopt->ip_tos);
+        }
+    }
+
+    if (socktype != SOCK_STREAM) {
+        return;
+    }
+    if (sockopt->tcp_nodelay) {
+        _core_sysdep_sockopt_set(fd, IPPROTO_TCP, TCP_NODELAY, "TCP_NODELAY", 1);
+    }
+    if (sockopt->keepalive_enabled) {
+        _core_sysdep_sockopt_set(fd, SOL_SOCKET, SO_KEEPALIVE, "SO_KEEPALIVE", 1);
+#if defined(TCP_KEEPIDLE)
+        if (sockopt->keepalive_idle_s > 0) {
+            _core_sysdep_sockopt_set(fd, IPPROTO_TCP, TCP_KEEPIDLE, "TCP_KEEPIDLE", (int)sockopt->keepalive_idle_s);
+        }
+#endif
+#if defined(TCP_KEEPINTVL)
+        if (sockopt->keepalive_interval_s > 0) {
+            _core_sysdep_sockopt_set(fd, IPPROTO_TCP, TCP_KEEPINTVL, "TCP_KEEPINTVL", (int)sockopt->keepalive_interval_s);
+        }
+#endif
+#if defined(TCP_KEEPCNT)
+        if (sockopt->keepalive_count > 0) {
+            _core_sysdep_sockopt_set(fd, IPPROTO_TCP, TCP_KEEPCNT, "TCP_KEEPCNT", (int)sockopt->keepalive_count);
+        }
+#endif
+    }
+#if defined(TCP_USER_TIMEOUT)
+    if (sockopt->tcp_user_timeout_ms > 0) {
+        _core_sysdep_sockopt_set(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, "TCP_USER_TIMEOUT", (int)sockopt->tcp_user_timeout_ms);
+    }
+#endif
+}
+
+static int32_t _core_sysdep_candidate_start(_core_sysdep_connect_candidate_t *candidate, int socktype, int protocol,
+        const aiot_sysdep_network_sockopt_t *sockopt)
+{
+    int fd = 0, flags = 0;
+
+    fd = socket(candidate->family, socktype, protocol);
+    if (fd < 0) {
+        _core_printf("create socket error\n");
+        return STATE_PORT_NETWORK_SOCKET_CREATE_FAILED;
+    }
+    _core_sysdep_sockopt_apply(fd, candidate->family, socktype, sockopt);
+
+    candidate->start_ms = _core_sysdep_monotonic_ms();
+    flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        /* block connect */
+        if (connect(fd, (struct sockaddr *)&candidate->addr, candidate->addrlen) == 0) {
+            candidate->fd = fd;
+            return STATE_SUCCESS;
+        }
+        close(fd);
+        return STATE_PORT_NETWORK_CONNECT_FAILED;
+    }
+
+    candidate->fd = fd;
+    if (connect(fd, (struct sockaddr *)&candidate->addr, candidate->addrlen) == 0) {
+        return STATE_SUCCESS;
+    } else if (errno == EINPROGRESS) {
+        return STATE_PORT_NETWORK_CONNECT_TIMEOUT;
+    }
+
+    _core_printf("connect error, errno: %d\n", errno);
+    close(fd);
+    candidate->fd = -1;
+    return STATE_PORT_NETWORK_CONNECT_FAILED;
+}
+
+static int32_t _core_sysdep_network_connect(char *host, char *backup_ip, uint16_t port, int family, int socktype,
+        int protocol, uint32_t timeout_ms, const aiot_sysdep_network_sockopt_t *sockopt, int *fd_out)
 {
     int32_t res = STATE_SUCCESS;
+    int sock_err = 0;
+    _core_sysdep_dns_addrs_t addrs;
+    _core_sysdep_connect_candidate_t candidates[CORE_SYSDEP_CONNECT_CANDIDATES_MAX];
+    struct pollfd pfds[CORE_SYSDEP_CONNECT_CANDIDATES_MAX];
+    uint32_t pfd_idx[CORE_SYSDEP_CONNECT_CANDIDATES_MAX];
+    uint32_t count = 0, started = 0, inflight = 0, idx = 0, npfd = 0;
+    int32_t winner = -1;
+    uint64_t time_start = 0, time_now = 0, next_start = 0, wait_until = 0;
+    struct sockaddr_in loc_addr;
+    socklen_t len = sizeof(loc_addr);
+    socklen_t err_len = sizeof(sock_err);
 
-    _core_printf("establish tcp connection with server(host='%s', port=[%u])\n", network_handle->host, network_handle->port);
-    res = _core_sysdep_network_connect(network_handle->host, network_handle->port,
-                                       AF_UNSPEC, SOCK_STREAM, IPPROTO_TCP, network_handle->connect_timeout_ms, &network_handle->fd);
-    if (res == STATE_PORT_NETWORK_DNS_FAILED && strlen(network_handle->backup_ip) > 0) {
-         _core_printf("using backup ip: %s\n", network_handle->backup_ip);
-        res = _core_sysdep_network_connect(network_handle->backup_ip, network_handle->port,
-                                           AF_UNSPEC, SOCK_STREAM, IPPROTO_TCP, network_handle->connect_timeout_ms, &network_handle->fd);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (_core_sysdep_dns_lookup(host, &addrs) == STATE_SUCCESS) {
+        count = _core_sysdep_candidates_append(candidates, count, &addrs, family, port);
+    }
+    if (backup_ip != NULL && strlen(backup_ip) > 0) {
+        if (_core_sysdep_dns_resolve(backup_ip, AI_NUMERICHOST, &addrs, NULL) == STATE_SUCCESS) {
+            if (count == 0) {
+                _core_printf("using backup ip: %s\n", backup_ip);
+            }
+            count = _core_sysdep_candidates_append(candidates, count, &addrs, family, port);
+        }
+    }
+    if (count == 0) {
+        _core_printf("fail to establish tcp\n");
+        return STATE_PORT_NETWORK_DNS_FAILED;
     }
 
-    return res;
+    _core_sysdep_candidates_sort(candidates, count);
+
+    res = STATE_PORT_NETWORK_CONNECT_FAILED;
+    time_start = _core_sysdep_monotonic_ms();
+    next_start = time_start;
+    while (winner < 0) {
+        time_now = _core_sysdep_monotonic_ms();
+        if (time_now - time_start >= timeout_ms) {
+            res = STATE_PORT_NETWORK_CONNECT_TIMEOUT;
+            break;
+        }
+
+        /* 到达发起间隔或当前没有进行中的连接时, 发起下一个候选地址 */
+        if (started < count && (inflight == 0 || time_now >= next_start)) {
+            res = _core_sysdep_candidate_start(&candidates[started], socktype, protocol, sockopt);
+            if (res == STATE_SUCCESS) {
+                winner = started;
+            } else if (res == STATE_PORT_NETWORK_CONNECT_TIMEOUT) {
+                inflight++;
+                next_start = time_now + CORE_SYSDEP_CONNECT_ATTEMPT_DELAY_MS;
+            } else {
+                _core_sysdep_addr_stats_update(&candidates[started].addr, candidates[started].addrlen, 0, 0);
+                /* 立即失败(如ECONNREFUSED/ENETUNREACH)时不等待发起间隔, 直接发起下一个候选地址 */
+                next_start = time_now;
+            }
+            started++;
+            continue;
+        }
+
+        if (inflight == 0) {
+            break;
+        }
+
+        npfd = 0;
+        for (idx = 0; idx < started; idx++) {
+            if (candidates[idx].fd >= 0) {
+                pfds[npfd].fd = candidates[idx].fd;
+                pfds[npfd].events = POLLOUT;
+                pfds[npfd].revents = 0;
+                pfd_idx[npfd++] = idx;
+            }
+        }
+
+        wait_until = time_start + timeout_ms;
+        if (started < count && next_start < wait_until) {
+            wait_until = next_start;
+        }
+        if (poll(pfds, npfd, (int)(wait_until > time_now ? wait_until - time_now : 0)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            res = STATE_PORT_NETWORK_SELECT_FAILED;
+            break;
+        }
+
+        for (idx = 0; idx < npfd && winner < 0; idx++) {
+            _core_sysdep_connect_candidate_t *candidate = &candidates[pfd_idx[idx]];
+            if (pfds[idx].revents == 0) {
+                continue;
+            }
+            sock_err = 0;
+            err_len = sizeof(sock_err);
+            if (getsockopt(candidate->fd, SOL_SOCKET, SO_ERROR, &sock_err, &err_len) == 0 && sock_err == 0) {
+                winner = pfd_idx[idx];
+                inflight--;
+            } else {
+                _core_printf("connect error, errno: %d\n", sock_err);
+                close(candidate->fd);
+                candidate->fd = -1;
+                inflight--;
+                _core_sysdep_addr_stats_update(&candidate->addr, candidate->addrlen, 0, 0);
+                /* 失败后立即发起下一个候选地址 */
+                next_start = time_now;
+                res = STATE_PORT_NETWORK_CONNECT_FAILED;
+            }
+        }
+    }
+
+    /* 关闭未胜出的连接 */
+    for (idx = 0; idx < started; idx++) {
+        if ((int32_t)idx != winner && candidates[idx].fd >= 0) {
+            close(candidates[idx].fd);
+            candidates[idx].fd = -1;
+        }
+    }
+
+    if (winner < 0) {
+        _core_printf("fail to establish tcp\n");
+        return res;
+    }
+
+    *fd_out = candidates[winner].fd;
+    _core_sysdep_addr_stats_update(&candidates[winner].addr, candidates[winner].addrlen, 1,
+                                   (uint32_t)(_core_sysdep_monotonic_ms() - candidates[winner].start_ms));
+
+    _core_printf("success to establish tcp, fd=%d\n", *fd_out);
+    memset(&loc_addr, 0, len);
+    /* 获取本地的port并打印 */
+    if (0 == getsockname(*fd_out, (struct sockaddr *)&loc_addr, &len)
+        && loc_addr.sin_family == AF_INET) {
+        _core_printf("local port: %u\n", ntohs(loc_addr.sin_port));
+    }
+
+    return STATE_SUCCESS;
+}
+
+static int32_t _core_sysdep_network_tcp_establish(core_network_handle_t *network_handle)
+{
+    aiot_sysdep_network_sockopt_t sockopt;
+
+    /*
+     *  TLS握手的一轮消息由多次小的写入组成, 开启Nagle算法时后面的写入要等前一次写入被确认,
+     *  而服务端延迟确认(delayed ACK), 每轮握手因此多等约40ms. 握手期间总是关闭Nagle算法
+     */
+    memcpy(&sockopt, &network_handle->sockopt, sizeof(aiot_sysdep_network_sockopt_t));
+    if (network_handle->tls) {
+        sockopt.tcp_nodelay = 1;
+    }
+    _core_printf("establish tcp connection with server(host='%s', port=[%u])\n", network_handle->host, network_handle->port);
+    return _core_sysdep_network_connect(network_handle->host, network_handle->backup_ip, network_handle->port,
+                                        AF_UNSPEC, SOCK_STREAM, IPPROTO_TCP, network_handle->connect_timeout_ms, &sockopt,
+                                        &network_handle->fd);
 }
 
 static int32_t _core_sysdep_network_udp_server_establish(core_network_handle_t *network_handle)
@@ -328,6 +1113,7 @@ static int32_t _core_sysdep_network_udp_server_establish(core_network_handle_t *
         close(sockfd);
         return STATE_PORT_NETWORK_SOCKET_CONFIG_FAILED;
     }
+    _core_sysdep_sockopt_apply(sockfd, AF_INET, SOCK_DGRAM, &network_handle->sockopt);
 
     memset(&servaddr, 0, sizeof(struct sockaddr_in));
     servaddr.sin_addr.s_addr = htonl(INADDR_ANY);
@@ -348,6 +1134,7 @@ static int32_t _core_sysdep_network_udp_server_establish(core_network_handle_t *
 
 static int32_t core_sysdep_network_establish(void *handle)
 {
+    int32_t res = STATE_SUCCESS;
     core_network_handle_t *network_handle = (core_network_handle_t *)handle;
     if (handle == NULL) {
         return STATE_PORT_INPUT_NULL_POINTER;
@@ -357,15 +1144,24 @@ static int32_t core_sysdep_network_establish(void *handle)
         if (network_handle->host == NULL) {
             return STATE_PORT_MISSING_HOST;
         }
-        return _core_sysdep_network_tcp_establish(network_handle);
+        res = _core_sysdep_network_tcp_establish(network_handle);
+#if defined(CORE_SYSDEP_NETWORK_IO_BACKEND)
+        _core_sysdep_network_io_init(&network_handle->network_io, network_handle->fd);
+#endif
+        return res;
     } else if (network_handle->socket_type == CORE_SYSDEP_SOCKET_TCP_SERVER) {
         return STATE_PORT_TCP_SERVER_NOT_IMPLEMENT;
     } else if (network_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_CLIENT) {
         if (network_handle->host == NULL) {
             return STATE_PORT_MISSING_HOST;
         }
-        return  _core_sysdep_network_connect(network_handle->host, network_handle->port,
-                                             AF_UNSPEC, SOCK_DGRAM, IPPROTO_UDP, network_handle->connect_timeout_ms, &network_handle->fd);
+        res = _core_sysdep_network_connect(network_handle->host, NULL, network_handle->port,
+                                           AF_UNSPEC, SOCK_DGRAM, IPPROTO_UDP, network_handle->connect_timeout_ms, &network_handle->sockopt,
+                                           &network_handle->fd);
+#if defined(CORE_SYSDEP_NETWORK_IO_BACKEND)
+        _core_sysdep_network_io_init(&network_handle->network_io, network_handle->fd);
+#endif
+        return res;
     } else if (network_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_SERVER) {
         return _core_sysdep_network_udp_server_establish(network_handle);
     }
@@ -375,27 +1171,32 @@ static int32_t core_sysdep_network_establish(void *handle)
 }
 
 
+/* once为1时收到数据即返回, 否则读满len字节或等到超时; UDP每次只收一个报文 */
 static int32_t _core_sysdep_network_recv(core_network_handle_t *network_handle, uint8_t *buffer, uint32_t len,
-        uint32_t timeout_ms)
+        uint32_t timeout_ms, uint8_t once)
 {
+    if (network_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_CLIENT) {
+        once = 1;
+    }
+#if defined(CORE_SYSDEP_NETWORK_IO_BACKEND)
+    return _core_sysdep_network_io_recv(&network_handle->network_io, buffer, len, timeout_ms, once);
+#else
     int res = 0;
     int32_t recv_bytes = 0;
     ssize_t recv_res = 0;
     uint64_t timestart_ms = 0, timenow_ms = 0, timeselect_ms = 0;
     fd_set recv_sets;
-    struct timeval timestart, timenow, timeselect;
+    struct timeval timeselect;
 
     FD_ZERO(&recv_sets);
     FD_SET(network_handle->fd, &recv_sets);
 
     /* Start Time */
-    gettimeofday(&timestart, NULL);
-    timestart_ms = timestart.tv_sec * 1000 + timestart.tv_usec / 1000;
+    timestart_ms = _core_sysdep_monotonic_ms();
     timenow_ms = timestart_ms;
 
     do {
-        gettimeofday(&timenow, NULL);
-        timenow_ms = timenow.tv_sec * 1000 + timenow.tv_usec / 1000;
+        timenow_ms = _core_sysdep_monotonic_ms();
 
         if (timenow_ms - timestart_ms >= timenow_ms ||
             timeout_ms - (timenow_ms - timestart_ms) > timeout_ms) {
@@ -415,20 +1216,20 @@ static int32_t _core_sysdep_network_recv(core_network_handle_t *network_handle,
             return STATE_PORT_NETWORK_SELECT_FAILED;
         } else {
             if (FD_ISSET(network_handle->fd, &recv_sets)) {
-                recv_res = recv(network_handle->fd, buffer + recv_bytes, len - recv_bytes, 0);
+                recv_res = recv(network_handle->fd, buffer + recv_bytes, len - recv_bytes, MSG_DONTWAIT);
                 if (recv_res == 0) {
                      _core_printf("_core_sysdep_network_recv, nwk connection closed\n");
                     return STATE_PORT_NETWORK_RECV_CONNECTION_CLOSED;
                 } else if (recv_res < 0) {
-                     _core_printf("_core_sysdep_network_recv, errno: %d, %s\n", errno, strerror(errno));
-                    if (errno == EINTR) {
+                    if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
                         continue;
                     }
+                     _core_printf("_core_sysdep_network_recv, errno: %d, %s\n", errno, strerror(errno));
                     return STATE_PORT_NETWORK_RECV_FAILED;
                 } else {
                     recv_bytes += recv_res;
                     /*  _core_printf("recv_bytes: %d, len: %d\n",recv_bytes,len); */
-                    if (network_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_CLIENT || recv_bytes == len) {
+                    if (once == 1 || recv_bytes == len) {
                         break;
                     }
                 }
@@ -438,6 +1239,7 @@ static int32_t _core_sysdep_network_recv(core_network_handle_t *network_handle,
 
     /*  _core_printf("%s: recv over\n",__FUNCTION__); */
     return recv_bytes;
+#endif
 }
 
 static int32_t _core_sysdep_network_udp_server_recv(core_network_handle_t *network_handle, uint8_t *buffer,
@@ -467,7 +1269,7 @@ static int32_t _core_sysdep_network_udp_server_recv(core_network_handle_t *netwo
         if (NULL != addr) {
             addr->port = ntohs(cliaddr.sin_port);
             inet_addr = inet_ntoa(cliaddr.sin_addr);
-            strncpy((char *)addr->addr, inet_addr, strlen(inet_addr));
+            memcpy(addr->addr, inet_addr, strlen(inet_addr) + 1);
         }
 
         return res;
@@ -486,16 +1288,16 @@ static int32_t core_sysdep_network_recv(void *handle, uint8_t *buffer, uint32_t
         return STATE_PORT_INPUT_NULL_POINTER;
     }
 
-    if (len == 0 || timeout_ms == 0) {
+    if (len == 0) {
         return STATE_PORT_INPUT_OUT_RANGE;
     }
 
     if (network_handle->socket_type == CORE_SYSDEP_SOCKET_TCP_CLIENT) {
-        return _core_sysdep_network_recv(network_handle, buffer, len, timeout_ms);
+        return _core_sysdep_network_recv(network_handle, buffer, len, timeout_ms, 0);
     } else if (network_handle->socket_type == CORE_SYSDEP_SOCKET_TCP_SERVER) {
         return STATE_PORT_TCP_SERVER_NOT_IMPLEMENT;
     } else if (network_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_CLIENT) {
-        return _core_sysdep_network_recv(network_handle, buffer, len, timeout_ms);
+        return _core_sysdep_network_recv(network_handle, buffer, len, timeout_ms, 0);
     } else if (network_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_SERVER) {
         return _core_sysdep_network_udp_server_recv(network_handle, buffer, len, timeout_ms, addr);
     }
@@ -508,24 +1310,25 @@ static int32_t core_sysdep_network_recv(void *handle, uint8_t *buffer, uint32_t
 int32_t _core_sysdep_network_send(core_network_handle_t *network_handle, uint8_t *buffer, uint32_t len,
                                   uint32_t timeout_ms)
 {
+#if defined(CORE_SYSDEP_NETWORK_IO_BACKEND)
+    return _core_sysdep_network_io_send(&network_handle->network_io, buffer, len, timeout_ms);
+#else
     int res = 0;
     int32_t send_bytes = 0;
     ssize_t send_res = 0;
     uint64_t timestart_ms = 0, timenow_ms = 0, timeselect_ms = 0;
     fd_set send_sets;
-    struct timeval timestart, timenow, timeselect;
+    struct timeval timeselect;
 
     FD_ZERO(&send_sets);
     FD_SET(network_handle->fd, &send_sets);
 
     /* Start Time */
-    gettimeofday(&timestart, NULL);
-    timestart_ms = timestart.tv_sec * 1000 + timestart.tv_usec / 1000;
+    timestart_ms = _core_sysdep_monotonic_ms();
     timenow_ms = timestart_ms;
 
     do {
-        gettimeofday(&timenow, NULL);
-        timenow_ms = timenow.tv_sec * 1000 + timenow.tv_usec / 1000;
+        timenow_ms = _core_sysdep_monotonic_ms();
 
         if (timenow_ms - timestart_ms >= timenow_ms ||
             timeout_ms - (timenow_ms - timestart_ms) > timeout_ms) {
@@ -545,15 +1348,15 @@ int32_t _core_sysdep_network_send(core_network_handle_t *network_handle, uint8_t
             return STATE_PORT_NETWORK_SELECT_FAILED;
         } else {
             if (FD_ISSET(network_handle->fd, &send_sets)) {
-                send_res = send(network_handle->fd, buffer + send_bytes, len - send_bytes, 0);
+                send_res = send(network_handle->fd, buffer + send_bytes, len - send_bytes, MSG_DONTWAIT);
                 if (send_res == 0) {
                      _core_printf("_core_sysdep_network_send, nwk connection closed\n");
                     return STATE_PORT_NETWORK_SEND_CONNECTION_CLOSED;
                 } else if (send_res < 0) {
-                     _core_printf("_core_sysdep_network_send, errno: %d, %s\n", errno, strerror(errno));
-                    if (errno == EINTR) {
+                    if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
                         continue;
                     }
+                     _core_printf("_core_sysdep_network_send, errno: %d, %s\n", errno, strerror(errno));
                     return STATE_PORT_NETWORK_SEND_FAILED;
                 } else {
                     send_bytes += send_res;
@@ -566,6 +1369,7 @@ int32_t _core_sysdep_network_send(core_network_handle_t *network_handle, uint8_t
     } while (((timenow_ms - timestart_ms) < timeout_ms) && (send_bytes < len));
 
     return send_bytes;
+#endif
 }
 
 
@@ -621,7 +1425,7 @@ static int32_t core_sysdep_network_send(void *handle, uint8_t *buffer, uint32_t
          _core_printf("invalid parameter\n");
         return STATE_PORT_INPUT_NULL_POINTER;
     }
-    if (len == 0 || timeout_ms == 0) {
+    if (len == 0) {
         return STATE_PORT_INPUT_OUT_RANGE;
     }
 
@@ -641,6 +1445,9 @@ static int32_t core_sysdep_network_send(void *handle, uint8_t *buffer, uint32_t
 
 static void _core_sysdep_network_tcp_disconnect(core_network_handle_t *network_handle)
 {
+#if defined(CORE_SYSDEP_NETWORK_IO_BACKEND)
+    _core_sysdep_network_io_deinit(&network_handle->network_io);
+#endif
     /* 仅仅对正常的fd 进行close操作 */
     if (network_handle->fd >= 0) {
         shutdown(network_handle->fd, 2);
@@ -665,50 +1472,226 @@ static int32_t core_sysdep_network_deinit(void **handle)
     }
 
     if (network_handle->host != NULL) {
-        free(network_handle->host);
+        core_sysdep_free(network_handle->host);
         network_handle->host = NULL;
     }
 
-    free(network_handle);
+    core_sysdep_free(network_handle);
     *handle = NULL;
 
     return 0;
 }
 
-void core_sysdep_rand(uint8_t *output, uint32_t output_len)
+static int32_t core_sysdep_network_recv_some(void *handle, uint8_t *buffer, uint32_t len, uint32_t timeout_ms,
+        core_sysdep_addr_t *addr)
 {
-    uint32_t idx = 0, bytes = 0, rand_num = 0;
-    struct timeval time;
+    core_network_handle_t *network_handle = (core_network_handle_t *)handle;
 
-    memset(&time, 0, sizeof(struct timeval));
-    gettimeofday(&time, NULL);
+    if (handle == NULL || buffer == NULL) {
+        return STATE_PORT_INPUT_NULL_POINTER;
+    }
 
-    srand((unsigned int)(time.tv_sec * 1000 + time.tv_usec / 1000) + rand());
+    if (len == 0) {
+        return STATE_PORT_INPUT_OUT_RANGE;
+    }
 
-    for (idx = 0; idx < output_len;) {
-        if (output_len - idx < 4) {
-            bytes = output_len - idx;
-        } else {
-            bytes = 4;
+    if (network_handle->socket_type == CORE_SYSDEP_SOCKET_TCP_CLIENT ||
+        network_handle->socket_type == CORE_SYSDEP_SOCKET_UDP_CLIENT) {
+        return _core_sysdep_network_recv(network_handle, buffer, len, timeout_ms, 1);
+    }
+
+    return core_sysdep_network_recv(handle, buffer, len, timeout_ms, addr);
+}
+
+static int32_t core_sysdep_network_get_fd(void *handle)
+{
+    core_network_handle_t *network_handle = (core_network_handle_t *)handle;
+
+    if (handle == NULL) {
+        return STATE_PORT_INPUT_NULL_POINTER;
+    }
+
+    return network_handle->fd;
+}
+
+/*
+ * 随机数: 每个线程一份ChaCha20生成器, 调用时无需加锁也不改动libc的全局状态. 生成器一次产生一批密钥流,
+ * 开头32字节立即作为下一批的密钥, 其余字节依次输出, 已输出的字节从缓冲区中清除, 线程状态泄露后无法反推之前的输出.
+ * 种子取自getrandom(不可用时读/dev/urandom), 每输出CORE_SYSDEP_RAND_RESEED_BYTES字节或进程fork之后重新混入种子
+ */
+static void _core_sysdep_chacha20_block(const uint32_t key[8], uint32_t counter, uint8_t output[64])
+{
+    uint32_t x[16], state[16];
+    uint32_t idx = 0;
+
+    state[0] = 0x61707865;
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+    memcpy(&state[4], key, 32);
+    state[12] = counter;
+    state[13] = 0;
+    state[14] = 0;
+    state[15] = 0;
+    memcpy(x, state, sizeof(x));
+
+#define CORE_SYSDEP_ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define CORE_SYSDEP_QUARTERROUND(a, b, c, d) \
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = CORE_SYSDEP_ROTL32(x[d], 16); \
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = CORE_SYSDEP_ROTL32(x[b], 12); \
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = CORE_SYSDEP_ROTL32(x[d], 8);  \
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = CORE_SYSDEP_ROTL32(x[b], 7);
+    for (idx = 0; idx < 10; idx++) {
+        CORE_SYSDEP_QUARTERROUND(0, 4, 8, 12)
+        CORE_SYSDEP_QUARTERROUND(1, 5, 9, 13)
+        CORE_SYSDEP_QUARTERROUND(2, 6, 10, 14)
+        CORE_SYSDEP_QUARTERROUND(3, 7, 11, 15)
+        CORE_SYSDEP_QUARTERROUND(0, 5, 10, 15)
+        CORE_SYSDEP_QUARTERROUND(1, 6, 11, 12)
+        CORE_SYSDEP_QUARTERROUND(2, 7, 8, 13)
+        CORE_SYSDEP_QUARTERROUND(3, 4, 9, 14)
+    }
+#undef CORE_SYSDEP_QUARTERROUND
+#undef CORE_SYSDEP_ROTL32
+
+    for (idx = 0; idx < 16; idx++) {
+        x[idx] += state[idx];
+        output[idx * 4] = (uint8_t)x[idx];
+        output[idx * 4 + 1] = (uint8_t)(x[idx] >> 8);
+        output[idx * 4 + 2] = (uint8_t)(x[idx] >> 16);
+        output[idx * 4 + 3] = (uint8_t)(x[idx] >> 24);
+    }
+}
+
+static int32_t _core_sysdep_rand_entropy(uint8_t *output, uint32_t output_len)
+{
+    uint32_t offset = 0;
+    int fd = -1;
+    ssize_t res = 0;
+
+#if defined(CORE_SYSDEP_RAND_GETRANDOM)
+    while (offset < output_len) {
+        res = getrandom(output + offset, output_len - offset, 0);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
         }
-        rand_num = rand();
-        while (bytes-- > 0) {
-            output[idx++] = (uint8_t)(rand_num >> bytes * 8);
+        offset += res;
+    }
+    if (offset == output_len) {
+        return 0;
+    }
+    offset = 0;
+#endif
+
+    fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    while (offset < output_len) {
+        res = read(fd, output + offset, output_len - offset);
+        if (res <= 0) {
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
         }
+        offset += res;
     }
+    close(fd);
+
+    return (offset == output_len) ? 0 : -1;
+}
+
+static void _core_sysdep_rand_fork_child(void)
+{
+    g_core_sysdep_rand_fork_gen++;
+}
+
+static void _core_sysdep_rand_atfork_init(void)
+{
+    pthread_atfork(NULL, NULL, _core_sysdep_rand_fork_child);
+}
+
+static void _core_sysdep_rand_refill(core_sysdep_rand_ctx_t *ctx)
+{
+    uint32_t seed[8];
+    uint32_t idx = 0;
+
+    if (ctx->seeded == 0 || ctx->fork_gen != g_core_sysdep_rand_fork_gen ||
+        ctx->output_bytes >= CORE_SYSDEP_RAND_RESEED_BYTES) {
+        pthread_once(&g_core_sysdep_rand_once, _core_sysdep_rand_atfork_init);
+        if (_core_sysdep_rand_entropy((uint8_t *)seed, sizeof(seed)) != 0) {
+            /* 取不到系统熵源时退化为时间与地址, 仍然保证同一进程内各线程及fork前后的输出不同 */
+            struct timespec ts;
+            memset(&ts, 0, sizeof(ts));
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            seed[0] = (uint32_t)ts.tv_nsec;
+            seed[1] = (uint32_t)ts.tv_sec;
+            seed[2] = (uint32_t)getpid();
+            seed[3] = (uint32_t)(uintptr_t)ctx;
+            seed[4] = (uint32_t)((uint64_t)(uintptr_t)ctx >> 32);
+            seed[5] = (uint32_t)time(NULL);
+            seed[6] = g_core_sysdep_rand_fork_gen;
+            seed[7] = (uint32_t)ctx->output_bytes;
+        }
+        for (idx = 0; idx < 8; idx++) {
+            ctx->key[idx] ^= seed[idx];
+        }
+        memset(seed, 0, sizeof(seed));
+        ctx->seeded = 1;
+        ctx->fork_gen = g_core_sysdep_rand_fork_gen;
+        ctx->output_bytes = 0;
+    }
+
+    for (idx = 0; idx < CORE_SYSDEP_RAND_BUFFER_LEN / 64; idx++) {
+        _core_sysdep_chacha20_block(ctx->key, idx, ctx->buffer + idx * 64);
+    }
+    memcpy(ctx->key, ctx->buffer, sizeof(ctx->key));
+    memset(ctx->buffer, 0, sizeof(ctx->key));
+    ctx->buffer_left = CORE_SYSDEP_RAND_BUFFER_LEN - sizeof(ctx->key);
+}
+
+void core_sysdep_rand(uint8_t *output, uint32_t output_len)
+{
+    core_sysdep_rand_ctx_t *ctx = &g_core_sysdep_rand_ctx;
+    uint32_t bytes = 0;
+    uint8_t *keystream = NULL;
+
+#if defined(CORE_SYSDEP_RAND_SHARED)
+    pthread_mutex_lock(&g_core_sysdep_rand_mutex);
+#endif
+    while (output_len > 0) {
+        if (ctx->buffer_left == 0 || ctx->fork_gen != g_core_sysdep_rand_fork_gen) {
+            _core_sysdep_rand_refill(ctx);
+        }
+        bytes = (output_len < ctx->buffer_left) ? output_len : ctx->buffer_left;
+        keystream = ctx->buffer + CORE_SYSDEP_RAND_BUFFER_LEN - ctx->buffer_left;
+        memcpy(output, keystream, bytes);
+        memset(keystream, 0, bytes);
+        ctx->buffer_left -= bytes;
+        ctx->output_bytes += bytes;
+        output += bytes;
+        output_len -= bytes;
+    }
+#if defined(CORE_SYSDEP_RAND_SHARED)
+    pthread_mutex_unlock(&g_core_sysdep_rand_mutex);
+#endif
 }
 
 void *core_sysdep_mutex_init(void)
 {
     int res = 0;
-    pthread_mutex_t *mutex = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_t *mutex = (pthread_mutex_t *)core_sysdep_malloc(sizeof(pthread_mutex_t), CORE_SYSDEP_MODULE_NAME);
     if (NULL == mutex) {
         return NULL;
     }
 
     if (0 != (res = pthread_mutex_init(mutex, NULL))) {
          _core_printf("create mutex failed \n");
-        free(mutex);
+        core_sysdep_free(mutex);
         return NULL;
     }
     /*  _core_printf("init mutex: %p\n",mutex); */
@@ -744,11 +1727,135 @@ void core_sysdep_mutex_deinit(void **mutex)
         if (0 != (err_num = pthread_mutex_destroy(*(pthread_mutex_t **)mutex))) {
              _core_printf("destroy mutex failed\n");
         }
-        free(*(pthread_mutex_t **)mutex);
+        core_sysdep_free(*(pthread_mutex_t **)mutex);
         *mutex = NULL;
     }
 }
 
+void *core_sysdep_rwlock_init(void)
+{
+    int res = 0;
+    pthread_rwlock_t *rwlock = (pthread_rwlock_t *)core_sysdep_malloc(sizeof(pthread_rwlock_t), CORE_SYSDEP_MODULE_NAME);
+    if (NULL == rwlock) {
+        return NULL;
+    }
+
+    if (0 != (res = pthread_rwlock_init(rwlock, NULL))) {
+         _core_printf("create rwlock failed \n");
+        core_sysdep_free(rwlock);
+        return NULL;
+    }
+
+    return (void *)rwlock;
+}
+
+void core_sysdep_rwlock_rdlock(void *rwlock)
+{
+    int res = 0;
+    if (rwlock != NULL) {
+        if (0 != (res = pthread_rwlock_rdlock((pthread_rwlock_t *)rwlock))) {
+             _core_printf("rdlock rwlock failed: - '%s' (%d)\n", strerror(res), res);
+        }
+    }
+}
+
+void core_sysdep_rwlock_wrlock(void *rwlock)
+{
+    int res = 0;
+    if (rwlock != NULL) {
+        if (0 != (res = pthread_rwlock_wrlock((pthread_rwlock_t *)rwlock))) {
+             _core_printf("wrlock rwlock failed: - '%s' (%d)\n", strerror(res), res);
+        }
+    }
+}
+
+void core_sysdep_rwlock_unlock(void *rwlock)
+{
+    int res = 0;
+    if (rwlock != NULL) {
+        if (0 != (res = pthread_rwlock_unlock((pthread_rwlock_t *)rwlock))) {
+             _core_printf("unlock rwlock failed - '%s' (%d)\n", strerror(res), res);
+        }
+    }
+}
+
+void core_sysdep_rwlock_deinit(void **rwlock)
+{
+    if (rwlock != NULL && *rwlock != NULL) {
+        if (0 != pthread_rwlock_destroy(*(pthread_rwlock_t **)rwlock)) {
+             _core_printf("destroy rwlock failed\n");
+        }
+        core_sysdep_free(*rwlock);
+        *rwlock = NULL;
+    }
+}
+
+/* 条件变量使用CLOCK_MONOTONIC计算超时, 不受系统时间调整影响 */
+void *core_sysdep_cond_init(void)
+{
+    pthread_condattr_t attr;
+    pthread_cond_t *cond = (pthread_cond_t *)core_sysdep_malloc(sizeof(pthread_cond_t), CORE_SYSDEP_MODULE_NAME);
+    if (NULL == cond) {
+        return NULL;
+    }
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (0 != pthread_cond_init(cond, &attr)) {
+         _core_printf("create cond failed \n");
+        pthread_condattr_destroy(&attr);
+        core_sysdep_free(cond);
+        return NULL;
+    }
+    pthread_condattr_destroy(&attr);
+
+    return (void *)cond;
+}
+
+void core_sysdep_cond_wait(void *cond, void *mutex, uint32_t timeout_ms)
+{
+    struct timespec ts;
+
+    if (cond == NULL || mutex == NULL) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait((pthread_cond_t *)cond, (pthread_mutex_t *)mutex, &ts);
+}
+
+void core_sysdep_cond_broadcast(void *cond)
+{
+    if (cond != NULL) {
+        pthread_cond_broadcast((pthread_cond_t *)cond);
+    }
+}
+
+void core_sysdep_cond_deinit(void **cond)
+{
+    if (cond != NULL && *cond != NULL) {
+        pthread_cond_destroy(*(pthread_cond_t **)cond);
+        core_sysdep_free(*cond);
+        *cond = NULL;
+    }
+}
+
+int32_t core_sysdep_atomic_add(int32_t *value, int32_t delta)
+{
+    return __atomic_add_fetch(value, delta, __ATOMIC_SEQ_CST);
+}
+
+uint8_t core_sysdep_atomic_cas(int32_t *value, int32_t expected, int32_t desired)
+{
+    return __atomic_compare_exchange_n(value, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ? 1 : 0;
+}
+
 aiot_sysdep_portfile_t g_aiot_sysdep_portfile = {
     .core_sysdep_malloc = core_sysdep_malloc,
     .core_sysdep_free = core_sysdep_free,
@@ -765,5 +1872,22 @@ aiot_sysdep_portfile_t g_aiot_sysdep_portfile = {
     .core_sysdep_mutex_lock = core_sysdep_mutex_lock,
     .core_sysdep_mutex_unlock = core_sysdep_mutex_unlock,
     .core_sysdep_mutex_deinit = core_sysdep_mutex_deinit,
+    .core_sysdep_time_ns = core_sysdep_time_ns,
+#if defined(CORE_SYSDEP_MEM_POOL_ENABLE)
+    .core_sysdep_mem_stats = core_sysdep_mem_pool_stats,
+#endif
+    .core_sysdep_rwlock_init = core_sysdep_rwlock_init,
+    .core_sysdep_rwlock_rdlock = core_sysdep_rwlock_rdlock,
+    .core_sysdep_rwlock_wrlock = core_sysdep_rwlock_wrlock,
+    .core_sysdep_rwlock_unlock = core_sysdep_rwlock_unlock,
+    .core_sysdep_rwlock_deinit = core_sysdep_rwlock_deinit,
+    .core_sysdep_cond_init = core_sysdep_cond_init,
+    .core_sysdep_cond_wait = core_sysdep_cond_wait,
+    .core_sysdep_cond_broadcast = core_sysdep_cond_broadcast,
+    .core_sysdep_cond_deinit = core_sysdep_cond_deinit,
+    .core_sysdep_atomic_add = core_sysdep_atomic_add,
+    .core_sysdep_network_get_fd = core_sysdep_network_get_fd,
+    .core_sysdep_network_recv_some = core_sysdep_network_recv_some,
+    .core_sysdep_atomic_cas = core_sysdep_atomic_cas,
 };
 